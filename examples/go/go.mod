@@ -0,0 +1,3 @@
+module github.com/yinqiwen/rdict/examples/go
+
+go 1.20
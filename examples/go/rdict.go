@@ -0,0 +1,143 @@
+// Package rdict wraps the rdict C ABI(rdict/rdict_c.h) with cgo.
+//
+// Values are returned as byte slices over the dict mapping without copying, they stay valid until the dict is
+// closed and must not be modified. A flatbuffers value can be read in place with the generated go code, e.g.
+// rdict.GetRootAsDictEntry(val, 0).
+package rdict
+
+/*
+#cgo LDFLAGS: -lrdict_c
+#include <stdlib.h>
+#include "rdict/rdict_c.h"
+*/
+import "C"
+
+import (
+	"errors"
+	"runtime"
+	"unsafe"
+)
+
+type KeyType int
+
+const (
+	KeyString KeyType = C.RDICT_KEY_STRING
+	KeyInt32  KeyType = C.RDICT_KEY_INT32
+	KeyUint32 KeyType = C.RDICT_KEY_UINT32
+	KeyInt64  KeyType = C.RDICT_KEY_INT64
+	KeyUint64 KeyType = C.RDICT_KEY_UINT64
+)
+
+var ErrNotFound = errors.New("rdict: not found entry")
+
+// lastError reads the thread local message of the failed call, callers lock the goroutine to its OS thread around
+// the call and lastError so that the message is not the one of another call on another thread.
+func lastError(code C.int) error {
+	if code == C.RDICT_NOT_FOUND {
+		return ErrNotFound
+	}
+	return errors.New("rdict: " + C.GoString(C.rdict_last_error()))
+}
+
+func view(val unsafe.Pointer, size C.size_t) []byte {
+	if val == nil {
+		return nil
+	}
+	return unsafe.Slice((*byte)(val), int(size))
+}
+
+type KV struct {
+	kv *C.rdict_kv
+}
+
+func OpenKV(path string, keyType KeyType) (*KV, error) {
+	runtime.LockOSThread()
+	defer runtime.UnlockOSThread()
+	cpath := C.CString(path)
+	defer C.free(unsafe.Pointer(cpath))
+	var kv *C.rdict_kv
+	if code := C.rdict_kv_open(cpath, C.rdict_key_type(keyType), C.RDICT_LOAD_MMAP, &kv); code != C.RDICT_OK {
+		return nil, lastError(code)
+	}
+	return &KV{kv: kv}, nil
+}
+
+func (d *KV) Close() {
+	C.rdict_kv_close(d.kv)
+	d.kv = nil
+}
+
+func (d *KV) Size() int { return int(C.rdict_kv_size(d.kv)) }
+
+func (d *KV) Get(key string) ([]byte, error) {
+	runtime.LockOSThread()
+	defer runtime.UnlockOSThread()
+	var val unsafe.Pointer
+	var size C.size_t
+	// the key is only read during the call, pass the go memory directly
+	keyData := (*C.char)(unsafe.Pointer(unsafe.StringData(key)))
+	if code := C.rdict_kv_get_str(d.kv, keyData, C.size_t(len(key)), &val, &size); code != C.RDICT_OK {
+		return nil, lastError(code)
+	}
+	return view(val, size), nil
+}
+
+func (d *KV) GetInt(key int64) ([]byte, error) {
+	runtime.LockOSThread()
+	defer runtime.UnlockOSThread()
+	var val unsafe.Pointer
+	var size C.size_t
+	if code := C.rdict_kv_get_int(d.kv, C.int64_t(key), &val, &size); code != C.RDICT_OK {
+		return nil, lastError(code)
+	}
+	return view(val, size), nil
+}
+
+// MultiGetInt looks up all keys in one cgo call, missing keys map to nil.
+func (d *KV) MultiGetInt(keys []int64) [][]byte {
+	if len(keys) == 0 {
+		return nil
+	}
+	vals := make([]unsafe.Pointer, len(keys))
+	sizes := make([]C.size_t, len(keys))
+	C.rdict_kv_multi_get_int(d.kv, (*C.int64_t)(unsafe.Pointer(&keys[0])), C.size_t(len(keys)), &vals[0], &sizes[0])
+	result := make([][]byte, len(keys))
+	for i := range keys {
+		result[i] = view(vals[i], sizes[i])
+	}
+	return result
+}
+
+type List struct {
+	list *C.rdict_list
+}
+
+func OpenList(path string) (*List, error) {
+	runtime.LockOSThread()
+	defer runtime.UnlockOSThread()
+	cpath := C.CString(path)
+	defer C.free(unsafe.Pointer(cpath))
+	var list *C.rdict_list
+	if code := C.rdict_list_open(cpath, C.RDICT_LOAD_MMAP, &list); code != C.RDICT_OK {
+		return nil, lastError(code)
+	}
+	return &List{list: list}, nil
+}
+
+func (l *List) Close() {
+	C.rdict_list_close(l.list)
+	l.list = nil
+}
+
+func (l *List) Size() int { return int(C.rdict_list_size(l.list)) }
+
+func (l *List) Get(idx int) ([]byte, error) {
+	runtime.LockOSThread()
+	defer runtime.UnlockOSThread()
+	var val unsafe.Pointer
+	var size C.size_t
+	if code := C.rdict_list_get(l.list, C.size_t(idx), &val, &size); code != C.RDICT_OK {
+		return nil, lastError(code)
+	}
+	return view(val, size), nil
+}
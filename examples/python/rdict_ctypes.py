@@ -0,0 +1,165 @@
+"""Zero-copy rdict lookups from python through the C ABI in rdict/rdict_c.h.
+
+Values are returned as memoryviews over the dict mapping, valid until the dict is closed. A flatbuffers value can be
+wrapped without copying, e.g. with the generated python code of the schema:
+
+    entry = DictEntry.GetRootAs(kv.get("key1"), 0)
+
+Usage: python3 rdict_ctypes.py <librdict_c.so> <kv rdict file> [key ...]
+"""
+
+import ctypes
+import sys
+import time
+
+RDICT_OK = 0
+RDICT_NOT_FOUND = 5
+
+RDICT_KEY_STRING = 0
+RDICT_KEY_INT32 = 1
+RDICT_KEY_UINT32 = 2
+RDICT_KEY_INT64 = 3
+RDICT_KEY_UINT64 = 4
+
+RDICT_LOAD_MMAP = 0
+RDICT_LOAD_ANONYMOUS = 1
+
+_c_void_p_p = ctypes.POINTER(ctypes.c_void_p)
+_c_size_t_p = ctypes.POINTER(ctypes.c_size_t)
+
+
+def load_library(path):
+    lib = ctypes.CDLL(path)
+    lib.rdict_last_error.restype = ctypes.c_char_p
+    lib.rdict_kv_open.argtypes = [ctypes.c_char_p, ctypes.c_int, ctypes.c_int, _c_void_p_p]
+    lib.rdict_kv_close.argtypes = [ctypes.c_void_p]
+    lib.rdict_kv_close.restype = None
+    lib.rdict_kv_size.argtypes = [ctypes.c_void_p]
+    lib.rdict_kv_size.restype = ctypes.c_size_t
+    lib.rdict_kv_get_str.argtypes = [ctypes.c_void_p, ctypes.c_char_p, ctypes.c_size_t, _c_void_p_p, _c_size_t_p]
+    lib.rdict_kv_get_int.argtypes = [ctypes.c_void_p, ctypes.c_int64, _c_void_p_p, _c_size_t_p]
+    lib.rdict_kv_multi_get_str.argtypes = [ctypes.c_void_p, ctypes.POINTER(ctypes.c_char_p), _c_size_t_p,
+                                           ctypes.c_size_t, _c_void_p_p, _c_size_t_p]
+    lib.rdict_kv_multi_get_str.restype = ctypes.c_size_t
+    lib.rdict_kv_multi_get_int.argtypes = [ctypes.c_void_p, ctypes.POINTER(ctypes.c_int64), ctypes.c_size_t,
+                                           _c_void_p_p, _c_size_t_p]
+    lib.rdict_kv_multi_get_int.restype = ctypes.c_size_t
+    lib.rdict_list_open.argtypes = [ctypes.c_char_p, ctypes.c_int, _c_void_p_p]
+    lib.rdict_list_close.argtypes = [ctypes.c_void_p]
+    lib.rdict_list_close.restype = None
+    lib.rdict_list_size.argtypes = [ctypes.c_void_p]
+    lib.rdict_list_size.restype = ctypes.c_size_t
+    lib.rdict_list_get.argtypes = [ctypes.c_void_p, ctypes.c_size_t, _c_void_p_p, _c_size_t_p]
+    return lib
+
+
+def _view(ptr, size):
+    return memoryview((ctypes.c_char * size).from_address(ptr)).cast("B")
+
+
+class RdictError(Exception):
+    pass
+
+
+class KV:
+    def __init__(self, lib, path, key_type=RDICT_KEY_STRING, load_mode=RDICT_LOAD_MMAP):
+        self._lib = lib
+        self._key_type = key_type
+        self._handle = ctypes.c_void_p()
+        if lib.rdict_kv_open(path.encode(), key_type, load_mode, ctypes.byref(self._handle)) != RDICT_OK:
+            raise RdictError(lib.rdict_last_error().decode())
+        self._val = ctypes.c_void_p()
+        self._val_len = ctypes.c_size_t()
+
+    def __len__(self):
+        return self._lib.rdict_kv_size(self._handle)
+
+    def get(self, key):
+        """Returns a memoryview of the value, or None if the key does not exist."""
+        if self._key_type == RDICT_KEY_STRING:
+            key = key.encode() if isinstance(key, str) else key
+            code = self._lib.rdict_kv_get_str(self._handle, key, len(key), ctypes.byref(self._val),
+                                              ctypes.byref(self._val_len))
+        else:
+            code = self._lib.rdict_kv_get_int(self._handle, key, ctypes.byref(self._val), ctypes.byref(self._val_len))
+        if code == RDICT_NOT_FOUND:
+            return None
+        if code != RDICT_OK:
+            raise RdictError(self._lib.rdict_last_error().decode())
+        return _view(self._val.value, self._val_len.value)
+
+    def multi_get(self, keys):
+        """Looks up all keys in one FFI call, missing keys map to None."""
+        n = len(keys)
+        vals = (ctypes.c_void_p * n)()
+        val_lens = (ctypes.c_size_t * n)()
+        if self._key_type == RDICT_KEY_STRING:
+            keys = [k.encode() if isinstance(k, str) else k for k in keys]
+            key_ptrs = (ctypes.c_char_p * n)(*keys)
+            key_lens = (ctypes.c_size_t * n)(*[len(k) for k in keys])
+            self._lib.rdict_kv_multi_get_str(self._handle, key_ptrs, key_lens, n, vals, val_lens)
+        else:
+            int_keys = (ctypes.c_int64 * n)(*keys)
+            self._lib.rdict_kv_multi_get_int(self._handle, int_keys, n, vals, val_lens)
+        return [_view(vals[i], val_lens[i]) if vals[i] else None for i in range(n)]
+
+    def close(self):
+        if self._handle:
+            self._lib.rdict_kv_close(self._handle)
+            self._handle = ctypes.c_void_p()
+
+
+class List:
+    def __init__(self, lib, path, load_mode=RDICT_LOAD_MMAP):
+        self._lib = lib
+        self._handle = ctypes.c_void_p()
+        if lib.rdict_list_open(path.encode(), load_mode, ctypes.byref(self._handle)) != RDICT_OK:
+            raise RdictError(lib.rdict_last_error().decode())
+
+    def __len__(self):
+        return self._lib.rdict_list_size(self._handle)
+
+    def __getitem__(self, idx):
+        val = ctypes.c_void_p()
+        val_len = ctypes.c_size_t()
+        if self._lib.rdict_list_get(self._handle, idx, ctypes.byref(val), ctypes.byref(val_len)) != RDICT_OK:
+            raise IndexError(self._lib.rdict_last_error().decode())
+        return _view(val.value, val_len.value)
+
+    def close(self):
+        if self._handle:
+            self._lib.rdict_list_close(self._handle)
+            self._handle = ctypes.c_void_p()
+
+
+def main():
+    if len(sys.argv) < 3:
+        print(__doc__)
+        return 1
+    lib = load_library(sys.argv[1])
+    kv = KV(lib, sys.argv[2])
+    keys = sys.argv[3:]
+    print("size:", len(kv))
+    for key in keys:
+        val = kv.get(key)
+        print(key, "=>", None if val is None else bytes(val))
+
+    # per call overhead of the FFI layer
+    if keys:
+        rounds = 100000
+        start = time.perf_counter()
+        for i in range(rounds):
+            kv.get(keys[i % len(keys)])
+        get_cost = (time.perf_counter() - start) / rounds
+        batch = (keys * (64 // len(keys) + 1))[:64]
+        start = time.perf_counter()
+        for _ in range(rounds // 64):
+            kv.multi_get(batch)
+        multi_get_cost = (time.perf_counter() - start) / (rounds // 64 * 64)
+        print("get: %.0fns/key, multi_get(64): %.0fns/key" % (get_cost * 1e9, multi_get_cost * 1e9))
+    kv.close()
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
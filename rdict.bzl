@@ -79,6 +79,27 @@ cc_library(
         ],
     )
 
+    _SIMDJSON_BUILD_FILE = """
+cc_library(
+    name = "simdjson",
+    hdrs = ["singleheader/simdjson.h"],
+    srcs = ["singleheader/simdjson.cpp"],
+    includes = ["singleheader"],
+    visibility = ["//visibility:public"],
+)
+"""
+    simdjson_ver = kwargs.get("simdjson_ver", "3.10.1")
+    simdjson_name = "simdjson-{ver}".format(ver = simdjson_ver)
+    http_archive(
+        name = "com_github_simdjson",
+        strip_prefix = simdjson_name,
+        urls = [
+            "https://mirrors.tencent.com/github.com/simdjson/simdjson/archive/v{ver}.tar.gz".format(ver = simdjson_ver),
+            "https://github.com/simdjson/simdjson/archive/v{ver}.tar.gz".format(ver = simdjson_ver),
+        ],
+        build_file_content = _SIMDJSON_BUILD_FILE,
+    )
+
     protobuf_ver = kwargs.get("protobuf_ver", "3.19.2")
     protobuf_name = "protobuf-{ver}".format(ver = protobuf_ver)
     http_archive(
@@ -0,0 +1,142 @@
+/*
+** BSD 3-Clause License
+**
+** Copyright (c) 2023, qiyingwang <qiyingwang@tencent.com>, the respective contributors, as shown by the AUTHORS file.
+** All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions are met:
+** * Redistributions of source code must retain the above copyright notice, this
+** list of conditions and the following disclaimer.
+**
+** * Redistributions in binary form must reproduce the above copyright notice,
+** this list of conditions and the following disclaimer in the documentation
+** and/or other materials provided with the distribution.
+**
+** * Neither the name of the copyright holder nor the names of its
+** contributors may be used to endorse or promote products derived from
+** this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+** AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+** IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+** DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+** FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+** DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+** SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+** CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+** OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#include "rdict/access_profile.h"
+#include <unistd.h>
+#include <algorithm>
+#include <cstring>
+#include <thread>
+#include <vector>
+#include "folly/FileUtil.h"
+
+namespace rdict {
+namespace {
+struct AccessProfileHeader {
+  uint32_t magic = 0xD1C8;
+  uint32_t page_size = AccessProfile::kPageSize;
+  uint64_t num_pages = 0;
+};
+}  // namespace
+
+std::unique_ptr<AccessProfile> AccessProfile::New(size_t region_size, uint32_t sample_rate) {
+  std::unique_ptr<AccessProfile> p(new AccessProfile);
+  p->sample_threshold_ = (uint64_t{1} << 32) / std::max<uint32_t>(1, sample_rate);
+  p->num_pages_ = (region_size + kPageSize - 1) / kPageSize;
+  p->num_words_ = (p->num_pages_ + 63) / 64;
+  p->bits_.reset(new std::atomic<uint64_t>[p->num_words_]);
+  for (size_t i = 0; i < p->num_words_; i++) {
+    p->bits_[i].store(0, std::memory_order_relaxed);
+  }
+  return p;
+}
+
+absl::StatusOr<std::unique_ptr<AccessProfile>> AccessProfile::Load(const std::string& path) {
+  if (access(path.c_str(), F_OK) == -1) {
+    return absl::NotFoundError("access profile not exist:" + path);
+  }
+  std::string content;
+  if (!folly::readFile(path.c_str(), content)) {
+    return absl::InvalidArgumentError("read access profile failed:" + path);
+  }
+  AccessProfileHeader header;
+  if (content.size() < sizeof(header)) {
+    return absl::InvalidArgumentError("invalid access profile with too small length:" + path);
+  }
+  memcpy(&header, content.data(), sizeof(header));
+  if (header.magic != AccessProfileHeader{}.magic || header.page_size != kPageSize) {
+    return absl::InvalidArgumentError("invalid access profile header:" + path);
+  }
+  auto p = New(header.num_pages * kPageSize, 1);
+  if (content.size() != sizeof(header) + p->num_words_ * sizeof(uint64_t)) {
+    return absl::InvalidArgumentError("invalid access profile length:" + path);
+  }
+  const char* words = content.data() + sizeof(header);
+  for (size_t i = 0; i < p->num_words_; i++) {
+    uint64_t word = 0;
+    memcpy(&word, words + i * sizeof(uint64_t), sizeof(uint64_t));
+    p->bits_[i].store(word, std::memory_order_relaxed);
+  }
+  return p;
+}
+
+absl::Status AccessProfile::Save(const std::string& path) const {
+  AccessProfileHeader header;
+  header.num_pages = num_pages_;
+  std::string content(sizeof(header) + num_words_ * sizeof(uint64_t), '\0');
+  memcpy(&content[0], &header, sizeof(header));
+  for (size_t i = 0; i < num_words_; i++) {
+    uint64_t word = bits_[i].load(std::memory_order_relaxed);
+    memcpy(&content[sizeof(header) + i * sizeof(uint64_t)], &word, sizeof(uint64_t));
+  }
+  std::string tmp_path = path + ".tmp";
+  if (!folly::writeFile(content, tmp_path.c_str())) {
+    return absl::InternalError("write access profile failed:" + tmp_path);
+  }
+  if (0 != rename(tmp_path.c_str(), path.c_str())) {
+    return absl::InternalError("rename access profile failed:" + path);
+  }
+  return absl::OkStatus();
+}
+
+size_t AccessProfile::HotPages() const {
+  size_t n = 0;
+  for (size_t i = 0; i < num_words_; i++) {
+    n += __builtin_popcountll(bits_[i].load(std::memory_order_relaxed));
+  }
+  return n;
+}
+
+size_t AccessProfile::Warmup(const uint8_t* base, size_t size, uint32_t threads) const {
+  std::vector<size_t> pages;
+  size_t limit = std::min(num_pages_, (size + kPageSize - 1) / kPageSize);
+  for (size_t page = 0; page < limit; page++) {
+    if (bits_[page / 64].load(std::memory_order_relaxed) & (uint64_t{1} << (page % 64))) {
+      pages.push_back(page);
+    }
+  }
+  threads = std::max<uint32_t>(1, threads);
+  size_t chunk = (pages.size() + threads - 1) / threads;
+  std::vector<std::thread> workers;
+  for (size_t start = 0; start < pages.size(); start += chunk) {
+    size_t end = std::min(pages.size(), start + chunk);
+    workers.emplace_back([&pages, base, start, end]() {
+      uint8_t sum = 0;
+      for (size_t i = start; i < end; i++) {
+        sum += *reinterpret_cast<const volatile uint8_t*>(base + pages[i] * kPageSize);
+      }
+      (void)sum;
+    });
+  }
+  for (auto& worker : workers) {
+    worker.join();
+  }
+  return pages.size();
+}
+}  // namespace rdict
@@ -0,0 +1,84 @@
+/*
+** BSD 3-Clause License
+**
+** Copyright (c) 2023, qiyingwang <qiyingwang@tencent.com>, the respective contributors, as shown by the AUTHORS file.
+** All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions are met:
+** * Redistributions of source code must retain the above copyright notice, this
+** list of conditions and the following disclaimer.
+**
+** * Redistributions in binary form must reproduce the above copyright notice,
+** this list of conditions and the following disclaimer in the documentation
+** and/or other materials provided with the distribution.
+**
+** * Neither the name of the copyright holder nor the names of its
+** contributors may be used to endorse or promote products derived from
+** this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+** AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+** IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+** DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+** FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+** DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+** SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+** CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+** OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "absl/status/statusor.h"
+
+namespace rdict {
+/**
+ * Sampled page access bitmap of a dict file, used to warmup only the hot pages on next load.
+ */
+class AccessProfile {
+ public:
+  static constexpr size_t kPageSize = 4096;
+  static std::unique_ptr<AccessProfile> New(size_t region_size, uint32_t sample_rate);
+  static absl::StatusOr<std::unique_ptr<AccessProfile>> Load(const std::string& path);
+
+  /**
+   * True with a probability of 1/sample_rate. The random state is per thread so that lookups do no shared writes, and
+   * every call is an independent draw so that the interleaved lookups of dicts of other rates do not shift the rate.
+   */
+  bool Sample() const {
+    // xorshift64, seeded by the address of the state which differs between threads
+    thread_local uint64_t state = 0;
+    if (0 == state) {
+      state = (reinterpret_cast<uintptr_t>(&state) * UINT64_C(0x9E3779B97F4A7C15)) | 1;
+    }
+    state ^= state << 13;
+    state ^= state >> 7;
+    state ^= state << 17;
+    return (state >> 32) < sample_threshold_;
+  }
+  void Record(size_t offset) const {
+    size_t page = offset / kPageSize;
+    if (page < num_pages_) {
+      bits_[page / 64].fetch_or(uint64_t{1} << (page % 64), std::memory_order_relaxed);
+    }
+  }
+  absl::Status Save(const std::string& path) const;
+  size_t HotPages() const;
+  // touch the hot pages of [base, base + size) with 'threads' threads, return the touched page count
+  size_t Warmup(const uint8_t* base, size_t size, uint32_t threads) const;
+
+ private:
+  AccessProfile() {}
+  std::unique_ptr<std::atomic<uint64_t>[]> bits_;
+  size_t num_words_ = 0;
+  size_t num_pages_ = 0;
+  // 2^32 / sample_rate, compared with 32 random bits
+  uint64_t sample_threshold_ = uint64_t{1} << 32;
+};
+}  // namespace rdict
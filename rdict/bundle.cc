@@ -0,0 +1,260 @@
+/*
+** BSD 3-Clause License
+**
+** Copyright (c) 2023, qiyingwang <qiyingwang@tencent.com>, the respective contributors, as shown by the AUTHORS file.
+** All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions are met:
+** * Redistributions of source code must retain the above copyright notice, this
+** list of conditions and the following disclaimer.
+**
+** * Redistributions in binary form must reproduce the above copyright notice,
+** this list of conditions and the following disclaimer in the documentation
+** and/or other materials provided with the distribution.
+**
+** * Neither the name of the copyright holder nor the names of its
+** contributors may be used to endorse or promote products derived from
+** this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+** AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+** IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+** DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+** FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+** DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+** SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+** CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+** OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#include "rdict/bundle.h"
+#include <string.h>
+#include <algorithm>
+
+namespace rdict {
+namespace {
+constexpr uint64_t kBundleMagic = 0x314C444E55424452ULL;  // "RDBUNDL1"
+constexpr uint32_t kBundleVersion = 1;
+
+// at the start of the header page
+struct BundleHeader {
+  uint64_t magic = kBundleMagic;
+  uint32_t version = kBundleVersion;
+  uint32_t entry_count = 0;
+  // table of contents: 'entry_count' TocEntry then the names
+  uint64_t toc_offset = 0;
+  uint64_t toc_size = 0;
+};
+
+struct TocEntry {
+  uint64_t offset = 0;
+  uint64_t size = 0;
+  // offset of the name from the table of contents
+  uint64_t name_offset = 0;
+  uint32_t name_size = 0;
+  uint8_t type = 0;
+  uint8_t reserved[3] = {};
+};
+static_assert(sizeof(TocEntry) == 32);
+}  // namespace
+
+absl::StatusOr<std::unique_ptr<DictBundle>> DictBundle::Load(const std::string& path) {
+  Options opts;
+  opts.path = path;
+  return Load(opts);
+}
+
+absl::StatusOr<std::unique_ptr<DictBundle>> DictBundle::Load(const Options& opts) {
+  std::unique_ptr<DictBundle> p(new DictBundle);
+  auto status = p->Init(opts);
+  if (!status.ok()) {
+    return status;
+  }
+  return p;
+}
+
+absl::Status DictBundle::Init(const Options& opts) {
+  opts_ = opts;
+  MmapFile::Options file_opts;
+  file_opts.path = opts.path;
+  file_opts.readonly = true;
+  file_opts.load_mode = opts.load_mode;
+  file_opts.load_threads = opts.load_threads;
+  file_opts.populate = opts.populate;
+  auto result = MmapFile::Open(file_opts);
+  if (!result.ok()) {
+    return result.status();
+  }
+  file_ = std::move(result.value());
+  const uint8_t* data = file_->GetRawData();
+  size_t file_size = file_->GetWriteOffset();
+  BundleHeader header;
+  if (file_size < kPageSize) {
+    return absl::InvalidArgumentError("invalid dict bundle with too small length:" + opts.path);
+  }
+  memcpy(&header, data, sizeof(header));
+  if (header.magic != kBundleMagic || header.version != kBundleVersion) {
+    return absl::InvalidArgumentError("not a dict bundle:" + opts.path);
+  }
+  if (header.toc_offset > file_size || header.toc_size > file_size - header.toc_offset ||
+      header.entry_count > header.toc_size / sizeof(TocEntry)) {
+    return absl::InvalidArgumentError("invalid dict bundle table of contents:" + opts.path);
+  }
+  const uint8_t* toc = data + header.toc_offset;
+  entries_.resize(header.entry_count);
+  for (size_t i = 0; i < header.entry_count; i++) {
+    TocEntry toc_entry;
+    memcpy(&toc_entry, toc + i * sizeof(TocEntry), sizeof(TocEntry));
+    if (toc_entry.offset > file_size || toc_entry.size > file_size - toc_entry.offset ||
+        toc_entry.name_offset > header.toc_size || toc_entry.name_size > header.toc_size - toc_entry.name_offset) {
+      return absl::InvalidArgumentError("invalid dict bundle entry:" + opts.path);
+    }
+    Entry& entry = entries_[i];
+    entry.name = std::string_view(reinterpret_cast<const char*>(toc + toc_entry.name_offset), toc_entry.name_size);
+    entry.type = static_cast<detail::DictType>(toc_entry.type);
+    entry.offset = toc_entry.offset;
+    entry.size = toc_entry.size;
+    if (i > 0 && entries_[i - 1].name >= entry.name) {
+      return absl::InvalidArgumentError("unsorted dict bundle entries:" + opts.path);
+    }
+  }
+  return absl::OkStatus();
+}
+
+const DictBundle::Entry* DictBundle::Find(std::string_view name) const {
+  auto found = std::lower_bound(entries_.begin(), entries_.end(), name,
+                                [](const Entry& entry, std::string_view key) { return entry.name < key; });
+  if (found == entries_.end() || found->name != name) {
+    return nullptr;
+  }
+  return &(*found);
+}
+
+absl::StatusOr<MmapFile::View> DictBundle::GetView(std::string_view name) const {
+  const Entry* entry = Find(name);
+  if (nullptr == entry) {
+    return absl::NotFoundError("no dict named " + std::string(name) + " in bundle:" + opts_.path);
+  }
+  MmapFile::View view;
+  view.file = file_;
+  view.offset = entry->offset;
+  view.size = entry->size;
+  return view;
+}
+
+absl::StatusOr<std::unique_ptr<DictBundleBuilder>> DictBundleBuilder::New(const Options& opts) {
+  std::unique_ptr<DictBundleBuilder> p(new DictBundleBuilder);
+  auto status = p->Init(opts);
+  if (!status.ok()) {
+    return status;
+  }
+  return p;
+}
+
+absl::Status DictBundleBuilder::Init(const Options& opts) {
+  MmapFile::Options file_opts;
+  file_opts.path = opts.path;
+  file_opts.reserved_space_bytes = opts.reserved_space_bytes;
+  file_opts.truncate = true;
+  file_opts.atomic_publish = true;
+  auto result = MmapFile::Open(file_opts);
+  if (!result.ok()) {
+    return result.status();
+  }
+  file_ = std::move(result.value());
+  // the header page, written by Commit
+  return Pad(DictBundle::kPageSize);
+}
+
+absl::Status DictBundleBuilder::Pad(size_t align) {
+  size_t offset = file_->GetWriteOffset();
+  size_t pad = (offset + align - 1) / align * align - offset;
+  if (0 == offset) {
+    pad = align;
+  }
+  auto result = file_->Reserve(pad);
+  if (!result.ok()) {
+    return result.status();
+  }
+  memset(result.value(), 0, pad);
+  file_->Commit(pad);
+  return absl::OkStatus();
+}
+
+absl::Status DictBundleBuilder::Add(std::string_view name, const std::string& dict_path) {
+  if (name.empty() || name.size() > UINT32_MAX) {
+    return absl::InvalidArgumentError("invalid dict name in bundle");
+  }
+  for (const auto& [added, entry] : entries_) {
+    if (added == name) {
+      return absl::AlreadyExistsError("duplicate dict name in bundle:" + added);
+    }
+  }
+  MmapFile::Options dict_opts;
+  dict_opts.path = dict_path;
+  dict_opts.readonly = true;
+  auto result = MmapFile::Open(dict_opts);
+  if (!result.ok()) {
+    return result.status();
+  }
+  auto dict_file = std::move(result.value());
+  detail::RdictMetaHeader header;
+  if (dict_file->GetWriteOffset() < detail::kRdictMetaHeaderSize) {
+    return absl::InvalidArgumentError("invalid rdict file with too small length:" + dict_path);
+  }
+  memcpy(&header, dict_file->GetRawData(), sizeof(header));
+  if (header.magic != detail::RdictMetaHeader{}.magic) {
+    return absl::InvalidArgumentError("not a rdict file:" + dict_path);
+  }
+  auto status = Pad(DictBundle::kPageSize);
+  if (!status.ok()) {
+    return status;
+  }
+  auto offset = file_->Add(dict_file->GetRawData(), dict_file->GetWriteOffset());
+  if (!offset.ok()) {
+    return offset.status();
+  }
+  DictBundle::Entry entry;
+  entry.type = static_cast<detail::DictType>(header.type);
+  entry.offset = offset.value();
+  entry.size = dict_file->GetWriteOffset();
+  entries_.emplace_back(std::string(name), entry);
+  return absl::OkStatus();
+}
+
+absl::Status DictBundleBuilder::Commit() {
+  std::sort(entries_.begin(), entries_.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+  auto status = Pad(sizeof(uint64_t));
+  if (!status.ok()) {
+    return status;
+  }
+  BundleHeader header;
+  header.entry_count = entries_.size();
+  header.toc_offset = file_->GetWriteOffset();
+  std::vector<TocEntry> toc(entries_.size());
+  uint64_t name_offset = entries_.size() * sizeof(TocEntry);
+  for (size_t i = 0; i < entries_.size(); i++) {
+    toc[i].offset = entries_[i].second.offset;
+    toc[i].size = entries_[i].second.size;
+    toc[i].name_offset = name_offset;
+    toc[i].name_size = entries_[i].first.size();
+    toc[i].type = entries_[i].second.type;
+    name_offset += entries_[i].first.size();
+  }
+  auto result = file_->Add(toc.data(), toc.size() * sizeof(TocEntry));
+  for (size_t i = 0; result.ok() && i < entries_.size(); i++) {
+    result = file_->Add(entries_[i].first.data(), entries_[i].first.size());
+  }
+  if (!result.ok()) {
+    return result.status();
+  }
+  header.toc_size = name_offset;
+  memcpy(file_->GetRawData(), &header, sizeof(header));
+  auto size = file_->ShrinkToFit();
+  if (!size.ok()) {
+    return size.status();
+  }
+  return absl::OkStatus();
+}
+}  // namespace rdict
@@ -0,0 +1,130 @@
+/*
+** BSD 3-Clause License
+**
+** Copyright (c) 2023, qiyingwang <qiyingwang@tencent.com>, the respective contributors, as shown by the AUTHORS file.
+** All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions are met:
+** * Redistributions of source code must retain the above copyright notice, this
+** list of conditions and the following disclaimer.
+**
+** * Redistributions in binary form must reproduce the above copyright notice,
+** this list of conditions and the following disclaimer in the documentation
+** and/or other materials provided with the distribution.
+**
+** * Neither the name of the copyright holder nor the names of its
+** contributors may be used to endorse or promote products derived from
+** this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+** AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+** IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+** DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+** FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+** DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+** SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+** CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+** OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#pragma once
+
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "absl/status/statusor.h"
+#include "rdict/common.h"
+#include "rdict/mmap_file.h"
+
+namespace rdict {
+namespace detail {
+template <typename D>
+using detect_options_load = decltype(D::Load(std::declval<const typename D::Options&>()));
+}  // namespace detail
+
+/**
+ * Many dict files packed in one file: a header page, every dict starting at a page boundary, then a table of contents
+ * sorted by name. The bundle is loaded with a single mapping and its dicts are opened by name in place, they share the
+ * mapping which stays alive until the bundle and all dicts opened from it are released. A bundle is published
+ * atomically as a whole, reloading it is loading the new file and reopening the dicts from it.
+ */
+class DictBundle {
+ public:
+  static constexpr size_t kPageSize = 4096;
+  struct Options {
+    std::string path;
+    MmapFile::LoadMode load_mode = MmapFile::LOAD_MMAP;
+    uint32_t load_threads = 4;
+    // prefault the whole bundle at load with LOAD_MMAP, one pass for all dicts
+    bool populate = false;
+  };
+  struct Entry {
+    // points into the bundle
+    std::string_view name;
+    detail::DictType type = detail::DICT_KV;
+    uint64_t offset = 0;
+    uint64_t size = 0;
+  };
+
+  static absl::StatusOr<std::unique_ptr<DictBundle>> Load(const std::string& path);
+  static absl::StatusOr<std::unique_ptr<DictBundle>> Load(const Options& opts);
+
+  // sorted by name
+  const std::vector<Entry>& Entries() const { return entries_; }
+  const Entry* Find(std::string_view name) const;
+  absl::StatusOr<MmapFile::View> GetView(std::string_view name) const;
+  /**
+   * Open the dict 'name' with the readonly 'opts', whose path and view are set here. D is any dict with a 'view'
+   * option: ReadonlyKV and the dicts based on it(FbsKv, ReadonlySet, ...), ReadonlyList, FbsList and ReadonlyTrie.
+   */
+  template <typename D>
+  absl::StatusOr<std::unique_ptr<D>> Open(std::string_view name, typename D::Options opts = {}) const {
+    auto view = GetView(name);
+    if (!view.ok()) {
+      return view.status();
+    }
+    opts.path = opts_.path + "#" + std::string(name);
+    opts.readonly = true;
+    opts.view = std::move(view.value());
+    if constexpr (detail::is_detected_v<detail::detect_options_load, D>) {
+      return D::Load(opts);
+    } else {
+      return D::New(opts);
+    }
+  }
+
+ private:
+  DictBundle() {}
+  absl::Status Init(const Options& opts);
+
+  Options opts_;
+  std::shared_ptr<MmapFile> file_;
+  std::vector<Entry> entries_;
+};
+
+class DictBundleBuilder {
+ public:
+  struct Options {
+    std::string path;
+    size_t reserved_space_bytes = 100 * 1024 * 1024 * 1024LL;
+  };
+  static absl::StatusOr<std::unique_ptr<DictBundleBuilder>> New(const Options& opts);
+
+  // copy the committed dict file 'dict_path' into the bundle as 'name', names are unique
+  absl::Status Add(std::string_view name, const std::string& dict_path);
+  // write the table of contents and publish the bundle atomically, nothing is published without it
+  absl::Status Commit();
+
+ private:
+  DictBundleBuilder() {}
+  absl::Status Init(const Options& opts);
+  absl::Status Pad(size_t align);
+
+  std::unique_ptr<MmapFile> file_;
+  std::vector<std::pair<std::string, DictBundle::Entry>> entries_;
+};
+}  // namespace rdict
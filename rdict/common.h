@@ -43,6 +43,28 @@ enum DictType {
   DICT_KV = 0,
   DICT_LIST,
   DICT_KKV,
+  DICT_TRIE,
+  DICT_SET,
+};
+
+enum IndexType {
+  // robin hood hashing, the writable in-memory index of all kv dicts
+  INDEX_ROBIN_HOOD = 0,
+  // bucketized cuckoo hashing written by Commit, every lookup probes at most two 64 bytes buckets
+  INDEX_CUCKOO,
+  // robin hood hashing written by Commit with 32 bytes buckets, which also hold the key and value of small records
+  INDEX_INLINE,
+};
+
+enum HashType {
+  // wyhash, rdict::hash
+  HASH_WYHASH = 0,
+  // rdict::crc32c_hash
+  HASH_CRC32C,
+  // rdict::stripe_hash
+  HASH_STRIPE,
+  // hash functors without a 'hash_id', not validated at load
+  HASH_CUSTOM = 255,
 };
 
 struct RdictMetaHeader {
@@ -51,6 +73,18 @@ struct RdictMetaHeader {
   uint16_t data_pad_size = 0;
   uint16_t magic = 0xD1C7;
   uint8_t type = 0;
+  uint8_t index_type = INDEX_ROBIN_HOOD;
+  // front index of the hottest keys after the main index, 0 size for none
+  uint64_t front_index_offset = 0;
+  uint64_t front_index_size = 0;
+  // HashType of kv dicts, files written before it was recorded are all wyhash
+  uint8_t hash_type = HASH_WYHASH;
+  // sizes of flat kv dicts, all 0 for non flat dicts and the builtin u32/u64 flat dicts written before
+  uint16_t flat_key_size = 0;
+  uint16_t flat_value_size = 0;
+  uint16_t flat_bucket_size = 0;
+  // bytes of the string key hashes stored in place of the keys by HashKeyKV, 0 for dicts of real keys
+  uint8_t hashed_key_size = 0;
 };
 
 constexpr size_t kRdictMetaHeaderSize = 64 * sizeof(uint64_t);
@@ -84,14 +118,17 @@ template <typename T>
 using detect_avalanching = typename T::is_avalanching;
 template <typename T>
 struct Serializer {
-  static void Pack(const T& v, std::vector<uint8_t>& buffer, bool align) {
-    size_t orig_len = buffer.size();
+  static size_t PackSize(const T&, bool align) {
     uint32_t val_size = sizeof(T);
     if (align) {
       val_size = ((val_size + 7) & ~7);
     }
-    buffer.resize(buffer.size() + val_size);
-    memcpy(&buffer[0] + orig_len, &v, sizeof(T));
+    return val_size;
+  }
+  // writes PackSize bytes to 'dst', the padding is zeroed
+  static void PackTo(const T& v, uint8_t* dst, bool align) {
+    memcpy(dst, &v, sizeof(T));
+    memset(dst + sizeof(T), 0, PackSize(v, align) - sizeof(T));
   }
   static size_t Unpack(const uint8_t* data, T& v, bool align) {
     memcpy(&v, data, sizeof(T));
@@ -112,18 +149,20 @@ struct Serializer {
 
 template <>
 struct Serializer<std::string_view> {
-  static void Pack(const std::string_view& v, std::vector<uint8_t>& buffer, bool align) {
-    uint32_t v_len = static_cast<uint32_t>(v.size());
-    size_t orig_len = buffer.size();
+  static size_t PackSize(const std::string_view& v, bool align) {
     uint32_t val_size = sizeof(LenHeader) + v.size();
     if (align) {
       val_size = ((val_size + 7) & ~7);
     }
-    uint32_t capacity = val_size - sizeof(LenHeader);
-    buffer.resize(buffer.size() + val_size);
+    return val_size;
+  }
+  static void PackTo(const std::string_view& v, uint8_t* dst, bool align) {
+    uint32_t v_len = static_cast<uint32_t>(v.size());
+    uint32_t capacity = PackSize(v, align) - sizeof(LenHeader);
     LenHeader header{capacity, v_len};
-    memcpy(&buffer[0] + orig_len, &header, sizeof(LenHeader));
-    memcpy(&buffer[0] + orig_len + sizeof(LenHeader), v.data(), v.size());
+    memcpy(dst, &header, sizeof(LenHeader));
+    memcpy(dst + sizeof(LenHeader), v.data(), v.size());
+    memset(dst + sizeof(LenHeader) + v.size(), 0, capacity - v.size());
   }
   static size_t Unpack(const uint8_t* data, std::string_view& v, bool align) {
     LenHeader header;
@@ -140,4 +179,12 @@ struct Serializer<std::string_view> {
   }
 };
 }  // namespace detail
+
+// a mapped range of a readonly dict file, see DictManager
+struct MemoryRegion {
+  const uint8_t* addr = nullptr;
+  size_t size = 0;
+  // pages advised out are read back from the file, false for anonymous copies(LOAD_ANONYMOUS) which would be lost
+  bool file_backed = false;
+};
 }  // namespace rdict
\ No newline at end of file
@@ -0,0 +1,212 @@
+/*
+** BSD 3-Clause License
+**
+** Copyright (c) 2023, qiyingwang <qiyingwang@tencent.com>, the respective contributors, as shown by the AUTHORS file.
+** All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions are met:
+** * Redistributions of source code must retain the above copyright notice, this
+** list of conditions and the following disclaimer.
+**
+** * Redistributions in binary form must reproduce the above copyright notice,
+** this list of conditions and the following disclaimer in the documentation
+** and/or other materials provided with the distribution.
+**
+** * Neither the name of the copyright holder nor the names of its
+** contributors may be used to endorse or promote products derived from
+** this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+** AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+** IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+** DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+** FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+** DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+** SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+** CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+** OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#pragma once
+
+#include <coroutine>
+#include <deque>
+#include <exception>
+#include <optional>
+#include <type_traits>
+#include <utility>
+
+namespace rdict {
+template <typename T>
+class Task;
+
+/**
+ * Round robin scheduler of coroutines suspended by 'Yield', used to interleave many dict lookups so that the memory
+ * accesses of one overlap the computation of others.
+ */
+class Interleaver {
+ public:
+  // queues a top level task, started by Run
+  template <typename T>
+  void Spawn(Task<T>& task) {
+    ready_.push_back(task.handle_);
+  }
+  // resumes the queued coroutines until all tasks are done
+  void Run() {
+    Interleaver* prev = std::exchange(current(), this);
+    while (!ready_.empty()) {
+      auto handle = ready_.front();
+      ready_.pop_front();
+      handle.resume();
+    }
+    current() = prev;
+  }
+  static Interleaver*& current() {
+    thread_local Interleaver* scheduler = nullptr;
+    return scheduler;
+  }
+
+ private:
+  friend struct Yield;
+  std::deque<std::coroutine_handle<>> ready_;
+};
+
+// suspends to the running Interleaver after a prefetch, no-op outside of Interleaver::Run
+struct Yield {
+  bool await_ready() const noexcept { return nullptr == Interleaver::current(); }
+  void await_suspend(std::coroutine_handle<> handle) const { Interleaver::current()->ready_.push_back(handle); }
+  void await_resume() const noexcept {}
+};
+
+namespace detail {
+template <typename T>
+struct TaskPromise;
+// coroutine frames are recycled per thread, a lookup frame is allocated for every key
+class FramePool {
+ public:
+  static void* Allocate(size_t size) {
+    auto& pool = Local();
+    size_t bucket = (size + kAlign - 1) / kAlign;
+    if (bucket < kBuckets && nullptr != pool.free_[bucket]) {
+      Frame* frame = pool.free_[bucket];
+      pool.free_[bucket] = frame->next;
+      return frame;
+    }
+    return ::operator new(bucket < kBuckets ? bucket * kAlign : size);
+  }
+  static void Deallocate(void* p, size_t size) {
+    size_t bucket = (size + kAlign - 1) / kAlign;
+    if (bucket >= kBuckets) {
+      ::operator delete(p);
+      return;
+    }
+    auto& pool = Local();
+    Frame* frame = static_cast<Frame*>(p);
+    frame->next = pool.free_[bucket];
+    pool.free_[bucket] = frame;
+  }
+
+ private:
+  static constexpr size_t kAlign = 64;
+  static constexpr size_t kBuckets = 16;
+  struct Frame {
+    Frame* next;
+  };
+  ~FramePool() {
+    for (Frame* frame : free_) {
+      while (nullptr != frame) {
+        ::operator delete(std::exchange(frame, frame->next));
+      }
+    }
+  }
+  static FramePool& Local() {
+    thread_local FramePool pool;
+    return pool;
+  }
+  Frame* free_[kBuckets] = {};
+};
+
+template <typename P>
+struct TaskPromiseBase {
+  static void* operator new(size_t size) { return FramePool::Allocate(size); }
+  static void operator delete(void* p, size_t size) { FramePool::Deallocate(p, size); }
+  std::coroutine_handle<> continuation;
+  std::suspend_always initial_suspend() noexcept { return {}; }
+  auto final_suspend() noexcept {
+    struct FinalAwaiter {
+      bool await_ready() const noexcept { return false; }
+      std::coroutine_handle<> await_suspend(std::coroutine_handle<P> handle) const noexcept {
+        auto continuation = handle.promise().continuation;
+        return continuation ? continuation : std::noop_coroutine();
+      }
+      void await_resume() const noexcept {}
+    };
+    return FinalAwaiter{};
+  }
+  void unhandled_exception() { std::terminate(); }
+};
+template <typename T>
+struct TaskPromise : public TaskPromiseBase<TaskPromise<T>> {
+  std::optional<T> value;
+  Task<T> get_return_object() { return Task<T>(std::coroutine_handle<TaskPromise>::from_promise(*this)); }
+  template <typename U>
+  void return_value(U&& v) {
+    value.emplace(std::forward<U>(v));
+  }
+};
+template <>
+struct TaskPromise<void> : public TaskPromiseBase<TaskPromise<void>> {
+  Task<void> get_return_object();
+  void return_void() {}
+};
+}  // namespace detail
+
+/**
+ * Lazily started coroutine. Awaiting it runs it and resumes the awaiter once done, a top level task is run by
+ * 'Interleaver' and its result read by 'Result' afterwards.
+ */
+template <typename T>
+class Task {
+ public:
+  using promise_type = detail::TaskPromise<T>;
+  Task(Task&& other) noexcept : handle_(std::exchange(other.handle_, nullptr)) {}
+  Task& operator=(Task&& other) noexcept {
+    std::swap(handle_, other.handle_);
+    return *this;
+  }
+  Task(const Task&) = delete;
+  Task& operator=(const Task&) = delete;
+  ~Task() {
+    if (handle_) {
+      handle_.destroy();
+    }
+  }
+
+  bool await_ready() const noexcept { return false; }
+  std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiter) noexcept {
+    handle_.promise().continuation = awaiter;
+    return handle_;
+  }
+  T await_resume() {
+    if constexpr (!std::is_void_v<T>) {
+      return std::move(*handle_.promise().value);
+    }
+  }
+
+  bool Done() const { return handle_.done(); }
+  std::add_lvalue_reference_t<T> Result() { return *handle_.promise().value; }
+
+ private:
+  friend class Interleaver;
+  friend struct detail::TaskPromise<T>;
+  explicit Task(std::coroutine_handle<promise_type> handle) : handle_(handle) {}
+  std::coroutine_handle<promise_type> handle_;
+};
+
+namespace detail {
+inline Task<void> TaskPromise<void>::get_return_object() {
+  return Task<void>(std::coroutine_handle<TaskPromise>::from_promise(*this));
+}
+}  // namespace detail
+}  // namespace rdict
@@ -0,0 +1,121 @@
+/*
+** BSD 3-Clause License
+**
+** Copyright (c) 2023, qiyingwang <qiyingwang@tencent.com>, the respective contributors, as shown by the AUTHORS file.
+** All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions are met:
+** * Redistributions of source code must retain the above copyright notice, this
+** list of conditions and the following disclaimer.
+**
+** * Redistributions in binary form must reproduce the above copyright notice,
+** this list of conditions and the following disclaimer in the documentation
+** and/or other materials provided with the distribution.
+**
+** * Neither the name of the copyright holder nor the names of its
+** contributors may be used to endorse or promote products derived from
+** this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+** AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+** IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+** DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+** FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+** DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+** SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+** CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+** OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#include "rdict/cuckoo_index.h"
+#include <random>
+#include <utility>
+
+namespace rdict {
+namespace {
+// random walk length before the table is considered too small
+constexpr uint32_t kMaxKicks = 500;
+}  // namespace
+
+absl::StatusOr<uint8_t> CuckooIndex::Build(const std::vector<Entry>& entries, std::vector<Bucket>* buckets) {
+  for (const auto& entry : entries) {
+    if (entry.offset == 0 || entry.offset > kOffsetMask) {
+      return absl::OutOfRangeError("record offset exceeds the cuckoo index limit");
+    }
+  }
+  uint8_t bits = 1;
+  while (static_cast<float>(kSlots << bits) * kMaxLoadFactor < static_cast<float>(entries.size())) {
+    bits++;
+  }
+  for (; bits < 48; bits++) {
+    if (Fill(entries, bits, buckets)) {
+      return bits;
+    }
+  }
+  return absl::InternalError("failed to build cuckoo index");
+}
+
+uint8_t CuckooIndex::BuildFront(const std::vector<Entry>& entries, std::vector<Bucket>* buckets) {
+  // half loaded on average, so that few hot keys are dropped by full buckets
+  uint8_t bits = 1;
+  while ((kSlots << bits) / 2 < entries.size()) {
+    bits++;
+  }
+  buckets->assign(size_t{1} << bits, Bucket{});
+  for (const auto& entry : entries) {
+    if (entry.offset == 0 || entry.offset > kOffsetMask) {
+      continue;
+    }
+    for (uint64_t& slot : (*buckets)[First(entry.hash, bits)].slots) {
+      if (slot == 0) {
+        slot = Tag(entry.hash) | entry.offset;
+        break;
+      }
+    }
+  }
+  return bits;
+}
+
+bool CuckooIndex::Fill(const std::vector<Entry>& entries, uint8_t bits, std::vector<Bucket>* buckets) {
+  size_t num_buckets = size_t{1} << bits;
+  buckets->assign(num_buckets, Bucket{});
+  // hash of the entry in every slot, to find the alternative bucket of an evicted entry
+  std::vector<uint64_t> slot_hashes(num_buckets * kSlots);
+  std::mt19937_64 rng(bits);
+
+  auto try_place = [&](uint64_t bucket_idx, uint64_t hash, uint64_t slot) {
+    Bucket& bucket = (*buckets)[bucket_idx];
+    for (size_t i = 0; i < kSlots; i++) {
+      if (bucket.slots[i] == 0) {
+        bucket.slots[i] = slot;
+        slot_hashes[bucket_idx * kSlots + i] = hash;
+        return true;
+      }
+    }
+    return false;
+  };
+  for (const auto& entry : entries) {
+    uint64_t hash = entry.hash;
+    uint64_t slot = Tag(hash) | entry.offset;
+    uint64_t from = num_buckets;
+    for (uint32_t kicks = 0;; kicks++) {
+      uint64_t first = First(hash, bits);
+      uint64_t second = Second(hash, bits);
+      if (try_place(first, hash, slot) || try_place(second, hash, slot)) {
+        break;
+      }
+      if (kicks == kMaxKicks) {
+        return false;
+      }
+      // evict a random slot of the candidate the current entry was not just evicted from
+      uint64_t victim_bucket = first == from ? second : (second == from ? first : (rng() & 1 ? first : second));
+      size_t victim = victim_bucket * kSlots + rng() % kSlots;
+      std::swap(slot, (*buckets)[victim_bucket].slots[victim % kSlots]);
+      std::swap(hash, slot_hashes[victim]);
+      from = victim_bucket;
+    }
+  }
+  return true;
+}
+}  // namespace rdict
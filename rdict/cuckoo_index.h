@@ -0,0 +1,113 @@
+/*
+** BSD 3-Clause License
+**
+** Copyright (c) 2023, qiyingwang <qiyingwang@tencent.com>, the respective contributors, as shown by the AUTHORS file.
+** All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions are met:
+** * Redistributions of source code must retain the above copyright notice, this
+** list of conditions and the following disclaimer.
+**
+** * Redistributions in binary form must reproduce the above copyright notice,
+** this list of conditions and the following disclaimer in the documentation
+** and/or other materials provided with the distribution.
+**
+** * Neither the name of the copyright holder nor the names of its
+** contributors may be used to endorse or promote products derived from
+** this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+** AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+** IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+** DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+** FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+** DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+** SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+** CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+** OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "absl/status/statusor.h"
+
+namespace rdict {
+/**
+ * Bucketized cuckoo hash index over record offsets. Every key has two candidate 64 bytes buckets of 8 slots, so a
+ * lookup touches at most two cache lines of the index whatever the load. A slot packs a 16 bits fingerprint of the
+ * hash with the 48 bits record offset, 0 for empty.
+ * The table is built offline from the complete key set, the bucket count is a power of two.
+ */
+class CuckooIndex {
+ public:
+  static constexpr size_t kSlots = 8;
+  static constexpr uint64_t kOffsetMask = (uint64_t{1} << 48) - 1;
+  static constexpr float kMaxLoadFactor = 0.9F;
+  struct alignas(64) Bucket {
+    uint64_t slots[kSlots];
+  };
+  struct Entry {
+    uint64_t hash;
+    uint64_t offset;
+  };
+
+  /**
+   * Lays out 'entries' into 2^bits buckets, starting from the smallest table that fits with 'kMaxLoadFactor' and
+   * doubling it until every entry is placed. Returns the bits.
+   */
+  static absl::StatusOr<uint8_t> Build(const std::vector<Entry>& entries, std::vector<Bucket>* buckets);
+  /**
+   * Lays out a front table of hot keys with the same buckets, where every key has only its first candidate bucket.
+   * 'entries' are in descending hotness, the ones whose bucket is already full are dropped. Returns the bits.
+   */
+  static uint8_t BuildFront(const std::vector<Entry>& entries, std::vector<Bucket>* buckets);
+
+  static uint64_t First(uint64_t hash, uint8_t bits) { return hash >> (64 - bits); }
+  static uint64_t Second(uint64_t hash, uint8_t bits) {
+    uint64_t idx = (hash * UINT64_C(0x9E3779B97F4A7C15)) >> (64 - bits);
+    return idx == First(hash, bits) ? idx ^ 1 : idx;
+  }
+  // fingerprint in the upper 16 bits of a slot, never 0 so that empty slots never match
+  static uint64_t Tag(uint64_t hash) {
+    uint64_t fingerprint = hash & 0xFFFF;
+    return (fingerprint == 0 ? 1 : fingerprint) << 48;
+  }
+
+  /**
+   * Returns the record offset of the slot whose fingerprint matches 'hash' and for which 'match(offset)' is true,
+   * 0 if none.
+   */
+  template <typename Match>
+  static uint64_t Find(const Bucket* buckets, uint8_t bits, uint64_t hash, Match&& match) {
+    const Bucket* candidates[2] = {buckets + First(hash, bits), buckets + Second(hash, bits)};
+    __builtin_prefetch(candidates[1]);
+    uint64_t tag = Tag(hash);
+    for (const Bucket* bucket : candidates) {
+      for (uint64_t slot : bucket->slots) {
+        if ((slot & ~kOffsetMask) == tag && match(slot & kOffsetMask)) {
+          return slot & kOffsetMask;
+        }
+      }
+    }
+    return 0;
+  }
+  // single cache line probe of a front table
+  template <typename Match>
+  static uint64_t FindFront(const Bucket* buckets, uint8_t bits, uint64_t hash, Match&& match) {
+    uint64_t tag = Tag(hash);
+    for (uint64_t slot : buckets[First(hash, bits)].slots) {
+      if ((slot & ~kOffsetMask) == tag && match(slot & kOffsetMask)) {
+        return slot & kOffsetMask;
+      }
+    }
+    return 0;
+  }
+
+ private:
+  static bool Fill(const std::vector<Entry>& entries, uint8_t bits, std::vector<Bucket>* buckets);
+};
+}  // namespace rdict
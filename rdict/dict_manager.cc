@@ -0,0 +1,225 @@
+/*
+** BSD 3-Clause License
+**
+** Copyright (c) 2023, qiyingwang <qiyingwang@tencent.com>, the respective contributors, as shown by the AUTHORS file.
+** All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions are met:
+** * Redistributions of source code must retain the above copyright notice, this
+** list of conditions and the following disclaimer.
+**
+** * Redistributions in binary form must reproduce the above copyright notice,
+** this list of conditions and the following disclaimer in the documentation
+** and/or other materials provided with the distribution.
+**
+** * Neither the name of the copyright holder nor the names of its
+** contributors may be used to endorse or promote products derived from
+** this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+** AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+** IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+** DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+** FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+** DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+** SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+** CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+** OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#include "rdict/dict_manager.h"
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <algorithm>
+
+namespace rdict {
+namespace {
+// pages of every mincore call over a sampled region
+constexpr size_t kSampleRunPages = 16;
+}  // namespace
+
+absl::StatusOr<std::unique_ptr<DictManager>> DictManager::New(const Options& opts) {
+  std::unique_ptr<DictManager> p(new DictManager);
+  auto status = p->Init(opts);
+  if (!status.ok()) {
+    return status;
+  }
+  return p;
+}
+
+absl::Status DictManager::Init(const Options& opts) {
+  opts_ = opts;
+  long page_size = sysconf(_SC_PAGESIZE);
+  if (page_size > 0) {
+    page_size_ = static_cast<size_t>(page_size);
+  }
+  return absl::OkStatus();
+}
+
+DictManager::~DictManager() {
+  for (const Entry& entry : entries_) {
+    if (entry.status.index_locked) {
+      munlock(entry.index.addr, entry.index.size);
+    }
+  }
+}
+
+DictManager::Entry* DictManager::FindEntry(std::string_view name) {
+  for (Entry& entry : entries_) {
+    if (entry.status.name == name) {
+      return &entry;
+    }
+  }
+  return nullptr;
+}
+
+size_t DictManager::ResidentBytes(MemoryRegion region) const {
+  if (nullptr == region.addr || 0 == region.size) {
+    return 0;
+  }
+  // regions start inside page aligned mappings, the first page is the mapped page containing the start
+  uintptr_t start = reinterpret_cast<uintptr_t>(region.addr) & ~(page_size_ - 1);
+  size_t pages = (reinterpret_cast<uintptr_t>(region.addr) + region.size - start + page_size_ - 1) / page_size_;
+  size_t checked = 0;
+  size_t resident = 0;
+  std::vector<unsigned char> vec;
+  auto check = [&](size_t first, size_t n) {
+    vec.resize(n);
+    if (0 != mincore(reinterpret_cast<void*>(start + first * page_size_), n * page_size_, vec.data())) {
+      return;
+    }
+    checked += n;
+    for (unsigned char v : vec) {
+      resident += v & 1;
+    }
+  };
+  if (pages <= opts_.sample_pages) {
+    check(0, pages);
+  } else {
+    size_t runs = std::max<size_t>(1, opts_.sample_pages / kSampleRunPages);
+    size_t stride = pages / runs;
+    for (size_t i = 0; i < runs; i++) {
+      check(i * stride, std::min(kSampleRunPages, pages - i * stride));
+    }
+  }
+  if (0 == checked) {
+    return 0;
+  }
+  return std::min(region.size, resident * pages / checked * page_size_);
+}
+
+bool DictManager::Advise(MemoryRegion region) const {
+  // MADV_DONTNEED zeroes private anonymous pages and the page rounding reaches the neighbouring bytes, hugetlb pages
+  // are not reclaimable at all
+  if (!region.file_backed) {
+    return false;
+  }
+  uintptr_t start = reinterpret_cast<uintptr_t>(region.addr) & ~(page_size_ - 1);
+  size_t len = reinterpret_cast<uintptr_t>(region.addr) + region.size - start;
+  int advice = MADV_DONTNEED;
+#if defined(MADV_PAGEOUT) && defined(MADV_COLD)
+  advice = opts_.pageout ? MADV_PAGEOUT : MADV_COLD;
+#endif
+  // kernels before 5.4 reject MADV_PAGEOUT/MADV_COLD, dropping the mapped pages still lets them be reclaimed first
+  if (0 == madvise(reinterpret_cast<void*>(start), len, advice)) {
+    return true;
+  }
+  return advice != MADV_DONTNEED && 0 == madvise(reinterpret_cast<void*>(start), len, MADV_DONTNEED);
+}
+
+absl::Status DictManager::Register(std::string_view name, MemoryRegion index, MemoryRegion data, int priority) {
+  if (nullptr == index.addr && nullptr == data.addr) {
+    return absl::InvalidArgumentError("only readonly dicts can be registered");
+  }
+  std::lock_guard<std::mutex> guard(mutex_);
+  if (nullptr != FindEntry(name)) {
+    return absl::AlreadyExistsError("duplicate dict name:" + std::string(name));
+  }
+  Entry entry;
+  entry.status.name = std::string(name);
+  entry.status.priority = priority;
+  entry.status.index_bytes = index.size;
+  entry.status.data_bytes = data.size;
+  entry.index = index;
+  entry.data = data;
+  absl::Status status;
+  if (priority >= opts_.lock_index_priority && index.size > 0) {
+    if (0 == mlock(index.addr, index.size)) {
+      entry.status.index_locked = true;
+    } else {
+      status = absl::ResourceExhaustedError("lock index of dict:" + entry.status.name + " failed:" + strerror(errno));
+    }
+  }
+  entries_.emplace_back(std::move(entry));
+  return status;
+}
+
+absl::Status DictManager::Unregister(std::string_view name) {
+  std::lock_guard<std::mutex> guard(mutex_);
+  Entry* entry = FindEntry(name);
+  if (nullptr == entry) {
+    return absl::NotFoundError("no registered dict:" + std::string(name));
+  }
+  if (entry->status.index_locked) {
+    munlock(entry->index.addr, entry->index.size);
+  }
+  entries_.erase(entries_.begin() + (entry - entries_.data()));
+  return absl::OkStatus();
+}
+
+absl::Status DictManager::Enforce() {
+  std::lock_guard<std::mutex> guard(mutex_);
+  if (0 == opts_.memory_budget_bytes) {
+    return absl::OkStatus();
+  }
+  size_t total = 0;
+  std::vector<std::pair<size_t, size_t>> resident(entries_.size());
+  for (size_t i = 0; i < entries_.size(); i++) {
+    resident[i].first = ResidentBytes(entries_[i].data);
+    resident[i].second = entries_[i].status.index_locked ? 0 : ResidentBytes(entries_[i].index);
+    total += resident[i].first + (entries_[i].status.index_locked ? entries_[i].index.size : resident[i].second);
+  }
+  std::vector<size_t> order(entries_.size());
+  for (size_t i = 0; i < order.size(); i++) {
+    order[i] = i;
+  }
+  std::stable_sort(order.begin(), order.end(), [this](size_t a, size_t b) {
+    return entries_[a].status.priority < entries_[b].status.priority;
+  });
+  // data sections first, the indexes only if the data of all dicts is not enough
+  for (bool index_pass : {false, true}) {
+    for (size_t i : order) {
+      if (total <= opts_.memory_budget_bytes) {
+        return absl::OkStatus();
+      }
+      size_t bytes = index_pass ? resident[i].second : resident[i].first;
+      if (0 == bytes) {
+        continue;
+      }
+      if (!Advise(index_pass ? entries_[i].index : entries_[i].data)) {
+        continue;
+      }
+      entries_[i].status.evicted_bytes += bytes;
+      total -= bytes;
+    }
+  }
+  return absl::OkStatus();
+}
+
+std::vector<DictManager::DictStatus> DictManager::GetStatus() const {
+  std::lock_guard<std::mutex> guard(mutex_);
+  std::vector<DictStatus> statuses;
+  statuses.reserve(entries_.size());
+  for (const Entry& entry : entries_) {
+    DictStatus status = entry.status;
+    status.resident_index_bytes = status.index_locked ? entry.index.size : ResidentBytes(entry.index);
+    status.resident_data_bytes = ResidentBytes(entry.data);
+    statuses.emplace_back(std::move(status));
+  }
+  std::stable_sort(statuses.begin(), statuses.end(),
+                   [](const DictStatus& a, const DictStatus& b) { return a.priority > b.priority; });
+  return statuses;
+}
+}  // namespace rdict
@@ -0,0 +1,113 @@
+/*
+** BSD 3-Clause License
+**
+** Copyright (c) 2023, qiyingwang <qiyingwang@tencent.com>, the respective contributors, as shown by the AUTHORS file.
+** All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions are met:
+** * Redistributions of source code must retain the above copyright notice, this
+** list of conditions and the following disclaimer.
+**
+** * Redistributions in binary form must reproduce the above copyright notice,
+** this list of conditions and the following disclaimer in the documentation
+** and/or other materials provided with the distribution.
+**
+** * Neither the name of the copyright holder nor the names of its
+** contributors may be used to endorse or promote products derived from
+** this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+** AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+** IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+** DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+** FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+** DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+** SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+** CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+** OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#pragma once
+
+#include <climits>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "absl/status/statusor.h"
+#include "rdict/common.h"
+
+namespace rdict {
+/**
+ * Memory budget of the readonly dicts of a process. Registered dicts have a priority, higher is more important: the
+ * indexes of dicts at 'lock_index_priority' or above are locked in memory(mlock) at register, and Enforce advises the
+ * data sections, then the unlocked indexes, of the lowest priority dicts out of memory(MADV_PAGEOUT or MADV_COLD)
+ * until the sampled resident bytes of all dicts fit the budget, instead of leaving it to the page cache reclaim which
+ * is blind to the priorities. Anonymous copies(LOAD_ANONYMOUS) are never advised out, only file backed regions which
+ * are read back from the file. Dicts are registered by their mapped regions and must be unregistered before released.
+ */
+class DictManager {
+ public:
+  struct Options {
+    // resident bytes of all registered dicts to keep under by Enforce, 0 for no budget
+    size_t memory_budget_bytes = 0;
+    int lock_index_priority = INT_MAX;
+    // pages of a region checked with mincore, larger regions are sampled in runs and extrapolated
+    size_t sample_pages = 4096;
+    // reclaim advised pages at once with MADV_PAGEOUT, else MADV_COLD only makes them the first to be reclaimed
+    bool pageout = true;
+  };
+  struct DictStatus {
+    std::string name;
+    int priority = 0;
+    size_t index_bytes = 0;
+    size_t data_bytes = 0;
+    size_t resident_index_bytes = 0;
+    size_t resident_data_bytes = 0;
+    bool index_locked = false;
+    // resident bytes advised out by Enforce since registered
+    size_t evicted_bytes = 0;
+  };
+
+  static absl::StatusOr<std::unique_ptr<DictManager>> New(const Options& opts);
+  ~DictManager();
+
+  /**
+   * Register a loaded readonly dict(FbsKv, FbsList, ReadonlyKV, ReadonlySet, ...) under an unique name. An index
+   * which fails to lock(e.g. over RLIMIT_MEMLOCK) is registered unlocked and the error returned.
+   */
+  template <typename D>
+  absl::Status Register(std::string_view name, const D& dict, int priority) {
+    return Register(name, dict.IndexRegion(), dict.DataRegion(), priority);
+  }
+  absl::Status Register(std::string_view name, MemoryRegion index, MemoryRegion data, int priority);
+  absl::Status Unregister(std::string_view name);
+  // advise the lowest priority dicts out until the budget is met, to be called periodically
+  absl::Status Enforce();
+  // registered dicts in descending priority order with their sampled resident bytes
+  std::vector<DictStatus> GetStatus() const;
+  // sampled resident bytes of 'region'
+  size_t ResidentBytes(MemoryRegion region) const;
+
+ private:
+  struct Entry {
+    DictStatus status;
+    MemoryRegion index;
+    MemoryRegion data;
+  };
+
+  DictManager() {}
+  absl::Status Init(const Options& opts);
+  Entry* FindEntry(std::string_view name);
+  // false if 'region' is not advised out
+  bool Advise(MemoryRegion region) const;
+
+  Options opts_;
+  size_t page_size_ = 4096;
+  mutable std::mutex mutex_;
+  std::vector<Entry> entries_;
+};
+}  // namespace rdict
@@ -0,0 +1,272 @@
+/*
+** BSD 3-Clause License
+**
+** Copyright (c) 2023, qiyingwang <qiyingwang@tencent.com>, the respective contributors, as shown by the AUTHORS file.
+** All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions are met:
+** * Redistributions of source code must retain the above copyright notice, this
+** list of conditions and the following disclaimer.
+**
+** * Redistributions in binary form must reproduce the above copyright notice,
+** this list of conditions and the following disclaimer in the documentation
+** and/or other materials provided with the distribution.
+**
+** * Neither the name of the copyright holder nor the names of its
+** contributors may be used to endorse or promote products derived from
+** this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+** AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+** IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+** DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+** FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+** DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+** SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+** CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+** OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#include "rdict/embedding_kv.h"
+#include <algorithm>
+#include <cmath>
+#include <queue>
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
+#include "folly/Likely.h"
+
+namespace rdict {
+namespace embedding {
+namespace {
+inline float HalfToFloatScalar(uint16_t h) {
+  uint32_t sign = static_cast<uint32_t>(h & 0x8000) << 16;
+  uint32_t exp = (h >> 10) & 0x1F;
+  uint32_t mantissa = h & 0x3FF;
+  uint32_t bits;
+  if (exp == 0x1F) {
+    // NaNs are quieted like vcvtph2ps
+    bits = sign | 0x7F800000 | (mantissa << 13) | (mantissa != 0 ? 0x400000 : 0);
+  } else if (exp != 0) {
+    bits = sign | ((exp + 112) << 23) | (mantissa << 13);
+  } else if (mantissa == 0) {
+    bits = sign;
+  } else {
+    // subnormal, normalize the mantissa
+    exp = 113;
+    while ((mantissa & 0x400) == 0) {
+      mantissa <<= 1;
+      exp--;
+    }
+    bits = sign | (exp << 23) | ((mantissa & 0x3FF) << 13);
+  }
+  float f;
+  memcpy(&f, &bits, sizeof(f));
+  return f;
+}
+
+// round to nearest even like vcvtps2ph
+inline uint16_t FloatToHalfScalar(float f) {
+  uint32_t bits;
+  memcpy(&bits, &f, sizeof(bits));
+  uint16_t sign = (bits >> 16) & 0x8000;
+  uint32_t abs = bits & 0x7FFFFFFF;
+  if (abs >= 0x7F800000) {
+    return sign | 0x7C00 | (abs > 0x7F800000 ? 0x200 : 0);
+  }
+  if (abs >= 0x477FF000) {
+    // rounds to beyond the max half
+    return sign | 0x7C00;
+  }
+  if (abs < 0x38800000) {
+    // subnormal half, scale by 2^24 so the result is an integer in [0, 1024]
+    float v;
+    memcpy(&v, &abs, sizeof(v));
+    return sign | static_cast<uint16_t>(std::nearbyint(v * 16777216.0F));
+  }
+  uint32_t mantissa_odd = (abs >> 13) & 1;
+  abs += 0xC8000FFF + mantissa_odd;  // rebias exponent by -112 and round
+  return sign | static_cast<uint16_t>(abs >> 13);
+}
+
+struct ScoreGreater {
+  bool operator()(const ScoredRow& a, const ScoredRow& b) const {
+    return a.score > b.score || (a.score == b.score && a.row < b.row);
+  }
+};
+
+#if defined(__x86_64__)
+__attribute__((target("avx512f"))) float DotAvx512(const float* a, const float* b, size_t dim) {
+  __m512 acc0 = _mm512_setzero_ps();
+  __m512 acc1 = _mm512_setzero_ps();
+  size_t i = 0;
+  for (; i + 32 <= dim; i += 32) {
+    acc0 = _mm512_fmadd_ps(_mm512_loadu_ps(a + i), _mm512_loadu_ps(b + i), acc0);
+    acc1 = _mm512_fmadd_ps(_mm512_loadu_ps(a + i + 16), _mm512_loadu_ps(b + i + 16), acc1);
+  }
+  for (; i < dim; i += 16) {
+    __mmask16 mask = dim - i >= 16 ? 0xFFFF : static_cast<__mmask16>((1U << (dim - i)) - 1);
+    acc0 = _mm512_fmadd_ps(_mm512_maskz_loadu_ps(mask, a + i), _mm512_maskz_loadu_ps(mask, b + i), acc0);
+  }
+  return _mm512_reduce_add_ps(_mm512_add_ps(acc0, acc1));
+}
+
+__attribute__((target("avx2,fma"))) float DotAvx2(const float* a, const float* b, size_t dim) {
+  __m256 acc0 = _mm256_setzero_ps();
+  __m256 acc1 = _mm256_setzero_ps();
+  size_t i = 0;
+  for (; i + 16 <= dim; i += 16) {
+    acc0 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i), acc0);
+    acc1 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i + 8), _mm256_loadu_ps(b + i + 8), acc1);
+  }
+  for (; i + 8 <= dim; i += 8) {
+    acc0 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i), acc0);
+  }
+  __m256 acc = _mm256_add_ps(acc0, acc1);
+  __m128 sum = _mm_add_ps(_mm256_castps256_ps128(acc), _mm256_extractf128_ps(acc, 1));
+  sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+  sum = _mm_add_ss(sum, _mm_movehdup_ps(sum));
+  float result = _mm_cvtss_f32(sum);
+  for (; i < dim; i++) {
+    result += a[i] * b[i];
+  }
+  return result;
+}
+
+__attribute__((target("avx2,f16c"))) void HalfToFloatF16c(const uint16_t* half, size_t dim, float* out) {
+  size_t i = 0;
+  for (; i + 8 <= dim; i += 8) {
+    _mm256_storeu_ps(out + i, _mm256_cvtph_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(half + i))));
+  }
+  for (; i < dim; i++) {
+    out[i] = HalfToFloatScalar(half[i]);
+  }
+}
+
+__attribute__((target("avx2"))) void DequantizeInt8Avx2(const int8_t* q, float scale, size_t dim, float* out) {
+  __m256 vscale = _mm256_set1_ps(scale);
+  size_t i = 0;
+  for (; i + 8 <= dim; i += 8) {
+    __m256i v = _mm256_cvtepi8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(q + i)));
+    _mm256_storeu_ps(out + i, _mm256_mul_ps(_mm256_cvtepi32_ps(v), vscale));
+  }
+  for (; i < dim; i++) {
+    out[i] = static_cast<float>(q[i]) * scale;
+  }
+}
+
+const bool kHasAvx512 = (__builtin_cpu_init(), __builtin_cpu_supports("avx512f"));
+const bool kHasAvx2 = (__builtin_cpu_init(), __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"));
+const bool kHasF16c = (__builtin_cpu_init(), __builtin_cpu_supports("avx2") && __builtin_cpu_supports("f16c"));
+#else
+const bool kHasAvx512 = false;
+const bool kHasAvx2 = false;
+const bool kHasF16c = false;
+#endif
+}  // namespace
+
+float PortableDot(const float* a, const float* b, size_t dim) {
+  float result = 0;
+  for (size_t i = 0; i < dim; i++) {
+    result += a[i] * b[i];
+  }
+  return result;
+}
+
+float Dot(const float* a, const float* b, size_t dim) {
+#if defined(__x86_64__)
+  if (kHasAvx512) {
+    return DotAvx512(a, b, dim);
+  }
+  if (FOLLY_LIKELY(kHasAvx2)) {
+    return DotAvx2(a, b, dim);
+  }
+#endif
+  return PortableDot(a, b, dim);
+}
+
+void Score(const float* query, const float* rows, size_t n, size_t dim, float* scores) {
+  for (size_t i = 0; i < n; i++) {
+    scores[i] = Dot(query, rows + i * dim, dim);
+  }
+}
+
+void TopK(const float* query, const float* rows, size_t n, size_t dim, size_t k, std::vector<ScoredRow>* top) {
+  top->clear();
+  if (k == 0) {
+    return;
+  }
+  // min heap of the best k so far, top() is the worst of them
+  std::priority_queue<ScoredRow, std::vector<ScoredRow>, ScoreGreater> heap;
+  for (size_t i = 0; i < n; i++) {
+    ScoredRow scored{static_cast<uint32_t>(i), Dot(query, rows + i * dim, dim)};
+    if (heap.size() < k) {
+      heap.push(scored);
+    } else if (ScoreGreater()(scored, heap.top())) {
+      heap.pop();
+      heap.push(scored);
+    }
+  }
+  top->resize(heap.size());
+  for (size_t i = heap.size(); i > 0; i--) {
+    (*top)[i - 1] = heap.top();
+    heap.pop();
+  }
+}
+
+void PortableHalfToFloat(const uint16_t* half, size_t dim, float* out) {
+  for (size_t i = 0; i < dim; i++) {
+    out[i] = HalfToFloatScalar(half[i]);
+  }
+}
+
+void HalfToFloat(const uint16_t* half, size_t dim, float* out) {
+#if defined(__x86_64__)
+  if (FOLLY_LIKELY(kHasF16c)) {
+    HalfToFloatF16c(half, dim, out);
+    return;
+  }
+#endif
+  PortableHalfToFloat(half, dim, out);
+}
+
+void FloatToHalf(const float* in, size_t dim, uint16_t* half) {
+  for (size_t i = 0; i < dim; i++) {
+    half[i] = FloatToHalfScalar(in[i]);
+  }
+}
+
+void PortableDequantizeInt8(const int8_t* q, float scale, size_t dim, float* out) {
+  for (size_t i = 0; i < dim; i++) {
+    out[i] = static_cast<float>(q[i]) * scale;
+  }
+}
+
+void DequantizeInt8(const int8_t* q, float scale, size_t dim, float* out) {
+#if defined(__x86_64__)
+  if (FOLLY_LIKELY(kHasAvx2)) {
+    DequantizeInt8Avx2(q, scale, dim, out);
+    return;
+  }
+#endif
+  PortableDequantizeInt8(q, scale, dim, out);
+}
+
+float QuantizeInt8(const float* in, size_t dim, int8_t* q) {
+  float max_abs = 0;
+  for (size_t i = 0; i < dim; i++) {
+    max_abs = std::max(max_abs, std::fabs(in[i]));
+  }
+  float scale = max_abs / 127.0F;
+  float inv = scale > 0 ? 1.0F / scale : 0;
+  for (size_t i = 0; i < dim; i++) {
+    q[i] = static_cast<int8_t>(std::clamp(std::nearbyint(in[i] * inv), -127.0F, 127.0F));
+  }
+  return scale;
+}
+
+bool HardwareAccelerated() { return kHasAvx2 || kHasAvx512; }
+}  // namespace embedding
+}  // namespace rdict
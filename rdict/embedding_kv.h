@@ -0,0 +1,301 @@
+/*
+** BSD 3-Clause License
+**
+** Copyright (c) 2023, qiyingwang <qiyingwang@tencent.com>, the respective contributors, as shown by the AUTHORS file.
+** All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions are met:
+** * Redistributions of source code must retain the above copyright notice, this
+** list of conditions and the following disclaimer.
+**
+** * Redistributions in binary form must reproduce the above copyright notice,
+** this list of conditions and the following disclaimer in the documentation
+** and/or other materials provided with the distribution.
+**
+** * Neither the name of the copyright holder nor the names of its
+** contributors may be used to endorse or promote products derived from
+** this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+** AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+** IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+** DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+** FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+** DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+** SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+** CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+** OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/status/statusor.h"
+#include "rdict/kv.h"
+
+namespace rdict {
+enum EmbeddingQuantization : uint8_t {
+  EMBEDDING_FP32 = 0,
+  // IEEE half floats
+  EMBEDDING_FP16,
+  // symmetric int8 with a float scale per row, max(|x|) / 127
+  EMBEDDING_INT8,
+};
+
+namespace embedding {
+/**
+ * Kernels of embedding rows, AVX-512/AVX2 when the cpu supports them. Dot products of the vectorized versions sum in
+ * a different order than the portable ones, conversions return the same values.
+ */
+float Dot(const float* a, const float* b, size_t dim);
+float PortableDot(const float* a, const float* b, size_t dim);
+// 'scores'[i] = Dot('query', row i of the n x dim row major 'rows')
+void Score(const float* query, const float* rows, size_t n, size_t dim, float* scores);
+struct ScoredRow {
+  uint32_t row;
+  float score;
+};
+// the 'k' best scored rows in descending score order
+void TopK(const float* query, const float* rows, size_t n, size_t dim, size_t k, std::vector<ScoredRow>* top);
+void HalfToFloat(const uint16_t* half, size_t dim, float* out);
+void PortableHalfToFloat(const uint16_t* half, size_t dim, float* out);
+void FloatToHalf(const float* in, size_t dim, uint16_t* half);
+void DequantizeInt8(const int8_t* q, float scale, size_t dim, float* out);
+void PortableDequantizeInt8(const int8_t* q, float scale, size_t dim, float* out);
+// returns the scale
+float QuantizeInt8(const float* in, size_t dim, int8_t* q);
+bool HardwareAccelerated();
+}  // namespace embedding
+
+/**
+ * id -> fixed dimension float vector dict. Rows are stored in the data section at 64 bytes boundaries of the file,
+ * as fp32, fp16 or int8 with a per row scale, and the flat robin hood index maps keys to row offsets. Only for flat
+ * (small trivially copyable) keys, the data section holds nothing but rows.
+ */
+template <typename K, typename HashFn = hash<K>>
+class ReadonlyEmbeddingKV : public ReadonlyKV<K, uint64_t, HashFn> {
+  static_assert(detail::is_flat_kv_v<K, uint64_t>, "embedding dicts need flat keys");
+
+ public:
+  using Base = ReadonlyKV<K, uint64_t, HashFn>;
+  struct Options : public Base::Options {
+    // row format of a new file, 0 'dim' takes the one of an existing file
+    uint32_t dim = 0;
+    EmbeddingQuantization quantization = EMBEDDING_FP32;
+  };
+  static constexpr size_t k_row_align = 64;
+
+  static absl::StatusOr<std::unique_ptr<ReadonlyEmbeddingKV>> New(const Options& opts) {
+    std::unique_ptr<ReadonlyEmbeddingKV> p(new ReadonlyEmbeddingKV);
+    auto status = p->Init(opts);
+    if (!status.ok()) {
+      return status;
+    }
+    return p;
+  }
+  static absl::StatusOr<std::unique_ptr<ReadonlyEmbeddingKV>> Load(const std::string& path) {
+    Options opts;
+    opts.path = path;
+    return Load(opts);
+  }
+  static absl::StatusOr<std::unique_ptr<ReadonlyEmbeddingKV>> Load(const Options& options) {
+    Options opts = options;
+    opts.readonly = true;
+    return New(opts);
+  }
+
+  uint32_t Dim() const { return meta_.dim; }
+  EmbeddingQuantization Quantization() const { return static_cast<EmbeddingQuantization>(meta_.quantization); }
+  // stored bytes of a row
+  size_t RowBytes() const { return meta_.row_bytes; }
+  // 'embedding' of Dim() floats, a duplicated key is pointed to the new row
+  absl::Status Put(const K& key, const float* embedding);
+  absl::Status Put(const K& key, const std::vector<float>& embedding) {
+    if (embedding.size() != meta_.dim) {
+      return absl::InvalidArgumentError("embedding size mismatch with dict dim");
+    }
+    return Put(key, embedding.data());
+  }
+  // dequantized row of 'key' into 'out' of Dim() floats
+  bool Find(const K& key, float* out) const {
+    uint64_t offset = 0;
+    if (!Base::Find(key, &offset)) {
+      return false;
+    }
+    DecodeRow(this->LocalData() + offset, out);
+    return true;
+  }
+  /**
+   * Dequantized rows of 'keys' into the n x Dim() row major 'out', with the index probes and row loads of a batch
+   * overlapped. Rows of missing keys are zero filled and 'found'(if not null) of them false, returns the number found.
+   */
+  size_t Gather(const K* keys, size_t n, float* out, bool* found = nullptr) const;
+
+ protected:
+  static constexpr uint32_t k_embedding_magic = 0xE3BEDD16;
+  static constexpr size_t k_gather_batch = 16;
+  // first 64 bytes of the data section
+  struct EmbeddingMeta {
+    uint32_t magic = k_embedding_magic;
+    uint32_t dim = 0;
+    uint32_t row_bytes = 0;
+    uint8_t quantization = EMBEDDING_FP32;
+    uint8_t reserved[k_row_align - 13] = {};
+  };
+  static_assert(sizeof(EmbeddingMeta) == k_row_align);
+
+  ReadonlyEmbeddingKV() {}
+  absl::Status Init(const Options& opts);
+  void DecodeRow(const uint8_t* row, float* out) const;
+  // int8 rows keep the scale after the values at a 4 bytes boundary
+  static size_t Int8ScaleOffset(uint32_t dim) { return (dim + 3) & ~size_t{3}; }
+
+  // records are row offsets, rewriting or merging the data section would invalidate them
+  using Base::BulkAdd;
+  using Base::BulkBuild;
+  using Base::BulkFinish;
+  using Base::Get;
+  using Base::Merge;
+  using Base::ReorderData;
+
+  EmbeddingMeta meta_;
+};
+
+template <typename K, typename H>
+absl::Status ReadonlyEmbeddingKV<K, H>::Init(const Options& opts) {
+  auto status = Base::Init(opts);
+  if (!status.ok()) {
+    return status;
+  }
+  MmapFile* file = this->data_mmap_file_.get();
+  if (!opts.readonly && file->GetWriteOffset() == detail::kRdictMetaHeaderSize) {
+    if (opts.dim == 0 || opts.quantization > EMBEDDING_INT8) {
+      return absl::InvalidArgumentError("invalid embedding dim or quantization");
+    }
+    meta_.dim = opts.dim;
+    meta_.quantization = opts.quantization;
+    size_t row_bytes = opts.dim * sizeof(float);
+    if (opts.quantization == EMBEDDING_FP16) {
+      row_bytes = opts.dim * sizeof(uint16_t);
+    } else if (opts.quantization == EMBEDDING_INT8) {
+      row_bytes = Int8ScaleOffset(opts.dim) + sizeof(float);
+    }
+    meta_.row_bytes = (row_bytes + k_row_align - 1) & ~(k_row_align - 1);
+    auto result = file->Add(&meta_, sizeof(meta_));
+    if (!result.ok()) {
+      return result.status();
+    }
+    return absl::OkStatus();
+  }
+  if (file->GetWriteOffset() < detail::kRdictMetaHeaderSize + sizeof(EmbeddingMeta)) {
+    return absl::InvalidArgumentError("not an embedding dict");
+  }
+  memcpy(&meta_, file->GetRawData() + detail::kRdictMetaHeaderSize, sizeof(meta_));
+  if (meta_.magic != k_embedding_magic || meta_.dim == 0 || meta_.row_bytes % k_row_align != 0) {
+    return absl::InvalidArgumentError("not an embedding dict");
+  }
+  if (opts.dim != 0 && (opts.dim != meta_.dim || opts.quantization != meta_.quantization)) {
+    return absl::InvalidArgumentError("embedding dim or quantization mismatch with the dict file");
+  }
+  return absl::OkStatus();
+}
+
+template <typename K, typename H>
+absl::Status ReadonlyEmbeddingKV<K, H>::Put(const K& key, const float* embedding) {
+  if (this->opt_.readonly) {
+    return absl::PermissionDeniedError("Unable to put into readonly rdict");
+  }
+  MmapFile* file = this->data_mmap_file_.get();
+  auto result = file->Reserve(meta_.row_bytes);
+  if (!result.ok()) {
+    return result.status();
+  }
+  uint8_t* row = result.value();
+  memset(row, 0, meta_.row_bytes);
+  switch (meta_.quantization) {
+    case EMBEDDING_FP16: {
+      std::vector<uint16_t> half(meta_.dim);
+      embedding::FloatToHalf(embedding, meta_.dim, half.data());
+      memcpy(row, half.data(), meta_.dim * sizeof(uint16_t));
+      break;
+    }
+    case EMBEDDING_INT8: {
+      float scale = embedding::QuantizeInt8(embedding, meta_.dim, reinterpret_cast<int8_t*>(row));
+      memcpy(row + Int8ScaleOffset(meta_.dim), &scale, sizeof(float));
+      break;
+    }
+    default: {
+      memcpy(row, embedding, meta_.dim * sizeof(float));
+      break;
+    }
+  }
+  uint64_t offset = file->Commit(meta_.row_bytes);
+  return Base::Put(key, offset);
+}
+
+template <typename K, typename H>
+void ReadonlyEmbeddingKV<K, H>::DecodeRow(const uint8_t* row, float* out) const {
+  switch (meta_.quantization) {
+    case EMBEDDING_FP16: {
+      embedding::HalfToFloat(reinterpret_cast<const uint16_t*>(row), meta_.dim, out);
+      break;
+    }
+    case EMBEDDING_INT8: {
+      float scale;
+      memcpy(&scale, row + Int8ScaleOffset(meta_.dim), sizeof(float));
+      embedding::DequantizeInt8(reinterpret_cast<const int8_t*>(row), scale, meta_.dim, out);
+      break;
+    }
+    default: {
+      memcpy(out, row, meta_.dim * sizeof(float));
+      break;
+    }
+  }
+}
+
+template <typename K, typename H>
+size_t ReadonlyEmbeddingKV<K, H>::Gather(const K* keys, size_t n, float* out, bool* found) const {
+  using Lookup = typename Base::Lookup;
+  const uint8_t* data = this->LocalData();
+  size_t hits = 0;
+  std::vector<Lookup> lookups;
+  lookups.reserve(k_gather_batch);
+  for (size_t begin = 0; begin < n; begin += k_gather_batch) {
+    size_t end = std::min(n, begin + k_gather_batch);
+    lookups.clear();
+    for (size_t i = begin; i < end; i++) {
+      lookups.emplace_back(typename Base::hashed_key_type(keys[i]));
+      this->StartLookup(&lookups.back());
+    }
+    for (auto& lookup : lookups) {
+      while (!this->StepLookup(&lookup)) {
+      }
+      if (lookup.found) {
+        for (size_t line = 0; line < meta_.row_bytes; line += k_row_align) {
+          __builtin_prefetch(data + lookup.value + line);
+        }
+      }
+    }
+    for (size_t i = begin; i < end; i++) {
+      const Lookup* lookup = &lookups[i - begin];
+      float* row_out = out + i * meta_.dim;
+      if (lookup->found) {
+        DecodeRow(data + lookup->value, row_out);
+        hits++;
+      } else {
+        memset(row_out, 0, meta_.dim * sizeof(float));
+      }
+      if (nullptr != found) {
+        found[i] = lookup->found;
+      }
+    }
+  }
+  return hits;
+}
+}  // namespace rdict
@@ -29,10 +29,15 @@
 ** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 */
 #include "rdict/fbs_builder.h"
+#include <cstring>
+#include <fstream>
 #include <string_view>
+#include <type_traits>
+#include "absl/strings/string_view.h"
 #include "folly/FileUtil.h"
 #include "rdict/kv.h"
 #include "rdict/list.h"
+#include "rdict/set.h"
 namespace rdict {
 absl::StatusOr<std::unique_ptr<FbsDictBuilder>> FbsDictBuilder::New(const std::string& schema_path,
                                                                     const std::string& output_path,
@@ -45,21 +50,132 @@ absl::StatusOr<std::unique_ptr<FbsDictBuilder>> FbsDictBuilder::New(const std::s
   return p;
 }
 
-template <typename T>
+template <typename D>
 static absl::StatusOr<void*> new_kv_dict(const std::string& output_path, const FbsDictBuilder::Options& opts) {
-  typename rdict::ReadonlyKV<T, std::string_view>::Options dict_opt;
+  typename D::Options dict_opt;
   dict_opt.path = output_path;
   dict_opt.readonly = false;
+  dict_opt.atomic_publish = true;
+  dict_opt.index_type = opts.cuckoo_index ? detail::INDEX_CUCKOO : detail::INDEX_ROBIN_HOOD;
   dict_opt.reserved_space_bytes = opts.reserved_space_bytes;
-  dict_opt.bucket_count = static_cast<size_t>(opts.max_elements * 1.0 / dict_opt.max_load_factor);
-  auto result = rdict::ReadonlyKV<T, std::string_view>::New(dict_opt);
+  dict_opt.bulk_build_threads = opts.bulk_build_threads;
+  // reserved as records, the load factor is applied by the dict
+  dict_opt.bucket_count = opts.max_elements;
+  auto result = D::New(dict_opt);
   if (!result.ok()) {
     return result.status();
   }
   return result.value().release();
 }
 
+template <typename T>
+static absl::Status add_kv_record(rdict::ReadonlyKV<T, std::string_view>* dict, const T& key,
+                                  std::string_view content, bool bulk) {
+  return bulk ? dict->BulkAdd(key, content) : dict->Put(key, content);
+}
+
+template <typename T>
+static absl::Status add_kv_record(rdict::ReadonlySet<T>* dict, const T& key, std::string_view content, bool bulk) {
+  return bulk ? dict->BulkAdd(key) : dict->Insert(key);
+}
+
+template <typename T>
+static uint64_t get_key_frequency(const absl::flat_hash_map<std::string, uint64_t>& key_frequency, const T& key) {
+  absl::flat_hash_map<std::string, uint64_t>::const_iterator found;
+  if constexpr (std::is_same_v<T, std::string_view>) {
+    found = key_frequency.find(absl::string_view(key.data(), key.size()));
+  } else {
+    found = key_frequency.find(std::to_string(key));
+  }
+  return found == key_frequency.end() ? 0 : found->second;
+}
+
+template <typename F>
+absl::Status FbsDictBuilder::VisitKvDict(F&& f) {
+  switch (key_reflection_field_->type()->base_type()) {
+    case reflection::BaseType::String: {
+      if (opts_.key_set) {
+        return f(reinterpret_cast<rdict::ReadonlySet<std::string_view>*>(dict_));
+      }
+      return f(reinterpret_cast<rdict::ReadonlyKV<std::string_view, std::string_view>*>(dict_));
+    }
+    case reflection::BaseType::ULong: {
+      if (opts_.key_set) {
+        return f(reinterpret_cast<rdict::ReadonlySet<uint64_t>*>(dict_));
+      }
+      return f(reinterpret_cast<rdict::ReadonlyKV<uint64_t, std::string_view>*>(dict_));
+    }
+    case reflection::BaseType::UInt: {
+      if (opts_.key_set) {
+        return f(reinterpret_cast<rdict::ReadonlySet<uint32_t>*>(dict_));
+      }
+      return f(reinterpret_cast<rdict::ReadonlyKV<uint32_t, std::string_view>*>(dict_));
+    }
+    case reflection::BaseType::Long: {
+      if (opts_.key_set) {
+        return f(reinterpret_cast<rdict::ReadonlySet<int64_t>*>(dict_));
+      }
+      return f(reinterpret_cast<rdict::ReadonlyKV<int64_t, std::string_view>*>(dict_));
+    }
+    case reflection::BaseType::Int: {
+      if (opts_.key_set) {
+        return f(reinterpret_cast<rdict::ReadonlySet<int32_t>*>(dict_));
+      }
+      return f(reinterpret_cast<rdict::ReadonlyKV<int32_t, std::string_view>*>(dict_));
+    }
+    default: {
+      return absl::InvalidArgumentError("Unsupported 'key' field type.");
+    }
+  }
+}
+
+absl::Status FbsDictBuilder::LoadKeyFrequency(const std::string& path) {
+  std::ifstream file(path.c_str());
+  if (!file.is_open()) {
+    return absl::InvalidArgumentError("invalid key frequency file path:" + path);
+  }
+  std::string line;
+  while (std::getline(file, line)) {
+    size_t pos = line.find_last_of("\t ");
+    if (pos == std::string::npos || pos == 0) {
+      continue;
+    }
+    char* end = nullptr;
+    uint64_t count = strtoull(line.c_str() + pos + 1, &end, 10);
+    if (end == line.c_str() + pos + 1) {
+      continue;
+    }
+    key_frequency_[line.substr(0, pos)] += count;
+  }
+  return absl::OkStatus();
+}
+
+void FbsDictBuilder::FillHotnessReport(const std::vector<std::pair<uint64_t, uint64_t>>& layout) {
+  uint64_t total = 0;
+  for (const auto& [hotness, end_offset] : layout) {
+    total += hotness;
+    if (hotness > 0) {
+      report_.hot_keys++;
+    }
+  }
+  report_.coverage = opts_.report_coverage;
+  report_.data_bytes = layout.empty() ? 0 : layout.back().second - detail::kRdictMetaHeaderSize;
+  double target = total * opts_.report_coverage;
+  uint64_t covered = 0;
+  uint64_t resident_end = detail::kRdictMetaHeaderSize;
+  for (const auto& [hotness, end_offset] : layout) {
+    if (hotness == 0 || covered >= target) {
+      break;
+    }
+    covered += hotness;
+    resident_end = end_offset;
+  }
+  constexpr uint64_t kPageSize = 4096;
+  report_.resident_bytes = (resident_end + kPageSize - 1) / kPageSize * kPageSize;
+}
+
 absl::Status FbsDictBuilder::Init(const std::string& schema_path, const std::string& output_path, const Options& opts) {
+  opts_ = opts;
   std::string fbs_schema;
   if (!folly::readFile(schema_path.c_str(), fbs_schema)) {
     return absl::InvalidArgumentError("invalid flatbuffers schema path");
@@ -84,154 +200,259 @@ absl::Status FbsDictBuilder::Init(const std::string& schema_path, const std::str
       key_reflection_field_ = field;
     }
   }
+  if (opts.simdjson_ingest) {
+    auto encoder = FbsJsonEncoder::New(parser_, reflection_schema_);
+    // schemas the encoder can not reproduce are built with the parser only
+    if (encoder.ok()) {
+      json_encoder_ = std::move(encoder.value());
+      report_.simdjson_ingest = true;
+    }
+  }
+  if (!opts.columns.empty()) {
+    auto encoder = FbsRowEncoder::New(parser_, reflection_schema_, opts.columns);
+    if (!encoder.ok()) {
+      return encoder.status();
+    }
+    row_encoder_ = std::move(encoder.value());
+  }
+  if (!opts.key_frequency_path.empty()) {
+    auto status = LoadKeyFrequency(opts.key_frequency_path);
+    if (!status.ok()) {
+      return status;
+    }
+  }
   if (nullptr == key_reflection_field_) {
     rdict::ReadonlyList::Options dict_opt;
     dict_opt.path = output_path;
     dict_opt.readonly = false;
+    dict_opt.atomic_publish = true;
     dict_opt.reserved_space_bytes = opts.reserved_space_bytes;
     auto result = rdict::ReadonlyList::New(dict_opt);
     if (!result.ok()) {
       return result.status();
     }
     dict_ = result.value().release();
-  } else {
-    switch (key_reflection_field_->type()->base_type()) {
-      case reflection::BaseType::String: {
-        auto result = new_kv_dict<std::string_view>(output_path, opts);
-        if (!result.ok()) {
-          return result.status();
-        }
-        dict_ = result.value();
-        break;
-      }
-      case reflection::BaseType::ULong: {
-        auto result = new_kv_dict<uint64_t>(output_path, opts);
-        if (!result.ok()) {
-          return result.status();
-        }
-        dict_ = result.value();
-        break;
-      }
-      case reflection::BaseType::UInt: {
-        auto result = new_kv_dict<uint32_t>(output_path, opts);
-        if (!result.ok()) {
-          return result.status();
-        }
-        dict_ = result.value();
-      }
-      case reflection::BaseType::Long: {
-        auto result = new_kv_dict<int64_t>(output_path, opts);
-        if (!result.ok()) {
-          return result.status();
+    return absl::OkStatus();
+  }
+  return VisitKvDict([&](auto* dict) -> absl::Status {
+    auto result = new_kv_dict<std::remove_pointer_t<decltype(dict)>>(output_path, opts);
+    if (!result.ok()) {
+      return result.status();
+    }
+    dict_ = result.value();
+    return absl::OkStatus();
+  });
+}
+
+absl::Status FbsDictBuilder::Add(std::string_view json) {
+  if (json_encoder_) {
+    auto result = json_encoder_->Encode(json);
+    if (result.ok()) {
+      return AddContent(result.value());
+    }
+    report_.parser_fallbacks++;
+  }
+  json_buffer_.assign(json.data(), json.size());
+  if (!parser_.ParseJson(json_buffer_.c_str())) {
+    return absl::InvalidArgumentError("Invalid json to parse");
+  }
+  return AddContent(std::string_view(reinterpret_cast<const char*>(parser_.builder_.GetBufferPointer()),
+                                     parser_.builder_.GetSize()));
+}
+
+uint8_t* FbsDictBuilder::AlignedCopy(std::string_view buf) {
+  flatbuffer_buffer_.resize((buf.size() + sizeof(uint64_t) - 1) / sizeof(uint64_t));
+  uint8_t* data = reinterpret_cast<uint8_t*>(flatbuffer_buffer_.data());
+  memcpy(data, buf.data(), buf.size());
+  return data;
+}
+
+absl::Status FbsDictBuilder::AddAlignedFlatbuffer(std::string_view buf) {
+  if (opts_.verify_flatbuffer &&
+      !flatbuffers::Verify(*reflection_schema_, *reflection_schema_->root_table(),
+                           reinterpret_cast<const uint8_t*>(buf.data()), buf.size())) {
+    return absl::InvalidArgumentError("Invalid flatbuffer of root table");
+  }
+  return AddContent(buf);
+}
+
+absl::Status FbsDictBuilder::AddFlatbuffer(std::string_view buf) {
+  if (buf.size() < sizeof(flatbuffers::uoffset_t)) {
+    return absl::InvalidArgumentError("Too small flatbuffer");
+  }
+  if (reinterpret_cast<uintptr_t>(buf.data()) % sizeof(uint64_t) != 0) {
+    buf = std::string_view(reinterpret_cast<const char*>(AlignedCopy(buf)), buf.size());
+  }
+  return AddAlignedFlatbuffer(buf);
+}
+
+absl::Status FbsDictBuilder::AddSizePrefixedFlatbuffer(std::string_view buf) {
+  constexpr size_t kPrefixSize = sizeof(flatbuffers::uoffset_t);
+  if (buf.size() < 2 * kPrefixSize) {
+    return absl::InvalidArgumentError("Too small flatbuffer");
+  }
+  if (flatbuffers::ReadScalar<flatbuffers::uoffset_t>(buf.data()) != buf.size() - kPrefixSize) {
+    return absl::InvalidArgumentError("Mismatch flatbuffer size prefix");
+  }
+  uint8_t* data = AlignedCopy(buf);
+  // the root offset is relative to the end of the prefix, rebase it to the buffer start so that the prefix becomes
+  // the root offset and the old one padding, all other offsets are relative and stay valid
+  flatbuffers::uoffset_t root = flatbuffers::ReadScalar<flatbuffers::uoffset_t>(data + kPrefixSize);
+  if (root > buf.size() - kPrefixSize) {
+    return absl::InvalidArgumentError("Invalid flatbuffer of root table");
+  }
+  flatbuffers::WriteScalar<flatbuffers::uoffset_t>(data, root + kPrefixSize);
+  return AddAlignedFlatbuffer(std::string_view(reinterpret_cast<const char*>(data), buf.size()));
+}
+
+static void split_row(std::string_view line, char delimiter, std::vector<std::string_view>* columns,
+                      std::string* buffer) {
+  columns->clear();
+  buffer->clear();
+  // unquoted columns never exceed the line, so views into buffer stay valid
+  buffer->reserve(line.size());
+  size_t pos = 0;
+  while (true) {
+    if (delimiter == ',' && pos < line.size() && line[pos] == '"') {
+      // quoted csv column, "" is an escaped quote
+      size_t begin = buffer->size();
+      pos++;
+      while (pos < line.size()) {
+        if (line[pos] == '"') {
+          if (pos + 1 < line.size() && line[pos + 1] == '"') {
+            buffer->push_back('"');
+            pos += 2;
+            continue;
+          }
+          pos++;
+          break;
         }
-        dict_ = result.value();
-        break;
+        buffer->push_back(line[pos++]);
       }
-      case reflection::BaseType::Int: {
-        auto result = new_kv_dict<int32_t>(output_path, opts);
-        if (!result.ok()) {
-          return result.status();
-        }
-        dict_ = result.value();
+      columns->emplace_back(buffer->data() + begin, buffer->size() - begin);
+      pos = line.find(delimiter, pos);
+      if (pos == std::string_view::npos) {
         break;
       }
-      default: {
-        return absl::InvalidArgumentError("Unsupported 'key' field type.");
-      }
+      pos++;
+      continue;
+    }
+    size_t next = line.find(delimiter, pos);
+    if (next == std::string_view::npos) {
+      columns->emplace_back(line.substr(pos));
+      break;
     }
+    columns->emplace_back(line.substr(pos, next - pos));
+    pos = next + 1;
   }
-  return absl::OkStatus();
 }
 
-absl::Status FbsDictBuilder::Add(const std::string& json) {
-  if (!parser_.ParseJson(json.c_str())) {
-    return absl::InvalidArgumentError("Invalid json to parse");
+absl::Status FbsDictBuilder::AddRow(std::string_view line, char delimiter) {
+  if (!line.empty() && line.back() == '\r') {
+    line.remove_suffix(1);
   }
-  std::string_view content(reinterpret_cast<const char*>(parser_.builder_.GetBufferPointer()),
-                           parser_.builder_.GetSize());
-  auto& root = *flatbuffers::GetAnyRoot(parser_.builder_.GetBufferPointer());
-  if (nullptr != key_reflection_field_) {
-    switch (key_reflection_field_->type()->base_type()) {
-      case reflection::BaseType::String: {
-        const flatbuffers::String* field_val = flatbuffers::GetFieldS(root, *key_reflection_field_);
-        std::string_view sv;
-        if (nullptr != field_val) {
-          sv = field_val->string_view();
-        }
-        rdict::ReadonlyKV<std::string_view, std::string_view>* dict =
-            reinterpret_cast<rdict::ReadonlyKV<std::string_view, std::string_view>*>(dict_);
-        return dict->Put(sv, content);
-      }
-      case reflection::BaseType::ULong: {
-        uint64_t field_val = flatbuffers::GetFieldI<uint64_t>(root, *key_reflection_field_);
-        rdict::ReadonlyKV<uint64_t, std::string_view>* dict =
-            reinterpret_cast<rdict::ReadonlyKV<uint64_t, std::string_view>*>(dict_);
-        return dict->Put(field_val, content);
-      }
-      case reflection::BaseType::UInt: {
-        uint32_t field_val = flatbuffers::GetFieldI<uint32_t>(root, *key_reflection_field_);
-        rdict::ReadonlyKV<uint32_t, std::string_view>* dict =
-            reinterpret_cast<rdict::ReadonlyKV<uint32_t, std::string_view>*>(dict_);
-        return dict->Put(field_val, content);
-      }
-      case reflection::BaseType::Long: {
-        uint64_t field_val = flatbuffers::GetFieldI<uint64_t>(root, *key_reflection_field_);
-        rdict::ReadonlyKV<uint64_t, std::string_view>* dict =
-            reinterpret_cast<rdict::ReadonlyKV<uint64_t, std::string_view>*>(dict_);
-        return dict->Put(field_val, content);
+  split_row(line, delimiter, &row_columns_, &row_buffer_);
+  if (!row_encoder_) {
+    std::vector<std::string> header(row_columns_.begin(), row_columns_.end());
+    auto encoder = FbsRowEncoder::New(parser_, reflection_schema_, header);
+    if (!encoder.ok()) {
+      return encoder.status();
+    }
+    row_encoder_ = std::move(encoder.value());
+    return absl::OkStatus();
+  }
+  auto result = row_encoder_->Encode(row_columns_);
+  if (!result.ok()) {
+    return result.status();
+  }
+  return AddContent(result.value());
+}
+
+absl::Status FbsDictBuilder::AddContent(std::string_view content) {
+  auto& root = *flatbuffers::GetAnyRoot(reinterpret_cast<const uint8_t*>(content.data()));
+  if (nullptr == key_reflection_field_) {
+    rdict::ReadonlyList* dict = reinterpret_cast<rdict::ReadonlyList*>(dict_);
+    return dict->Add(content);
+  }
+  return VisitKvDict([&](auto* dict) -> absl::Status {
+    using KeyType = typename std::remove_pointer_t<decltype(dict)>::key_type;
+    if constexpr (std::is_same_v<KeyType, std::string_view>) {
+      const flatbuffers::String* field_val = flatbuffers::GetFieldS(root, *key_reflection_field_);
+      std::string_view sv;
+      if (nullptr != field_val) {
+        sv = field_val->string_view();
       }
-      case reflection::BaseType::Int: {
-        int32_t field_val = flatbuffers::GetFieldI<int32_t>(root, *key_reflection_field_);
-        rdict::ReadonlyKV<int32_t, std::string_view>* dict =
-            reinterpret_cast<rdict::ReadonlyKV<int32_t, std::string_view>*>(dict_);
-        return dict->Put(field_val, content);
+      if (key_estimator_) {
+        key_estimator_->Add(HashedKey<KeyType>::Mix(sv));
+        return absl::OkStatus();
       }
-      default: {
-        return absl::InvalidArgumentError("Unsupported 'key' field type.");
+      return add_kv_record(dict, sv, content, opts_.bulk_build);
+    } else {
+      KeyType field_val = flatbuffers::GetFieldI<KeyType>(root, *key_reflection_field_);
+      if (key_estimator_) {
+        key_estimator_->Add(HashedKey<KeyType>::Mix(field_val));
+        return absl::OkStatus();
       }
+      return add_kv_record(dict, field_val, content, opts_.bulk_build);
     }
-  } else {
-    rdict::ReadonlyList* dict = reinterpret_cast<rdict::ReadonlyList*>(dict_);
-    return dict->Add(content);
+  });
+}
+
+void FbsDictBuilder::BeginKeyEstimate() {
+  if (nullptr != key_reflection_field_) {
+    key_estimator_ = std::make_unique<HyperLogLog>();
+  }
+}
+
+absl::Status FbsDictBuilder::EndKeyEstimate() {
+  if (!key_estimator_) {
+    return absl::OkStatus();
+  }
+  report_.estimated_keys = key_estimator_->Estimate();
+  key_estimator_.reset();
+  // the records are added again, the header row of csv/tsv included
+  report_.parser_fallbacks = 0;
+  if (opts_.columns.empty()) {
+    row_encoder_.reset();
   }
+  // ~4 standard errors of slack over the estimate
+  size_t keys = report_.estimated_keys + report_.estimated_keys / 32;
+  return VisitKvDict([&](auto* dict) -> absl::Status { return dict->Reserve(keys); });
 }
 
 absl::Status FbsDictBuilder::Flush() {
-  if (nullptr != key_reflection_field_) {
-    switch (key_reflection_field_->type()->base_type()) {
-      case reflection::BaseType::String: {
-        rdict::ReadonlyKV<std::string_view, std::string_view>* dict =
-            reinterpret_cast<rdict::ReadonlyKV<std::string_view, std::string_view>*>(dict_);
-        return dict->Commit();
-      }
-      case reflection::BaseType::ULong: {
-        rdict::ReadonlyKV<uint64_t, std::string_view>* dict =
-            reinterpret_cast<rdict::ReadonlyKV<uint64_t, std::string_view>*>(dict_);
-        return dict->Commit();
-      }
-      case reflection::BaseType::UInt: {
-        rdict::ReadonlyKV<uint32_t, std::string_view>* dict =
-            reinterpret_cast<rdict::ReadonlyKV<uint32_t, std::string_view>*>(dict_);
-        return dict->Commit();
-      }
-      case reflection::BaseType::Long: {
-        rdict::ReadonlyKV<uint64_t, std::string_view>* dict =
-            reinterpret_cast<rdict::ReadonlyKV<uint64_t, std::string_view>*>(dict_);
-        return dict->Commit();
-      }
-      case reflection::BaseType::Int: {
-        rdict::ReadonlyKV<int32_t, std::string_view>* dict =
-            reinterpret_cast<rdict::ReadonlyKV<int32_t, std::string_view>*>(dict_);
-        return dict->Commit();
+  if (nullptr == key_reflection_field_) {
+    rdict::ReadonlyList* dict = reinterpret_cast<rdict::ReadonlyList*>(dict_);
+    report_.records = dict->Size();
+    return dict->Commit();
+  }
+  return VisitKvDict([&](auto* dict) -> absl::Status {
+    using KeyType = typename std::remove_pointer_t<decltype(dict)>::key_type;
+    auto status = dict->BulkFinish();
+    if (!status.ok()) {
+      return status;
+    }
+    report_.records = dict->Size();
+    report_.rehashes = dict->GetBuildStats().rehashes;
+    report_.rehash_secs = dict->GetBuildStats().rehash_secs;
+    if (!key_frequency_.empty()) {
+      std::vector<std::pair<uint64_t, uint64_t>> layout;
+      status = dict->ReorderData(
+          [this](const KeyType& key) -> uint64_t { return get_key_frequency(key_frequency_, key); }, &layout);
+      if (!status.ok()) {
+        return status;
       }
-      default: {
-        return absl::InvalidArgumentError("Unsupported 'key' field type.");
+      FillHotnessReport(layout);
+    }
+    if (!key_frequency_.empty() && opts_.front_index_keys > 0) {
+      status = dict->SetFrontIndex(
+          [this](const KeyType& key) -> uint64_t { return get_key_frequency(key_frequency_, key); },
+          opts_.front_index_keys);
+      if (!status.ok()) {
+        return status;
       }
     }
-  } else {
-    rdict::ReadonlyList* dict = reinterpret_cast<rdict::ReadonlyList*>(dict_);
     return dict->Commit();
-  }
-  return absl::OkStatus();
+  });
 }
-}  // namespace rdict
\ No newline at end of file
+}  // namespace rdict
@@ -32,33 +32,114 @@
 #pragma once
 
 #include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include "absl/container/flat_hash_map.h"
 #include "absl/status/statusor.h"
 #include "flatbuffers/idl.h"
 #include "flatbuffers/reflection.h"
+#include "rdict/fbs_encoder.h"
+#include "rdict/hyperloglog.h"
 
 namespace rdict {
 class FbsDictBuilder {
  public:
   struct Options {
+    // expected number of kv records, the index is sized once for it
     size_t max_elements = 0;
     size_t reserved_space_bytes = 100 * 1024 * 1024 * 1024LL;
+    // optional file with '<key>\t<count>' lines, kv data section is written in descending count order
+    std::string key_frequency_path;
+    // traffic coverage used to estimate the hot resident set in report
+    double report_coverage = 0.9;
+    // encode json lines with simdjson driven by the reflection schema instead of flatbuffers::Parser, the output is
+    // byte-identical and lines the encoder can not reproduce fall back to the parser
+    bool simdjson_ingest = false;
+    // csv/tsv column to root table field names, empty names skip the column. if not set, the first row is the header
+    std::vector<std::string> columns;
+    // verify flatbuffers passed to AddFlatbuffer against the schema
+    bool verify_flatbuffer = true;
+    // write the kv index as bucketized cuckoo hash instead of robin hood, see detail::INDEX_CUCKOO
+    bool cuckoo_index = false;
+    // with 'key_frequency_path', put this many hottest keys of a kv dict in a front index, see SetFrontIndex
+    size_t front_index_keys = 0;
+    // index kv records once at Flush with ReadonlyKV::BulkAdd/BulkFinish instead of a Put per record
+    bool bulk_build = false;
+    uint32_t bulk_build_threads = 4;
+    // write a ReadonlySet of the root table keys instead of a kv dict, the records themselves are dropped
+    bool key_set = false;
     Options() {}
   };
+  struct Report {
+    size_t records = 0;
+    size_t data_bytes = 0;
+    // keys found in the key frequency file
+    size_t hot_keys = 0;
+    double coverage = 0;
+    // expected resident data bytes(4KB pages) to serve 'coverage' of the traffic
+    size_t resident_bytes = 0;
+    // whether 'simdjson_ingest' is active for the schema, and the json lines which fell back to the parser
+    bool simdjson_ingest = false;
+    size_t parser_fallbacks = 0;
+    // distinct keys counted by the key estimate pass, and the kv index rebuilds while adding records
+    size_t estimated_keys = 0;
+    size_t rehashes = 0;
+    double rehash_secs = 0;
+  };
 
   static absl::StatusOr<std::unique_ptr<FbsDictBuilder>> New(const std::string& schema_path,
                                                              const std::string& output_path,
                                                              const Options& opts = Options{});
 
-  absl::Status Add(const std::string& json);
+  absl::Status Add(std::string_view json);
+  // adds a serialized root table as is, without re-encoding
+  absl::Status AddFlatbuffer(std::string_view buf);
+  /**
+   * Adds a root table finished with FinishSizePrefixed, 'buf' includes the uint32 size prefix. Such a buffer is
+   * aligned with the prefix counted, so the whole buffer is stored with the prefix turned into the root offset
+   * instead of stripping it, which would misalign the 8 bytes scalars of the table.
+   */
+  absl::Status AddSizePrefixedFlatbuffer(std::string_view buf);
+  // adds a row of delimited text, csv quoting is supported if the delimiter is ','
+  absl::Status AddRow(std::string_view line, char delimiter);
   absl::Status Flush();
+  const Report& GetReport() const { return report_; }
+  /**
+   * Key count pre-pass of kv dicts: records added between BeginKeyEstimate and EndKeyEstimate only have their keys
+   * counted by a HyperLogLog, EndKeyEstimate then sizes the index once for the estimate so that the build does not
+   * grow through rehashes. The same records must be added again afterwards.
+   */
+  void BeginKeyEstimate();
+  absl::Status EndKeyEstimate();
+  bool EstimatingKeys() const { return nullptr != key_estimator_; }
 
  private:
   absl::Status Init(const std::string& schema_path, const std::string& output_path, const Options& opts);
+  absl::Status AddContent(std::string_view content);
+  absl::Status AddAlignedFlatbuffer(std::string_view buf);
+  uint8_t* AlignedCopy(std::string_view buf);
+  absl::Status LoadKeyFrequency(const std::string& path);
+  void FillHotnessReport(const std::vector<std::pair<uint64_t, uint64_t>>& layout);
+  template <typename F>
+  absl::Status VisitKvDict(F&& f);
 
   flatbuffers::Parser parser_;
   flatbuffers::Parser schema_parser_;
   const reflection::Schema* reflection_schema_ = nullptr;
   const reflection::Field* key_reflection_field_ = nullptr;
   void* dict_ = nullptr;
+  Options opts_;
+  Report report_;
+  absl::flat_hash_map<std::string, uint64_t> key_frequency_;
+  std::unique_ptr<FbsJsonEncoder> json_encoder_;
+  std::string json_buffer_;
+  std::unique_ptr<FbsRowEncoder> row_encoder_;
+  std::vector<std::string_view> row_columns_;
+  std::string row_buffer_;
+  // 8 bytes aligned copy of flatbuffers to verify and read
+  std::vector<uint64_t> flatbuffer_buffer_;
+  std::unique_ptr<HyperLogLog> key_estimator_;
 };
 }  // namespace rdict
\ No newline at end of file
@@ -0,0 +1,658 @@
+/*
+** BSD 3-Clause License
+**
+** Copyright (c) 2023, qiyingwang <qiyingwang@tencent.com>, the respective contributors, as shown by the AUTHORS file.
+** All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions are met:
+** * Redistributions of source code must retain the above copyright notice, this
+** list of conditions and the following disclaimer.
+**
+** * Redistributions in binary form must reproduce the above copyright notice,
+** this list of conditions and the following disclaimer in the documentation
+** and/or other materials provided with the distribution.
+**
+** * Neither the name of the copyright holder nor the names of its
+** contributors may be used to endorse or promote products derived from
+** this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+** AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+** IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+** DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+** FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+** DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+** SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+** CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+** OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#include "rdict/fbs_encoder.h"
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <limits>
+#include <utility>
+#include "absl/strings/numbers.h"
+#include "absl/strings/string_view.h"
+
+namespace rdict {
+static const reflection::Field* lookup_field(const reflection::Object* object, std::string_view name) {
+  // reflection fields are sorted by name
+  auto fields = object->fields();
+  uint32_t lo = 0;
+  uint32_t hi = fields->size();
+  while (lo < hi) {
+    uint32_t mid = lo + (hi - lo) / 2;
+    auto field = fields->Get(mid);
+    int cmp = field->name()->string_view().compare(name);
+    if (0 == cmp) {
+      return field;
+    }
+    if (cmp < 0) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  return nullptr;
+}
+
+template <typename T>
+static bool in_range(int64_t v) {
+  return v >= static_cast<int64_t>(std::numeric_limits<T>::min()) &&
+         v <= static_cast<int64_t>(std::numeric_limits<T>::max());
+}
+
+static bool in_range(reflection::BaseType base_type, int64_t v) {
+  switch (base_type) {
+    case reflection::UType:
+    case reflection::UByte: {
+      return in_range<uint8_t>(v);
+    }
+    case reflection::Byte: {
+      return in_range<int8_t>(v);
+    }
+    case reflection::Short: {
+      return in_range<int16_t>(v);
+    }
+    case reflection::UShort: {
+      return in_range<uint16_t>(v);
+    }
+    case reflection::Int: {
+      return in_range<int32_t>(v);
+    }
+    case reflection::UInt: {
+      return in_range<uint32_t>(v);
+    }
+    case reflection::Long: {
+      return true;
+    }
+    case reflection::ULong: {
+      return v >= 0;
+    }
+    default: {
+      return false;
+    }
+  }
+}
+
+static bool lookup_enum_value(const reflection::Schema* schema, int32_t index, std::string_view name, int64_t* v) {
+  auto enum_values = schema->enums()->Get(index)->values();
+  for (uint32_t i = 0; i < enum_values->size(); i++) {
+    auto enum_value = enum_values->Get(i);
+    if (enum_value->name()->string_view() == name) {
+      *v = enum_value->value();
+      return true;
+    }
+  }
+  return false;
+}
+
+static bool is_unsigned(reflection::BaseType base_type) {
+  return base_type == reflection::UType || base_type == reflection::UByte || base_type == reflection::UShort ||
+         base_type == reflection::UInt || base_type == reflection::ULong;
+}
+
+static void add_field(flatbuffers::FlatBufferBuilder& builder, const detail::FbsFieldValue& value) {
+  flatbuffers::voffset_t offset = value.field->offset();
+  int64_t def = value.field->default_integer();
+  switch (value.type) {
+    case reflection::Bool:
+    case reflection::UType:
+    case reflection::UByte: {
+      builder.AddElement<uint8_t>(offset, static_cast<uint8_t>(value.i), static_cast<uint8_t>(def));
+      break;
+    }
+    case reflection::Byte: {
+      builder.AddElement<int8_t>(offset, static_cast<int8_t>(value.i), static_cast<int8_t>(def));
+      break;
+    }
+    case reflection::Short: {
+      builder.AddElement<int16_t>(offset, static_cast<int16_t>(value.i), static_cast<int16_t>(def));
+      break;
+    }
+    case reflection::UShort: {
+      builder.AddElement<uint16_t>(offset, static_cast<uint16_t>(value.i), static_cast<uint16_t>(def));
+      break;
+    }
+    case reflection::Int: {
+      builder.AddElement<int32_t>(offset, static_cast<int32_t>(value.i), static_cast<int32_t>(def));
+      break;
+    }
+    case reflection::UInt: {
+      builder.AddElement<uint32_t>(offset, static_cast<uint32_t>(value.i), static_cast<uint32_t>(def));
+      break;
+    }
+    case reflection::Long: {
+      builder.AddElement<int64_t>(offset, value.i, def);
+      break;
+    }
+    case reflection::ULong: {
+      builder.AddElement<uint64_t>(offset, static_cast<uint64_t>(value.i), static_cast<uint64_t>(def));
+      break;
+    }
+    case reflection::Float: {
+      builder.AddElement<float>(offset, static_cast<float>(value.d),
+                                 static_cast<float>(value.field->default_real()));
+      break;
+    }
+    case reflection::Double: {
+      builder.AddElement<double>(offset, value.d, value.field->default_real());
+      break;
+    }
+    default: {
+      builder.AddOffset(offset, flatbuffers::Offset<void>(static_cast<flatbuffers::uoffset_t>(value.i)));
+      break;
+    }
+  }
+}
+
+namespace detail {
+flatbuffers::uoffset_t BuildFbsTable(flatbuffers::FlatBufferBuilder& builder, const FbsFieldValue* begin,
+                                     const FbsFieldValue* end) {
+  auto start = builder.StartTable();
+  for (size_t size = sizeof(flatbuffers::largest_scalar_t); size > 0; size /= 2) {
+    for (const FbsFieldValue* value = end; value != begin; value--) {
+      if (flatbuffers::GetTypeSize(value[-1].type) == size) {
+        add_field(builder, value[-1]);
+      }
+    }
+  }
+  return builder.EndTable(start);
+}
+}  // namespace detail
+
+absl::StatusOr<std::unique_ptr<FbsJsonEncoder>> FbsJsonEncoder::New(const flatbuffers::Parser& parser,
+                                                                    const reflection::Schema* schema) {
+  std::unique_ptr<FbsJsonEncoder> p(new FbsJsonEncoder);
+  p->schema_ = schema;
+  p->file_identifier_ = parser.file_identifier_;
+  auto status = p->CheckSchema(parser);
+  if (!status.ok()) {
+    return status;
+  }
+  return p;
+}
+
+absl::Status FbsJsonEncoder::CheckSchema(const flatbuffers::Parser& parser) {
+  // attributes which change the parser output are builtin and not serialized into the reflection schema
+  for (const auto* struct_def : parser.structs_.vec) {
+    if (!struct_def->fixed && !struct_def->sortbysize) {
+      return absl::UnimplementedError("unsupported 'original_order' table:" + struct_def->name);
+    }
+    for (const auto* field : struct_def->fields.vec) {
+      if (field->shared || field->flexbuffer || nullptr != field->nested_flatbuffer ||
+          nullptr != field->attributes.Lookup("hash") || nullptr != field->attributes.Lookup("force_align")) {
+        return absl::UnimplementedError("unsupported attribute on field:" + struct_def->name + "." + field->name);
+      }
+    }
+  }
+  std::vector<const reflection::Object*> visited;
+  return CheckObject(schema_->root_table(), visited);
+}
+
+absl::Status FbsJsonEncoder::CheckObject(const reflection::Object* object,
+                                         std::vector<const reflection::Object*>& visited) {
+  if (object->is_struct()) {
+    return absl::UnimplementedError("unsupported struct:" + object->name()->str());
+  }
+  if (std::find(visited.begin(), visited.end(), object) != visited.end()) {
+    return absl::OkStatus();
+  }
+  visited.emplace_back(object);
+  auto fields = object->fields();
+  for (uint32_t i = 0; i < fields->size(); i++) {
+    auto field = fields->Get(i);
+    if (field->optional()) {
+      return absl::UnimplementedError("unsupported optional field:" + field->name()->str());
+    }
+    auto type = field->type();
+    reflection::BaseType base_type = type->base_type();
+    if (base_type == reflection::Vector) {
+      base_type = type->element();
+      if (base_type == reflection::Obj) {
+        // parser sorts vectors of tables with a key field
+        auto element_fields = schema_->objects()->Get(type->index())->fields();
+        for (uint32_t j = 0; j < element_fields->size(); j++) {
+          if (element_fields->Get(j)->key()) {
+            return absl::UnimplementedError("unsupported vector of keyed tables:" + field->name()->str());
+          }
+        }
+      }
+    }
+    switch (base_type) {
+      case reflection::None:
+      case reflection::UType:
+      case reflection::Vector:
+      case reflection::Union:
+      case reflection::Array: {
+        return absl::UnimplementedError("unsupported type of field:" + field->name()->str());
+      }
+      case reflection::Obj: {
+        auto status = CheckObject(schema_->objects()->Get(type->index()), visited);
+        if (!status.ok()) {
+          return status;
+        }
+        break;
+      }
+      default: {
+        break;
+      }
+    }
+  }
+  return absl::OkStatus();
+}
+
+absl::StatusOr<std::string_view> FbsJsonEncoder::Encode(std::string_view json) {
+  json_buffer_.reserve(json.size() + simdjson::SIMDJSON_PADDING);
+  json_buffer_.assign(json.data(), json.size());
+  simdjson::ondemand::document doc;
+  auto error = json_parser_.iterate(json_buffer_.data(), json_buffer_.size(), json_buffer_.capacity()).get(doc);
+  if (error) {
+    return absl::InvalidArgumentError(simdjson::error_message(error));
+  }
+  simdjson::ondemand::object json_object;
+  error = doc.get_object().get(json_object);
+  if (error) {
+    return absl::InvalidArgumentError(simdjson::error_message(error));
+  }
+  builder_.Clear();
+  field_stack_.clear();
+  auto result = EncodeTable(schema_->root_table(), json_object);
+  if (!result.ok()) {
+    return result.status();
+  }
+  if (!doc.at_end()) {
+    return absl::InvalidArgumentError("trailing content after json object");
+  }
+  builder_.Finish(flatbuffers::Offset<flatbuffers::Table>(result.value()),
+                  file_identifier_.empty() ? nullptr : file_identifier_.c_str());
+  return std::string_view(reinterpret_cast<const char*>(builder_.GetBufferPointer()), builder_.GetSize());
+}
+
+absl::StatusOr<flatbuffers::uoffset_t> FbsJsonEncoder::EncodeTable(const reflection::Object* object,
+                                                                   simdjson::ondemand::object json_object) {
+  size_t base = field_stack_.size();
+  for (auto item : json_object) {
+    simdjson::ondemand::field json_field;
+    std::string_view name;
+    if (std::move(item).get(json_field) || json_field.unescaped_key().get(name)) {
+      return absl::InvalidArgumentError("invalid json object");
+    }
+    const reflection::Field* field = lookup_field(object, name);
+    if (nullptr == field || field->deprecated()) {
+      return absl::InvalidArgumentError("unknown field:" + std::string(name));
+    }
+    simdjson::ondemand::json_type json_type;
+    if (json_field.value().type().get(json_type)) {
+      return absl::InvalidArgumentError("invalid json value of field:" + std::string(name));
+    }
+    reflection::BaseType base_type = field->type()->base_type();
+    if (json_type == simdjson::ondemand::json_type::null && base_type >= reflection::String) {
+      // same as the parser, null non-scalar fields are ignored
+      continue;
+    }
+    FieldValue value;
+    value.field = field;
+    auto status = EncodeValue(*field->type(), base_type, json_field.value(), &value);
+    if (!status.ok()) {
+      return status;
+    }
+    field_stack_.emplace_back(value);
+  }
+  auto fields = object->fields();
+  for (uint32_t i = 0; i < fields->size(); i++) {
+    auto field = fields->Get(i);
+    if (field->required() && std::none_of(field_stack_.begin() + base, field_stack_.end(),
+                                          [field](const FieldValue& v) { return v.field == field; })) {
+      return absl::InvalidArgumentError("required field is missing:" + field->name()->str());
+    }
+  }
+  std::sort(field_stack_.begin() + base, field_stack_.end(),
+            [](const FieldValue& x, const FieldValue& y) { return x.field->offset() < y.field->offset(); });
+  for (size_t i = base + 1; i < field_stack_.size(); i++) {
+    if (field_stack_[i].field == field_stack_[i - 1].field) {
+      return absl::InvalidArgumentError("field set more than once:" + field_stack_[i].field->name()->str());
+    }
+  }
+  flatbuffers::uoffset_t table =
+      detail::BuildFbsTable(builder_, field_stack_.data() + base, field_stack_.data() + field_stack_.size());
+  field_stack_.resize(base);
+  return table;
+}
+
+absl::StatusOr<flatbuffers::uoffset_t> FbsJsonEncoder::EncodeVector(const reflection::Type& type,
+                                                                    simdjson::ondemand::array json_array) {
+  size_t base = field_stack_.size();
+  reflection::BaseType element = type.element();
+  for (auto item : json_array) {
+    simdjson::ondemand::value json_value;
+    if (std::move(item).get(json_value)) {
+      return absl::InvalidArgumentError("invalid json array");
+    }
+    FieldValue value;
+    auto status = EncodeValue(type, element, json_value, &value);
+    if (!status.ok()) {
+      return status;
+    }
+    field_stack_.emplace_back(value);
+  }
+  // elements are pushed backwards since the buffer is built from the end
+  size_t count = field_stack_.size() - base;
+  builder_.StartVector(count, flatbuffers::GetTypeSize(element));
+  for (size_t i = field_stack_.size(); i > base; i--) {
+    PushElement(field_stack_[i - 1]);
+  }
+  flatbuffers::uoffset_t vector = builder_.EndVector(count);
+  field_stack_.resize(base);
+  return vector;
+}
+
+absl::Status FbsJsonEncoder::EncodeValue(const reflection::Type& type, reflection::BaseType base_type,
+                                         simdjson::ondemand::value& json_value, FieldValue* value) {
+  value->type = base_type;
+  switch (base_type) {
+    case reflection::String: {
+      std::string_view str;
+      if (json_value.get_string().get(str)) {
+        return absl::InvalidArgumentError("expect json string");
+      }
+      value->i = builder_.CreateString(str.data(), str.size()).o;
+      return absl::OkStatus();
+    }
+    case reflection::Vector: {
+      simdjson::ondemand::array json_array;
+      if (json_value.get_array().get(json_array)) {
+        return absl::InvalidArgumentError("expect json array");
+      }
+      auto result = EncodeVector(type, json_array);
+      if (!result.ok()) {
+        return result.status();
+      }
+      value->i = result.value();
+      return absl::OkStatus();
+    }
+    case reflection::Obj: {
+      simdjson::ondemand::object json_object;
+      if (json_value.get_object().get(json_object)) {
+        return absl::InvalidArgumentError("expect json object");
+      }
+      auto result = EncodeTable(schema_->objects()->Get(type.index()), json_object);
+      if (!result.ok()) {
+        return result.status();
+      }
+      value->i = result.value();
+      return absl::OkStatus();
+    }
+    default: {
+      return EncodeScalar(type, base_type, json_value, value);
+    }
+  }
+}
+
+absl::Status FbsJsonEncoder::EncodeScalar(const reflection::Type& type, reflection::BaseType base_type,
+                                          simdjson::ondemand::value& json_value, FieldValue* value) {
+  simdjson::ondemand::json_type json_type;
+  if (json_value.type().get(json_type)) {
+    return absl::InvalidArgumentError("invalid json value");
+  }
+  switch (json_type) {
+    case simdjson::ondemand::json_type::boolean: {
+      bool v = false;
+      if (base_type != reflection::Bool || json_value.get_bool().get(v)) {
+        return absl::InvalidArgumentError("unexpected json bool");
+      }
+      value->i = v ? 1 : 0;
+      return absl::OkStatus();
+    }
+    case simdjson::ondemand::json_type::string: {
+      // enum value by name, flags and qualified names are left to the parser
+      std::string_view name;
+      if (type.index() < 0 || base_type == reflection::Bool || json_value.get_string().get(name)) {
+        return absl::InvalidArgumentError("unexpected json string");
+      }
+      if (lookup_enum_value(schema_, type.index(), name, &value->i)) {
+        if (!in_range(base_type, value->i)) {
+          return absl::InvalidArgumentError("enum value out of range");
+        }
+        return absl::OkStatus();
+      }
+      return absl::InvalidArgumentError("unknown enum value:" + std::string(name));
+    }
+    case simdjson::ondemand::json_type::number: {
+      break;
+    }
+    default: {
+      return absl::InvalidArgumentError("unexpected json value for scalar");
+    }
+  }
+  if (base_type == reflection::Bool) {
+    return absl::InvalidArgumentError("unexpected json number for bool");
+  }
+  std::string_view token = json_value.raw_json_token();
+  if (base_type == reflection::Float || base_type == reflection::Double) {
+    // the parser converts the token text with strtof/strtod, so does the encoder to get the same rounding
+    char buf[64];
+    double check = 0;
+    if (token.size() >= sizeof(buf) || json_value.get_double().get(check)) {
+      return absl::InvalidArgumentError("invalid json number");
+    }
+    memcpy(buf, token.data(), token.size());
+    buf[token.size()] = 0;
+    value->d = base_type == reflection::Float ? strtof(buf, nullptr) : strtod(buf, nullptr);
+    return absl::OkStatus();
+  }
+  if (is_unsigned(base_type) && !token.empty() && token[0] == '-') {
+    return absl::InvalidArgumentError("negative value for unsigned field");
+  }
+  simdjson::ondemand::number_type number_type;
+  if (json_value.get_number_type().get(number_type)) {
+    return absl::InvalidArgumentError("invalid json number");
+  }
+  if (number_type == simdjson::ondemand::number_type::unsigned_integer) {
+    uint64_t v = 0;
+    if (base_type != reflection::ULong || json_value.get_uint64().get(v)) {
+      return absl::InvalidArgumentError("integer value out of range");
+    }
+    value->i = static_cast<int64_t>(v);
+    return absl::OkStatus();
+  }
+  if (number_type != simdjson::ondemand::number_type::signed_integer || json_value.get_int64().get(value->i)) {
+    return absl::InvalidArgumentError("expect integer json number");
+  }
+  if (!in_range(base_type, value->i)) {
+    return absl::InvalidArgumentError("integer value out of range");
+  }
+  return absl::OkStatus();
+}
+
+void FbsJsonEncoder::PushElement(const FieldValue& value) {
+  switch (value.type) {
+    case reflection::Bool:
+    case reflection::UType:
+    case reflection::UByte: {
+      builder_.PushElement(static_cast<uint8_t>(value.i));
+      break;
+    }
+    case reflection::Byte: {
+      builder_.PushElement(static_cast<int8_t>(value.i));
+      break;
+    }
+    case reflection::Short: {
+      builder_.PushElement(static_cast<int16_t>(value.i));
+      break;
+    }
+    case reflection::UShort: {
+      builder_.PushElement(static_cast<uint16_t>(value.i));
+      break;
+    }
+    case reflection::Int: {
+      builder_.PushElement(static_cast<int32_t>(value.i));
+      break;
+    }
+    case reflection::UInt: {
+      builder_.PushElement(static_cast<uint32_t>(value.i));
+      break;
+    }
+    case reflection::Long: {
+      builder_.PushElement(value.i);
+      break;
+    }
+    case reflection::ULong: {
+      builder_.PushElement(static_cast<uint64_t>(value.i));
+      break;
+    }
+    case reflection::Float: {
+      builder_.PushElement(static_cast<float>(value.d));
+      break;
+    }
+    case reflection::Double: {
+      builder_.PushElement(value.d);
+      break;
+    }
+    default: {
+      builder_.PushElement(flatbuffers::Offset<void>(static_cast<flatbuffers::uoffset_t>(value.i)));
+      break;
+    }
+  }
+}
+
+absl::StatusOr<std::unique_ptr<FbsRowEncoder>> FbsRowEncoder::New(const flatbuffers::Parser& parser,
+                                                                  const reflection::Schema* schema,
+                                                                  const std::vector<std::string>& columns) {
+  std::unique_ptr<FbsRowEncoder> p(new FbsRowEncoder);
+  p->schema_ = schema;
+  p->file_identifier_ = parser.file_identifier_;
+  for (const auto& name : columns) {
+    const reflection::Field* field = nullptr;
+    if (!name.empty()) {
+      field = lookup_field(schema->root_table(), name);
+      if (nullptr == field || field->deprecated()) {
+        return absl::InvalidArgumentError("unknown column field:" + name);
+      }
+      reflection::BaseType base_type = field->type()->base_type();
+      if (base_type != reflection::String && (base_type < reflection::Bool || base_type > reflection::Double)) {
+        return absl::InvalidArgumentError("column field must be scalar or string:" + name);
+      }
+      if (std::find(p->column_fields_.begin(), p->column_fields_.end(), field) != p->column_fields_.end()) {
+        return absl::InvalidArgumentError("duplicate column field:" + name);
+      }
+    }
+    p->column_fields_.emplace_back(field);
+  }
+  return p;
+}
+
+absl::StatusOr<std::string_view> FbsRowEncoder::Encode(const std::vector<std::string_view>& columns) {
+  builder_.Clear();
+  fields_.clear();
+  size_t n = std::min(columns.size(), column_fields_.size());
+  for (size_t i = 0; i < n; i++) {
+    const reflection::Field* field = column_fields_[i];
+    if (nullptr == field || columns[i].empty()) {
+      continue;
+    }
+    detail::FbsFieldValue value;
+    value.field = field;
+    value.type = field->type()->base_type();
+    if (value.type == reflection::String) {
+      value.i = builder_.CreateString(columns[i].data(), columns[i].size()).o;
+    } else {
+      auto status = EncodeScalar(field, columns[i], &value);
+      if (!status.ok()) {
+        return status;
+      }
+    }
+    fields_.emplace_back(value);
+  }
+  auto root_fields = schema_->root_table()->fields();
+  for (uint32_t i = 0; i < root_fields->size(); i++) {
+    auto field = root_fields->Get(i);
+    if (field->required() && std::none_of(fields_.begin(), fields_.end(), [field](const detail::FbsFieldValue& v) {
+          return v.field == field;
+        })) {
+      return absl::InvalidArgumentError("required field is missing:" + field->name()->str());
+    }
+  }
+  std::sort(fields_.begin(), fields_.end(), [](const detail::FbsFieldValue& x, const detail::FbsFieldValue& y) {
+    return x.field->offset() < y.field->offset();
+  });
+  flatbuffers::uoffset_t table = detail::BuildFbsTable(builder_, fields_.data(), fields_.data() + fields_.size());
+  builder_.Finish(flatbuffers::Offset<flatbuffers::Table>(table),
+                  file_identifier_.empty() ? nullptr : file_identifier_.c_str());
+  return std::string_view(reinterpret_cast<const char*>(builder_.GetBufferPointer()), builder_.GetSize());
+}
+
+absl::Status FbsRowEncoder::EncodeScalar(const reflection::Field* field, std::string_view text,
+                                         detail::FbsFieldValue* value) {
+  absl::string_view str(text.data(), text.size());
+  switch (value->type) {
+    case reflection::Bool: {
+      if (str == "true" || str == "1") {
+        value->i = 1;
+        return absl::OkStatus();
+      }
+      if (str == "false" || str == "0") {
+        value->i = 0;
+        return absl::OkStatus();
+      }
+      break;
+    }
+    case reflection::Float: {
+      float v = 0;
+      if (absl::SimpleAtof(str, &v)) {
+        value->d = v;
+        return absl::OkStatus();
+      }
+      break;
+    }
+    case reflection::Double: {
+      if (absl::SimpleAtod(str, &value->d)) {
+        return absl::OkStatus();
+      }
+      break;
+    }
+    case reflection::ULong: {
+      uint64_t v = 0;
+      if (absl::SimpleAtoi(str, &v)) {
+        value->i = static_cast<int64_t>(v);
+        return absl::OkStatus();
+      }
+      break;
+    }
+    default: {
+      if (absl::SimpleAtoi(str, &value->i) && in_range(value->type, value->i)) {
+        return absl::OkStatus();
+      }
+      break;
+    }
+  }
+  int32_t index = field->type()->index();
+  if (index >= 0 && lookup_enum_value(schema_, index, text, &value->i) && in_range(value->type, value->i)) {
+    return absl::OkStatus();
+  }
+  return absl::InvalidArgumentError("invalid value:" + std::string(text) + " for field:" + field->name()->str());
+}
+}  // namespace rdict
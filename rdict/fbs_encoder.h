@@ -0,0 +1,124 @@
+/*
+** BSD 3-Clause License
+**
+** Copyright (c) 2023, qiyingwang <qiyingwang@tencent.com>, the respective contributors, as shown by the AUTHORS file.
+** All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions are met:
+** * Redistributions of source code must retain the above copyright notice, this
+** list of conditions and the following disclaimer.
+**
+** * Redistributions in binary form must reproduce the above copyright notice,
+** this list of conditions and the following disclaimer in the documentation
+** and/or other materials provided with the distribution.
+**
+** * Neither the name of the copyright holder nor the names of its
+** contributors may be used to endorse or promote products derived from
+** this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+** AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+** IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+** DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+** FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+** DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+** SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+** CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+** OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "absl/status/statusor.h"
+#include "flatbuffers/idl.h"
+#include "flatbuffers/reflection.h"
+#include "simdjson.h"
+
+namespace rdict {
+namespace detail {
+struct FbsFieldValue {
+  const reflection::Field* field = nullptr;
+  reflection::BaseType type = reflection::None;
+  // integer/bool value or uoffset of a created string/vector/table
+  int64_t i = 0;
+  double d = 0;
+};
+
+// starts a table and adds fields the way flatbuffers::Parser does: largest size first, descending field offset within
+// a size. fields must be sorted by field offset and all children already created.
+flatbuffers::uoffset_t BuildFbsTable(flatbuffers::FlatBufferBuilder& builder, const FbsFieldValue* begin,
+                                     const FbsFieldValue* end);
+}  // namespace detail
+
+// FbsJsonEncoder encodes json objects into flatbuffers of the schema's root table by driving a FlatBufferBuilder
+// directly from the reflection schema, without going through the flatbuffers::Parser tokenizer.
+// The output is byte-identical to flatbuffers::Parser::ParseJson: children are created in json order, table fields
+// are added largest size first and in descending field offset order within a size, default scalars are omitted.
+// Json which can not be reproduced exactly(unknown/deprecated fields, quoted numbers, flag enums...) is reported as
+// an error, callers are expected to fall back to the parser for such input.
+class FbsJsonEncoder {
+ public:
+  // returns UnimplementedError if the schema uses features which the encoder does not reproduce, such as unions,
+  // structs, optional scalars, shared strings or vectors of keyed tables.
+  static absl::StatusOr<std::unique_ptr<FbsJsonEncoder>> New(const flatbuffers::Parser& parser,
+                                                             const reflection::Schema* schema);
+
+  // returned content is valid until next Encode call.
+  absl::StatusOr<std::string_view> Encode(std::string_view json);
+
+ private:
+  using FieldValue = detail::FbsFieldValue;
+
+  FbsJsonEncoder() {}
+  absl::Status CheckSchema(const flatbuffers::Parser& parser);
+  absl::Status CheckObject(const reflection::Object* object, std::vector<const reflection::Object*>& visited);
+  absl::StatusOr<flatbuffers::uoffset_t> EncodeTable(const reflection::Object* object,
+                                                     simdjson::ondemand::object json_object);
+  absl::StatusOr<flatbuffers::uoffset_t> EncodeVector(const reflection::Type& type,
+                                                      simdjson::ondemand::array json_array);
+  absl::Status EncodeValue(const reflection::Type& type, reflection::BaseType base_type,
+                           simdjson::ondemand::value& json_value, FieldValue* value);
+  absl::Status EncodeScalar(const reflection::Type& type, reflection::BaseType base_type,
+                            simdjson::ondemand::value& json_value, FieldValue* value);
+  void PushElement(const FieldValue& value);
+
+  const reflection::Schema* schema_ = nullptr;
+  std::string file_identifier_;
+  simdjson::ondemand::parser json_parser_;
+  // reused input copy with simdjson::SIMDJSON_PADDING bytes capacity at the end
+  std::string json_buffer_;
+  flatbuffers::FlatBufferBuilder builder_;
+  // parsed but not yet added fields/vector elements of all tables being encoded, like flatbuffers::Parser
+  std::vector<FieldValue> field_stack_;
+};
+
+// FbsRowEncoder encodes rows of delimited text into flatbuffers of the schema's root table, columns are mapped to
+// scalar or string fields of the root table by name. Empty columns leave the field unset, integer columns also accept
+// enum value names.
+class FbsRowEncoder {
+ public:
+  // empty column names skip the column.
+  static absl::StatusOr<std::unique_ptr<FbsRowEncoder>> New(const flatbuffers::Parser& parser,
+                                                            const reflection::Schema* schema,
+                                                            const std::vector<std::string>& columns);
+
+  // returned content is valid until next Encode call.
+  absl::StatusOr<std::string_view> Encode(const std::vector<std::string_view>& columns);
+
+ private:
+  FbsRowEncoder() {}
+  absl::Status EncodeScalar(const reflection::Field* field, std::string_view text, detail::FbsFieldValue* value);
+
+  const reflection::Schema* schema_ = nullptr;
+  std::string file_identifier_;
+  std::vector<const reflection::Field*> column_fields_;
+  flatbuffers::FlatBufferBuilder builder_;
+  std::vector<detail::FbsFieldValue> fields_;
+};
+}  // namespace rdict
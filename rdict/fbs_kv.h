@@ -38,19 +38,26 @@ template <typename K, typename FBS>
 class FbsKv : public ReadonlyKV<K, std::string_view> {
  public:
   using fbs_type = FBS;
+  using Options = typename ReadonlyKV<K, std::string_view>::Options;
   static absl::StatusOr<std::unique_ptr<FbsKv>> Load(const std::string& path, size_t reserved_space_bytes = 0) {
-    std::unique_ptr<FbsKv> p(new FbsKv);
-    typename ReadonlyKV<K, std::string_view>::Options opts;
-    opts.readonly = true;
+    Options opts;
     opts.path = path;
     opts.reserved_space_bytes = reserved_space_bytes;
+    return Load(opts);
+  }
+  static absl::StatusOr<std::unique_ptr<FbsKv>> Load(const Options& options) {
+    std::unique_ptr<FbsKv> p(new FbsKv);
+    Options opts = options;
+    opts.readonly = true;
     auto status = p->Init(opts);
     if (!status.ok()) {
       return status;
     }
     return p;
   }
-  absl::StatusOr<const FBS*> Get(const K& key) const {
+  // accepts the key types of ReadonlyKV::Get, including HashedKey and string key views
+  template <typename T>
+  absl::StatusOr<const FBS*> Get(const T& key) const {
     auto val = ReadonlyKV<K, std::string_view>::Get(key);
     if (!val.ok()) {
       return val.status();
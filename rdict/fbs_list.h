@@ -39,11 +39,15 @@ class FbsList : public ReadonlyList {
  public:
   using fbs_type = FBS;
   static absl::StatusOr<std::unique_ptr<FbsList>> Load(const std::string& path, size_t reserved_space_bytes = 0) {
-    std::unique_ptr<FbsList> p(new FbsList);
     ReadonlyList::Options opts;
-    opts.readonly = true;
     opts.path = path;
     opts.reserved_space_bytes = reserved_space_bytes;
+    return Load(opts);
+  }
+  static absl::StatusOr<std::unique_ptr<FbsList>> Load(const ReadonlyList::Options& options) {
+    std::unique_ptr<FbsList> p(new FbsList);
+    ReadonlyList::Options opts = options;
+    opts.readonly = true;
     auto status = p->Init(opts);
     if (!status.ok()) {
       return status;
@@ -0,0 +1,249 @@
+/*
+** BSD 3-Clause License
+**
+** Copyright (c) 2023, qiyingwang <qiyingwang@tencent.com>, the respective contributors, as shown by the AUTHORS file.
+** All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions are met:
+** * Redistributions of source code must retain the above copyright notice, this
+** list of conditions and the following disclaimer.
+**
+** * Redistributions in binary form must reproduce the above copyright notice,
+** this list of conditions and the following disclaimer in the documentation
+** and/or other materials provided with the distribution.
+**
+** * Neither the name of the copyright holder nor the names of its
+** contributors may be used to endorse or promote products derived from
+** this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+** AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+** IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+** DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+** FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+** DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+** SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+** CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+** OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#include "rdict/hash.h"
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
+namespace rdict {
+namespace crc32c {
+namespace {
+constexpr uint32_t kSeed = 0x9E3779B9;
+constexpr uint64_t kLaneMul = UINT64_C(0x9E3779B97F4A7C15);
+
+// reflected Castagnoli polynomial, the one of the SSE4.2 crc32 instruction
+constexpr std::array<uint32_t, 256> kTable = [] {
+  std::array<uint32_t, 256> table{};
+  for (uint32_t i = 0; i < 256; i++) {
+    uint32_t crc = i;
+    for (int j = 0; j < 8; j++) {
+      crc = (crc >> 1) ^ ((crc & 1) ? 0x82F63B78 : 0);
+    }
+    table[i] = crc;
+  }
+  return table;
+}();
+
+inline uint32_t Extend(uint32_t crc, uint64_t v) {
+  for (int i = 0; i < 8; i++) {
+    crc = kTable[(crc ^ v) & 0xFF] ^ (crc >> 8);
+    v >>= 8;
+  }
+  return crc;
+}
+
+// must stay equal to HardwareHash
+uint64_t HashBytes(const uint8_t* p, size_t len) {
+  uint32_t lo = kSeed ^ static_cast<uint32_t>(len);
+  uint32_t hi = ~lo;
+  for (; len >= 8; len -= 8, p += 8) {
+    uint64_t w = wyhash::r8(p);
+    lo = Extend(lo, w);
+    hi = Extend(hi, w * kLaneMul);
+  }
+  if (len > 0) {
+    uint64_t w = 0;
+    memcpy(&w, p, len);
+    lo = Extend(lo, w);
+    hi = Extend(hi, w * kLaneMul);
+  }
+  return (static_cast<uint64_t>(hi) << 32) | lo;
+}
+
+#if defined(__x86_64__)
+__attribute__((target("sse4.2"))) uint64_t HardwareHash(const void* key, size_t len) {
+  const uint8_t* p = static_cast<const uint8_t*>(key);
+  uint32_t lo = kSeed ^ static_cast<uint32_t>(len);
+  uint32_t hi = ~lo;
+  for (; len >= 8; len -= 8, p += 8) {
+    uint64_t w = wyhash::r8(p);
+    lo = static_cast<uint32_t>(_mm_crc32_u64(lo, w));
+    hi = static_cast<uint32_t>(_mm_crc32_u64(hi, w * kLaneMul));
+  }
+  if (len > 0) {
+    uint64_t w = 0;
+    memcpy(&w, p, len);
+    lo = static_cast<uint32_t>(_mm_crc32_u64(lo, w));
+    hi = static_cast<uint32_t>(_mm_crc32_u64(hi, w * kLaneMul));
+  }
+  return (static_cast<uint64_t>(hi) << 32) | lo;
+}
+__attribute__((target("sse4.2"))) uint64_t HardwareHash(uint64_t x) {
+  return (static_cast<uint64_t>(_mm_crc32_u64(~kSeed, x * kLaneMul)) << 32) | _mm_crc32_u64(kSeed, x);
+}
+const bool kHasSse42 = (__builtin_cpu_init(), __builtin_cpu_supports("sse4.2"));
+#else
+const bool kHasSse42 = false;
+#endif
+}  // namespace
+
+uint64_t PortableHash(const void* key, size_t len) { return HashBytes(static_cast<const uint8_t*>(key), len); }
+uint64_t PortableHash(uint64_t x) {
+  return (static_cast<uint64_t>(Extend(~kSeed, x * kLaneMul)) << 32) | Extend(kSeed, x);
+}
+bool HardwareAccelerated() { return kHasSse42; }
+
+uint64_t Hash(const void* key, size_t len) {
+#if defined(__x86_64__)
+  if (FOLLY_LIKELY(kHasSse42)) {
+    return HardwareHash(key, len);
+  }
+#endif
+  return PortableHash(key, len);
+}
+uint64_t Hash(uint64_t x) {
+#if defined(__x86_64__)
+  if (FOLLY_LIKELY(kHasSse42)) {
+    return HardwareHash(x);
+  }
+#endif
+  return PortableHash(x);
+}
+}  // namespace crc32c
+
+namespace stripe {
+namespace {
+constexpr size_t kStripeLen = 64;
+// wyhash is faster until the stripes amortize the final mixing of the 8 lanes
+constexpr size_t kShortLen = 256;
+// stripes between two scrambles of the accumulators, so that their high bits keep feeding back
+constexpr size_t kStripesPerBlock = 16;
+constexpr uint64_t kPrime32 = UINT64_C(0x9E3779B1);
+alignas(32) constexpr uint64_t kSecret[8] = {UINT64_C(0xa0761d6478bd642f), UINT64_C(0xe7037ed1a0b428db),
+                                             UINT64_C(0x8ebc6af09c88c6e3), UINT64_C(0x589965cc75374cc3),
+                                             UINT64_C(0x1d8e4e27c47d124f), UINT64_C(0xbe4ba423396cfeb8),
+                                             UINT64_C(0xdb979083e96dd4de), UINT64_C(0x7c01812cf721ad1c)};
+alignas(32) constexpr uint64_t kInitAcc[8] = {UINT64_C(0xC2B2AE3D),         UINT64_C(0x9E3779B185EBCA87),
+                                              UINT64_C(0xC2B2AE3D27D4EB4F), UINT64_C(0x165667B19E3779F9),
+                                              UINT64_C(0x85EBCA77C2B2AE63), UINT64_C(0x85EBCA77),
+                                              UINT64_C(0x27D4EB2F165667C5), UINT64_C(0x9E3779B1)};
+
+inline void Accumulate(uint64_t* acc, const uint8_t* p) {
+  for (size_t i = 0; i < 8; i++) {
+    uint64_t d = wyhash::r8(p + 8 * i);
+    uint64_t dk = d ^ kSecret[i];
+    acc[i ^ 1] += d;
+    acc[i] += (dk & 0xFFFFFFFF) * (dk >> 32);
+  }
+}
+
+inline void Scramble(uint64_t* acc) {
+  for (size_t i = 0; i < 8; i++) {
+    acc[i] = (acc[i] ^ (acc[i] >> 47) ^ kSecret[i]) * kPrime32;
+  }
+}
+
+inline uint64_t Finalize(const uint64_t* acc, size_t len) {
+  uint64_t h = len * UINT64_C(0x9E3779B97F4A7C15);
+  for (size_t i = 0; i < 8; i += 2) {
+    h = wyhash::mix(acc[i] ^ kSecret[i], acc[i + 1] ^ h);
+  }
+  return h;
+}
+
+#if defined(__x86_64__)
+__attribute__((target("avx2"), always_inline)) inline void Accumulate(__m256i* acc, const __m256i* secret,
+                                                                     const uint8_t* p) {
+  for (int i = 0; i < 2; i++) {
+    __m256i d = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + 32 * i));
+    __m256i dk = _mm256_xor_si256(d, secret[i]);
+    __m256i product = _mm256_mul_epu32(dk, _mm256_srli_epi64(dk, 32));
+    // lane i gets the data of lane i^1
+    __m256i swapped = _mm256_shuffle_epi32(d, _MM_SHUFFLE(1, 0, 3, 2));
+    acc[i] = _mm256_add_epi64(acc[i], _mm256_add_epi64(product, swapped));
+  }
+}
+
+__attribute__((target("avx2"))) uint64_t HardwareHash(const uint8_t* p, size_t len) {
+  __m256i acc[2] = {_mm256_load_si256(reinterpret_cast<const __m256i*>(kInitAcc)),
+                    _mm256_load_si256(reinterpret_cast<const __m256i*>(kInitAcc + 4))};
+  const __m256i secret[2] = {_mm256_load_si256(reinterpret_cast<const __m256i*>(kSecret)),
+                             _mm256_load_si256(reinterpret_cast<const __m256i*>(kSecret + 4))};
+  const __m256i prime = _mm256_set1_epi64x(kPrime32);
+  size_t stripes = (len - 1) / kStripeLen;
+  for (size_t i = 0; i < stripes; i++) {
+    Accumulate(acc, secret, p + i * kStripeLen);
+    if ((i + 1) % kStripesPerBlock == 0) {
+      for (int j = 0; j < 2; j++) {
+        __m256i a = _mm256_xor_si256(acc[j], _mm256_srli_epi64(acc[j], 47));
+        a = _mm256_xor_si256(a, secret[j]);
+        __m256i lo = _mm256_mul_epu32(a, prime);
+        __m256i hi = _mm256_mul_epu32(_mm256_srli_epi64(a, 32), prime);
+        acc[j] = _mm256_add_epi64(lo, _mm256_slli_epi64(hi, 32));
+      }
+    }
+  }
+  Accumulate(acc, secret, p + len - kStripeLen);
+  alignas(32) uint64_t lanes[8];
+  _mm256_store_si256(reinterpret_cast<__m256i*>(lanes), acc[0]);
+  _mm256_store_si256(reinterpret_cast<__m256i*>(lanes + 4), acc[1]);
+  return Finalize(lanes, len);
+}
+const bool kHasAvx2 = (__builtin_cpu_init(), __builtin_cpu_supports("avx2"));
+#else
+const bool kHasAvx2 = false;
+#endif
+}  // namespace
+
+uint64_t PortableHash(const void* key, size_t len) {
+  if (len <= kShortLen) {
+    return wyhash::hash(key, len);
+  }
+  // must stay equal to HardwareHash, the last stripe is the trailing 64 bytes which overlaps the previous one unless
+  // the length is a multiple of 64
+  const uint8_t* p = static_cast<const uint8_t*>(key);
+  uint64_t acc[8];
+  memcpy(acc, kInitAcc, sizeof(acc));
+  size_t stripes = (len - 1) / kStripeLen;
+  for (size_t i = 0; i < stripes; i++) {
+    Accumulate(acc, p + i * kStripeLen);
+    if ((i + 1) % kStripesPerBlock == 0) {
+      Scramble(acc);
+    }
+  }
+  Accumulate(acc, p + len - kStripeLen);
+  return Finalize(acc, len);
+}
+bool HardwareAccelerated() { return kHasAvx2; }
+
+uint64_t Hash(const void* key, size_t len) {
+  if (len <= kShortLen) {
+    return wyhash::hash(key, len);
+  }
+#if defined(__x86_64__)
+  if (FOLLY_LIKELY(kHasAvx2)) {
+    return HardwareHash(static_cast<const uint8_t*>(key), len);
+  }
+#endif
+  return PortableHash(key, len);
+}
+}  // namespace stripe
+}  // namespace rdict
@@ -0,0 +1,258 @@
+/*
+** BSD 3-Clause License
+**
+** Copyright (c) 2023, qiyingwang <qiyingwang@tencent.com>, the respective contributors, as shown by the AUTHORS file.
+** All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions are met:
+** * Redistributions of source code must retain the above copyright notice, this
+** list of conditions and the following disclaimer.
+**
+** * Redistributions in binary form must reproduce the above copyright notice,
+** this list of conditions and the following disclaimer in the documentation
+** and/or other materials provided with the distribution.
+**
+** * Neither the name of the copyright holder nor the names of its
+** contributors may be used to endorse or promote products derived from
+** this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+** AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+** IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+** DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+** FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+** DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+** SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+** CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+** OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <string_view>
+
+#include "folly/Likely.h"
+#include "rdict/common.h"
+
+namespace rdict {
+
+namespace wyhash {
+inline void mum(uint64_t* a, uint64_t* b) {
+#if defined(__SIZEOF_INT128__)
+  __uint128_t r = *a;
+  r *= *b;
+  *a = static_cast<uint64_t>(r);
+  *b = static_cast<uint64_t>(r >> 64U);
+#elif defined(_MSC_VER) && defined(_M_X64)
+  *a = _umul128(*a, *b, b);
+#else
+  uint64_t ha = *a >> 32U;
+  uint64_t hb = *b >> 32U;
+  uint64_t la = static_cast<uint32_t>(*a);
+  uint64_t lb = static_cast<uint32_t>(*b);
+  uint64_t hi{};
+  uint64_t lo{};
+  uint64_t rh = ha * hb;
+  uint64_t rm0 = ha * lb;
+  uint64_t rm1 = hb * la;
+  uint64_t rl = la * lb;
+  uint64_t t = rl + (rm0 << 32U);
+  auto c = static_cast<uint64_t>(t < rl);
+  lo = t + (rm1 << 32U);
+  c += static_cast<uint64_t>(lo < t);
+  hi = rh + (rm0 >> 32U) + (rm1 >> 32U) + c;
+  *a = lo;
+  *b = hi;
+#endif
+}
+
+// multiply and xor mix function, aka MUM
+[[nodiscard]] inline auto mix(uint64_t a, uint64_t b) -> uint64_t {
+  mum(&a, &b);
+  return a ^ b;
+}
+
+// read functions. WARNING: we don't care about endianness, so results are different on big endian!
+[[nodiscard]] inline auto r8(const uint8_t* p) -> uint64_t {
+  uint64_t v{};
+  std::memcpy(&v, p, 8U);
+  return v;
+}
+
+[[nodiscard]] inline auto r4(const uint8_t* p) -> uint64_t {
+  uint32_t v{};
+  std::memcpy(&v, p, 4);
+  return v;
+}
+
+// reads 1, 2, or 3 bytes
+[[nodiscard]] inline auto r3(const uint8_t* p, size_t k) -> uint64_t {
+  return (static_cast<uint64_t>(p[0]) << 16U) | (static_cast<uint64_t>(p[k >> 1U]) << 8U) | p[k - 1];
+}
+
+[[maybe_unused]] [[nodiscard]] inline auto hash(void const* key, size_t len) -> uint64_t {
+  static constexpr auto secret = std::array{UINT64_C(0xa0761d6478bd642f), UINT64_C(0xe7037ed1a0b428db),
+                                            UINT64_C(0x8ebc6af09c88c6e3), UINT64_C(0x589965cc75374cc3)};
+
+  auto const* p = static_cast<uint8_t const*>(key);
+  uint64_t seed = secret[0];
+  uint64_t a{};
+  uint64_t b{};
+  if (FOLLY_LIKELY(len <= 16)) {
+    if (FOLLY_LIKELY(len >= 4)) {
+      a = (r4(p) << 32U) | r4(p + ((len >> 3U) << 2U));
+      b = (r4(p + len - 4) << 32U) | r4(p + len - 4 - ((len >> 3U) << 2U));
+    } else if (FOLLY_LIKELY(len > 0)) {
+      a = r3(p, len);
+      b = 0;
+    } else {
+      a = 0;
+      b = 0;
+    }
+  } else {
+    size_t i = len;
+    if (FOLLY_UNLIKELY(i > 48)) {
+      uint64_t see1 = seed;
+      uint64_t see2 = seed;
+      do {
+        seed = mix(r8(p) ^ secret[1], r8(p + 8) ^ seed);
+        see1 = mix(r8(p + 16) ^ secret[2], r8(p + 24) ^ see1);
+        see2 = mix(r8(p + 32) ^ secret[3], r8(p + 40) ^ see2);
+        p += 48;
+        i -= 48;
+      } while (FOLLY_LIKELY(i > 48));
+      seed ^= see1 ^ see2;
+    }
+    while (FOLLY_UNLIKELY(i > 16)) {
+      seed = mix(r8(p) ^ secret[1], r8(p + 8) ^ seed);
+      i -= 16;
+      p += 16;
+    }
+    a = r8(p + i - 16);
+    b = r8(p + i - 8);
+  }
+
+  return mix(secret[1] ^ len, mix(a ^ secret[1], b ^ seed));
+}
+
+[[nodiscard]] inline auto hash(uint64_t x) -> uint64_t { return wyhash::mix(x, UINT64_C(0x9E3779B97F4A7C15)); }
+
+}  // namespace wyhash
+
+template <typename T, typename Enable = void>
+struct hash {
+  auto operator()(T const& obj) const
+      noexcept(noexcept(std::declval<std::hash<T>>().operator()(std::declval<T const&>()))) -> uint64_t {
+    return std::hash<T>{}(obj);
+  }
+};
+
+template <>
+struct hash<std::string_view> {
+  using is_avalanching = void;
+  static constexpr detail::HashType hash_id = detail::HASH_WYHASH;
+  auto operator()(std::string_view const& str) const noexcept -> uint64_t {
+    return wyhash::hash(str.data(), str.size());
+  }
+};
+
+#define RDICT_HASH_STATICCAST(T)                                                                                  \
+  template <>                                                                                                     \
+  struct hash<T> {                                                                                                \
+    using is_avalanching = void;                                                                                  \
+    static constexpr detail::HashType hash_id = detail::HASH_WYHASH;                                              \
+    auto operator()(T const& obj) const noexcept -> uint64_t { return wyhash::hash(static_cast<uint64_t>(obj)); } \
+  }
+
+RDICT_HASH_STATICCAST(bool);
+RDICT_HASH_STATICCAST(uint8_t);
+RDICT_HASH_STATICCAST(int8_t);
+RDICT_HASH_STATICCAST(uint16_t);
+RDICT_HASH_STATICCAST(int16_t);
+RDICT_HASH_STATICCAST(uint32_t);
+RDICT_HASH_STATICCAST(int32_t);
+RDICT_HASH_STATICCAST(uint64_t);
+RDICT_HASH_STATICCAST(int64_t);
+
+namespace crc32c {
+/**
+ * 64 bits hash of two crc32c lanes over 8 bytes words, the second one over the words multiplied by a constant so that
+ * the lanes are not linearly related. Few instructions for short keys with SSE4.2, selected at runtime, the portable
+ * table driven fallback returns the same values so files are interchangeable between machines.
+ */
+uint64_t Hash(const void* key, size_t len);
+uint64_t Hash(uint64_t x);
+uint64_t PortableHash(const void* key, size_t len);
+uint64_t PortableHash(uint64_t x);
+bool HardwareAccelerated();
+}  // namespace crc32c
+
+namespace stripe {
+/**
+ * Hash for long keys accumulating 64 bytes stripes in 8 independent multiply lanes(the xxh3 scheme), vectorized with
+ * AVX2 when the cpu supports it and equal to the portable version. Keys up to 256 bytes use wyhash.
+ */
+uint64_t Hash(const void* key, size_t len);
+uint64_t PortableHash(const void* key, size_t len);
+bool HardwareAccelerated();
+}  // namespace stripe
+
+// crc32c based, the fastest for short string and integer keys on x86 servers
+template <typename T, typename Enable = void>
+struct crc32c_hash {};
+
+template <>
+struct crc32c_hash<std::string_view> {
+  using is_avalanching = void;
+  static constexpr detail::HashType hash_id = detail::HASH_CRC32C;
+  auto operator()(std::string_view const& str) const noexcept -> uint64_t {
+    return crc32c::Hash(str.data(), str.size());
+  }
+};
+
+#define RDICT_CRC32C_HASH_STATICCAST(T)                                                                            \
+  template <>                                                                                                      \
+  struct crc32c_hash<T> {                                                                                          \
+    using is_avalanching = void;                                                                                   \
+    static constexpr detail::HashType hash_id = detail::HASH_CRC32C;                                               \
+    auto operator()(T const& obj) const noexcept -> uint64_t { return crc32c::Hash(static_cast<uint64_t>(obj)); } \
+  }
+
+RDICT_CRC32C_HASH_STATICCAST(uint32_t);
+RDICT_CRC32C_HASH_STATICCAST(int32_t);
+RDICT_CRC32C_HASH_STATICCAST(uint64_t);
+RDICT_CRC32C_HASH_STATICCAST(int64_t);
+
+// for long string keys, e.g. urls or serialized feature crosses
+template <typename T, typename Enable = void>
+struct stripe_hash {};
+
+template <>
+struct stripe_hash<std::string_view> {
+  using is_avalanching = void;
+  static constexpr detail::HashType hash_id = detail::HASH_STRIPE;
+  auto operator()(std::string_view const& str) const noexcept -> uint64_t {
+    return stripe::Hash(str.data(), str.size());
+  }
+};
+
+namespace detail {
+template <typename T>
+using detect_hash_id = decltype(T::hash_id);
+
+// the id recorded in the header of dicts hashed by 'HashFn'
+template <typename HashFn>
+constexpr uint8_t hash_type_of() {
+  if constexpr (is_detected_v<detect_hash_id, HashFn>) {
+    return HashFn::hash_id;
+  } else {
+    return HASH_CUSTOM;
+  }
+}
+}  // namespace detail
+}  // namespace rdict
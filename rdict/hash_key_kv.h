@@ -0,0 +1,180 @@
+/*
+** BSD 3-Clause License
+**
+** Copyright (c) 2023, qiyingwang <qiyingwang@tencent.com>, the respective contributors, as shown by the AUTHORS file.
+** All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions are met:
+** * Redistributions of source code must retain the above copyright notice, this
+** list of conditions and the following disclaimer.
+**
+** * Redistributions in binary form must reproduce the above copyright notice,
+** this list of conditions and the following disclaimer in the documentation
+** and/or other materials provided with the distribution.
+**
+** * Neither the name of the copyright holder nor the names of its
+** contributors may be used to endorse or promote products derived from
+** this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+** AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+** IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+** DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+** FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+** DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+** SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+** CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+** OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#pragma once
+
+#include <algorithm>
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "absl/status/statusor.h"
+#include "rdict/kv.h"
+
+namespace rdict {
+// 128 bits string key hash of HashKeyKV
+struct Hash128 {
+  uint64_t lo;
+  uint64_t hi;
+  bool operator==(const Hash128& other) const { return lo == other.lo && hi == other.hi; }
+  bool operator<(const Hash128& other) const { return hi != other.hi ? hi < other.hi : lo < other.lo; }
+};
+
+template <>
+struct hash<Hash128> {
+  using is_avalanching = void;
+  static constexpr detail::HashType hash_id = detail::HASH_WYHASH;
+  // already a wyhash of the string key
+  auto operator()(Hash128 const& obj) const noexcept -> uint64_t { return obj.lo; }
+};
+
+/**
+ * String keyed dict storing a 64(or 128) bits hash of every key in place of the key bytes, records hold the hash and
+ * the value only and lookups compare hashes. Keys put since the dict was opened are checked for hash collisions with
+ * an independent hash at Commit, which fails on any collision if 'fail_on_collision' is set, else the later key
+ * replaces the former and is counted in Collisions().
+ * The files are plain ReadonlyKV<uint64_t(or Hash128), V> dicts, e.g. served by FbsKv<uint64_t, T> with HashKey(key).
+ */
+template <typename V, typename KeyHash = uint64_t>
+class HashKeyKV : public ReadonlyKV<KeyHash, V> {
+  static_assert(std::is_same_v<KeyHash, uint64_t> || std::is_same_v<KeyHash, Hash128>,
+                "key hashes are uint64_t or Hash128");
+
+ public:
+  using Base = ReadonlyKV<KeyHash, V>;
+  // keys accepted by Put/Get, the stored ones are 'KeyHash'
+  using key_type = std::string_view;
+  struct Options : public Base::Options {
+    // writable only, see class comment
+    bool fail_on_collision = true;
+  };
+
+  static absl::StatusOr<std::unique_ptr<HashKeyKV>> New(const Options& opts) {
+    std::unique_ptr<HashKeyKV> p(new HashKeyKV);
+    auto status = p->Init(opts);
+    if (!status.ok()) {
+      return status;
+    }
+    return p;
+  }
+  static absl::StatusOr<std::unique_ptr<HashKeyKV>> Load(const std::string& path) {
+    Options opts;
+    opts.path = path;
+    return Load(opts);
+  }
+  static absl::StatusOr<std::unique_ptr<HashKeyKV>> Load(const Options& options) {
+    Options opts = options;
+    opts.readonly = true;
+    return New(opts);
+  }
+
+  static KeyHash HashKey(std::string_view key) {
+    if constexpr (std::is_same_v<KeyHash, Hash128>) {
+      return Hash128{wyhash::hash(key.data(), key.size()), crc32c::Hash(key.data(), key.size())};
+    } else {
+      return wyhash::hash(key.data(), key.size());
+    }
+  }
+  absl::Status Put(std::string_view key, const V& val) {
+    Track(key);
+    return Base::Put(HashKey(key), val);
+  }
+  absl::Status BulkAdd(std::string_view key, const V& val) {
+    Track(key);
+    return Base::BulkAdd(HashKey(key), val);
+  }
+  bool Exists(std::string_view key) const { return Base::Exists(HashKey(key)); }
+  absl::StatusOr<V> Get(std::string_view key) const { return Base::Get(HashKey(key)); }
+  bool Find(std::string_view key, V* value) const { return Base::Find(HashKey(key), value); }
+  // distinct keys put since opened which share their hash with another key, counted by Commit
+  size_t Collisions() const { return collisions_; }
+  absl::Status Commit();
+
+ protected:
+  struct KeyCheck {
+    KeyHash hash;
+    // of an independent hash function, equal for the puts of a same key
+    uint64_t check;
+  };
+
+  HashKeyKV() {}
+  absl::Status Init(const Options& opts);
+  void Track(std::string_view key) {
+    if (!this->opt_.readonly) {
+      key_checks_.push_back(KeyCheck{HashKey(key), std::hash<std::string_view>{}(key)});
+    }
+  }
+
+  // records are keyed by hashes, unverified records or string hotness can not be taken
+  using Base::BulkBuild;
+  using Base::Merge;
+  using Base::ReorderData;
+  using Base::SetFrontIndex;
+
+  bool fail_on_collision_ = true;
+  std::vector<KeyCheck> key_checks_;
+  size_t collisions_ = 0;
+};
+
+template <typename V, typename KeyHash>
+absl::Status HashKeyKV<V, KeyHash>::Init(const Options& opts) {
+  auto status = Base::Init(opts);
+  if (!status.ok()) {
+    return status;
+  }
+  fail_on_collision_ = opts.fail_on_collision;
+  if (this->header_->index_size == 0) {
+    // a new dict
+    this->header_->hashed_key_size = sizeof(KeyHash);
+  } else if (this->header_->hashed_key_size != sizeof(KeyHash)) {
+    return absl::InvalidArgumentError("not a dict of hashed keys with the key hash size");
+  }
+  return absl::OkStatus();
+}
+
+template <typename V, typename KeyHash>
+absl::Status HashKeyKV<V, KeyHash>::Commit() {
+  std::sort(key_checks_.begin(), key_checks_.end(), [](const KeyCheck& a, const KeyCheck& b) {
+    return a.hash == b.hash ? a.check < b.check : a.hash < b.hash;
+  });
+  for (size_t i = 1; i < key_checks_.size(); i++) {
+    if (key_checks_[i].hash == key_checks_[i - 1].hash && key_checks_[i].check != key_checks_[i - 1].check) {
+      collisions_++;
+    }
+  }
+  key_checks_ = std::vector<KeyCheck>();
+  if (collisions_ > 0 && fail_on_collision_) {
+    return absl::AlreadyExistsError("hash collisions of " + std::to_string(collisions_) + " distinct keys");
+  }
+  return Base::Commit();
+}
+}  // namespace rdict
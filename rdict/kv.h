@@ -32,6 +32,9 @@
 #pragma once
 
 #include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
 #include <cstdint>
 #include <cstdio>
 #include <cstring>
@@ -39,16 +42,25 @@
 #include <memory>
 #include <string>
 #include <string_view>
+#include <thread>
 #include <type_traits>
 #include <unordered_set>
 #include <vector>
 
 #include "absl/status/statusor.h"
+#include "absl/strings/cord.h"
 #include "folly/File.h"
 #include "folly/FileUtil.h"
 #include "folly/Likely.h"
+#include "rdict/access_profile.h"
 #include "rdict/common.h"
+#include "rdict/cuckoo_index.h"
+#include "rdict/hash.h"
+#if defined(__cpp_impl_coroutine)
+#include "rdict/coro.h"
+#endif
 #include "rdict/mmap_file.h"
+#include "rdict/numa_replica.h"
 
 namespace rdict {
 
@@ -60,7 +72,27 @@ namespace detail {
 //   KeyValFlags() : invalid(0), reserved(0) {}
 // };
 
-template <typename KeyType, typename ValueType>
+// upper bound of sizeof(K) + sizeof(V) stored in flat buckets, larger records are packed into the data section
+constexpr size_t k_max_flat_kv_size = 64;
+
+template <typename T>
+constexpr bool is_flat_field_v = std::is_trivially_copyable_v<T> && !std::is_pointer_v<T> &&
+                                 !std::is_same_v<T, std::string_view> && alignof(T) <= alignof(std::max_align_t);
+
+/**
+ * Trivially copyable keys and values small enough are stored in the index buckets, without the data section and the
+ * offset indirection. C arrays can not be returned by value, use std::array instead.
+ */
+template <typename K, typename V>
+constexpr bool is_flat_kv_v = is_flat_field_v<K> && is_flat_field_v<V> && sizeof(K) + sizeof(V) <= k_max_flat_kv_size;
+
+// the flat layouts before the key/value sizes were recorded in the header
+template <typename T>
+constexpr bool is_builtin_flat_field_v = std::is_same_v<T, uint32_t> || std::is_same_v<T, uint64_t>;
+template <typename K, typename V>
+constexpr bool is_builtin_flat_kv_v = is_builtin_flat_field_v<K> && is_builtin_flat_field_v<V>;
+
+template <typename KeyType, typename ValueType, typename Enable = void>
 struct Bucket {
   static constexpr uint32_t k_dist_inc = 1U << 8U;                // skip 1 byte fingerprint
   static constexpr uint32_t k_fingerprint_mask = k_dist_inc - 1;  // mask for 1 byte of fingerprint
@@ -69,34 +101,92 @@ struct Bucket {
   uint32_t dist_and_fingerprint;  // upper 3 byte: distance to original bucket. lower byte: fingerprint from hash
 };
 
-#define RDICT_BUCKET_PRIMITIVE(K, V)                               \
-  template <>                                                      \
-  struct Bucket<K, V> {                                            \
-    static constexpr uint32_t k_dist_inc = 1U << 8U;               \
-    static constexpr uint32_t k_fingerprint_mask = k_dist_inc - 1; \
-    static constexpr bool is_flat = true;                          \
-    K key;                                                         \
-    V val;                                                         \
-    uint32_t dist_and_fingerprint;                                 \
+template <typename K, typename V>
+struct Bucket<K, V, std::enable_if_t<is_flat_kv_v<K, V>>> {
+  static constexpr uint32_t k_dist_inc = 1U << 8U;
+  static constexpr uint32_t k_fingerprint_mask = k_dist_inc - 1;
+  static constexpr bool is_flat = true;
+  K key;
+  V val;
+  uint32_t dist_and_fingerprint;
+};
+
+/**
+ * Bucket of INDEX_INLINE, the robin hood bucket followed by the key and value of records small enough to fit, so that
+ * lookups of them are served from the index cache line alone. 'value_idx' is kept for every record.
+ */
+struct InlineBucket {
+  static constexpr size_t k_max_inline_size = 17;
+  uint64_t value_idx;
+  uint32_t dist_and_fingerprint;
+  uint8_t inlined;
+  uint8_t key_size;
+  uint8_t value_size;
+  uint8_t record[k_max_inline_size];
+
+  template <typename T>
+  static std::string_view Bytes(const T& v) {
+    if constexpr (std::is_same_v<T, std::string_view>) {
+      return v;
+    } else {
+      return std::string_view(reinterpret_cast<const char*>(&v), sizeof(T));
+    }
+  }
+  template <typename T>
+  static T Unpack(const uint8_t* data, size_t size) {
+    if constexpr (std::is_same_v<T, std::string_view>) {
+      return std::string_view(reinterpret_cast<const char*>(data), size);
+    } else {
+      T v;
+      memcpy(&v, data, sizeof(T));
+      return v;
+    }
+  }
+  template <typename K, typename V>
+  void Pack(const K& k, const V& v) {
+    std::string_view key = Bytes(k);
+    std::string_view value = Bytes(v);
+    if (key.size() + value.size() > k_max_inline_size) {
+      return;
+    }
+    inlined = 1;
+    key_size = static_cast<uint8_t>(key.size());
+    value_size = static_cast<uint8_t>(value.size());
+    memcpy(record, key.data(), key.size());
+    memcpy(record + key.size(), value.data(), value.size());
   }
+  template <typename K>
+  K Key() const {
+    return Unpack<K>(record, key_size);
+  }
+  template <typename V>
+  V Value() const {
+    return Unpack<V>(record + key_size, value_size);
+  }
+};
+static_assert(sizeof(InlineBucket) == 32, "two inline buckets per cache line");
 
-RDICT_BUCKET_PRIMITIVE(uint32_t, uint64_t);
-RDICT_BUCKET_PRIMITIVE(uint32_t, uint32_t);
-RDICT_BUCKET_PRIMITIVE(uint64_t, uint64_t);
-RDICT_BUCKET_PRIMITIVE(uint64_t, uint32_t);
+/**
+ * Bucket of flat key/value types in dicts built before the flat layout(no flat sizes in the header), the record is
+ * packed into the data section at 'value_idx' as for other types. Read in place by readonly dicts, writable dicts
+ * convert them into flat buckets at load.
+ */
+struct RecordBucket {
+  uint64_t value_idx;
+  uint32_t dist_and_fingerprint;
+};
+static_assert(sizeof(RecordBucket) == sizeof(Bucket<std::string_view, std::string_view>), "same as record buckets");
 
 template <typename K, typename V>
 struct KeyValPair {
   static constexpr bool kShouldAlign = std::is_same_v<std::string_view, K> || std::is_same_v<std::string_view, V>;
-  static std::vector<uint8_t> Pack(const K& k, const V& v) {
-    std::vector<uint8_t> buffer;
-    Serializer<K>::Pack(k, buffer, kShouldAlign);
-    Serializer<V>::Pack(v, buffer, kShouldAlign);
-    // size_t allign_len = (buffer.size() + 1 + 7) & ~7;
-    // if (buffer.size() < allign_len) {
-    //   buffer.resize(allign_len);
-    // }
-    return buffer;
+  static size_t PackSize(const K& k, const V& v) {
+    return Serializer<K>::PackSize(k, kShouldAlign) + Serializer<V>::PackSize(v, kShouldAlign);
+  }
+  // writes PackSize bytes to 'dst'
+  static void PackTo(const K& k, const V& v, uint8_t* dst) {
+    Serializer<K>::PackTo(k, dst, kShouldAlign);
+    Serializer<V>::PackTo(v, dst + Serializer<K>::PackSize(k, kShouldAlign), kShouldAlign);
   }
   static K UnpackKey(const uint8_t* data) {
     K k;
@@ -131,146 +221,83 @@ struct KeyValPair {
 
 }  // namespace detail
 
-namespace wyhash {
-inline void mum(uint64_t* a, uint64_t* b) {
-#if defined(__SIZEOF_INT128__)
-  __uint128_t r = *a;
-  r *= *b;
-  *a = static_cast<uint64_t>(r);
-  *b = static_cast<uint64_t>(r >> 64U);
-#elif defined(_MSC_VER) && defined(_M_X64)
-  *a = _umul128(*a, *b, b);
-#else
-  uint64_t ha = *a >> 32U;
-  uint64_t hb = *b >> 32U;
-  uint64_t la = static_cast<uint32_t>(*a);
-  uint64_t lb = static_cast<uint32_t>(*b);
-  uint64_t hi{};
-  uint64_t lo{};
-  uint64_t rh = ha * hb;
-  uint64_t rm0 = ha * lb;
-  uint64_t rm1 = hb * la;
-  uint64_t rl = la * lb;
-  uint64_t t = rl + (rm0 << 32U);
-  auto c = static_cast<uint64_t>(t < rl);
-  lo = t + (rm1 << 32U);
-  c += static_cast<uint64_t>(lo < t);
-  hi = rh + (rm0 >> 32U) + (rm1 >> 32U) + c;
-  *a = lo;
-  *b = hi;
-#endif
-}
-
-// multiply and xor mix function, aka MUM
-[[nodiscard]] inline auto mix(uint64_t a, uint64_t b) -> uint64_t {
-  mum(&a, &b);
-  return a ^ b;
-}
-
-// read functions. WARNING: we don't care about endianness, so results are different on big endian!
-[[nodiscard]] inline auto r8(const uint8_t* p) -> uint64_t {
-  uint64_t v{};
-  std::memcpy(&v, p, 8U);
-  return v;
-}
-
-[[nodiscard]] inline auto r4(const uint8_t* p) -> uint64_t {
-  uint32_t v{};
-  std::memcpy(&v, p, 4);
-  return v;
-}
-
-// reads 1, 2, or 3 bytes
-[[nodiscard]] inline auto r3(const uint8_t* p, size_t k) -> uint64_t {
-  return (static_cast<uint64_t>(p[0]) << 16U) | (static_cast<uint64_t>(p[k >> 1U]) << 8U) | p[k - 1];
-}
-
-[[maybe_unused]] [[nodiscard]] inline auto hash(void const* key, size_t len) -> uint64_t {
-  static constexpr auto secret = std::array{UINT64_C(0xa0761d6478bd642f), UINT64_C(0xe7037ed1a0b428db),
-                                            UINT64_C(0x8ebc6af09c88c6e3), UINT64_C(0x589965cc75374cc3)};
+/**
+ * A key with its mixed hash computed once, lookups with it skip hashing. It can be reused across dicts with the same
+ * key type and hash function, e.g. querying the profile/embedding/history dicts keyed by the same user id.
+ * For string keys the referenced bytes must outlive the HashedKey.
+ */
+template <typename KeyType, typename HashFn = hash<KeyType>>
+class HashedKey {
+ public:
+  explicit HashedKey(const KeyType& key) : key_(key), hash_(Mix(key)) {}
+  const KeyType& key() const { return key_; }
+  uint64_t hash() const { return hash_; }
 
-  auto const* p = static_cast<uint8_t const*>(key);
-  uint64_t seed = secret[0];
-  uint64_t a{};
-  uint64_t b{};
-  if (FOLLY_LIKELY(len <= 16)) {
-    if (FOLLY_LIKELY(len >= 4)) {
-      a = (r4(p) << 32U) | r4(p + ((len >> 3U) << 2U));
-      b = (r4(p + len - 4) << 32U) | r4(p + len - 4 - ((len >> 3U) << 2U));
-    } else if (FOLLY_LIKELY(len > 0)) {
-      a = r3(p, len);
-      b = 0;
+  static uint64_t Mix(const KeyType& key) {
+    HashFn hash_fn{};
+    if constexpr (detail::is_detected_v<detail::detect_avalanching, HashFn>) {
+      // we know that the hash is good because is_avalanching.
+      if constexpr (sizeof(decltype(hash_fn(key))) < sizeof(uint64_t)) {
+        // 32bit hash and is_avalanching => multiply with a constant to avalanche bits upwards
+        return hash_fn(key) * UINT64_C(0x9ddfea08eb382d69);
+      } else {
+        // 64bit and is_avalanching => only use the hash itself.
+        return hash_fn(key);
+      }
     } else {
-      a = 0;
-      b = 0;
-    }
-  } else {
-    size_t i = len;
-    if (FOLLY_UNLIKELY(i > 48)) {
-      uint64_t see1 = seed;
-      uint64_t see2 = seed;
-      do {
-        seed = mix(r8(p) ^ secret[1], r8(p + 8) ^ seed);
-        see1 = mix(r8(p + 16) ^ secret[2], r8(p + 24) ^ see1);
-        see2 = mix(r8(p + 32) ^ secret[3], r8(p + 40) ^ see2);
-        p += 48;
-        i -= 48;
-      } while (FOLLY_LIKELY(i > 48));
-      seed ^= see1 ^ see2;
-    }
-    while (FOLLY_UNLIKELY(i > 16)) {
-      seed = mix(r8(p) ^ secret[1], r8(p + 8) ^ seed);
-      i -= 16;
-      p += 16;
+      // not is_avalanching => apply wyhash
+      return wyhash::hash(hash_fn(key));
     }
-    a = r8(p + i - 16);
-    b = r8(p + i - 8);
   }
 
-  return mix(secret[1] ^ len, mix(a ^ secret[1], b ^ seed));
-}
-
-[[nodiscard]] inline auto hash(uint64_t x) -> uint64_t { return wyhash::mix(x, UINT64_C(0x9E3779B97F4A7C15)); }
-
-}  // namespace wyhash
-
-template <typename T, typename Enable = void>
-struct hash {
-  auto operator()(T const& obj) const
-      noexcept(noexcept(std::declval<std::hash<T>>().operator()(std::declval<T const&>()))) -> uint64_t {
-    return std::hash<T>{}(obj);
-  }
+ private:
+  KeyType key_;
+  uint64_t hash_;
 };
 
+namespace detail {
+// views of the key types string keyed dicts accept besides std::string_view
+template <typename T>
+struct StringKeyView {};
 template <>
-struct hash<std::string_view> {
-  using is_avalanching = void;
-  auto operator()(std::string_view const& str) const noexcept -> uint64_t {
-    return wyhash::hash(str.data(), str.size());
-  }
+struct StringKeyView<const char*> {
+  static std::string_view Get(const char* key) { return key; }
 };
-
-#define RDICT_HASH_STATICCAST(T)                                                                                  \
-  template <>                                                                                                     \
-  struct hash<T> {                                                                                                \
-    using is_avalanching = void;                                                                                  \
-    auto operator()(T const& obj) const noexcept -> uint64_t { return wyhash::hash(static_cast<uint64_t>(obj)); } \
+template <>
+struct StringKeyView<char*> : StringKeyView<const char*> {};
+template <>
+struct StringKeyView<std::string> {
+  static std::string_view Get(const std::string& key) { return key; }
+};
+template <>
+struct StringKeyView<absl::string_view> {
+  static std::string_view Get(absl::string_view key) { return std::string_view(key.data(), key.size()); }
+};
+template <>
+struct StringKeyView<absl::Cord> {
+  // stored keys are contiguous, a fragmented cord is flattened into a thread local buffer
+  static std::string_view Get(const absl::Cord& key) {
+    if (auto flat = key.TryFlat()) {
+      return std::string_view(flat->data(), flat->size());
+    }
+    thread_local std::string buffer;
+    absl::CopyCordToString(key, &buffer);
+    return buffer;
   }
-
-RDICT_HASH_STATICCAST(bool);
-RDICT_HASH_STATICCAST(uint8_t);
-RDICT_HASH_STATICCAST(int8_t);
-RDICT_HASH_STATICCAST(uint16_t);
-RDICT_HASH_STATICCAST(int16_t);
-RDICT_HASH_STATICCAST(uint32_t);
-RDICT_HASH_STATICCAST(int32_t);
-RDICT_HASH_STATICCAST(uint64_t);
-RDICT_HASH_STATICCAST(int64_t);
+};
+template <typename K, typename T>
+using enable_string_key_t =
+    std::enable_if_t<std::is_same_v<K, std::string_view>,
+                     decltype(StringKeyView<std::decay_t<T>>::Get(std::declval<const T&>()))>;
+}  // namespace detail
 
 template <typename KeyType, typename ValueType, typename HashFn = hash<KeyType>,
           typename KeyEqual = std::equal_to<KeyType>>
 class ReadonlyKV {
  public:
+  using key_type = KeyType;
+  using value_type = ValueType;
+  using hashed_key_type = HashedKey<KeyType, HashFn>;
   static constexpr float k_default_max_load_factor = 0.8F;
   struct Options {
     std::string path;
@@ -279,12 +306,95 @@ class ReadonlyKV {
     float max_load_factor = k_default_max_load_factor;
     bool readonly = false;
     bool truncate = false;
+    // writable only, build into a temporary file renamed to 'path' by Commit, see MmapFile::Options
+    bool atomic_publish = false;
+    // writable only, index layout written by Commit and recorded in the header. INDEX_CUCKOO bounds every lookup to
+    // two cache lines of the index, INDEX_INLINE serves records of up to 17 bytes key and value from the index.
+    // Not supported by flat(small trivially copyable key and value) dicts
+    detail::IndexType index_type = detail::INDEX_ROBIN_HOOD;
+    MmapFile::LoadMode load_mode = MmapFile::LOAD_MMAP;
+    uint32_t load_threads = 4;
+    // readonly only, load from a range of an already loaded file instead of 'path', see DictBundle::Open
+    MmapFile::View view;
+    // readonly only, replicate index/data once per NUMA node, need compiled with RDICT_WITH_NUMA
+    bool numa_replicate_index = false;
+    bool numa_replicate_data = false;
+    // readonly only, record touched pages of one in every N lookups, 0 to disable
+    uint32_t access_profile_sample_rate = 0;
+    // readonly only, touch the hot pages recorded in this profile before Load returns
+    std::string warmup_profile_path;
+    uint32_t warmup_threads = 8;
+    // writable only, threads filling the index from the records of BulkAdd
+    uint32_t bulk_build_threads = 4;
   };
 
   static absl::StatusOr<std::unique_ptr<ReadonlyKV>> New(const Options& opt);
   bool Exists(const KeyType& key) const;
   absl::StatusOr<ValueType> Get(const KeyType& key) const;
+  // same as Get without building a status for missing keys, for batch and FFI lookups
+  bool Find(const KeyType& key, ValueType* value) const;
+  // lookups with a precomputed hash, see HashedKey
+  bool Exists(const hashed_key_type& key) const;
+  absl::StatusOr<ValueType> Get(const hashed_key_type& key) const;
+  bool Find(const hashed_key_type& key, ValueType* value) const;
+  // string keyed dicts also accept 'const char*', 'std::string', 'absl::string_view' and 'absl::Cord' keys
+  template <typename T, typename = detail::enable_string_key_t<KeyType, T>>
+  bool Exists(const T& key) const {
+    return Exists(detail::StringKeyView<std::decay_t<T>>::Get(key));
+  }
+  template <typename T, typename = detail::enable_string_key_t<KeyType, T>>
+  absl::StatusOr<ValueType> Get(const T& key) const {
+    return Get(detail::StringKeyView<std::decay_t<T>>::Get(key));
+  }
+  template <typename T, typename = detail::enable_string_key_t<KeyType, T>>
+  bool Find(const T& key, ValueType* value) const {
+    return Find(detail::StringKeyView<std::decay_t<T>>::Get(key), value);
+  }
+
+  /**
+   * A lookup split at its memory accesses so that many of them can be interleaved: StartLookup prefetches the index,
+   * every StepLookup returning false has prefetched a data record to compare on the next step, true is done.
+   */
+  struct Lookup {
+    explicit Lookup(const hashed_key_type& k) : key(k) {}
+    hashed_key_type key;
+    bool found = false;
+    ValueType value{};
+    // probe position, the slot index of the two candidate buckets for a cuckoo index
+    uint64_t bucket_idx = 0;
+    uint32_t dist_and_fingerprint = 0;
+    bool compare_pending = false;
+    // found in the front index by StartLookup
+    bool done = false;
+    const uint8_t* data = nullptr;
+  };
+  void StartLookup(Lookup* lookup) const;
+  bool StepLookup(Lookup* lookup) const;
+#if defined(__cpp_impl_coroutine)
+  // C++20 only, a Get which suspends at its memory accesses, interleaved with other lookups by rdict::Interleaver
+  Task<absl::StatusOr<ValueType>> AsyncGet(hashed_key_type key) const;
+  Task<absl::StatusOr<ValueType>> AsyncGet(const KeyType& key) const { return AsyncGet(hashed_key_type(key)); }
+#endif
   absl::Status Put(const KeyType& key, const ValueType& val);
+  /**
+   * Append the record to the data section and defer its indexing to 'BulkFinish'(or 'Commit'), which radix partitions
+   * all deferred records by bucket and fills the robin hood index with one sequential pass per bucket range on
+   * 'bulk_build_threads' threads, several times faster than a Put loop for large dicts. Deferred records are not
+   * visible until finished and override records put before, duplicated keys keep the last value like Put.
+   */
+  absl::Status BulkAdd(const KeyType& key, const ValueType& val);
+  absl::Status BulkFinish();
+  // BulkAdd every (key, value) of 'records' then BulkFinish
+  template <typename Range>
+  absl::Status BulkBuild(const Range& records) {
+    for (const auto& [key, val] : records) {
+      auto status = BulkAdd(key, val);
+      if (!status.ok()) {
+        return status;
+      }
+    }
+    return BulkFinish();
+  }
   // template <typename T>
   // absl::StatusOr<const T*> GetFbsValue(const KeyType& key) const {
   //   if constexpr (std::is_same_v<ValueType, std::string_view>) {
@@ -300,8 +410,33 @@ class ReadonlyKV {
   // }
 
   size_t Size() const { return meta_->size; }
+  // writable only, size the index for 'count' records at once instead of growing through rehashes
+  absl::Status Reserve(size_t count);
+  // index rebuilds of a writable dict growing with records since it was opened
+  struct BuildStats {
+    size_t rehashes = 0;
+    double rehash_secs = 0;
+  };
+  const BuildStats& GetBuildStats() const { return build_stats_; }
+  absl::Status SaveAccessProfile(const std::string& path) const;
+  // readonly only, the mapped index(with the front index if any) and data section, empty for writable dicts
+  MemoryRegion IndexRegion() const;
+  MemoryRegion DataRegion() const;
   absl::Status Commit();
   absl::Status Merge(const ReadonlyKV& other);
+  /**
+   * Rewrite the data section in descending 'hotness' order of keys so that hot records are packed together,
+   * the index format is unchanged. Only for writable dicts and must be called before 'Commit'.
+   * 'layout' if not null receives (hotness, record end offset) in the new data order.
+   */
+  absl::Status ReorderData(const std::function<uint64_t(const KeyType&)>& hotness,
+                           std::vector<std::pair<uint64_t, uint64_t>>* layout = nullptr);
+  /**
+   * Let 'Commit' write a front index of the 'max_keys' hottest keys(hotness > 0), a small table probed with a single
+   * cache line before the main index by readonly lookups. Only for writable non flat dicts, 0 'max_keys' to disable,
+   * ignored with INDEX_INLINE.
+   */
+  absl::Status SetFrontIndex(const std::function<uint64_t(const KeyType&)>& hotness, size_t max_keys);
 
  protected:
   static constexpr uint8_t initial_shifts = 64 - 2;  // 2^(64-m_shift) number of buckets
@@ -314,6 +449,9 @@ class ReadonlyKV {
     uint8_t shifts = 0;
   };
   static constexpr uint32_t k_meta_reserved_space = 64;
+  // BulkFinish scatters records into at most 2^k_bulk_partition_bits bucket ranges, counting sorted independently
+  static constexpr uint8_t k_bulk_partition_bits = 10;
+  static constexpr uint8_t k_hash_type = detail::hash_type_of<HashFn>();
   using Bucket = detail::Bucket<KeyType, ValueType>;
   // using value_idx_type = decltype(Bucket::value_idx);
   using value_idx_type = uint64_t;
@@ -337,21 +475,7 @@ class ReadonlyKV {
   [[nodiscard]] value_idx_type next(value_idx_type bucket_idx) const {
     return (bucket_idx + 1U == meta_->num_buckets) ? 0 : static_cast<value_idx_type>(bucket_idx + 1U);
   }
-  [[nodiscard]] constexpr auto mixed_hash(KeyType const& key) const -> uint64_t {
-    if constexpr (detail::is_detected_v<detail::detect_avalanching, HashFn>) {
-      // we know that the hash is good because is_avalanching.
-      if constexpr (sizeof(decltype(hash_(key))) < sizeof(uint64_t)) {
-        // 32bit hash and is_avalanching => multiply with a constant to avalanche bits upwards
-        return hash_(key) * UINT64_C(0x9ddfea08eb382d69);
-      } else {
-        // 64bit and is_avalanching => only use the hash itself.
-        return hash_(key);
-      }
-    } else {
-      // not is_avalanching => apply wyhash
-      return wyhash::hash(hash_(key));
-    }
-  }
+  [[nodiscard]] static auto mixed_hash(KeyType const& key) -> uint64_t { return hashed_key_type::Mix(key); }
   [[nodiscard]] static constexpr auto max_size() noexcept -> size_t {
     if constexpr ((std::numeric_limits<value_idx_type>::max)() == (std::numeric_limits<size_t>::max)()) {
       return size_t{1} << (sizeof(value_idx_type) * 8 - 1);
@@ -402,26 +526,98 @@ class ReadonlyKV {
 
   std::unordered_set<uint64_t> GetValueOffsets() const;
   KeyType GetKeyByBucket(uint64_t bucket_idx) const;
+  KeyType GetKeyByBucket(const Bucket* bucket, const uint8_t* data) const;
   // KeyType GetKey(uint64_t offset) const;
   // detail::KeyValFlags GetKeyValFlags(uint64_t offset) const;
   // ValueType GetValue(uint64_t offset) const;
   ValueType GetValueByBucket(uint64_t bucket_idx) const;
+  ValueType GetValueByBucket(const Bucket* bucket, const uint8_t* data) const;
+  template <typename B>
+  const B* FindBucket(const KeyType& key, uint64_t hash, const B* buckets, const uint8_t* data) const;
+  KeyType GetKeyByBucket(const detail::InlineBucket* bucket, const uint8_t* data) const;
+  ValueType GetValueByBucket(const detail::InlineBucket* bucket, const uint8_t* data) const;
+  KeyType GetKeyByBucket(const detail::RecordBucket* bucket, const uint8_t* data) const;
+  ValueType GetValueByBucket(const detail::RecordBucket* bucket, const uint8_t* data) const;
+  // the lookup of Exists/Get/Find, 'value' is not set if null
+  bool FindValue(const hashed_key_type& key, ValueType* value) const;
+  template <typename B>
+  bool StepRobinHood(Lookup* lookup, const B* buckets) const;
+  // samples a finished lookup into the access profile like FindValue, 'bucket' is null if not found
+  template <typename B>
+  void SampleLookup(const Lookup& lookup, const B* bucket) const;
+  // finds in the cuckoo index of a readonly dict if any, 'cuckoo_bucket' holds the returned bucket of a cuckoo hit
+  const Bucket* LookupBucket(const hashed_key_type& key, const uint8_t* data, Bucket* cuckoo_bucket) const;
+  const Bucket* LocalBuckets() const {
+    return nullptr == index_replica_ ? buckets_
+                                     : reinterpret_cast<const Bucket*>(index_replica_->Local() + k_meta_reserved_space);
+  }
+  const CuckooIndex::Bucket* LocalCuckooBuckets() const {
+    return nullptr == index_replica_
+               ? cuckoo_buckets_
+               : reinterpret_cast<const CuckooIndex::Bucket*>(index_replica_->Local() + k_meta_reserved_space);
+  }
+  const detail::InlineBucket* LocalInlineBuckets() const {
+    return nullptr == index_replica_
+               ? inline_buckets_
+               : reinterpret_cast<const detail::InlineBucket*>(index_replica_->Local() + k_meta_reserved_space);
+  }
+  const detail::RecordBucket* LocalRecordBuckets() const {
+    return nullptr == index_replica_
+               ? record_buckets_
+               : reinterpret_cast<const detail::RecordBucket*>(index_replica_->Local() + k_meta_reserved_space);
+  }
+  absl::Status RebuildFromCuckoo();
+  absl::Status RebuildFromInline();
+  absl::Status RebuildFromRecords();
+  // flat only, places the records of 'num_buckets' record buckets read from 'data' into the flat buckets
+  void PlaceRecords(const detail::RecordBucket* records, size_t num_buckets, const uint8_t* data);
+  absl::StatusOr<std::vector<uint8_t>> BuildCuckooIndex() const;
+  std::vector<uint8_t> BuildInlineIndex() const;
+  std::vector<uint8_t> BuildFrontIndex() const;
+  const uint8_t* LocalData() const {
+    return nullptr == data_replica_ ? data_mmap_file_->GetRawData() : data_replica_->Local();
+  }
+  void RecordAccess(uint64_t hash, const Bucket* bucket) const;
+  void RecordAccess(uint64_t hash, const detail::RecordBucket* bucket) const;
   absl::Status Update(Bucket* bucket, const KeyType& k, const ValueType& v);
   const uint8_t* GetKeyValData(uint64_t offset) const;
   uint8_t* GetKeyValData(uint64_t offset);
   absl::StatusOr<size_t> Append(const KeyType& k, const ValueType& v);
   absl::StatusOr<Bucket> NewBucket(const KeyType& k, const ValueType& v,
                                    dist_and_fingerprint_type dist_and_fingerprint);
+  struct BulkEntry {
+    uint64_t hash;
+    Bucket bucket;
+  };
 
   Options opt_;
   std::unique_ptr<MmapFile> data_mmap_file_;
-  HashFn hash_{};
   KeyEqual equal_;
   Bucket* buckets_ = nullptr;
+  // the index of a readonly dict committed with INDEX_CUCKOO, 2^meta_->shifts buckets
+  const CuckooIndex::Bucket* cuckoo_buckets_ = nullptr;
+  // the index of a readonly dict committed with INDEX_INLINE, same positions as the robin hood buckets
+  const detail::InlineBucket* inline_buckets_ = nullptr;
+  // the index of a readonly flat dict built before the flat layout, 'buckets_' is null then
+  const detail::RecordBucket* record_buckets_ = nullptr;
+  // the front index of hot keys of a readonly dict if any, 2^front_meta_->shifts buckets
+  const CuckooIndex::Bucket* front_buckets_ = nullptr;
+  const IndexMeta* front_meta_ = nullptr;
+  std::function<uint64_t(const KeyType&)> front_hotness_;
+  size_t front_index_keys_ = 0;
+  // records of BulkAdd not indexed yet
+  std::vector<BulkEntry> bulk_entries_;
+  BuildStats build_stats_;
   IndexMeta* meta_ = nullptr;
   std::vector<uint8_t> index_buffer_;
   std::vector<uint8_t> rdict_header_buffer_;
   detail::RdictMetaHeader* header_ = nullptr;
+  std::unique_ptr<NumaReplica> index_replica_;
+  std::unique_ptr<NumaReplica> data_replica_;
+  std::unique_ptr<AccessProfile> access_profile_;
+  size_t index_offset_ = 0;
+  // written to the header of new dicts and checked at load, set by derived dicts before Init
+  detail::DictType dict_type_ = detail::DictType::DICT_KV;
 
   float max_load_factor_ = default_max_load_factor;
 };
@@ -457,12 +653,33 @@ absl::Status ReadonlyKV<K, V, H, E>::LoadIndex(bool ignore_nonexist) {
     // printf("data_mmap_file_->GetWriteOffset()::%lld\n", data_mmap_file_->GetWriteOffset());
     return absl::InvalidArgumentError("invalid rdict file with too small length");
   }
+  // mapped bytes of a readonly dict up to the end of its indexes
+  size_t file_size = 0;
   if (opt_.readonly) {
     header_ = reinterpret_cast<detail::RdictMetaHeader*>(data_mmap_file_->GetRawData());
     uint8_t* read_index_data =
         data_mmap_file_->GetRawData() + detail::kRdictMetaHeaderSize + header_->data_size + header_->data_pad_size;
     meta_ = reinterpret_cast<IndexMeta*>(read_index_data);
     buckets_ = reinterpret_cast<Bucket*>(read_index_data + k_meta_reserved_space);
+    if (header_->index_type == detail::INDEX_CUCKOO) {
+      cuckoo_buckets_ = reinterpret_cast<const CuckooIndex::Bucket*>(read_index_data + k_meta_reserved_space);
+    } else if (header_->index_type == detail::INDEX_INLINE) {
+      inline_buckets_ = reinterpret_cast<const detail::InlineBucket*>(read_index_data + k_meta_reserved_space);
+    } else if (header_->index_type != detail::INDEX_ROBIN_HOOD) {
+      return absl::InvalidArgumentError("unsupported rdict index type");
+    }
+    index_offset_ = read_index_data - data_mmap_file_->GetRawData();
+    file_size = index_offset_ + header_->index_size;
+    if (header_->front_index_size > 0) {
+      if (header_->front_index_offset < file_size ||
+          header_->front_index_offset + header_->front_index_size > data_mmap_file_->GetWriteOffset()) {
+        return absl::InvalidArgumentError("invalid rdict front index");
+      }
+      const uint8_t* front_index_data = data_mmap_file_->GetRawData() + header_->front_index_offset;
+      front_meta_ = reinterpret_cast<const IndexMeta*>(front_index_data);
+      front_buckets_ = reinterpret_cast<const CuckooIndex::Bucket*>(front_index_data + k_meta_reserved_space);
+      file_size = header_->front_index_offset + header_->front_index_size;
+    }
   } else {
     memcpy(&rdict_header_buffer_[0], data_mmap_file_->GetRawData(), detail::kRdictMetaHeaderSize);
     header_ = reinterpret_cast<detail::RdictMetaHeader*>(&rdict_header_buffer_[0]);
@@ -473,10 +690,148 @@ absl::Status ReadonlyKV<K, V, H, E>::LoadIndex(bool ignore_nonexist) {
     buckets_ = reinterpret_cast<Bucket*>(&index_buffer_[k_meta_reserved_space]);
     meta_ = reinterpret_cast<IndexMeta*>(&index_buffer_[0]);
   }
+  if (header_->type != dict_type_) {
+    return absl::InvalidArgumentError("rdict of another dict type");
+  }
+  if (k_hash_type != detail::HASH_CUSTOM && header_->hash_type != k_hash_type) {
+    return absl::InvalidArgumentError("rdict built with another hash function");
+  }
+  // small trivially copyable pairs other than u32/u64 were stored as data section records before the flat layout
+  bool records = false;
+  if constexpr (Bucket::is_flat) {
+    bool builtin = header_->flat_bucket_size == 0 && detail::is_builtin_flat_kv_v<K, V>;
+    records = !builtin && header_->flat_bucket_size == 0;
+    if (records && (header_->index_type != detail::INDEX_ROBIN_HOOD || header_->front_index_size > 0)) {
+      return absl::FailedPreconditionError("rdict of data records without robin hood index, rebuild required");
+    }
+    if (!builtin && !records &&
+        (header_->flat_key_size != sizeof(K) || header_->flat_value_size != sizeof(V) ||
+         header_->flat_bucket_size != sizeof(Bucket))) {
+      return absl::InvalidArgumentError("rdict built with another key/value layout");
+    }
+    if (records && opt_.readonly) {
+      record_buckets_ = reinterpret_cast<const detail::RecordBucket*>(buckets_);
+      buckets_ = nullptr;
+    }
+  } else if (header_->flat_bucket_size != 0) {
+    return absl::InvalidArgumentError("rdict built with another key/value layout");
+  }
+  // prefetched and replicated only once the header is known to match
+  if (opt_.readonly) {
+    if (!opt_.warmup_profile_path.empty()) {
+      auto profile = AccessProfile::Load(opt_.warmup_profile_path);
+      if (profile.ok()) {
+        profile.value()->Warmup(data_mmap_file_->GetRawData(), file_size, opt_.warmup_threads);
+      } else if (!absl::IsNotFound(profile.status())) {
+        return profile.status();
+      }
+    }
+    if (opt_.access_profile_sample_rate > 0) {
+      access_profile_ = AccessProfile::New(file_size, opt_.access_profile_sample_rate);
+    }
+    if (opt_.numa_replicate_index) {
+      index_replica_ = NumaReplica::New(data_mmap_file_->GetRawData() + index_offset_, header_->index_size);
+    }
+    if (opt_.numa_replicate_data && (!Bucket::is_flat || records)) {
+      data_replica_ = NumaReplica::New(data_mmap_file_->GetRawData(), detail::kRdictMetaHeaderSize + header_->data_size);
+    }
+  }
   data_mmap_file_->ResetWriteOffset(detail::kRdictMetaHeaderSize + header_->data_size);
+  if (!opt_.readonly && header_->index_type == detail::INDEX_CUCKOO) {
+    return RebuildFromCuckoo();
+  }
+  if (!opt_.readonly && header_->index_type == detail::INDEX_INLINE) {
+    return RebuildFromInline();
+  }
+  if (!opt_.readonly && records) {
+    return RebuildFromRecords();
+  }
+  return absl::OkStatus();
+}
+
+template <typename K, typename V, typename H, typename E>
+absl::Status ReadonlyKV<K, V, H, E>::RebuildFromCuckoo() {
+  if constexpr (Bucket::is_flat) {
+    return absl::InvalidArgumentError("unsupported rdict index type");
+  } else {
+    // the in-memory index of a writable dict is always robin hood
+    std::vector<CuckooIndex::Bucket> cuckoo_buckets(size_t{1} << meta_->shifts);
+    memcpy(cuckoo_buckets.data(), &index_buffer_[k_meta_reserved_space],
+           cuckoo_buckets.size() * sizeof(CuckooIndex::Bucket));
+    size_t size = meta_->size;
+    meta_ = nullptr;
+    buckets_ = nullptr;
+    allocate_buckets_from_shift(calc_shifts_for_size(size));
+    clear_buckets();
+    for (const auto& cuckoo_bucket : cuckoo_buckets) {
+      for (uint64_t slot : cuckoo_bucket.slots) {
+        if (slot != 0) {
+          uint64_t offset = slot & CuckooIndex::kOffsetMask;
+          auto key = detail::KeyValPair<K, V>::UnpackKey(data_mmap_file_->GetRawData() + offset);
+          auto [bucket_idx, dist_and_fingerprint] = next_while_less(key);
+          place_and_shift_up({offset, static_cast<uint32_t>(dist_and_fingerprint)}, bucket_idx);
+          meta_->size++;
+        }
+      }
+    }
+    header_->index_type = detail::INDEX_ROBIN_HOOD;
+    return absl::OkStatus();
+  }
+}
+
+template <typename K, typename V, typename H, typename E>
+absl::Status ReadonlyKV<K, V, H, E>::RebuildFromInline() {
+  if constexpr (Bucket::is_flat) {
+    return absl::InvalidArgumentError("unsupported rdict index type");
+  } else {
+    // same bucket positions, only narrowed
+    std::vector<uint8_t> inline_index = std::move(index_buffer_);
+    const detail::InlineBucket* inline_buckets =
+        reinterpret_cast<const detail::InlineBucket*>(&inline_index[k_meta_reserved_space]);
+    meta_ = nullptr;
+    buckets_ = nullptr;
+    allocate_buckets_from_shift(reinterpret_cast<const IndexMeta*>(inline_index.data())->shifts);
+    meta_->size = reinterpret_cast<const IndexMeta*>(inline_index.data())->size;
+    for (size_t i = 0; i < meta_->num_buckets; i++) {
+      buckets_[i] = Bucket{inline_buckets[i].value_idx, inline_buckets[i].dist_and_fingerprint};
+    }
+    header_->index_type = detail::INDEX_ROBIN_HOOD;
+    return absl::OkStatus();
+  }
+}
+
+template <typename K, typename V, typename H, typename E>
+absl::Status ReadonlyKV<K, V, H, E>::RebuildFromRecords() {
+  // the records are copied into the flat buckets, the data section is dropped at the next commit
+  std::vector<uint8_t> record_index = std::move(index_buffer_);
+  const IndexMeta* record_meta = reinterpret_cast<const IndexMeta*>(record_index.data());
+  meta_ = nullptr;
+  buckets_ = nullptr;
+  allocate_buckets_from_shift(record_meta->shifts);
+  clear_buckets();
+  PlaceRecords(reinterpret_cast<const detail::RecordBucket*>(&record_index[k_meta_reserved_space]),
+               record_meta->num_buckets, data_mmap_file_->GetRawData());
+  data_mmap_file_->ResetWriteOffset(detail::kRdictMetaHeaderSize);
   return absl::OkStatus();
 }
 
+template <typename K, typename V, typename H, typename E>
+void ReadonlyKV<K, V, H, E>::PlaceRecords(const detail::RecordBucket* records, size_t num_buckets,
+                                          const uint8_t* data) {
+  if constexpr (Bucket::is_flat) {
+    for (size_t i = 0; i < num_buckets; i++) {
+      if (records[i].dist_and_fingerprint > 0) {
+        Bucket bucket;
+        detail::KeyValPair<K, V>::Unpack(data + records[i].value_idx, bucket.key, bucket.val);
+        auto [bucket_idx, dist_and_fingerprint] = next_while_less(bucket.key);
+        bucket.dist_and_fingerprint = static_cast<uint32_t>(dist_and_fingerprint);
+        place_and_shift_up(bucket, bucket_idx);
+        meta_->size++;
+      }
+    }
+  }
+}
+
 template <typename K, typename V, typename H, typename E>
 absl::Status ReadonlyKV<K, V, H, E>::Init(const Options& opt) {
   opt_ = opt;
@@ -486,6 +841,10 @@ absl::Status ReadonlyKV<K, V, H, E>::Init(const Options& opt) {
   data_opts.readonly = opt.readonly;
   data_opts.reserved_space_bytes = opt.reserved_space_bytes;
   data_opts.truncate = opt.truncate;
+  data_opts.atomic_publish = opt.atomic_publish;
+  data_opts.load_mode = opt.load_mode;
+  data_opts.load_threads = opt.load_threads;
+  data_opts.view = opt.view;
 
   auto data_file_result = MmapFile::Open(data_opts);
   if (!data_file_result.ok()) {
@@ -496,6 +855,9 @@ absl::Status ReadonlyKV<K, V, H, E>::Init(const Options& opt) {
   rdict_header_buffer_.resize(detail::kRdictMetaHeaderSize);
   header_ = reinterpret_cast<detail::RdictMetaHeader*>(&rdict_header_buffer_[0]);
   if constexpr (Bucket::is_flat) {
+    if (opt_.index_type != detail::INDEX_ROBIN_HOOD) {
+      return absl::InvalidArgumentError("flat dicts only support robin hood index");
+    }
     auto status = LoadIndex(true);
     if (status.ok()) {
       if (nullptr != meta_ && meta_->size > 0) {
@@ -505,7 +867,7 @@ absl::Status ReadonlyKV<K, V, H, E>::Init(const Options& opt) {
       return status;
     }
     *header_ = detail::RdictMetaHeader{};
-    header_->type = detail::DictType::DICT_KV;
+    header_->type = dict_type_;
     if (0 != opt_.bucket_count) {
       auto status = reserve(opt_.bucket_count);
       if (!status.ok()) {
@@ -521,7 +883,7 @@ absl::Status ReadonlyKV<K, V, H, E>::Init(const Options& opt) {
     max_load_factor_ = opt_.max_load_factor;
     if (data_mmap_file_->GetWriteOffset() == 0) {
       *header_ = detail::RdictMetaHeader{};
-      header_->type = detail::DictType::DICT_KV;
+      header_->type = dict_type_;
       if (0 != opt_.bucket_count) {
         auto status = reserve(opt_.bucket_count);
         if (!status.ok()) {
@@ -543,6 +905,20 @@ template <typename K, typename V, typename H, typename E>
 std::unordered_set<uint64_t> ReadonlyKV<K, V, H, E>::GetValueOffsets() const {
   std::unordered_set<uint64_t> offsets;
   if constexpr (Bucket::is_flat) {
+  } else if (nullptr != cuckoo_buckets_) {
+    for (size_t i = 0; i < (size_t{1} << meta_->shifts); i++) {
+      for (uint64_t slot : cuckoo_buckets_[i].slots) {
+        if (slot != 0) {
+          offsets.insert(slot & CuckooIndex::kOffsetMask);
+        }
+      }
+    }
+  } else if (nullptr != inline_buckets_) {
+    for (size_t i = 0; i < meta_->num_buckets; i++) {
+      if (inline_buckets_[i].dist_and_fingerprint > 0) {
+        offsets.insert(inline_buckets_[i].value_idx);
+      }
+    }
   } else {
     if (nullptr != buckets_ && nullptr != meta_) {
       for (size_t i = 0; i < meta_->num_buckets; i++) {
@@ -555,6 +931,14 @@ std::unordered_set<uint64_t> ReadonlyKV<K, V, H, E>::GetValueOffsets() const {
   return offsets;
 }
 
+template <typename K, typename V, typename H, typename E>
+absl::Status ReadonlyKV<K, V, H, E>::Reserve(size_t count) {
+  if (opt_.readonly) {
+    return absl::PermissionDeniedError("Unable to reserve readonly rdict");
+  }
+  return reserve(count);
+}
+
 template <typename K, typename V, typename H, typename E>
 absl::Status ReadonlyKV<K, V, H, E>::reserve(size_t capa) {
   capa = (std::min)(capa, max_size());
@@ -611,8 +995,7 @@ absl::StatusOr<typename ReadonlyKV<K, V, H, E>::Bucket> ReadonlyKV<K, V, H, E>::
   if constexpr (Bucket::is_flat) {
     return Bucket{k, v, dist_and_fingerprint};
   } else {
-    auto buffer = detail::KeyValPair<K, V>::Pack(k, v);
-    auto result = data_mmap_file_->Add(buffer.data(), buffer.size());
+    auto result = Append(k, v);
     if (!result.ok()) {
       return result.status();
     }
@@ -634,6 +1017,7 @@ void ReadonlyKV<K, V, H, E>::place_and_shift_up(Bucket bucket, value_idx_type pl
 template <typename K, typename V, typename H, typename E>
 absl::Status ReadonlyKV<K, V, H, E>::clear_and_fill_buckets_from_values(
     const uint8_t* data, const std::unordered_set<uint64_t>& valid_offsets) {
+  auto start = std::chrono::steady_clock::now();
   if constexpr (Bucket::is_flat) {
     clear_buckets();
     const Bucket* old_buckets = reinterpret_cast<const Bucket*>(data);
@@ -670,7 +1054,10 @@ absl::Status ReadonlyKV<K, V, H, E>::clear_and_fill_buckets_from_values(
     }
     // printf("####end clear_and_fill_buckets_from_values with size:%lld\n", meta_->size);
   }
-
+  if (meta_->size > 0) {
+    build_stats_.rehashes++;
+    build_stats_.rehash_secs += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  }
   return absl::OkStatus();
 }
 template <typename K, typename V, typename H, typename E>
@@ -684,24 +1071,56 @@ uint8_t* ReadonlyKV<K, V, H, E>::GetKeyValData(uint64_t offset) {
 
 template <typename K, typename V, typename H, typename E>
 K ReadonlyKV<K, V, H, E>::GetKeyByBucket(uint64_t bucket_idx) const {
-  const Bucket* bucket = buckets_ + bucket_idx;
+  return GetKeyByBucket(buckets_ + bucket_idx, data_mmap_file_->GetRawData());
+}
+template <typename K, typename V, typename H, typename E>
+K ReadonlyKV<K, V, H, E>::GetKeyByBucket(const Bucket* bucket, const uint8_t* data) const {
   if constexpr (Bucket::is_flat) {
     return bucket->key;
   } else {
-    const uint8_t* key_val_data = GetKeyValData(bucket->value_idx);
-    return detail::KeyValPair<K, V>::UnpackKey(key_val_data);
+    return detail::KeyValPair<K, V>::UnpackKey(data + bucket->value_idx);
+  }
+}
+template <typename K, typename V, typename H, typename E>
+K ReadonlyKV<K, V, H, E>::GetKeyByBucket(const detail::InlineBucket* bucket, const uint8_t* data) const {
+  if (bucket->inlined) {
+    return bucket->Key<K>();
+  }
+  return detail::KeyValPair<K, V>::UnpackKey(data + bucket->value_idx);
+}
+template <typename K, typename V, typename H, typename E>
+V ReadonlyKV<K, V, H, E>::GetValueByBucket(const detail::InlineBucket* bucket, const uint8_t* data) const {
+  if (bucket->inlined) {
+    return bucket->Value<V>();
   }
+  K k;
+  V v;
+  detail::KeyValPair<K, V>::Unpack(data + bucket->value_idx, k, v);
+  return v;
+}
+template <typename K, typename V, typename H, typename E>
+K ReadonlyKV<K, V, H, E>::GetKeyByBucket(const detail::RecordBucket* bucket, const uint8_t* data) const {
+  return detail::KeyValPair<K, V>::UnpackKey(data + bucket->value_idx);
+}
+template <typename K, typename V, typename H, typename E>
+V ReadonlyKV<K, V, H, E>::GetValueByBucket(const detail::RecordBucket* bucket, const uint8_t* data) const {
+  K k;
+  V v;
+  detail::KeyValPair<K, V>::Unpack(data + bucket->value_idx, k, v);
+  return v;
 }
 template <typename K, typename V, typename H, typename E>
 V ReadonlyKV<K, V, H, E>::GetValueByBucket(uint64_t bucket_idx) const {
-  const Bucket* bucket = buckets_ + bucket_idx;
+  return GetValueByBucket(buckets_ + bucket_idx, data_mmap_file_->GetRawData());
+}
+template <typename K, typename V, typename H, typename E>
+V ReadonlyKV<K, V, H, E>::GetValueByBucket(const Bucket* bucket, const uint8_t* data) const {
   if constexpr (Bucket::is_flat) {
     return bucket->val;
   } else {
-    const uint8_t* key_val_data = GetKeyValData(bucket->value_idx);
     K k;
     V v;
-    detail::KeyValPair<K, V>::Unpack(key_val_data, k, v);
+    detail::KeyValPair<K, V>::Unpack(data + bucket->value_idx, k, v);
     return v;
   }
 }
@@ -717,8 +1136,7 @@ absl::Status ReadonlyKV<K, V, H, E>::Update(Bucket* bucket, const K& k, const V&
   if constexpr (Bucket::is_flat) {
     bucket->val = v;
   } else {
-    auto buffer = detail::KeyValPair<K, V>::Pack(k, v);
-    auto result = data_mmap_file_->Add(buffer.data(), buffer.size());
+    auto result = Append(k, v);
     if (!result.ok()) {
       return result.status();
     }
@@ -753,9 +1171,14 @@ absl::StatusOr<size_t> ReadonlyKV<K, V, H, E>::Append(const K& k, const V& v) {
   if constexpr (Bucket::is_flat) {
     return 0;
   } else {
-    auto buffer = detail::KeyValPair<K, V>::Pack(k, v);
-    auto result = data_mmap_file_->Add(buffer.data(), buffer.size());
-    return result;
+    // serialize straight into the mapping
+    size_t len = detail::KeyValPair<K, V>::PackSize(k, v);
+    auto result = data_mmap_file_->Reserve(len);
+    if (!result.ok()) {
+      return result.status();
+    }
+    detail::KeyValPair<K, V>::PackTo(k, v, result.value());
+    return data_mmap_file_->Commit(len);
   }
 }
 
@@ -777,6 +1200,199 @@ absl::Status ReadonlyKV<K, V, H, E>::increase_size() {
     return clear_and_fill_buckets_from_values(data_mmap_file_->GetRawData(), valid_offsets);
   }
 }
+template <typename K, typename V, typename H, typename E>
+absl::Status ReadonlyKV<K, V, H, E>::BulkAdd(const K& key, const V& val) {
+  if (opt_.readonly) {
+    return absl::PermissionDeniedError("Unable to bulk add to readonly rdict");
+  }
+  auto result = NewBucket(key, val, 0);
+  if (!result.ok()) {
+    return result.status();
+  }
+  bulk_entries_.push_back({mixed_hash(key), result.value()});
+  return absl::OkStatus();
+}
+
+template <typename K, typename V, typename H, typename E>
+absl::Status ReadonlyKV<K, V, H, E>::BulkFinish() {
+  if (opt_.readonly) {
+    return absl::PermissionDeniedError("Unable to bulk build readonly rdict");
+  }
+  if (bulk_entries_.empty()) {
+    return absl::OkStatus();
+  }
+  // records already indexed go first so that the deferred ones win on duplicated keys
+  std::vector<BulkEntry> entries;
+  if (meta_->size > 0) {
+    entries.reserve(meta_->size + bulk_entries_.size());
+    for (size_t i = 0; i < meta_->num_buckets; i++) {
+      if (buckets_[i].dist_and_fingerprint > 0) {
+        entries.push_back({mixed_hash(GetKeyByBucket(i)), buckets_[i]});
+      }
+    }
+    entries.insert(entries.end(), bulk_entries_.begin(), bulk_entries_.end());
+    std::vector<BulkEntry>().swap(bulk_entries_);
+  } else {
+    entries.swap(bulk_entries_);
+  }
+
+  // a fresh zeroed buffer instead of clearing the old one
+  uint8_t shifts = (std::min)(meta_->shifts, calc_shifts_for_size(entries.size()));
+  std::vector<uint8_t>().swap(index_buffer_);
+  meta_ = nullptr;
+  buckets_ = nullptr;
+  allocate_buckets_from_shift(shifts);
+
+  // runs f(task, worker) for every task in [0, num_tasks)
+  size_t threads = (std::max)(opt_.bulk_build_threads, 1U);
+  auto parallel_for = [threads](size_t num_tasks, auto&& f) {
+    std::atomic<size_t> next_task{0};
+    auto worker = [&](size_t worker_idx) {
+      for (size_t task = next_task.fetch_add(1); task < num_tasks; task = next_task.fetch_add(1)) {
+        f(task, worker_idx);
+      }
+    };
+    std::vector<std::thread> workers;
+    for (size_t i = 1; i < threads; i++) {
+      workers.emplace_back(worker, i);
+    }
+    worker(0);
+    for (auto& t : workers) {
+      t.join();
+    }
+  };
+
+  // stable counting scatter by the top bits of the bucket index, every partition owns a contiguous bucket range.
+  // each worker histograms and scatters its own chunk of the records.
+  uint8_t bucket_bits = 64 - meta_->shifts;
+  uint8_t range_bits = bucket_bits - (std::min)(bucket_bits, k_bulk_partition_bits);
+  size_t num_partitions = meta_->num_buckets >> range_bits;
+  size_t num_entries = entries.size();
+  auto chunk_begin = [&](size_t chunk) { return num_entries * chunk / threads; };
+  std::vector<std::vector<size_t>> cursors(threads, std::vector<size_t>(num_partitions, 0));
+  parallel_for(threads, [&](size_t chunk, size_t) {
+    for (size_t i = chunk_begin(chunk); i < chunk_begin(chunk + 1); i++) {
+      cursors[chunk][bucket_idx_from_hash(entries[i].hash) >> range_bits]++;
+    }
+  });
+  std::vector<size_t> partition_begin(num_partitions + 1, 0);
+  for (size_t p = 0; p < num_partitions; p++) {
+    size_t pos = partition_begin[p];
+    for (size_t chunk = 0; chunk < threads; chunk++) {
+      size_t count = cursors[chunk][p];
+      cursors[chunk][p] = pos;
+      pos += count;
+    }
+    partition_begin[p + 1] = pos;
+  }
+  // not value initialized, every record is written by the scatter
+  std::unique_ptr<BulkEntry[]> partitioned(new BulkEntry[num_entries]);
+  parallel_for(threads, [&](size_t chunk, size_t) {
+    for (size_t i = chunk_begin(chunk); i < chunk_begin(chunk + 1); i++) {
+      partitioned[cursors[chunk][bucket_idx_from_hash(entries[i].hash) >> range_bits]++] = entries[i];
+    }
+  });
+  std::vector<BulkEntry>().swap(entries);
+
+  // robin hood order is ascending home bucket, then descending fingerprint. 'partition_end' is the live end after
+  // dropping duplicated keys, 'fill_end' the position after the last record when filled from position 0.
+  const uint8_t* data = data_mmap_file_->GetRawData();
+  std::vector<size_t> partition_end(num_partitions);
+  std::vector<uint64_t> fill_end(num_partitions);
+  size_t range_mask = (size_t{1} << range_bits) - 1;
+  std::vector<std::vector<BulkEntry>> scratches(threads);
+  std::vector<std::vector<uint32_t>> worker_counts(threads);
+  parallel_for(num_partitions, [&](size_t p, size_t worker) {
+    std::vector<BulkEntry>* scratch = &scratches[worker];
+    std::vector<uint32_t>* counts = &worker_counts[worker];
+    BulkEntry* begin = partitioned.get() + partition_begin[p];
+    BulkEntry* end = partitioned.get() + partition_begin[p + 1];
+    // counting sort by bucket, the few records of a bucket by insertion sort, both stable
+    scratch->assign(begin, end);
+    counts->assign(range_mask + 2, 0);
+    for (const auto& entry : *scratch) {
+      (*counts)[(bucket_idx_from_hash(entry.hash) & range_mask) + 1]++;
+    }
+    for (size_t i = 0; i <= range_mask; i++) {
+      (*counts)[i + 1] += (*counts)[i];
+    }
+    for (const auto& entry : *scratch) {
+      begin[(*counts)[bucket_idx_from_hash(entry.hash) & range_mask]++] = entry;
+    }
+    for (BulkEntry* entry = begin + 1; entry < end; entry++) {
+      BulkEntry moving = *entry;
+      BulkEntry* pos = entry;
+      for (; pos > begin && bucket_idx_from_hash(pos[-1].hash) == bucket_idx_from_hash(moving.hash) &&
+             dist_and_fingerprint_from_hash(pos[-1].hash) < dist_and_fingerprint_from_hash(moving.hash);
+           pos--) {
+        *pos = pos[-1];
+      }
+      *pos = moving;
+    }
+    BulkEntry* live_end = begin;
+    BulkEntry* run_begin = begin;
+    uint64_t pos = 0;
+    for (BulkEntry* entry = begin; entry != end; entry++) {
+      if (bucket_idx_from_hash(entry->hash) != bucket_idx_from_hash(run_begin->hash) ||
+          dist_and_fingerprint_from_hash(entry->hash) != dist_and_fingerprint_from_hash(run_begin->hash)) {
+        run_begin = live_end;
+      }
+      BulkEntry* duplicated = run_begin;
+      for (; duplicated != live_end; duplicated++) {
+        if (duplicated->hash == entry->hash &&
+            equal_(GetKeyByBucket(&duplicated->bucket, data), GetKeyByBucket(&entry->bucket, data))) {
+          break;
+        }
+      }
+      *duplicated = *entry;
+      if (duplicated == live_end) {
+        live_end++;
+        pos = (std::max)(pos, bucket_idx_from_hash(entry->hash)) + 1;
+      }
+    }
+    partition_end[p] = live_end - partitioned.get();
+    fill_end[p] = pos;
+  });
+
+  // start position of every partition, records overflowing the last bucket wrap around to the first ones
+  std::vector<uint64_t> fill_begin(num_partitions);
+  size_t size = 0;
+  uint64_t wrapped = 0;
+  while (true) {
+    uint64_t pos = wrapped;
+    size = 0;
+    for (size_t p = 0; p < num_partitions; p++) {
+      size_t n = partition_end[p] - partition_begin[p];
+      fill_begin[p] = pos;
+      if (n > 0) {
+        pos = (std::max)(pos + n, fill_end[p]);
+      }
+      size += n;
+    }
+    uint64_t overflow = pos > meta_->num_buckets ? pos - meta_->num_buckets : 0;
+    if (overflow == wrapped) {
+      break;
+    }
+    wrapped = overflow;
+  }
+
+  parallel_for(num_partitions, [&](size_t p, size_t) {
+    uint64_t pos = fill_begin[p];
+    for (size_t i = partition_begin[p]; i < partition_end[p]; i++) {
+      const BulkEntry& entry = partitioned[i];
+      uint64_t bucket_idx = bucket_idx_from_hash(entry.hash);
+      pos = (std::max)(pos, bucket_idx);
+      Bucket bucket = entry.bucket;
+      bucket.dist_and_fingerprint = static_cast<dist_and_fingerprint_type>(
+          dist_and_fingerprint_from_hash(entry.hash) + (pos - bucket_idx) * Bucket::k_dist_inc);
+      buckets_[pos >= meta_->num_buckets ? pos - meta_->num_buckets : pos] = bucket;
+      pos++;
+    }
+  });
+  meta_->size = size;
+  return absl::OkStatus();
+}
+
 template <typename K, typename V, typename H, typename E>
 absl::Status ReadonlyKV<K, V, H, E>::Put(const K& key, const V& val) {
   auto hash = mixed_hash(key);
@@ -823,37 +1439,344 @@ absl::Status ReadonlyKV<K, V, H, E>::Put(const K& key, const V& val) {
 }
 
 template <typename K, typename V, typename H, typename E>
-bool ReadonlyKV<K, V, H, E>::Exists(const K& key) const {
-  auto hash = mixed_hash(key);
+template <typename B>
+const B* ReadonlyKV<K, V, H, E>::FindBucket(const K& key, uint64_t hash, const B* buckets, const uint8_t* data) const {
   auto dist_and_fingerprint = dist_and_fingerprint_from_hash(hash);
   auto bucket_idx = bucket_idx_from_hash(hash);
-  while (dist_and_fingerprint <= buckets_[bucket_idx].dist_and_fingerprint) {
-    if (dist_and_fingerprint == buckets_[bucket_idx].dist_and_fingerprint && equal_(key, GetKeyByBucket(bucket_idx))) {
-      return true;
+  while (dist_and_fingerprint <= buckets[bucket_idx].dist_and_fingerprint) {
+    if (dist_and_fingerprint == buckets[bucket_idx].dist_and_fingerprint &&
+        equal_(key, GetKeyByBucket(buckets + bucket_idx, data))) {
+      return buckets + bucket_idx;
     }
     dist_and_fingerprint = dist_inc(dist_and_fingerprint);
     bucket_idx = next(bucket_idx);
   }
-  return false;
+  return nullptr;
+}
+
+template <typename K, typename V, typename H, typename E>
+const typename ReadonlyKV<K, V, H, E>::Bucket* ReadonlyKV<K, V, H, E>::LookupBucket(const hashed_key_type& key,
+                                                                                   const uint8_t* data,
+                                                                                   Bucket* cuckoo_bucket) const {
+  if constexpr (!Bucket::is_flat) {
+    if (nullptr != front_buckets_) {
+      uint64_t offset = CuckooIndex::FindFront(front_buckets_, front_meta_->shifts, key.hash(), [&](uint64_t offset) {
+        return equal_(key.key(), detail::KeyValPair<K, V>::UnpackKey(data + offset));
+      });
+      if (0 != offset) {
+        cuckoo_bucket->value_idx = offset;
+        return cuckoo_bucket;
+      }
+    }
+    if (nullptr != cuckoo_buckets_) {
+      uint64_t offset = CuckooIndex::Find(LocalCuckooBuckets(), meta_->shifts, key.hash(), [&](uint64_t offset) {
+        return equal_(key.key(), detail::KeyValPair<K, V>::UnpackKey(data + offset));
+      });
+      if (0 == offset) {
+        return nullptr;
+      }
+      cuckoo_bucket->value_idx = offset;
+      return cuckoo_bucket;
+    }
+  }
+  return FindBucket(key.key(), key.hash(), LocalBuckets(), data);
+}
+
+template <typename K, typename V, typename H, typename E>
+void ReadonlyKV<K, V, H, E>::RecordAccess(uint64_t hash, const Bucket* bucket) const {
+  if (nullptr != cuckoo_buckets_) {
+    size_t index_data_offset = index_offset_ + k_meta_reserved_space;
+    access_profile_->Record(index_data_offset +
+                            CuckooIndex::First(hash, meta_->shifts) * sizeof(CuckooIndex::Bucket));
+    access_profile_->Record(index_data_offset +
+                            CuckooIndex::Second(hash, meta_->shifts) * sizeof(CuckooIndex::Bucket));
+  } else {
+    size_t bucket_size = sizeof(Bucket);
+    if (nullptr != inline_buckets_) {
+      bucket_size = sizeof(detail::InlineBucket);
+    } else if (nullptr != record_buckets_) {
+      bucket_size = sizeof(detail::RecordBucket);
+    }
+    access_profile_->Record(index_offset_ + k_meta_reserved_space + bucket_idx_from_hash(hash) * bucket_size);
+  }
+  if constexpr (!Bucket::is_flat) {
+    if (nullptr != bucket) {
+      access_profile_->Record(bucket->value_idx);
+    }
+  }
+}
+template <typename K, typename V, typename H, typename E>
+void ReadonlyKV<K, V, H, E>::RecordAccess(uint64_t hash, const detail::RecordBucket* bucket) const {
+  RecordAccess(hash, static_cast<const Bucket*>(nullptr));
+  if (nullptr != bucket) {
+    access_profile_->Record(bucket->value_idx);
+  }
+}
+
+template <typename K, typename V, typename H, typename E>
+MemoryRegion ReadonlyKV<K, V, H, E>::IndexRegion() const {
+  if (!opt_.readonly) {
+    return MemoryRegion{};
+  }
+  size_t end = index_offset_ + header_->index_size;
+  if (header_->front_index_size > 0) {
+    end = header_->front_index_offset + header_->front_index_size;
+  }
+  return MemoryRegion{data_mmap_file_->GetRawData() + index_offset_, end - index_offset_,
+                      data_mmap_file_->FileBacked()};
+}
+
+template <typename K, typename V, typename H, typename E>
+MemoryRegion ReadonlyKV<K, V, H, E>::DataRegion() const {
+  if (!opt_.readonly) {
+    return MemoryRegion{};
+  }
+  return MemoryRegion{data_mmap_file_->GetRawData() + detail::kRdictMetaHeaderSize, header_->data_size,
+                      data_mmap_file_->FileBacked()};
+}
+
+template <typename K, typename V, typename H, typename E>
+absl::Status ReadonlyKV<K, V, H, E>::SaveAccessProfile(const std::string& path) const {
+  if (nullptr == access_profile_) {
+    return absl::FailedPreconditionError("access profile is not enabled");
+  }
+  return access_profile_->Save(path);
+}
+
+template <typename K, typename V, typename H, typename E>
+bool ReadonlyKV<K, V, H, E>::Exists(const K& key) const {
+  return Exists(hashed_key_type(key));
 }
 
 template <typename K, typename V, typename H, typename E>
 absl::StatusOr<V> ReadonlyKV<K, V, H, E>::Get(const K& key) const {
-  auto hash = mixed_hash(key);
-  auto dist_and_fingerprint = dist_and_fingerprint_from_hash(hash);
-  auto bucket_idx = bucket_idx_from_hash(hash);
-  // printf("####[%lld]get %lld %lld %lld\n", key, bucket_idx, dist_and_fingerprint,
-  //        buckets_[bucket_idx].dist_and_fingerprint);
-  while (dist_and_fingerprint <= buckets_[bucket_idx].dist_and_fingerprint) {
-    // printf("##cmp %lld %lld %lld %d\n", key, GetKey(offset), offset, equal_(key, GetKey(offset)));
-    if (dist_and_fingerprint == buckets_[bucket_idx].dist_and_fingerprint && equal_(key, GetKeyByBucket(bucket_idx))) {
-      return GetValueByBucket(bucket_idx);
+  return Get(hashed_key_type(key));
+}
+
+template <typename K, typename V, typename H, typename E>
+bool ReadonlyKV<K, V, H, E>::Find(const K& key, V* value) const {
+  return Find(hashed_key_type(key), value);
+}
+
+template <typename K, typename V, typename H, typename E>
+bool ReadonlyKV<K, V, H, E>::Exists(const hashed_key_type& key) const {
+  return FindValue(key, nullptr);
+}
+
+template <typename K, typename V, typename H, typename E>
+absl::StatusOr<V> ReadonlyKV<K, V, H, E>::Get(const hashed_key_type& key) const {
+  V value;
+  if (!FindValue(key, &value)) {
+    return absl::NotFoundError("not found entry");
+  }
+  return value;
+}
+
+template <typename K, typename V, typename H, typename E>
+bool ReadonlyKV<K, V, H, E>::Find(const hashed_key_type& key, V* value) const {
+  return FindValue(key, value);
+}
+
+template <typename K, typename V, typename H, typename E>
+bool ReadonlyKV<K, V, H, E>::FindValue(const hashed_key_type& key, V* value) const {
+  const uint8_t* data = LocalData();
+  if constexpr (!Bucket::is_flat) {
+    if (nullptr != inline_buckets_) {
+      const detail::InlineBucket* bucket = FindBucket(key.key(), key.hash(), LocalInlineBuckets(), data);
+      if (nullptr != access_profile_ && access_profile_->Sample()) {
+        // inlined records do not touch the data section
+        Bucket record{nullptr != bucket ? bucket->value_idx : 0, 0};
+        RecordAccess(key.hash(), nullptr == bucket || bucket->inlined ? nullptr : &record);
+      }
+      if (nullptr == bucket) {
+        return false;
+      }
+      if (nullptr != value) {
+        *value = GetValueByBucket(bucket, data);
+      }
+      return true;
     }
-    dist_and_fingerprint = dist_inc(dist_and_fingerprint);
-    bucket_idx = next(bucket_idx);
+  } else {
+    if (nullptr != record_buckets_) {
+      const detail::RecordBucket* bucket = FindBucket(key.key(), key.hash(), LocalRecordBuckets(), data);
+      if (nullptr != access_profile_ && access_profile_->Sample()) {
+        RecordAccess(key.hash(), bucket);
+      }
+      if (nullptr == bucket) {
+        return false;
+      }
+      if (nullptr != value) {
+        *value = GetValueByBucket(bucket, data);
+      }
+      return true;
+    }
+  }
+  Bucket cuckoo_bucket;
+  const Bucket* bucket = LookupBucket(key, data, &cuckoo_bucket);
+  if (nullptr != access_profile_ && access_profile_->Sample()) {
+    RecordAccess(key.hash(), bucket);
+  }
+  if (nullptr == bucket) {
+    return false;
+  }
+  if (nullptr != value) {
+    *value = GetValueByBucket(bucket, data);
+  }
+  return true;
+}
+
+template <typename K, typename V, typename H, typename E>
+void ReadonlyKV<K, V, H, E>::StartLookup(Lookup* lookup) const {
+  lookup->data = LocalData();
+  uint64_t hash = lookup->key.hash();
+  if constexpr (!Bucket::is_flat) {
+    // the front index holds the hottest records, probed at once as LookupBucket does before the main index
+    if (nullptr != front_buckets_ && nullptr == inline_buckets_) {
+      const uint8_t* data = lookup->data;
+      uint64_t offset = CuckooIndex::FindFront(front_buckets_, front_meta_->shifts, hash, [&](uint64_t offset) {
+        return equal_(lookup->key.key(), detail::KeyValPair<K, V>::UnpackKey(data + offset));
+      });
+      if (0 != offset) {
+        Bucket bucket{offset, 0};
+        lookup->found = true;
+        lookup->done = true;
+        lookup->value = GetValueByBucket(&bucket, data);
+        SampleLookup(*lookup, &bucket);
+        return;
+      }
+    }
+  }
+  if (nullptr != cuckoo_buckets_) {
+    __builtin_prefetch(LocalCuckooBuckets() + CuckooIndex::First(hash, meta_->shifts));
+    __builtin_prefetch(LocalCuckooBuckets() + CuckooIndex::Second(hash, meta_->shifts));
+    lookup->bucket_idx = 0;
+  } else {
+    lookup->dist_and_fingerprint = dist_and_fingerprint_from_hash(hash);
+    lookup->bucket_idx = bucket_idx_from_hash(hash);
+    if (nullptr != inline_buckets_) {
+      __builtin_prefetch(LocalInlineBuckets() + lookup->bucket_idx);
+    } else if (nullptr != record_buckets_) {
+      __builtin_prefetch(LocalRecordBuckets() + lookup->bucket_idx);
+    } else {
+      __builtin_prefetch(LocalBuckets() + lookup->bucket_idx);
+    }
+  }
+}
+
+template <typename K, typename V, typename H, typename E>
+bool ReadonlyKV<K, V, H, E>::StepLookup(Lookup* lookup) const {
+  if (lookup->done) {
+    return true;
+  }
+  const uint8_t* data = lookup->data;
+  if constexpr (!Bucket::is_flat) {
+    if (nullptr != cuckoo_buckets_) {
+      uint64_t hash = lookup->key.hash();
+      const CuckooIndex::Bucket* candidates[2] = {
+          LocalCuckooBuckets() + CuckooIndex::First(hash, meta_->shifts),
+          LocalCuckooBuckets() + CuckooIndex::Second(hash, meta_->shifts)};
+      uint64_t tag = CuckooIndex::Tag(hash);
+      for (; lookup->bucket_idx < 2 * CuckooIndex::kSlots; lookup->bucket_idx++) {
+        uint64_t slot =
+            candidates[lookup->bucket_idx / CuckooIndex::kSlots]->slots[lookup->bucket_idx % CuckooIndex::kSlots];
+        if ((slot & ~CuckooIndex::kOffsetMask) != tag) {
+          continue;
+        }
+        uint64_t offset = slot & CuckooIndex::kOffsetMask;
+        if (!lookup->compare_pending) {
+          lookup->compare_pending = true;
+          __builtin_prefetch(data + offset);
+          return false;
+        }
+        lookup->compare_pending = false;
+        if (equal_(lookup->key.key(), detail::KeyValPair<K, V>::UnpackKey(data + offset))) {
+          Bucket bucket{offset, 0};
+          lookup->found = true;
+          lookup->value = GetValueByBucket(&bucket, data);
+          SampleLookup(*lookup, &bucket);
+          return true;
+        }
+      }
+      SampleLookup<Bucket>(*lookup, nullptr);
+      return true;
+    }
+    if (nullptr != inline_buckets_) {
+      return StepRobinHood(lookup, LocalInlineBuckets());
+    }
+  } else {
+    if (nullptr != record_buckets_) {
+      return StepRobinHood(lookup, LocalRecordBuckets());
+    }
+  }
+  return StepRobinHood(lookup, LocalBuckets());
+}
+
+template <typename K, typename V, typename H, typename E>
+template <typename B>
+bool ReadonlyKV<K, V, H, E>::StepRobinHood(Lookup* lookup, const B* buckets) const {
+  const uint8_t* data = lookup->data;
+  while (lookup->dist_and_fingerprint <= buckets[lookup->bucket_idx].dist_and_fingerprint) {
+    const B* bucket = buckets + lookup->bucket_idx;
+    if (lookup->dist_and_fingerprint == bucket->dist_and_fingerprint) {
+      if constexpr (!Bucket::is_flat || std::is_same_v<B, detail::RecordBucket>) {
+        bool needs_data = true;
+        if constexpr (std::is_same_v<B, detail::InlineBucket>) {
+          needs_data = !bucket->inlined;
+        }
+        if (needs_data) {
+          if (!lookup->compare_pending) {
+            lookup->compare_pending = true;
+            __builtin_prefetch(data + bucket->value_idx);
+            return false;
+          }
+          lookup->compare_pending = false;
+        }
+      }
+      if (equal_(lookup->key.key(), GetKeyByBucket(bucket, data))) {
+        lookup->found = true;
+        lookup->value = GetValueByBucket(bucket, data);
+        SampleLookup(*lookup, bucket);
+        return true;
+      }
+    }
+    lookup->dist_and_fingerprint = dist_inc(lookup->dist_and_fingerprint);
+    lookup->bucket_idx = next(lookup->bucket_idx);
+  }
+  SampleLookup<B>(*lookup, nullptr);
+  return true;
+}
+
+template <typename K, typename V, typename H, typename E>
+template <typename B>
+void ReadonlyKV<K, V, H, E>::SampleLookup(const Lookup& lookup, const B* bucket) const {
+  if (nullptr == access_profile_ || !access_profile_->Sample()) {
+    return;
+  }
+  if constexpr (std::is_same_v<B, detail::InlineBucket>) {
+    // inlined records do not touch the data section
+    Bucket record{nullptr != bucket ? bucket->value_idx : 0, 0};
+    RecordAccess(lookup.key.hash(), nullptr == bucket || bucket->inlined ? nullptr : &record);
+  } else {
+    RecordAccess(lookup.key.hash(), bucket);
+  }
+}
+
+#if defined(__cpp_impl_coroutine)
+template <typename K, typename V, typename H, typename E>
+Task<absl::StatusOr<V>> ReadonlyKV<K, V, H, E>::AsyncGet(hashed_key_type key) const {
+  Lookup lookup(key);
+  StartLookup(&lookup);
+  co_await Yield{};
+  while (!StepLookup(&lookup)) {
+    co_await Yield{};
+  }
+  if (!lookup.found) {
+    co_return absl::NotFoundError("not found entry");
   }
-  return absl::NotFoundError("not found entry");
+  co_return lookup.value;
 }
+#endif
+
 template <typename K, typename V, typename H, typename E>
 absl::Status ReadonlyKV<K, V, H, E>::Commit() {
   // std::string index_path = opt_.path_prefix + ".index";
@@ -862,11 +1785,47 @@ absl::Status ReadonlyKV<K, V, H, E>::Commit() {
   //   int err = errno;
   //   return absl::ErrnoToStatus(err, "write rdict index file failed.");
   // }
+  if (!bulk_entries_.empty()) {
+    auto status = BulkFinish();
+    if (!status.ok()) {
+      return status;
+    }
+  }
+  const std::vector<uint8_t>* index = &index_buffer_;
+  std::vector<uint8_t> committed_index;
   uint64_t data_len = data_mmap_file_->GetWriteOffset() - detail::kRdictMetaHeaderSize;
   uint64_t data_pad_len = (data_len + 7) & ~7;
+  if (opt_.index_type == detail::INDEX_CUCKOO) {
+    auto result = BuildCuckooIndex();
+    if (!result.ok()) {
+      return result.status();
+    }
+    committed_index = std::move(result.value());
+    index = &committed_index;
+    // buckets start at a cache line boundary of the file
+    data_pad_len = (data_len + 63) & ~63;
+  } else if (opt_.index_type == detail::INDEX_INLINE) {
+    committed_index = BuildInlineIndex();
+    index = &committed_index;
+    data_pad_len = (data_len + 63) & ~63;
+  }
+  std::vector<uint8_t> front_index = BuildFrontIndex();
   header_->data_size = data_len;
-  header_->index_size = index_buffer_.size();
+  header_->index_size = index->size();
   header_->data_pad_size = data_pad_len - data_len;
+  header_->index_type = opt_.index_type;
+  header_->hash_type = k_hash_type;
+  if constexpr (Bucket::is_flat) {
+    header_->flat_key_size = sizeof(K);
+    header_->flat_value_size = sizeof(V);
+    header_->flat_bucket_size = sizeof(Bucket);
+  }
+  header_->front_index_offset = 0;
+  header_->front_index_size = front_index.size();
+  if (!front_index.empty()) {
+    // after the main index at a cache line boundary
+    header_->front_index_offset = (detail::kRdictMetaHeaderSize + data_pad_len + index->size() + 63) & ~63;
+  }
   memcpy(data_mmap_file_->GetRawData(), header_, detail::kRdictMetaHeaderSize);
 
   std::vector<uint8_t> data_pad(header_->data_pad_size);
@@ -876,10 +1835,23 @@ absl::Status ReadonlyKV<K, V, H, E>::Commit() {
       return result.status();
     }
   }
-  auto result = data_mmap_file_->Add(index_buffer_.data(), index_buffer_.size());
+  auto result = data_mmap_file_->Add(index->data(), index->size());
   if (!result.ok()) {
     return result.status();
   }
+  if (!front_index.empty()) {
+    std::vector<uint8_t> front_pad(header_->front_index_offset - data_mmap_file_->GetWriteOffset());
+    if (front_pad.size() > 0) {
+      result = data_mmap_file_->Add(front_pad.data(), front_pad.size());
+      if (!result.ok()) {
+        return result.status();
+      }
+    }
+    result = data_mmap_file_->Add(front_index.data(), front_index.size());
+    if (!result.ok()) {
+      return result.status();
+    }
+  }
   result = data_mmap_file_->ShrinkToFit();
   if (!result.ok()) {
     return result.status();
@@ -887,6 +1859,195 @@ absl::Status ReadonlyKV<K, V, H, E>::Commit() {
 
   return absl::OkStatus();
 }
+template <typename K, typename V, typename H, typename E>
+absl::StatusOr<std::vector<uint8_t>> ReadonlyKV<K, V, H, E>::BuildCuckooIndex() const {
+  if constexpr (Bucket::is_flat) {
+    return absl::InvalidArgumentError("flat dicts only support robin hood index");
+  } else {
+    std::vector<CuckooIndex::Entry> entries;
+    entries.reserve(meta_->size);
+    for (size_t i = 0; i < meta_->num_buckets; i++) {
+      if (buckets_[i].dist_and_fingerprint > 0) {
+        entries.push_back({mixed_hash(GetKeyByBucket(i)), buckets_[i].value_idx});
+      }
+    }
+    std::vector<CuckooIndex::Bucket> buckets;
+    auto result = CuckooIndex::Build(entries, &buckets);
+    if (!result.ok()) {
+      return result.status();
+    }
+    std::vector<uint8_t> index(k_meta_reserved_space + buckets.size() * sizeof(CuckooIndex::Bucket));
+    IndexMeta* meta = reinterpret_cast<IndexMeta*>(index.data());
+    meta->size = meta_->size;
+    meta->num_buckets = buckets.size();
+    meta->shifts = result.value();
+    memcpy(&index[k_meta_reserved_space], buckets.data(), buckets.size() * sizeof(CuckooIndex::Bucket));
+    return index;
+  }
+}
+
+template <typename K, typename V, typename H, typename E>
+std::vector<uint8_t> ReadonlyKV<K, V, H, E>::BuildInlineIndex() const {
+  std::vector<uint8_t> index(k_meta_reserved_space + meta_->num_buckets * sizeof(detail::InlineBucket));
+  memcpy(index.data(), meta_, sizeof(IndexMeta));
+  if constexpr (!Bucket::is_flat) {
+    detail::InlineBucket* inline_buckets = reinterpret_cast<detail::InlineBucket*>(&index[k_meta_reserved_space]);
+    for (size_t i = 0; i < meta_->num_buckets; i++) {
+      inline_buckets[i].value_idx = buckets_[i].value_idx;
+      inline_buckets[i].dist_and_fingerprint = buckets_[i].dist_and_fingerprint;
+      if (buckets_[i].dist_and_fingerprint > 0) {
+        K k;
+        V v;
+        detail::KeyValPair<K, V>::Unpack(GetKeyValData(buckets_[i].value_idx), k, v);
+        inline_buckets[i].Pack(k, v);
+      }
+    }
+  }
+  return index;
+}
+
+template <typename K, typename V, typename H, typename E>
+absl::Status ReadonlyKV<K, V, H, E>::SetFrontIndex(const std::function<uint64_t(const K&)>& hotness,
+                                                   size_t max_keys) {
+  if (opt_.readonly) {
+    return absl::PermissionDeniedError("Unable to set front index of readonly rdict");
+  }
+  if constexpr (Bucket::is_flat) {
+    return absl::InvalidArgumentError("flat dicts do not support front index");
+  } else {
+    front_hotness_ = hotness;
+    front_index_keys_ = max_keys;
+    return absl::OkStatus();
+  }
+}
+
+template <typename K, typename V, typename H, typename E>
+std::vector<uint8_t> ReadonlyKV<K, V, H, E>::BuildFrontIndex() const {
+  if constexpr (Bucket::is_flat) {
+    return {};
+  } else {
+    // the inline index serves small records from one cache line already
+    if (0 == front_index_keys_ || !front_hotness_ || opt_.index_type == detail::INDEX_INLINE) {
+      return {};
+    }
+    std::vector<std::pair<uint64_t, CuckooIndex::Entry>> hot_entries;
+    for (size_t i = 0; i < meta_->num_buckets; i++) {
+      if (buckets_[i].dist_and_fingerprint > 0) {
+        K key = GetKeyByBucket(i);
+        uint64_t key_hotness = front_hotness_(key);
+        if (key_hotness > 0) {
+          hot_entries.push_back({key_hotness, {mixed_hash(key), buckets_[i].value_idx}});
+        }
+      }
+    }
+    if (hot_entries.empty()) {
+      return {};
+    }
+    auto by_hotness = [](const auto& a, const auto& b) { return a.first > b.first; };
+    if (hot_entries.size() > front_index_keys_) {
+      std::nth_element(hot_entries.begin(), hot_entries.begin() + front_index_keys_, hot_entries.end(), by_hotness);
+      hot_entries.resize(front_index_keys_);
+    }
+    std::sort(hot_entries.begin(), hot_entries.end(), by_hotness);
+    std::vector<CuckooIndex::Entry> entries;
+    entries.reserve(hot_entries.size());
+    for (const auto& hot_entry : hot_entries) {
+      entries.push_back(hot_entry.second);
+    }
+    std::vector<CuckooIndex::Bucket> buckets;
+    uint8_t bits = CuckooIndex::BuildFront(entries, &buckets);
+    std::vector<uint8_t> index(k_meta_reserved_space + buckets.size() * sizeof(CuckooIndex::Bucket));
+    IndexMeta* meta = reinterpret_cast<IndexMeta*>(index.data());
+    meta->size = entries.size();
+    meta->num_buckets = buckets.size();
+    meta->shifts = bits;
+    memcpy(&index[k_meta_reserved_space], buckets.data(), buckets.size() * sizeof(CuckooIndex::Bucket));
+    return index;
+  }
+}
+
+template <typename K, typename V, typename H, typename E>
+absl::Status ReadonlyKV<K, V, H, E>::ReorderData(const std::function<uint64_t(const K&)>& hotness,
+                                                 std::vector<std::pair<uint64_t, uint64_t>>* layout) {
+  if (opt_.readonly) {
+    return absl::PermissionDeniedError("Unable to reorder readonly rdict");
+  }
+  if (!bulk_entries_.empty()) {
+    auto status = BulkFinish();
+    if (!status.ok()) {
+      return status;
+    }
+  }
+  if constexpr (Bucket::is_flat) {
+    // no data section
+    return absl::OkStatus();
+  } else {
+    struct Entry {
+      uint64_t hotness;
+      uint64_t bucket_idx;
+    };
+    std::vector<Entry> entries;
+    entries.reserve(meta_->size);
+    for (size_t i = 0; i < meta_->num_buckets; i++) {
+      if (buckets_[i].dist_and_fingerprint > 0) {
+        entries.push_back({hotness(GetKeyByBucket(i)), i});
+      }
+    }
+    // cold records keep their original order
+    std::stable_sort(entries.begin(), entries.end(), [this](const Entry& a, const Entry& b) {
+      if (a.hotness != b.hotness) {
+        return a.hotness > b.hotness;
+      }
+      return buckets_[a.bucket_idx].value_idx < buckets_[b.bucket_idx].value_idx;
+    });
+
+    MmapFile::Options data_opts;
+    data_opts.path = opt_.path + ".reorder";
+    data_opts.reserved_space_bytes = opt_.reserved_space_bytes;
+    data_opts.truncate = true;
+    if (opt_.atomic_publish) {
+      // replaces the current temporary file, published by Commit
+      data_opts.path = opt_.path;
+      data_opts.temp_path = opt_.path + ".reorder";
+      data_opts.atomic_publish = true;
+    }
+    auto data_file_result = MmapFile::Open(data_opts);
+    if (!data_file_result.ok()) {
+      return data_file_result.status();
+    }
+    auto reorder_file = std::move(data_file_result.value());
+    reorder_file->ResetWriteOffset(detail::kRdictMetaHeaderSize);
+    if (nullptr != layout) {
+      layout->clear();
+      layout->reserve(entries.size());
+    }
+    std::vector<uint64_t> new_offsets(entries.size());
+    for (size_t i = 0; i < entries.size(); i++) {
+      const uint8_t* key_val_data = GetKeyValData(buckets_[entries[i].bucket_idx].value_idx);
+      size_t key_val_len = detail::KeyValPair<K, V>::GetKeyValuePackSize(key_val_data);
+      auto result = reorder_file->Add(key_val_data, key_val_len);
+      if (!result.ok()) {
+        return result.status();
+      }
+      new_offsets[i] = result.value();
+      if (nullptr != layout) {
+        layout->emplace_back(entries[i].hotness, reorder_file->GetWriteOffset());
+      }
+    }
+    if (!opt_.atomic_publish) {
+      auto status = reorder_file->Rename(opt_.path);
+      if (!status.ok()) {
+        return status;
+      }
+    }
+    for (size_t i = 0; i < entries.size(); i++) {
+      buckets_[entries[i].bucket_idx].value_idx = new_offsets[i];
+    }
+    data_mmap_file_ = std::move(reorder_file);
+    return absl::OkStatus();
+  }
+}
+
 template <typename K, typename V, typename H, typename E>
 absl::Status ReadonlyKV<K, V, H, E>::Merge(const ReadonlyKV& other) {
   if (opt_.readonly) {
@@ -899,6 +2060,10 @@ absl::Status ReadonlyKV<K, V, H, E>::Merge(const ReadonlyKV& other) {
     return status;
   }
   if constexpr (Bucket::is_flat) {
+    if (nullptr != other.record_buckets_) {
+      PlaceRecords(other.record_buckets_, other.meta_->num_buckets, other.data_mmap_file_->GetRawData());
+      return absl::OkStatus();
+    }
     const Bucket* other_buckets = other.buckets_;
     uint64_t bucket_offset = 0;
     for (uint64_t value_idx = 0; value_idx < other.meta_->size;) {
@@ -56,6 +56,18 @@ absl::Status ReadonlyList::LoadIndex(bool ignore_nonexist) {
         data_mmap_file_->GetRawData() + detail::kRdictMetaHeaderSize + header_->data_size + header_->data_pad_size;
     offsets_ = reinterpret_cast<uint32_t*>(read_index_data + k_meta_reserved_space);
     meta_ = reinterpret_cast<IndexMeta*>(read_index_data);
+    size_t file_size = read_index_data - data_mmap_file_->GetRawData() + header_->index_size;
+    if (!opt_.warmup_profile_path.empty()) {
+      auto profile = AccessProfile::Load(opt_.warmup_profile_path);
+      if (profile.ok()) {
+        profile.value()->Warmup(data_mmap_file_->GetRawData(), file_size, opt_.warmup_threads);
+      } else if (!absl::IsNotFound(profile.status())) {
+        return profile.status();
+      }
+    }
+    if (opt_.access_profile_sample_rate > 0) {
+      access_profile_ = AccessProfile::New(file_size, opt_.access_profile_sample_rate);
+    }
   } else {
     memcpy(&rdict_header_buffer_[0], data_mmap_file_->GetRawData(), detail::kRdictMetaHeaderSize);
     header_ = reinterpret_cast<detail::RdictMetaHeader*>(&rdict_header_buffer_[0]);
@@ -78,6 +90,10 @@ absl::Status ReadonlyList::Init(const Options& opt) {
   data_opts.readonly = opt.readonly;
   data_opts.reserved_space_bytes = opt.reserved_space_bytes;
   data_opts.truncate = opt.truncate;
+  data_opts.atomic_publish = opt.atomic_publish;
+  data_opts.load_mode = opt.load_mode;
+  data_opts.load_threads = opt.load_threads;
+  data_opts.view = opt.view;
 
   auto data_file_result = MmapFile::Open(data_opts);
   if (!data_file_result.ok()) {
@@ -105,18 +121,17 @@ absl::Status ReadonlyList::Init(const Options& opt) {
 
 absl::Status ReadonlyList::Add(std::string_view s) {
   uint32_t allign_len = (s.size() + sizeof(uint32_t) + 7) & ~7;
-  auto result = data_mmap_file_->Add(s.data(), s.size());
+  auto result = data_mmap_file_->Reserve(allign_len);
   if (!result.ok()) {
     return result.status();
   }
-  uint64_t offset = result.value();
-  std::vector<uint8_t> pad(allign_len - s.size());
+  // value, zero padding and the trailing actual length are written straight into the mapping
+  uint8_t* dst = result.value();
   uint32_t actual_len = s.size();
-  memcpy(&pad[0] + pad.size() - sizeof(uint32_t), &actual_len, sizeof(uint32_t));
-  result = data_mmap_file_->Add(pad.data(), pad.size());
-  if (!result.ok()) {
-    return result.status();
-  }
+  memcpy(dst, s.data(), s.size());
+  memset(dst + s.size(), 0, allign_len - s.size() - sizeof(uint32_t));
+  memcpy(dst + allign_len - sizeof(uint32_t), &actual_len, sizeof(uint32_t));
+  uint64_t offset = data_mmap_file_->Commit(allign_len);
 
   if (meta_->size == meta_->capcity) {
     size_t current_cap = meta_->capcity;
@@ -140,16 +155,21 @@ absl::Status ReadonlyList::Add(std::string_view s) {
 }
 size_t ReadonlyList::Size() const { return nullptr == meta_ ? 0 : meta_->size; }
 
+const uint32_t* ReadonlyList::GetOffsetEntry(size_t idx) const {
+  if (idx < meta_->offset_32bits_num) {
+    return offsets_ + idx;
+  }
+  uint32_t offset_32bits_pad_num =
+      meta_->offset_32bits_num % 2 == 0 ? meta_->offset_32bits_num : meta_->offset_32bits_num + 1;
+  return offsets_ + offset_32bits_pad_num + (idx - meta_->offset_32bits_num) * 2;
+}
+
 uint64_t ReadonlyList::GetOffset(size_t idx) const {
+  const uint32_t* entry = GetOffsetEntry(idx);
   if (idx < meta_->offset_32bits_num) {
-    return offsets_[idx];
-  } else {
-    uint32_t offset_32bits_pad_num =
-        meta_->offset_32bits_num % 2 == 0 ? meta_->offset_32bits_num : meta_->offset_32bits_num + 1;
-    const uint64_t* read_offsets =
-        reinterpret_cast<const uint64_t*>(offsets_ + offset_32bits_pad_num + (idx - meta_->offset_32bits_num) * 2);
-    return *read_offsets;
+    return *entry;
   }
+  return *reinterpret_cast<const uint64_t*>(entry);
 }
 absl::StatusOr<std::string_view> ReadonlyList::Get(size_t idx) const {
   if ((idx) >= meta_->size) {
@@ -157,6 +177,10 @@ absl::StatusOr<std::string_view> ReadonlyList::Get(size_t idx) const {
   }
   uint64_t offset = GetOffset(idx);
   auto data_start = data_mmap_file_->GetRawData() + offset;
+  if (nullptr != access_profile_ && access_profile_->Sample()) {
+    access_profile_->Record(reinterpret_cast<const uint8_t*>(GetOffsetEntry(idx)) - data_mmap_file_->GetRawData());
+    access_profile_->Record(offset);
+  }
   uint64_t next_offset = data_mmap_file_->GetWriteOffset();
   if ((idx + 1) < meta_->size) {
     next_offset = GetOffset(idx + 1);
@@ -171,6 +195,27 @@ absl::StatusOr<std::string_view> ReadonlyList::Get(size_t idx) const {
   // printf("###size:%lld, len:%lld,next_offset:%lld,offset:%lld \n", len, act_len, next_offset, offset);
   return std::string_view(reinterpret_cast<const char*>(data_start), act_len);
 }
+MemoryRegion ReadonlyList::IndexRegion() const {
+  if (!opt_.readonly) {
+    return MemoryRegion{};
+  }
+  return MemoryRegion{reinterpret_cast<const uint8_t*>(meta_), header_->index_size, data_mmap_file_->FileBacked()};
+}
+
+MemoryRegion ReadonlyList::DataRegion() const {
+  if (!opt_.readonly) {
+    return MemoryRegion{};
+  }
+  return MemoryRegion{data_mmap_file_->GetRawData() + detail::kRdictMetaHeaderSize, header_->data_size,
+                      data_mmap_file_->FileBacked()};
+}
+
+absl::Status ReadonlyList::SaveAccessProfile(const std::string& path) const {
+  if (nullptr == access_profile_) {
+    return absl::FailedPreconditionError("access profile is not enabled");
+  }
+  return access_profile_->Save(path);
+}
 absl::Status ReadonlyList::Commit() {
   uint32_t offset_32bits_pad_num =
       meta_->offset_32bits_num % 2 == 0 ? meta_->offset_32bits_num : meta_->offset_32bits_num + 1;
@@ -34,6 +34,7 @@
 #include <cstdint>
 #include <string_view>
 #include <vector>
+#include "rdict/access_profile.h"
 #include "rdict/common.h"
 #include "rdict/mmap_file.h"
 
@@ -45,11 +46,26 @@ class ReadonlyList {
     size_t reserved_space_bytes = 100 * 1024 * 1024 * 1024LL;
     bool readonly = false;
     bool truncate = false;
+    // writable only, build into a temporary file renamed to 'path' by Commit, see MmapFile::Options
+    bool atomic_publish = false;
+    MmapFile::LoadMode load_mode = MmapFile::LOAD_MMAP;
+    uint32_t load_threads = 4;
+    // readonly only, load from a range of an already loaded file instead of 'path', see DictBundle::Open
+    MmapFile::View view;
+    // readonly only, record touched pages of one in every N lookups, 0 to disable
+    uint32_t access_profile_sample_rate = 0;
+    // readonly only, touch the hot pages recorded in this profile before Load returns
+    std::string warmup_profile_path;
+    uint32_t warmup_threads = 8;
   };
   static absl::StatusOr<std::unique_ptr<ReadonlyList>> New(const Options& opt);
   absl::Status Add(std::string_view s);
   size_t Size() const;
   absl::StatusOr<std::string_view> Get(size_t idx) const;
+  absl::Status SaveAccessProfile(const std::string& path) const;
+  // readonly only, the mapped index and data section, empty for writable lists
+  MemoryRegion IndexRegion() const;
+  MemoryRegion DataRegion() const;
   absl::Status Commit();
 
  protected:
@@ -62,6 +78,8 @@ class ReadonlyList {
   ReadonlyList() {}
   absl::Status LoadIndex(bool ignore_nonexist);
   absl::Status Init(const Options& opt);
+  // the index entry of 'idx', a uint32_t for the first 'offset_32bits_num' records and a uint64_t after
+  const uint32_t* GetOffsetEntry(size_t idx) const;
   uint64_t GetOffset(size_t idx) const;
 
   Options opt_;
@@ -71,6 +89,7 @@ class ReadonlyList {
   std::unique_ptr<MmapFile> data_mmap_file_;
   std::vector<uint8_t> rdict_header_buffer_;
   detail::RdictMetaHeader* header_ = nullptr;
+  std::unique_ptr<AccessProfile> access_profile_;
 };
 
 }  // namespace rdict
\ No newline at end of file
@@ -31,6 +31,10 @@
 #include "rdict/mmap_file.h"
 #include <fcntl.h>
 #include <sys/mman.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <thread>
 #include "folly/File.h"
 #include "folly/FileUtil.h"
 
@@ -47,25 +51,50 @@ MmapFile::MmapFile() {}
 
 absl::Status MmapFile::Init(const Options& opts) {
   opts_ = opts;
+  if (nullptr != opts.view.file) {
+    if (!opts.readonly || opts.view.offset + opts.view.size > opts.view.file->GetWriteOffset()) {
+      return absl::InvalidArgumentError("invalid readonly view of file path:" + opts_.path);
+    }
+    view_file_ = opts.view.file;
+    data_ = const_cast<uint8_t*>(view_file_->GetRawData()) + opts.view.offset;
+    capacity_ = opts.view.size;
+    write_offset_ = opts.view.size;
+    readonly_ = true;
+    return absl::OkStatus();
+  }
+  bool copy_existing = false;
+  if (!opts.readonly && opts.atomic_publish) {
+    publish_path_ = opts.path;
+    opts_.path = opts.temp_path.empty() ? opts.path + ".tmp" : opts.temp_path;
+    // leftovers of an interrupted build are discarded, an existing file is appended through a copy
+    opts_.truncate = true;
+    copy_existing = !opts.truncate && 0 == access(opts.path.c_str(), F_OK);
+  }
   std::unique_ptr<folly::File> segment_file;
   size_t file_size = 0;
   try {
     int file_flags = 0;
-    if (!opts.readonly) {
+    if (!opts_.readonly) {
       file_flags = O_RDWR | O_CREAT | O_CLOEXEC;
-      if (opts.truncate) {
+      if (opts_.truncate) {
         file_flags = file_flags | O_TRUNC;
       }
     } else {
       file_flags = O_RDONLY | O_CLOEXEC;
     }
     int mode = 0644;
-    segment_file = std::make_unique<folly::File>(opts.path, file_flags, mode);
+    segment_file = std::make_unique<folly::File>(opts_.path, file_flags, mode);
+    if (copy_existing) {
+      auto status = CopyFrom(opts.path, segment_file->fd());
+      if (!status.ok()) {
+        return status;
+      }
+    }
     struct stat st;
     int rc = fstat(segment_file->fd(), &st);
     if (rc != 0) {
       // int err = errno;
-      return absl::InvalidArgumentError("fstat failed for  file path:" + opts.path);
+      return absl::InvalidArgumentError("fstat failed for  file path:" + opts_.path);
     }
     file_size = st.st_size;
     write_offset_ = file_size;
@@ -81,11 +110,14 @@ absl::Status MmapFile::Init(const Options& opts) {
       int rc = ftruncate(segment_file->fd(), file_size);
       if (rc != 0) {
         // int err = errno;
-        return absl::InvalidArgumentError("truncate failed for  file path:" + opts.path);
+        return absl::InvalidArgumentError("truncate failed for  file path:" + opts_.path);
       }
     }
   } catch (...) {
-    return absl::InvalidArgumentError("invalid segment file path:" + opts.path);
+    return absl::InvalidArgumentError("invalid segment file path:" + opts_.path);
+  }
+  if (opts.readonly && opts.load_mode == LOAD_ANONYMOUS) {
+    return LoadAnonymous(segment_file->fd(), file_size);
   }
   capacity_ = file_size;
   size_t reserved_space_bytes = file_size;
@@ -103,14 +135,116 @@ absl::Status MmapFile::Init(const Options& opts) {
   int mmap_flags = 0;
   if (opts.readonly) {
     mmap_flags = MAP_PRIVATE | MAP_FILE;
+    if (opts.populate) {
+      mmap_flags |= MAP_POPULATE;
+    }
   } else {
     mmap_flags = MAP_SHARED | MAP_FILE;
   }
-  void* mapping_addr = mmap(reserved_addr_space, file_size, PROT_READ | PROT_WRITE, mmap_flags, segment_file->fd(), 0);
+  // fixed at the start of the reserved space which later segments extend into, a hint alone is not honored since the
+  // range is already mapped
+  void* mapping_addr =
+      mmap(reserved_addr_space, file_size, PROT_READ | PROT_WRITE, mmap_flags | MAP_FIXED, segment_file->fd(), 0);
   if (mapping_addr == MAP_FAILED) {
+    munmap(reserved_addr_space, reserved_space_bytes);
     return absl::InvalidArgumentError("mmap file failed");
   }
   data_ = reinterpret_cast<uint8_t*>(mapping_addr);
+  if (!opts.readonly) {
+    fd_ = segment_file->release();
+  }
+  return absl::OkStatus();
+}
+
+absl::Status MmapFile::CopyFrom(const std::string& path, int fd) {
+  try {
+    folly::File src(path, O_RDONLY | O_CLOEXEC);
+    while (true) {
+      ssize_t n = copy_file_range(src.fd(), nullptr, fd, nullptr, kSegmentSize, 0);
+      if (n < 0) {
+        return absl::InternalError("copy " + path + " to " + opts_.path + " failed");
+      }
+      if (n == 0) {
+        break;
+      }
+    }
+  } catch (...) {
+    return absl::InvalidArgumentError("invalid file path:" + path);
+  }
+  return absl::OkStatus();
+}
+
+void MmapFile::ResetWriteOffset(uint64_t v) {
+  write_offset_ = v;
+  if (flushed_offset_ > v) {
+    flushed_offset_ = v / kSegmentSize * kSegmentSize;
+    flush_wait_offset_ = std::min(flush_wait_offset_, flushed_offset_);
+  }
+}
+
+void MmapFile::FlushSegments() {
+  size_t end = write_offset_ / kSegmentSize * kSegmentSize;
+  if (end <= flushed_offset_) {
+    return;
+  }
+  // wait for the write-out started last time before starting the next one, this keeps dirty pages bounded to a few
+  // segments and spreads the write-out cost across the build instead of one huge sync in ShrinkToFit
+  if (flushed_offset_ > flush_wait_offset_) {
+    sync_file_range(fd_, flush_wait_offset_, flushed_offset_ - flush_wait_offset_, SYNC_FILE_RANGE_WAIT_BEFORE);
+  }
+  sync_file_range(fd_, flushed_offset_, end - flushed_offset_, SYNC_FILE_RANGE_WRITE);
+  flush_wait_offset_ = flushed_offset_;
+  flushed_offset_ = end;
+}
+
+absl::Status MmapFile::LoadAnonymous(int fd, size_t file_size) {
+  size_t map_size = (file_size + kHugePageSize - 1) / kHugePageSize * kHugePageSize;
+  if (map_size == 0) {
+    map_size = kHugePageSize;
+  }
+  // prefer preallocated hugetlbfs pages, fallback to transparent huge pages
+  void* addr = mmap(nullptr, map_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+  if (addr != MAP_FAILED) {
+    anonymous_base_ = reinterpret_cast<uint8_t*>(addr);
+    anonymous_size_ = map_size;
+    data_ = anonymous_base_;
+  } else {
+    // over allocate one huge page so that the data start is 2MB aligned for THP
+    anonymous_size_ = map_size + kHugePageSize;
+    addr = mmap(nullptr, anonymous_size_, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (addr == MAP_FAILED) {
+      anonymous_size_ = 0;
+      return absl::ResourceExhaustedError("allocate anonymous memory failed for file:" + opts_.path);
+    }
+    anonymous_base_ = reinterpret_cast<uint8_t*>(addr);
+    uintptr_t aligned_addr = (reinterpret_cast<uintptr_t>(addr) + kHugePageSize - 1) & ~(kHugePageSize - 1);
+    data_ = reinterpret_cast<uint8_t*>(aligned_addr);
+    madvise(data_, map_size, MADV_HUGEPAGE);
+  }
+
+  size_t threads = std::max<size_t>(1, opts_.load_threads);
+  size_t chunk_size = (file_size + threads - 1) / threads;
+  chunk_size = (chunk_size + kHugePageSize - 1) / kHugePageSize * kHugePageSize;
+  std::atomic<bool> read_failed{false};
+  std::vector<std::thread> workers;
+  for (size_t offset = 0; offset < file_size; offset += chunk_size) {
+    size_t len = std::min(chunk_size, file_size - offset);
+    workers.emplace_back([this, fd, offset, len, &read_failed]() {
+      ssize_t n = folly::preadFull(fd, data_ + offset, len, static_cast<off_t>(offset));
+      if (n < 0 || static_cast<size_t>(n) != len) {
+        read_failed = true;
+      }
+    });
+  }
+  for (auto& worker : workers) {
+    worker.join();
+  }
+  if (read_failed) {
+    return absl::InternalError("read file into anonymous memory failed:" + opts_.path);
+  }
+  capacity_ = map_size;
+  write_offset_ = file_size;
+  readonly_ = true;
   return absl::OkStatus();
 }
 
@@ -154,7 +288,7 @@ absl::Status MmapFile::ExtendBuffer(size_t len) {
   return absl::OkStatus();
 }
 
-absl::StatusOr<size_t> MmapFile::Add(const void* data, size_t len) {
+absl::StatusOr<uint8_t*> MmapFile::Reserve(size_t len) {
   if (readonly_) {
     return absl::PermissionDeniedError("unable to write readonly data");
   }
@@ -164,14 +298,40 @@ absl::StatusOr<size_t> MmapFile::Add(const void* data, size_t len) {
       return status;
     }
   }
-  memcpy(data_ + write_offset_, data, len);
-  size_t data_offset = write_offset_;
-  write_offset_ += len;
-  return data_offset;
+  return data_ + write_offset_;
+}
+
+absl::StatusOr<size_t> MmapFile::Add(const void* data, size_t len) {
+  auto result = Reserve(len);
+  if (!result.ok()) {
+    return result.status();
+  }
+  memcpy(result.value(), data, len);
+  return Commit(len);
 }
 
 absl::StatusOr<size_t> MmapFile::ShrinkToFit() {
   readonly_ = true;
+  if (!publish_path_.empty()) {
+    // completed segments are written back already, the sync only covers the tail, the header and the index
+    if (0 != ftruncate(fd_, write_offset_) || 0 != fdatasync(fd_)) {
+      return absl::InternalError("sync file failed:" + opts_.path);
+    }
+    if (0 != rename(opts_.path.c_str(), publish_path_.c_str())) {
+      return absl::InternalError("rename " + opts_.path + " to " + publish_path_ + " failed");
+    }
+    // persist the rename
+    size_t pos = publish_path_.find_last_of('/');
+    std::string dir = pos == std::string::npos ? "." : (pos == 0 ? "/" : publish_path_.substr(0, pos));
+    int dir_fd = open(dir.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (dir_fd >= 0) {
+      fsync(dir_fd);
+      close(dir_fd);
+    }
+    opts_.path = publish_path_;
+    publish_path_.clear();
+    return write_offset_;
+  }
   if (nullptr != data_) {
     msync(data_, write_offset_, 0);
   }
@@ -183,9 +343,30 @@ absl::StatusOr<size_t> MmapFile::ShrinkToFit() {
   return write_offset_;
 }
 
+absl::Status MmapFile::Rename(const std::string& path) {
+  if (0 != rename(opts_.path.c_str(), path.c_str())) {
+    return absl::InternalError("rename " + opts_.path + " to " + path + " failed");
+  }
+  opts_.path = path;
+  return absl::OkStatus();
+}
+
 MmapFile::~MmapFile() {
-  if (nullptr != data_) {
-    munmap(data_, capacity_);
+  if (fd_ >= 0) {
+    close(fd_);
+    fd_ = -1;
+  }
+  if (!publish_path_.empty()) {
+    // never published, discard the partial build
+    unlink(opts_.path.c_str());
+  }
+  if (nullptr != anonymous_base_) {
+    munmap(anonymous_base_, anonymous_size_);
+    anonymous_base_ = nullptr;
+    data_ = nullptr;
+  }
+  if (nullptr != data_ && nullptr == view_file_) {
+    munmap(data_, std::max(capacity_, opts_.reserved_space_bytes));
     data_ = nullptr;
   }
 }
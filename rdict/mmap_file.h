@@ -44,33 +44,84 @@ namespace rdict {
 class MmapFile {
  public:
   static constexpr size_t kSegmentSize = 64 * 1024 * 1024;
+  static constexpr size_t kHugePageSize = 2 * 1024 * 1024;
+  enum LoadMode {
+    LOAD_MMAP = 0,
+    // copy the whole file into hugepage backed anonymous memory with parallel pread, readonly only
+    LOAD_ANONYMOUS,
+  };
+  // a range of a readonly loaded file, e.g. a dict of a DictBundle, the range keeps the file mapped
+  struct View {
+    std::shared_ptr<const MmapFile> file;
+    size_t offset = 0;
+    size_t size = 0;
+  };
   struct Options {
     std::string path;
     size_t reserved_space_bytes = 100 * 1024 * 1024 * 1024LL;
     bool readonly = false;
     bool truncate = false;
+    LoadMode load_mode = LOAD_MMAP;
+    uint32_t load_threads = 4;
+    // writable only, build into 'temp_path'(default 'path' + ".tmp") with completed segments written back during
+    // ingestion, ShrinkToFit then fdatasyncs and renames it to 'path'. readers never see a partially built file, a
+    // file destroyed before ShrinkToFit is discarded.
+    bool atomic_publish = false;
+    std::string temp_path;
+    // readonly only, prefault the whole file at mmap(MAP_POPULATE) with LOAD_MMAP
+    bool populate = false;
+    // readonly only, serve the range of 'view.file' in place of 'path' without any mapping or copy of its own
+    View view;
   };
   static absl::StatusOr<std::unique_ptr<MmapFile>> Open(const Options& opts);
 
   absl::StatusOr<size_t> Add(const void* data, size_t len);
+  // returns a writable span of 'len' bytes at the write offset, the bytes are appended by the following Commit
+  absl::StatusOr<uint8_t*> Reserve(size_t len);
+  // appends 'len' bytes of the reserved span, returns their offset
+  size_t Commit(size_t len) {
+    size_t data_offset = write_offset_;
+    write_offset_ += len;
+    if (write_offset_ >= flushed_offset_ + kSegmentSize && !publish_path_.empty()) {
+      FlushSegments();
+    }
+    return data_offset;
+  }
   uint8_t* GetRawData() { return data_; }
   const uint8_t* GetRawData() const { return data_; }
   uint64_t GetWriteOffset() const { return write_offset_; }
-  void ResetWriteOffset(uint64_t v) { write_offset_ = v; }
+  void ResetWriteOffset(uint64_t v);
   bool Writable() const { return !readonly_; }
+  // false if the content is an anonymous copy of the file(LOAD_ANONYMOUS)
+  bool FileBacked() const { return nullptr == view_file_ ? nullptr == anonymous_base_ : view_file_->FileBacked(); }
   absl::StatusOr<size_t> ShrinkToFit();
+  // rename the underlying file, the mapping stays valid
+  absl::Status Rename(const std::string& path);
 
   ~MmapFile();
 
  private:
   MmapFile();
   absl::Status Init(const Options& opts);
+  absl::Status LoadAnonymous(int fd, size_t file_size);
   absl::Status ExtendBuffer(size_t len);
+  absl::Status CopyFrom(const std::string& path, int fd);
+  void FlushSegments();
   Options opts_;
   uint8_t* data_ = nullptr;
   size_t capacity_ = 0;
   size_t write_offset_ = 0;
   size_t reserved_space_bytes_ = 0;
+  uint8_t* anonymous_base_ = nullptr;
+  size_t anonymous_size_ = 0;
   bool readonly_ = false;
+  int fd_ = -1;
+  // the file owning the mapping of a view
+  std::shared_ptr<const MmapFile> view_file_;
+  // final path of an atomic publish file, empty once published
+  std::string publish_path_;
+  // write-out of [flush_wait_offset_, flushed_offset_) is started but not waited yet
+  size_t flushed_offset_ = 0;
+  size_t flush_wait_offset_ = 0;
 };
 }  // namespace rdict
\ No newline at end of file
@@ -0,0 +1,135 @@
+/*
+** BSD 3-Clause License
+**
+** Copyright (c) 2023, qiyingwang <qiyingwang@tencent.com>, the respective contributors, as shown by the AUTHORS file.
+** All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions are met:
+** * Redistributions of source code must retain the above copyright notice, this
+** list of conditions and the following disclaimer.
+**
+** * Redistributions in binary form must reproduce the above copyright notice,
+** this list of conditions and the following disclaimer in the documentation
+** and/or other materials provided with the distribution.
+**
+** * Neither the name of the copyright holder nor the names of its
+** contributors may be used to endorse or promote products derived from
+** this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+** AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+** IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+** DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+** FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+** DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+** SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+** CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+** OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#include "rdict/numa_replica.h"
+#include <sched.h>
+#include <cstring>
+#include <thread>
+#ifdef RDICT_WITH_NUMA
+#include <numa.h>
+#endif
+
+namespace rdict {
+#ifdef RDICT_WITH_NUMA
+static int current_numa_node() {
+  // the node of a thread rarely changes, refresh it periodically instead of per call
+  static constexpr uint32_t kRefreshInterval = 4096;
+  thread_local int node = -1;
+  thread_local uint32_t calls = 0;
+  if (node < 0 || ++calls % kRefreshInterval == 0) {
+    int cpu = sched_getcpu();
+    node = cpu < 0 ? 0 : numa_node_of_cpu(cpu);
+    if (node < 0) {
+      node = 0;
+    }
+  }
+  return node;
+}
+
+bool NumaReplica::Available() { return numa_available() >= 0 && numa_max_node() > 0; }
+
+std::unique_ptr<NumaReplica> NumaReplica::New(const uint8_t* data, size_t len) {
+  if (!Available() || nullptr == data || 0 == len) {
+    return nullptr;
+  }
+  std::unique_ptr<NumaReplica> p(new NumaReplica);
+  p->size_ = len;
+  int num_nodes = numa_max_node() + 1;
+  p->replicas_.resize(num_nodes, nullptr);
+  for (int node = 0; node < num_nodes; node++) {
+    if (!numa_bitmask_isbitset(numa_all_nodes_ptr, node)) {
+      continue;
+    }
+    p->replicas_[node] = reinterpret_cast<uint8_t*>(numa_alloc_onnode(len, node));
+    if (nullptr == p->replicas_[node]) {
+      return nullptr;
+    }
+  }
+  // copy with one thread per node so that pages are faulted by a local cpu
+  std::vector<std::thread> workers;
+  for (int node = 0; node < num_nodes; node++) {
+    uint8_t* replica = p->replicas_[node];
+    if (nullptr == replica) {
+      continue;
+    }
+    workers.emplace_back([node, replica, data, len]() {
+      numa_run_on_node(node);
+      memcpy(replica, data, len);
+    });
+  }
+  for (auto& worker : workers) {
+    worker.join();
+  }
+  // nodes without memory fallback to the first replica
+  uint8_t* first_replica = nullptr;
+  for (uint8_t* replica : p->replicas_) {
+    if (nullptr != replica) {
+      first_replica = replica;
+      break;
+    }
+  }
+  for (int node = 0; node < num_nodes; node++) {
+    if (nullptr == p->replicas_[node]) {
+      p->replicas_[node] = first_replica;
+    }
+  }
+  return p;
+}
+
+const uint8_t* NumaReplica::Local() const {
+  size_t node = static_cast<size_t>(current_numa_node());
+  return node < replicas_.size() ? replicas_[node] : replicas_[0];
+}
+
+NumaReplica::~NumaReplica() {
+  for (size_t node = 0; node < replicas_.size(); node++) {
+    uint8_t* replica = replicas_[node];
+    if (nullptr == replica) {
+      continue;
+    }
+    bool shared = false;
+    for (size_t i = 0; i < node; i++) {
+      if (replicas_[i] == replica) {
+        shared = true;
+        break;
+      }
+    }
+    if (!shared) {
+      numa_free(replica, size_);
+    }
+  }
+}
+#else
+bool NumaReplica::Available() { return false; }
+std::unique_ptr<NumaReplica> NumaReplica::New(const uint8_t*, size_t) { return nullptr; }
+const uint8_t* NumaReplica::Local() const { return replicas_[0]; }
+NumaReplica::~NumaReplica() {}
+#endif
+}  // namespace rdict
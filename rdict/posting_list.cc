@@ -0,0 +1,309 @@
+/*
+** BSD 3-Clause License
+**
+** Copyright (c) 2023, qiyingwang <qiyingwang@tencent.com>, the respective contributors, as shown by the AUTHORS file.
+** All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions are met:
+** * Redistributions of source code must retain the above copyright notice, this
+** list of conditions and the following disclaimer.
+**
+** * Redistributions in binary form must reproduce the above copyright notice,
+** this list of conditions and the following disclaimer in the documentation
+** and/or other materials provided with the distribution.
+**
+** * Neither the name of the copyright holder nor the names of its
+** contributors may be used to endorse or promote products derived from
+** this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+** AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+** IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+** DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+** FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+** DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+** SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+** CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+** OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#include "rdict/posting_list.h"
+#include <algorithm>
+#include <array>
+#include <queue>
+#include <utility>
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
+#include "folly/Likely.h"
+
+namespace rdict {
+namespace {
+constexpr size_t kHeaderSize = 2 * sizeof(uint32_t);
+
+inline size_t ControlBytes(size_t n) { return (n + 3) / 4; }
+
+inline size_t DeltaBytes(uint32_t delta) {
+  if (delta < (1U << 8)) return 1;
+  if (delta < (1U << 16)) return 2;
+  if (delta < (1U << 24)) return 3;
+  return 4;
+}
+
+inline uint32_t LoadDelta(const uint8_t* data, size_t len) {
+  uint32_t v = 0;
+  memcpy(&v, data, len);  // little endian
+  return v;
+}
+
+// decodes 'n' deltas from 'ctrl'/'data' starting at quad 'quad', 'prev' is the doc before the first one
+inline void DecodeScalar(const uint8_t* ctrl, const uint8_t* data, size_t quad, size_t n, uint32_t prev,
+                         uint32_t* docs) {
+  for (size_t i = quad * 4; i < n; i++) {
+    size_t len = ((ctrl[i / 4] >> (2 * (i % 4))) & 3) + 1;
+    prev += LoadDelta(data, len);
+    data += len;
+    docs[i] = prev;
+  }
+}
+
+constexpr auto kQuadLength = [] {
+  std::array<uint8_t, 256> table{};
+  for (size_t c = 0; c < 256; c++) {
+    table[c] = ((c & 3) + 1) + (((c >> 2) & 3) + 1) + (((c >> 4) & 3) + 1) + (((c >> 6) & 3) + 1);
+  }
+  return table;
+}();
+
+#if defined(__x86_64__)
+// pshufb masks moving the 1~4 bytes of each delta to its 32bit lane, 0x80 zeros the rest
+constexpr auto kShuffleTable = [] {
+  std::array<std::array<uint8_t, 16>, 256> table{};
+  for (size_t c = 0; c < 256; c++) {
+    uint8_t offset = 0;
+    for (size_t lane = 0; lane < 4; lane++) {
+      size_t len = ((c >> (2 * lane)) & 3) + 1;
+      for (size_t b = 0; b < 4; b++) {
+        table[c][lane * 4 + b] = b < len ? offset++ : 0x80;
+      }
+    }
+  }
+  return table;
+}();
+
+// full quads are decoded while 16 bytes can be loaded before 'end', the rest is left to the scalar tail
+__attribute__((target("ssse3"))) size_t DecodeSsse3(const uint8_t* ctrl, const uint8_t* data, const uint8_t* end,
+                                                    size_t n, uint32_t* prev, uint32_t* docs) {
+  __m128i last = _mm_set1_epi32(static_cast<int>(*prev));
+  size_t quad = 0;
+  for (; quad < n / 4 && data + 16 <= end; quad++) {
+    uint8_t c = ctrl[quad];
+    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data));
+    v = _mm_shuffle_epi8(v, _mm_loadu_si128(reinterpret_cast<const __m128i*>(kShuffleTable[c].data())));
+    v = _mm_add_epi32(v, _mm_slli_si128(v, 4));
+    v = _mm_add_epi32(v, _mm_slli_si128(v, 8));
+    v = _mm_add_epi32(v, last);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(docs + quad * 4), v);
+    last = _mm_shuffle_epi32(v, 0xFF);
+    data += kQuadLength[c];
+  }
+  *prev = static_cast<uint32_t>(_mm_cvtsi128_si32(last));
+  return quad;
+}
+
+const bool kHasSsse3 = (__builtin_cpu_init(), __builtin_cpu_supports("ssse3"));
+#else
+const bool kHasSsse3 = false;
+#endif
+}  // namespace
+
+absl::Status PostingList::Encode(const uint32_t* docs, size_t n, std::string* out) {
+  for (size_t i = 1; i < n; i++) {
+    if (docs[i] <= docs[i - 1]) {
+      return absl::InvalidArgumentError("posting list docs must be strictly increasing");
+    }
+  }
+  if (n > UINT32_MAX) {
+    return absl::InvalidArgumentError("too many docs in posting list");
+  }
+  size_t blocks = (n + kBlockSize - 1) / kBlockSize;
+  size_t start = out->size();
+  uint32_t header[2] = {static_cast<uint32_t>(n), static_cast<uint32_t>(blocks)};
+  out->append(reinterpret_cast<const char*>(header), sizeof(header));
+  out->resize(out->size() + blocks * sizeof(Skip));
+  size_t data_start = out->size();
+  uint32_t base = 0;
+  for (size_t block = 0; block < blocks; block++) {
+    const uint32_t* block_docs = docs + block * kBlockSize;
+    size_t count = std::min(kBlockSize, n - block * kBlockSize);
+    Skip skip;
+    skip.last_doc = block_docs[count - 1];
+    skip.offset = static_cast<uint32_t>(out->size() - data_start);
+    memcpy(out->data() + start + kHeaderSize + block * sizeof(Skip), &skip, sizeof(Skip));
+
+    size_t ctrl_pos = out->size();
+    out->resize(ctrl_pos + ControlBytes(count));
+    for (size_t i = 0; i < count; i++) {
+      uint32_t delta = block_docs[i] - base;
+      size_t len = DeltaBytes(delta);
+      (*out)[ctrl_pos + i / 4] |= static_cast<char>((len - 1) << (2 * (i % 4)));
+      out->append(reinterpret_cast<const char*>(&delta), len);
+      base = block_docs[i];
+    }
+  }
+  if (out->size() - data_start > UINT32_MAX) {
+    return absl::InvalidArgumentError("posting list too large");
+  }
+  return absl::OkStatus();
+}
+
+absl::StatusOr<PostingList> PostingList::Parse(std::string_view encoded) {
+  if (encoded.size() < kHeaderSize) {
+    return absl::DataLossError("posting list too short");
+  }
+  uint32_t header[2];
+  memcpy(header, encoded.data(), sizeof(header));
+  PostingList list;
+  list.size_ = header[0];
+  list.blocks_ = header[1];
+  if (list.blocks_ != (list.size_ + kBlockSize - 1) / kBlockSize ||
+      encoded.size() < kHeaderSize + list.blocks_ * sizeof(Skip)) {
+    return absl::DataLossError("corrupt posting list header");
+  }
+  list.skips_ = reinterpret_cast<const uint8_t*>(encoded.data()) + kHeaderSize;
+  list.data_ = list.skips_ + list.blocks_ * sizeof(Skip);
+  list.data_size_ = encoded.size() - kHeaderSize - list.blocks_ * sizeof(Skip);
+  uint32_t prev_offset = 0;
+  for (size_t block = 0; block < list.blocks_; block++) {
+    uint32_t offset = list.GetSkip(block).offset;
+    size_t n = std::min(kBlockSize, list.size_ - block * kBlockSize);
+    if (offset < prev_offset || offset + ControlBytes(n) + n > list.data_size_) {
+      return absl::DataLossError("corrupt posting list skips");
+    }
+    prev_offset = offset;
+  }
+  return list;
+}
+
+bool PostingList::HardwareAccelerated() { return kHasSsse3; }
+
+size_t PostingList::DecodeBlockPortable(size_t block, uint32_t* docs) const {
+  size_t n = std::min(kBlockSize, size_ - block * kBlockSize);
+  const uint8_t* ctrl = data_ + GetSkip(block).offset;
+  uint32_t prev = block == 0 ? 0 : GetSkip(block - 1).last_doc;
+  DecodeScalar(ctrl, ctrl + ControlBytes(n), 0, n, prev, docs);
+  return n;
+}
+
+size_t PostingList::DecodeBlock(size_t block, uint32_t* docs) const {
+#if defined(__x86_64__)
+  if (FOLLY_LIKELY(kHasSsse3)) {
+    size_t n = std::min(kBlockSize, size_ - block * kBlockSize);
+    const uint8_t* ctrl = data_ + GetSkip(block).offset;
+    const uint8_t* data = ctrl + ControlBytes(n);
+    uint32_t prev = block == 0 ? 0 : GetSkip(block - 1).last_doc;
+    size_t quad = DecodeSsse3(ctrl, data, data_ + data_size_, n, &prev, docs);
+    if (quad * 4 < n) {
+      for (size_t i = 0; i < quad; i++) {
+        data += kQuadLength[ctrl[i]];
+      }
+      DecodeScalar(ctrl, data, quad, n, prev, docs);
+    }
+    return n;
+  }
+#endif
+  return DecodeBlockPortable(block, docs);
+}
+
+std::vector<uint32_t> PostingList::Decode() const {
+  std::vector<uint32_t> docs(size_);
+  for (size_t block = 0; block < blocks_; block++) {
+    DecodeBlock(block, docs.data() + block * kBlockSize);
+  }
+  return docs;
+}
+
+PostingCursor::PostingCursor(const PostingList& list) : list_(list) { LoadBlock(0); }
+
+void PostingCursor::LoadBlock(size_t block) {
+  block_ = block;
+  pos_ = 0;
+  count_ = block < list_.Blocks() ? list_.DecodeBlock(block, docs_) : 0;
+}
+
+bool PostingCursor::NextGEQ(uint32_t target) {
+  if (!Valid() || Doc() >= target) {
+    return Valid();
+  }
+  if (docs_[count_ - 1] < target) {
+    // first block after the current one whose last doc reaches 'target'
+    size_t lo = block_ + 1, hi = list_.Blocks();
+    while (lo < hi) {
+      size_t mid = lo + (hi - lo) / 2;
+      if (list_.GetSkip(mid).last_doc < target) {
+        lo = mid + 1;
+      } else {
+        hi = mid;
+      }
+    }
+    LoadBlock(lo);
+    if (!Valid()) {
+      return false;
+    }
+  }
+  pos_ = std::lower_bound(docs_ + pos_, docs_ + count_, target) - docs_;
+  return true;
+}
+
+void IntersectPostings(std::vector<PostingCursor>* cursors, std::vector<uint32_t>* docs) {
+  if (cursors->empty()) {
+    return;
+  }
+  std::sort(cursors->begin(), cursors->end(),
+            [](const PostingCursor& a, const PostingCursor& b) { return a.Size() < b.Size(); });
+  auto& lead = (*cursors)[0];
+  while (lead.Valid()) {
+    uint32_t candidate = lead.Doc();
+    size_t i = 1;
+    for (; i < cursors->size(); i++) {
+      auto& cursor = (*cursors)[i];
+      if (!cursor.NextGEQ(candidate)) {
+        return;
+      }
+      if (cursor.Doc() != candidate) {
+        break;
+      }
+    }
+    if (i == cursors->size()) {
+      docs->push_back(candidate);
+      lead.Next();
+    } else {
+      lead.NextGEQ((*cursors)[i].Doc());
+    }
+  }
+}
+
+void UnionPostings(std::vector<PostingCursor>* cursors, std::vector<uint32_t>* docs) {
+  using Entry = std::pair<uint32_t, size_t>;
+  std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> heap;
+  for (size_t i = 0; i < cursors->size(); i++) {
+    if ((*cursors)[i].Valid()) {
+      heap.emplace((*cursors)[i].Doc(), i);
+    }
+  }
+  while (!heap.empty()) {
+    auto [doc, i] = heap.top();
+    heap.pop();
+    if (docs->empty() || docs->back() != doc) {
+      docs->push_back(doc);
+    }
+    auto& cursor = (*cursors)[i];
+    cursor.Next();
+    if (cursor.Valid()) {
+      heap.emplace(cursor.Doc(), i);
+    }
+  }
+}
+}  // namespace rdict
@@ -0,0 +1,168 @@
+/*
+** BSD 3-Clause License
+**
+** Copyright (c) 2023, qiyingwang <qiyingwang@tencent.com>, the respective contributors, as shown by the AUTHORS file.
+** All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions are met:
+** * Redistributions of source code must retain the above copyright notice, this
+** list of conditions and the following disclaimer.
+**
+** * Redistributions in binary form must reproduce the above copyright notice,
+** this list of conditions and the following disclaimer in the documentation
+** and/or other materials provided with the distribution.
+**
+** * Neither the name of the copyright holder nor the names of its
+** contributors may be used to endorse or promote products derived from
+** this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+** AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+** IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+** DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+** FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+** DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+** SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+** CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+** OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "absl/status/statusor.h"
+#include "rdict/kv.h"
+
+namespace rdict {
+/**
+ * Compressed posting list of strictly increasing uint32 doc ids. Docs are delta encoded in blocks of 128 with
+ * StreamVByte: a control byte holds the 2 bits byte lengths of 4 deltas, followed by the 1~4 bytes of every delta,
+ * decoded with SSSE3 shuffles and a SIMD prefix sum when the cpu supports it. A skip entry per block with its last
+ * doc and offset lets cursors jump over whole blocks.
+ * Layout: uint32 size, uint32 blocks, {uint32 last_doc, uint32 offset} per block, then the blocks.
+ */
+class PostingList {
+ public:
+  static constexpr size_t kBlockSize = 128;
+  struct Skip {
+    uint32_t last_doc;
+    // of the block from the first block
+    uint32_t offset;
+  };
+
+  PostingList() = default;
+  // appends the encoding of 'docs' to 'out'
+  static absl::Status Encode(const uint32_t* docs, size_t n, std::string* out);
+  // a view of an encoded list, which must outlive it
+  static absl::StatusOr<PostingList> Parse(std::string_view encoded);
+  static bool HardwareAccelerated();
+
+  size_t Size() const { return size_; }
+  size_t Blocks() const { return blocks_; }
+  Skip GetSkip(size_t block) const {
+    Skip skip;
+    memcpy(&skip, skips_ + block * sizeof(Skip), sizeof(Skip));
+    return skip;
+  }
+  // decodes 'block' into 'docs' of kBlockSize, returns the number of docs
+  size_t DecodeBlock(size_t block, uint32_t* docs) const;
+  // same result without SIMD
+  size_t DecodeBlockPortable(size_t block, uint32_t* docs) const;
+  std::vector<uint32_t> Decode() const;
+
+ private:
+  const uint8_t* skips_ = nullptr;
+  const uint8_t* data_ = nullptr;
+  size_t data_size_ = 0;
+  size_t size_ = 0;
+  size_t blocks_ = 0;
+};
+
+/**
+ * Forward iterator over a PostingList decoding one block at a time.
+ */
+class PostingCursor {
+ public:
+  explicit PostingCursor(const PostingList& list);
+  bool Valid() const { return pos_ < count_; }
+  uint32_t Doc() const { return docs_[pos_]; }
+  size_t Size() const { return list_.Size(); }
+  void Next() {
+    if (++pos_ == count_) {
+      LoadBlock(block_ + 1);
+    }
+  }
+  // moves to the first doc >= 'target' if the current one is smaller, skipping whole blocks. Returns Valid()
+  bool NextGEQ(uint32_t target);
+
+ private:
+  void LoadBlock(size_t block);
+
+  PostingList list_;
+  size_t block_ = 0;
+  size_t count_ = 0;
+  size_t pos_ = 0;
+  uint32_t docs_[PostingList::kBlockSize];
+};
+
+// appends docs in all of the lists to 'docs', shortest list first leapfrogging with NextGEQ
+void IntersectPostings(std::vector<PostingCursor>* cursors, std::vector<uint32_t>* docs);
+// appends docs in any of the lists to 'docs' once, in increasing order
+void UnionPostings(std::vector<PostingCursor>* cursors, std::vector<uint32_t>* docs);
+
+/**
+ * term -> posting list dict on the ReadonlyKV hash index, the values are encoded PostingList.
+ */
+template <typename K>
+class PostingDict : public ReadonlyKV<K, std::string_view> {
+ public:
+  using Options = typename ReadonlyKV<K, std::string_view>::Options;
+  static absl::StatusOr<std::unique_ptr<PostingDict>> New(const Options& opts) {
+    std::unique_ptr<PostingDict> p(new PostingDict);
+    auto status = p->Init(opts);
+    if (!status.ok()) {
+      return status;
+    }
+    return p;
+  }
+  static absl::StatusOr<std::unique_ptr<PostingDict>> Load(const std::string& path) {
+    Options opts;
+    opts.path = path;
+    return Load(opts);
+  }
+  static absl::StatusOr<std::unique_ptr<PostingDict>> Load(const Options& options) {
+    Options opts = options;
+    opts.readonly = true;
+    return New(opts);
+  }
+  // 'docs' must be strictly increasing
+  absl::Status Put(const K& key, const std::vector<uint32_t>& docs) {
+    buffer_.clear();
+    auto status = PostingList::Encode(docs.data(), docs.size(), &buffer_);
+    if (!status.ok()) {
+      return status;
+    }
+    return ReadonlyKV<K, std::string_view>::Put(key, buffer_);
+  }
+  // accepts the key types of ReadonlyKV::Get, including HashedKey and string key views
+  template <typename T>
+  absl::StatusOr<PostingList> Get(const T& key) const {
+    auto val = ReadonlyKV<K, std::string_view>::Get(key);
+    if (!val.ok()) {
+      return val.status();
+    }
+    return PostingList::Parse(val.value());
+  }
+
+ private:
+  PostingDict() {}
+  std::string buffer_;
+};
+}  // namespace rdict
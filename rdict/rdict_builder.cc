@@ -31,10 +31,21 @@
 
 #include <getopt.h>
 #include <stdio.h>
-#include <fstream>
 #include <iostream>
 #include <string>
+#include <string_view>
+#include <vector>
+#include "absl/strings/str_split.h"
 #include "rdict/fbs_builder.h"
+#include "rdict/mmap_file.h"
+
+enum InputFormat {
+  INPUT_JSON = 0,
+  // stream of little endian uint32 length prefixed flatbuffers of the root table
+  INPUT_FBS,
+  INPUT_CSV,
+  INPUT_TSV,
+};
 
 static void help() {
   printf("Usage:\n");
@@ -42,6 +53,106 @@ static void help() {
   printf("--output(-o)      <output data file>\n");
   printf("--schema(-s)      <schema file path>\n");
   printf("--reserve(-r)    <reserve build dataset size GB>\n");
+  printf("--key-freq(-f)   <key frequency file with '<key>\\t<count>' lines, write hot values first>\n");
+  printf("--coverage(-c)   <traffic coverage to report the hot resident set for, default 0.9>\n");
+  printf("--simdjson(-j)   encode json lines with simdjson, output is identical to the flatbuffers parser\n");
+  printf("--format(-F)     <json|fbs|csv|tsv, default json, fbs is a stream of uint32 length prefixed flatbuffers>\n");
+  printf("--columns(-C)    <comma separated root table field names of csv/tsv columns, default first row header>\n");
+  printf("--cuckoo(-k)     write a bucketized cuckoo index for kv dicts, lookups probe at most two cache lines\n");
+  printf("--front-keys(-n) <with --key-freq, number of hottest keys in a front index probed before the main index>\n");
+  printf("--bulk(-b)       <index threads, build the kv index once after all records are written>\n");
+  printf("--keys(-e)       <expected number of kv records, the index is sized once for it>\n");
+  printf("--estimate-keys(-E) count distinct kv keys of the input file with a HyperLogLog pass to size the index\n");
+  printf("--set(-S)        write a set of the root table keys(ReadonlySet) instead of a kv dict\n");
+}
+
+static void add_record(rdict::FbsDictBuilder* dict, InputFormat format, std::string_view record) {
+  absl::Status status;
+  switch (format) {
+    case INPUT_FBS: {
+      status = dict->AddSizePrefixedFlatbuffer(record);
+      if (!status.ok() && !dict->EstimatingKeys()) {
+        printf("Invalid flatbuffer record size:%zu with error:%s\n", record.size(), status.ToString().c_str());
+      }
+      return;
+    }
+    case INPUT_CSV: {
+      status = dict->AddRow(record, ',');
+      break;
+    }
+    case INPUT_TSV: {
+      status = dict->AddRow(record, '\t');
+      break;
+    }
+    default: {
+      status = dict->Add(record);
+      break;
+    }
+  }
+  if (!status.ok() && !dict->EstimatingKeys()) {
+    printf("Invalid line:%.*s with error:%s\n", static_cast<int>(record.size()), record.data(),
+           status.ToString().c_str());
+  }
+}
+
+static int add_from_stdin(rdict::FbsDictBuilder* dict, InputFormat format) {
+  if (format == INPUT_FBS) {
+    std::string record;
+    char prefix[sizeof(flatbuffers::uoffset_t)];
+    while (std::cin.read(prefix, sizeof(prefix))) {
+      record.assign(prefix, sizeof(prefix));
+      record.resize(sizeof(prefix) + flatbuffers::ReadScalar<flatbuffers::uoffset_t>(prefix));
+      if (!std::cin.read(record.data() + sizeof(prefix), record.size() - sizeof(prefix))) {
+        printf("Truncated flatbuffer record from stdin.\n");
+        return -1;
+      }
+      add_record(dict, format, record);
+    }
+    return 0;
+  }
+  std::string line;
+  while (std::getline(std::cin, line)) {
+    if (!line.empty()) {
+      add_record(dict, format, line);
+    }
+  }
+  return 0;
+}
+
+static int add_from_file(rdict::FbsDictBuilder* dict, InputFormat format, const std::string& path) {
+  rdict::MmapFile::Options opts;
+  opts.path = path;
+  opts.readonly = true;
+  auto result = rdict::MmapFile::Open(opts);
+  if (!result.ok()) {
+    printf("Open source file:%s failed:%s\n", path.c_str(), result.status().ToString().c_str());
+    return -1;
+  }
+  auto file = std::move(result.value());
+  std::string_view content(reinterpret_cast<const char*>(file->GetRawData()), file->GetWriteOffset());
+  if (format == INPUT_FBS) {
+    while (!content.empty()) {
+      if (content.size() < sizeof(flatbuffers::uoffset_t) ||
+          content.size() - sizeof(flatbuffers::uoffset_t) <
+              flatbuffers::ReadScalar<flatbuffers::uoffset_t>(content.data())) {
+        printf("Truncated flatbuffer record in source file:%s\n", path.c_str());
+        return -1;
+      }
+      size_t len = flatbuffers::ReadScalar<flatbuffers::uoffset_t>(content.data());
+      add_record(dict, format, content.substr(0, sizeof(flatbuffers::uoffset_t) + len));
+      content.remove_prefix(sizeof(flatbuffers::uoffset_t) + len);
+    }
+    return 0;
+  }
+  while (!content.empty()) {
+    size_t pos = content.find('\n');
+    std::string_view line = content.substr(0, pos);
+    if (!line.empty()) {
+      add_record(dict, format, line);
+    }
+    content.remove_prefix(pos == std::string_view::npos ? content.size() : pos + 1);
+  }
+  return 0;
 }
 
 int main(int argc, char** argv) {
@@ -50,14 +161,31 @@ int main(int argc, char** argv) {
   std::string src_file;
   std::string fbs_schema_path;
   std::string output_path;
+  std::string key_freq_path;
+  std::string coverage_str;
+  bool simdjson_ingest = false;
+  bool cuckoo_index = false;
+  std::string front_keys_str;
+  std::string bulk_threads_str;
+  std::string keys_str;
+  bool estimate_keys = false;
+  bool key_set = false;
+  std::string format_str;
+  std::string columns_str;
   struct option long_options[] = {/* These options set a flag. */
-                                  {"input", required_argument, 0, 'i'},  {"output", required_argument, 0, 'o'},
-                                  {"schema", required_argument, 0, 's'}, {"reserve", optional_argument, 0, 'r'},
-                                  {"help", no_argument, 0, 'h'},         {0, 0, 0, 0}};
+                                  {"input", required_argument, 0, 'i'},    {"output", required_argument, 0, 'o'},
+                                  {"schema", required_argument, 0, 's'},   {"reserve", optional_argument, 0, 'r'},
+                                  {"key-freq", required_argument, 0, 'f'}, {"coverage", required_argument, 0, 'c'},
+                                  {"simdjson", no_argument, 0, 'j'},       {"format", required_argument, 0, 'F'},
+                                  {"columns", required_argument, 0, 'C'},  {"cuckoo", no_argument, 0, 'k'},
+                                  {"front-keys", required_argument, 0, 'n'}, {"bulk", required_argument, 0, 'b'},
+                                  {"keys", required_argument, 0, 'e'},     {"estimate-keys", no_argument, 0, 'E'},
+                                  {"set", no_argument, 0, 'S'},            {"help", no_argument, 0, 'h'},
+                                  {0, 0, 0, 0}};
   while (1) {
     /* getopt_long stores the option index here. */
     int option_index = 0;
-    c = getopt_long(argc, argv, "hi:o:s:r:", long_options, &option_index);
+    c = getopt_long(argc, argv, "hi:o:s:r:f:c:jF:C:kn:b:e:ES", long_options, &option_index);
 
     /* Detect the end of the options. */
     if (c == -1) break;
@@ -93,6 +221,50 @@ int main(int argc, char** argv) {
         reserver_size_str = optarg;
         break;
       }
+      case 'f': {
+        key_freq_path = optarg;
+        break;
+      }
+      case 'c': {
+        coverage_str = optarg;
+        break;
+      }
+      case 'j': {
+        simdjson_ingest = true;
+        break;
+      }
+      case 'F': {
+        format_str = optarg;
+        break;
+      }
+      case 'C': {
+        columns_str = optarg;
+        break;
+      }
+      case 'k': {
+        cuckoo_index = true;
+        break;
+      }
+      case 'n': {
+        front_keys_str = optarg;
+        break;
+      }
+      case 'b': {
+        bulk_threads_str = optarg;
+        break;
+      }
+      case 'e': {
+        keys_str = optarg;
+        break;
+      }
+      case 'E': {
+        estimate_keys = true;
+        break;
+      }
+      case 'S': {
+        key_set = true;
+        break;
+      }
       case '?':
         /* getopt_long already printed an error message. */
         break;
@@ -111,6 +283,17 @@ int main(int argc, char** argv) {
     help();
     return -1;
   }
+  InputFormat format = INPUT_JSON;
+  if (format_str == "fbs") {
+    format = INPUT_FBS;
+  } else if (format_str == "csv") {
+    format = INPUT_CSV;
+  } else if (format_str == "tsv") {
+    format = INPUT_TSV;
+  } else if (!format_str.empty() && format_str != "json") {
+    printf("Invalid input format:%s\n", format_str.c_str());
+    return -1;
+  }
   rdict::FbsDictBuilder::Options opts;
   if (!reserver_size_str.empty()) {
     int64_t v = std::stoll(reserver_size_str);
@@ -118,6 +301,26 @@ int main(int argc, char** argv) {
       opts.reserved_space_bytes = v * 1024 * 1024 * 1024;
     }
   }
+  opts.key_frequency_path = key_freq_path;
+  opts.simdjson_ingest = simdjson_ingest;
+  opts.cuckoo_index = cuckoo_index;
+  opts.key_set = key_set;
+  if (!front_keys_str.empty()) {
+    opts.front_index_keys = std::stoull(front_keys_str);
+  }
+  if (!keys_str.empty()) {
+    opts.max_elements = std::stoull(keys_str);
+  }
+  if (!bulk_threads_str.empty()) {
+    opts.bulk_build = true;
+    opts.bulk_build_threads = std::stoul(bulk_threads_str);
+  }
+  if (!columns_str.empty()) {
+    opts.columns = absl::StrSplit(columns_str, ',');
+  }
+  if (!coverage_str.empty()) {
+    opts.report_coverage = std::stod(coverage_str);
+  }
   auto result = rdict::FbsDictBuilder::New(fbs_schema_path, output_path, opts);
   if (!result.ok()) {
     auto status = result.status();
@@ -126,31 +329,52 @@ int main(int argc, char** argv) {
   }
   auto dict = std::move(result.value());
 
-  std::istream* is = nullptr;
-  std::ifstream file(src_file.c_str());
-  if (src_file == "stdin" || src_file.empty()) {
-    is = &(std::cin);
-  } else {
-    if (!file.is_open()) {
-      printf("Open source file:%s failed.\n", src_file.c_str());
-      return -1;
+  int rc = 0;
+  if (estimate_keys) {
+    if (src_file == "stdin") {
+      printf("Key estimate pass needs an input file, skipped for stdin.\n");
+    } else {
+      dict->BeginKeyEstimate();
+      rc = add_from_file(dict.get(), format, src_file);
+      if (0 != rc) {
+        return rc;
+      }
+      auto status = dict->EndKeyEstimate();
+      if (!status.ok()) {
+        printf("Reserve estimated keys failed error:%s\n", status.ToString().c_str());
+        return -1;
+      }
     }
-    is = &file;
   }
-
-  std::string line;
-  while (std::getline(*is, line)) {
-    if (line.empty()) {
-      continue;
-    }
-    auto status = dict->Add(line);
-    if (!status.ok()) {
-      printf("Invalid line:%s with error:%s\n", line.c_str(), status.ToString().c_str());
-    }
+  if (src_file == "stdin") {
+    rc = add_from_stdin(dict.get(), format);
+  } else {
+    rc = add_from_file(dict.get(), format, src_file);
+  }
+  if (0 != rc) {
+    return rc;
   }
   auto status = dict->Flush();
   if (!status.ok()) {
     printf("Dict flush failed error:%s\n", status.ToString().c_str());
+    return -1;
+  }
+  const auto& report = dict->GetReport();
+  printf("Build records:%zu\n", report.records);
+  if (estimate_keys) {
+    printf("Estimated keys:%zu\n", report.estimated_keys);
+  }
+  printf("Index rehashes:%zu cost:%.3fs\n", report.rehashes, report.rehash_secs);
+  if (simdjson_ingest) {
+    if (report.simdjson_ingest) {
+      printf("Simdjson ingest parser fallbacks:%zu\n", report.parser_fallbacks);
+    } else {
+      printf("Simdjson ingest unsupported by schema, built with flatbuffers parser\n");
+    }
+  }
+  if (!key_freq_path.empty()) {
+    printf("Hotness layout data_bytes:%zu hot_keys:%zu resident_bytes:%zu for %.1f%% traffic coverage\n",
+           report.data_bytes, report.hot_keys, report.resident_bytes, report.coverage * 100);
   }
   return 0;
 }
\ No newline at end of file
@@ -0,0 +1,285 @@
+/*
+** BSD 3-Clause License
+**
+** Copyright (c) 2023, qiyingwang <qiyingwang@tencent.com>, the respective contributors, as shown by the AUTHORS file.
+** All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions are met:
+** * Redistributions of source code must retain the above copyright notice, this
+** list of conditions and the following disclaimer.
+**
+** * Redistributions in binary form must reproduce the above copyright notice,
+** this list of conditions and the following disclaimer in the documentation
+** and/or other materials provided with the distribution.
+**
+** * Neither the name of the copyright holder nor the names of its
+** contributors may be used to endorse or promote products derived from
+** this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+** AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+** IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+** DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+** FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+** DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+** SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+** CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+** OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "rdict/rdict_c.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <limits>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+#include "rdict/kv.h"
+#include "rdict/list.h"
+
+struct rdict_kv {
+  rdict_key_type key_type = RDICT_KEY_STRING;
+  void* dict = nullptr;
+};
+
+struct rdict_list {
+  std::unique_ptr<rdict::ReadonlyList> dict;
+};
+
+namespace {
+template <typename K>
+using KvDict = rdict::ReadonlyKV<K, std::string_view>;
+
+thread_local std::string last_error;
+
+int set_error(const absl::Status& status) {
+  last_error = std::string(status.message());
+  return static_cast<int>(status.code());
+}
+
+// for the lookup paths, a missing key should not cost a status allocation
+int set_error(rdict_code code, const char* msg) {
+  last_error = msg;
+  return code;
+}
+
+absl::Status check_dict_type(const char* path, rdict::detail::DictType type) {
+  int fd = open(path, O_RDONLY);
+  if (fd < 0) {
+    int err = errno;
+    return absl::ErrnoToStatus(err, std::string("open ") + path + " failed");
+  }
+  rdict::detail::RdictMetaHeader header;
+  ssize_t n = pread(fd, &header, sizeof(header), 0);
+  close(fd);
+  if (n != static_cast<ssize_t>(sizeof(header)) || header.magic != rdict::detail::RdictMetaHeader{}.magic) {
+    return absl::InvalidArgumentError(std::string(path) + " is not a rdict file");
+  }
+  if (header.type != type) {
+    return absl::InvalidArgumentError(std::string(path) + " is a rdict file of another dict type");
+  }
+  return absl::OkStatus();
+}
+
+template <typename F>
+auto visit_kv(const rdict_kv* kv, F&& f) {
+  switch (kv->key_type) {
+    case RDICT_KEY_INT32: {
+      return f(reinterpret_cast<KvDict<int32_t>*>(kv->dict));
+    }
+    case RDICT_KEY_UINT32: {
+      return f(reinterpret_cast<KvDict<uint32_t>*>(kv->dict));
+    }
+    case RDICT_KEY_INT64: {
+      return f(reinterpret_cast<KvDict<int64_t>*>(kv->dict));
+    }
+    case RDICT_KEY_UINT64: {
+      return f(reinterpret_cast<KvDict<uint64_t>*>(kv->dict));
+    }
+    default: {
+      return f(reinterpret_cast<KvDict<std::string_view>*>(kv->dict));
+    }
+  }
+}
+
+template <typename K>
+bool to_int_key(int64_t key, K* k) {
+  if constexpr (std::is_same_v<K, uint64_t>) {
+    *k = static_cast<uint64_t>(key);
+  } else {
+    if (key < std::numeric_limits<K>::min() || key > std::numeric_limits<K>::max()) {
+      return false;
+    }
+    *k = static_cast<K>(key);
+  }
+  return true;
+}
+
+template <typename K>
+bool find_value(const KvDict<K>* dict, const K& key, const void** val, size_t* val_len) {
+  std::string_view value;
+  if (!dict->Find(key, &value)) {
+    *val = nullptr;
+    *val_len = 0;
+    return false;
+  }
+  *val = value.data();
+  *val_len = value.size();
+  return true;
+}
+}  // namespace
+
+extern "C" {
+
+const char* rdict_last_error(void) { return last_error.c_str(); }
+
+int rdict_kv_open(const char* path, rdict_key_type key_type, rdict_load_mode load_mode, rdict_kv** kv) {
+  if (nullptr == path || nullptr == kv || key_type < RDICT_KEY_STRING || key_type > RDICT_KEY_UINT64 ||
+      load_mode < RDICT_LOAD_MMAP || load_mode > RDICT_LOAD_ANONYMOUS) {
+    return set_error(absl::InvalidArgumentError("invalid arguments to open kv"));
+  }
+  auto status = check_dict_type(path, rdict::detail::DICT_KV);
+  if (!status.ok()) {
+    return set_error(status);
+  }
+  std::unique_ptr<rdict_kv> handle(new rdict_kv);
+  handle->key_type = key_type;
+  status = visit_kv(handle.get(), [&](auto* dict) -> absl::Status {
+    using Dict = std::remove_pointer_t<decltype(dict)>;
+    typename Dict::Options opts;
+    opts.path = path;
+    opts.readonly = true;
+    opts.load_mode = static_cast<rdict::MmapFile::LoadMode>(load_mode);
+    auto result = Dict::New(opts);
+    if (!result.ok()) {
+      return result.status();
+    }
+    handle->dict = result.value().release();
+    return absl::OkStatus();
+  });
+  if (!status.ok()) {
+    return set_error(status);
+  }
+  *kv = handle.release();
+  return RDICT_OK;
+}
+
+void rdict_kv_close(rdict_kv* kv) {
+  if (nullptr == kv) {
+    return;
+  }
+  visit_kv(kv, [](auto* dict) { delete dict; });
+  delete kv;
+}
+
+size_t rdict_kv_size(const rdict_kv* kv) {
+  return visit_kv(kv, [](auto* dict) { return dict->Size(); });
+}
+
+int rdict_kv_get_str(const rdict_kv* kv, const char* key, size_t key_len, const void** val, size_t* val_len) {
+  if (kv->key_type != RDICT_KEY_STRING) {
+    return set_error(RDICT_INVALID_ARGUMENT, "string key to integer keyed kv");
+  }
+  auto* dict = reinterpret_cast<const KvDict<std::string_view>*>(kv->dict);
+  if (!find_value(dict, std::string_view(key, key_len), val, val_len)) {
+    return set_error(RDICT_NOT_FOUND, "not found entry");
+  }
+  return RDICT_OK;
+}
+
+int rdict_kv_get_int(const rdict_kv* kv, int64_t key, const void** val, size_t* val_len) {
+  return visit_kv(kv, [&](auto* dict) -> int {
+    using K = typename std::remove_pointer_t<decltype(dict)>::key_type;
+    if constexpr (std::is_same_v<K, std::string_view>) {
+      return set_error(RDICT_INVALID_ARGUMENT, "integer key to string keyed kv");
+    } else {
+      K k;
+      if (!to_int_key(key, &k)) {
+        return set_error(RDICT_OUT_OF_RANGE, "key out of range of the key type");
+      }
+      if (!find_value(dict, k, val, val_len)) {
+        return set_error(RDICT_NOT_FOUND, "not found entry");
+      }
+      return RDICT_OK;
+    }
+  });
+}
+
+size_t rdict_kv_multi_get_str(const rdict_kv* kv, const char* const* keys, const size_t* key_lens, size_t n,
+                              const void** vals, size_t* val_lens) {
+  if (kv->key_type != RDICT_KEY_STRING) {
+    for (size_t i = 0; i < n; i++) {
+      vals[i] = nullptr;
+      val_lens[i] = 0;
+    }
+    return 0;
+  }
+  auto* dict = reinterpret_cast<const KvDict<std::string_view>*>(kv->dict);
+  size_t found = 0;
+  for (size_t i = 0; i < n; i++) {
+    found += find_value(dict, std::string_view(keys[i], key_lens[i]), &vals[i], &val_lens[i]);
+  }
+  return found;
+}
+
+size_t rdict_kv_multi_get_int(const rdict_kv* kv, const int64_t* keys, size_t n, const void** vals,
+                              size_t* val_lens) {
+  return visit_kv(kv, [&](auto* dict) -> size_t {
+    using K = typename std::remove_pointer_t<decltype(dict)>::key_type;
+    size_t found = 0;
+    for (size_t i = 0; i < n; i++) {
+      vals[i] = nullptr;
+      val_lens[i] = 0;
+      if constexpr (!std::is_same_v<K, std::string_view>) {
+        K k;
+        if (to_int_key(keys[i], &k)) {
+          found += find_value(dict, k, &vals[i], &val_lens[i]);
+        }
+      }
+    }
+    return found;
+  });
+}
+
+int rdict_list_open(const char* path, rdict_load_mode load_mode, rdict_list** list) {
+  if (nullptr == path || nullptr == list || load_mode < RDICT_LOAD_MMAP || load_mode > RDICT_LOAD_ANONYMOUS) {
+    return set_error(absl::InvalidArgumentError("invalid arguments to open list"));
+  }
+  auto status = check_dict_type(path, rdict::detail::DICT_LIST);
+  if (!status.ok()) {
+    return set_error(status);
+  }
+  rdict::ReadonlyList::Options opts;
+  opts.path = path;
+  opts.readonly = true;
+  opts.load_mode = static_cast<rdict::MmapFile::LoadMode>(load_mode);
+  auto result = rdict::ReadonlyList::New(opts);
+  if (!result.ok()) {
+    return set_error(result.status());
+  }
+  *list = new rdict_list{std::move(result.value())};
+  return RDICT_OK;
+}
+
+void rdict_list_close(rdict_list* list) { delete list; }
+
+size_t rdict_list_size(const rdict_list* list) { return list->dict->Size(); }
+
+int rdict_list_get(const rdict_list* list, size_t idx, const void** val, size_t* val_len) {
+  if (idx >= list->dict->Size()) {
+    return set_error(RDICT_OUT_OF_RANGE, "invalid idx to get data");
+  }
+  auto result = list->dict->Get(idx);
+  if (!result.ok()) {
+    return set_error(result.status());
+  }
+  *val = result.value().data();
+  *val_len = result.value().size();
+  return RDICT_OK;
+}
+}
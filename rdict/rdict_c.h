@@ -0,0 +1,99 @@
+/*
+** BSD 3-Clause License
+**
+** Copyright (c) 2023, qiyingwang <qiyingwang@tencent.com>, the respective contributors, as shown by the AUTHORS file.
+** All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions are met:
+** * Redistributions of source code must retain the above copyright notice, this
+** list of conditions and the following disclaimer.
+**
+** * Redistributions in binary form must reproduce the above copyright notice,
+** this list of conditions and the following disclaimer in the documentation
+** and/or other materials provided with the distribution.
+**
+** * Neither the name of the copyright holder nor the names of its
+** contributors may be used to endorse or promote products derived from
+** this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+** AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+** IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+** DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+** FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+** DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+** SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+** CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+** OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * C ABI of the readonly dicts for FFI consumers(python ctypes, go cgo, ...).
+ * Returned values point into the dict mapping and stay valid until the dict is closed, a flatbuffers value can be
+ * wrapped as root table directly without copying.
+ * Functions return RDICT_OK or an error code, the message of the last error on the calling thread is available by
+ * rdict_last_error.
+ */
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// same values as absl::StatusCode, open may also return other codes mapped from errno
+typedef enum {
+  RDICT_OK = 0,
+  RDICT_INVALID_ARGUMENT = 3,
+  RDICT_NOT_FOUND = 5,
+  RDICT_OUT_OF_RANGE = 11,
+  RDICT_INTERNAL = 13,
+  RDICT_UNAVAILABLE = 14,
+} rdict_code;
+
+// must match the type of the key field the kv dict was built with
+typedef enum {
+  RDICT_KEY_STRING = 0,
+  RDICT_KEY_INT32,
+  RDICT_KEY_UINT32,
+  RDICT_KEY_INT64,
+  RDICT_KEY_UINT64,
+} rdict_key_type;
+
+typedef enum {
+  RDICT_LOAD_MMAP = 0,
+  // copy the whole file into hugepage backed anonymous memory
+  RDICT_LOAD_ANONYMOUS,
+} rdict_load_mode;
+
+typedef struct rdict_kv rdict_kv;
+typedef struct rdict_list rdict_list;
+
+const char* rdict_last_error(void);
+
+int rdict_kv_open(const char* path, rdict_key_type key_type, rdict_load_mode load_mode, rdict_kv** kv);
+void rdict_kv_close(rdict_kv* kv);
+size_t rdict_kv_size(const rdict_kv* kv);
+int rdict_kv_get_str(const rdict_kv* kv, const char* key, size_t key_len, const void** val, size_t* val_len);
+// integer keys are range checked against the key type of the dict, reinterpreted as uint64_t for RDICT_KEY_UINT64
+int rdict_kv_get_int(const rdict_kv* kv, int64_t key, const void** val, size_t* val_len);
+/**
+ * Looks up 'n' keys in one call, missing keys get a NULL value with zero length.
+ * Returns the number of keys found.
+ */
+size_t rdict_kv_multi_get_str(const rdict_kv* kv, const char* const* keys, const size_t* key_lens, size_t n,
+                              const void** vals, size_t* val_lens);
+size_t rdict_kv_multi_get_int(const rdict_kv* kv, const int64_t* keys, size_t n, const void** vals, size_t* val_lens);
+
+int rdict_list_open(const char* path, rdict_load_mode load_mode, rdict_list** list);
+void rdict_list_close(rdict_list* list);
+size_t rdict_list_size(const rdict_list* list);
+int rdict_list_get(const rdict_list* list, size_t idx, const void** val, size_t* val_len);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,225 @@
+/*
+** BSD 3-Clause License
+**
+** Copyright (c) 2023, qiyingwang <qiyingwang@tencent.com>, the respective contributors, as shown by the AUTHORS file.
+** All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions are met:
+** * Redistributions of source code must retain the above copyright notice, this
+** list of conditions and the following disclaimer.
+**
+** * Redistributions in binary form must reproduce the above copyright notice,
+** this list of conditions and the following disclaimer in the documentation
+** and/or other materials provided with the distribution.
+**
+** * Neither the name of the copyright holder nor the names of its
+** contributors may be used to endorse or promote products derived from
+** this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+** AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+** IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+** DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+** FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+** DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+** SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+** CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+** OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#pragma once
+
+#include <algorithm>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/status/statusor.h"
+#include "rdict/kv.h"
+
+namespace rdict {
+namespace detail {
+// value of set records, takes no bytes of the data section
+struct SetMember {};
+
+template <>
+struct Serializer<SetMember> {
+  static size_t PackSize(const SetMember&, bool) { return 0; }
+  static void PackTo(const SetMember&, uint8_t*, bool) {}
+  static size_t Unpack(const uint8_t*, SetMember&, bool) { return 0; }
+  static size_t GetSize(const uint8_t*, bool) { return 0; }
+};
+}  // namespace detail
+
+/**
+ * Exact membership set of keys(DICT_SET), a kv dict without values: string keys take only their packed key in the
+ * data section and flat keys are stored in the index buckets alone.
+ */
+template <typename K, typename HashFn = rdict::hash<K>, typename KeyEqual = std::equal_to<K>>
+class ReadonlySet : public ReadonlyKV<K, detail::SetMember, HashFn, KeyEqual> {
+ public:
+  using Base = ReadonlyKV<K, detail::SetMember, HashFn, KeyEqual>;
+  using Options = typename Base::Options;
+
+  static absl::StatusOr<std::unique_ptr<ReadonlySet>> New(const Options& opts) {
+    std::unique_ptr<ReadonlySet> p(new ReadonlySet);
+    auto status = p->Init(opts);
+    if (!status.ok()) {
+      return status;
+    }
+    return p;
+  }
+  static absl::StatusOr<std::unique_ptr<ReadonlySet>> Load(const std::string& path) {
+    Options opts;
+    opts.path = path;
+    return Load(opts);
+  }
+  static absl::StatusOr<std::unique_ptr<ReadonlySet>> Load(const Options& options) {
+    Options opts = options;
+    opts.readonly = true;
+    return New(opts);
+  }
+  /**
+   * Build the union/intersection of 'sets' into the new set of writable 'opts' and commit it.
+   */
+  static absl::Status Union(const std::vector<const ReadonlySet*>& sets, const Options& opts);
+  static absl::Status Intersect(const std::vector<const ReadonlySet*>& sets, const Options& opts);
+
+  // also accepts hashed keys and the string key types of Exists
+  template <typename T>
+  bool Contains(const T& key) const {
+    return this->Exists(key);
+  }
+  // membership of 'n' keys with their lookups interleaved, 'found' receives the result of every key if not null,
+  // returns the number of keys found
+  size_t ContainsMany(const K* keys, size_t n, bool* found = nullptr) const;
+  absl::Status Insert(const K& key) { return Base::Put(key, detail::SetMember{}); }
+  // deferred insert, see ReadonlyKV::BulkAdd
+  absl::Status BulkAdd(const K& key) { return Base::BulkAdd(key, detail::SetMember{}); }
+  // calls 'fn' with every key, in no particular order
+  void ForEach(const std::function<void(const K&)>& fn) const;
+
+ protected:
+  static constexpr size_t k_lookup_batch = 16;
+
+  ReadonlySet() {}
+  absl::Status Init(const Options& opts) {
+    this->dict_type_ = detail::DictType::DICT_SET;
+    return Base::Init(opts);
+  }
+
+  // no values to read or write
+  using Base::BulkBuild;
+  using Base::Find;
+  using Base::Get;
+  using Base::Put;
+};
+
+template <typename K, typename H, typename E>
+size_t ReadonlySet<K, H, E>::ContainsMany(const K* keys, size_t n, bool* found) const {
+  using Lookup = typename Base::Lookup;
+  size_t hits = 0;
+  std::vector<Lookup> lookups;
+  lookups.reserve(k_lookup_batch);
+  for (size_t begin = 0; begin < n; begin += k_lookup_batch) {
+    size_t end = std::min(n, begin + k_lookup_batch);
+    lookups.clear();
+    for (size_t i = begin; i < end; i++) {
+      lookups.emplace_back(typename Base::hashed_key_type(keys[i]));
+      this->StartLookup(&lookups.back());
+    }
+    // round robin over the batch so that the prefetches of a lookup overlap with the steps of the others
+    std::vector<bool> done(lookups.size(), false);
+    for (size_t pending = lookups.size(); pending > 0;) {
+      for (size_t i = 0; i < lookups.size(); i++) {
+        if (!done[i] && this->StepLookup(&lookups[i])) {
+          done[i] = true;
+          pending--;
+        }
+      }
+    }
+    for (size_t i = begin; i < end; i++) {
+      bool hit = lookups[i - begin].found;
+      hits += hit;
+      if (nullptr != found) {
+        found[i] = hit;
+      }
+    }
+  }
+  return hits;
+}
+
+template <typename K, typename H, typename E>
+void ReadonlySet<K, H, E>::ForEach(const std::function<void(const K&)>& fn) const {
+  if constexpr (Base::Bucket::is_flat) {
+    const typename Base::Bucket* buckets = this->buckets_;
+    for (size_t i = 0, count = 0; count < this->meta_->size; i++) {
+      if (buckets[i].dist_and_fingerprint > 0) {
+        fn(buckets[i].key);
+        count++;
+      }
+    }
+  } else {
+    for (uint64_t offset : this->GetValueOffsets()) {
+      fn(detail::KeyValPair<K, detail::SetMember>::UnpackKey(this->GetKeyValData(offset)));
+    }
+  }
+}
+
+template <typename K, typename H, typename E>
+absl::Status ReadonlySet<K, H, E>::Union(const std::vector<const ReadonlySet*>& sets, const Options& opts) {
+  auto result = New(opts);
+  if (!result.ok()) {
+    return result.status();
+  }
+  auto& dst = result.value();
+  size_t total = 0;
+  for (const ReadonlySet* set : sets) {
+    total += set->Size();
+  }
+  auto status = dst->Reserve(total);
+  for (const ReadonlySet* set : sets) {
+    set->ForEach([&](const K& key) {
+      if (status.ok()) {
+        status = dst->BulkAdd(key);
+      }
+    });
+  }
+  if (!status.ok()) {
+    return status;
+  }
+  return dst->Commit();
+}
+
+template <typename K, typename H, typename E>
+absl::Status ReadonlySet<K, H, E>::Intersect(const std::vector<const ReadonlySet*>& sets, const Options& opts) {
+  auto result = New(opts);
+  if (!result.ok()) {
+    return result.status();
+  }
+  auto& dst = result.value();
+  absl::Status status;
+  if (!sets.empty()) {
+    // probe the others with the keys of the smallest one
+    const ReadonlySet* smallest =
+        *std::min_element(sets.begin(), sets.end(), [](auto* a, auto* b) { return a->Size() < b->Size(); });
+    status = dst->Reserve(smallest->Size());
+    smallest->ForEach([&](const K& key) {
+      for (const ReadonlySet* set : sets) {
+        if (set != smallest && !set->Contains(key)) {
+          return;
+        }
+      }
+      if (status.ok()) {
+        status = dst->BulkAdd(key);
+      }
+    });
+  }
+  if (!status.ok()) {
+    return status;
+  }
+  return dst->Commit();
+}
+}  // namespace rdict
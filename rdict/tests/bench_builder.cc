@@ -0,0 +1,120 @@
+/*
+** BSD 3-Clause License
+**
+** Copyright (c) 2023, qiyingwang <qiyingwang@tencent.com>, the respective contributors, as shown by the AUTHORS file.
+** All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions are met:
+** * Redistributions of source code must retain the above copyright notice, this
+** list of conditions and the following disclaimer.
+**
+** * Redistributions in binary form must reproduce the above copyright notice,
+** this list of conditions and the following disclaimer in the documentation
+** and/or other materials provided with the distribution.
+**
+** * Neither the name of the copyright holder nor the names of its
+** contributors may be used to endorse or promote products derived from
+** this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+** AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+** IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+** DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+** FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+** DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+** SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+** CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+** OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#include <stdio.h>
+#include <chrono>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "folly/FileUtil.h"
+#include "rdict/fbs_encoder.h"
+
+static double elapsed_secs(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// bench_builder json <schema file> <json lines file>
+static int bench_json(int argc, char** argv) {
+  if (argc < 4) {
+    printf("Usage: %s json <schema file> <json lines file>\n", argv[0]);
+    return -1;
+  }
+  std::string schema;
+  if (!folly::readFile(argv[2], schema)) {
+    printf("read schema %s failed\n", argv[2]);
+    return -1;
+  }
+  std::vector<std::string> lines;
+  size_t input_bytes = 0;
+  std::ifstream file(argv[3]);
+  std::string line;
+  while (std::getline(file, line)) {
+    if (!line.empty()) {
+      input_bytes += line.size();
+      lines.emplace_back(std::move(line));
+    }
+  }
+  flatbuffers::Parser parser;
+  flatbuffers::Parser schema_parser;
+  if (!parser.Parse(schema.c_str()) || !schema_parser.Parse(schema.c_str())) {
+    printf("invalid schema:%s\n", parser.error_.c_str());
+    return -1;
+  }
+  schema_parser.Serialize();
+  auto result = rdict::FbsJsonEncoder::New(parser, reflection::GetSchema(schema_parser.builder_.GetBufferPointer()));
+  if (!result.ok()) {
+    printf("schema unsupported by encoder:%s\n", result.status().ToString().c_str());
+    return -1;
+  }
+  auto encoder = std::move(result.value());
+
+  auto start = std::chrono::steady_clock::now();
+  size_t parsed = 0;
+  for (const auto& json : lines) {
+    parsed += parser.ParseJson(json.c_str()) ? 1 : 0;
+  }
+  double secs = elapsed_secs(start);
+  printf("flatbuffers parser lines:%zu/%zu cost:%.3fs throughput:%.2fMB/s %.0flines/s\n", parsed, lines.size(), secs,
+         input_bytes / secs / 1e6, lines.size() / secs);
+
+  start = std::chrono::steady_clock::now();
+  size_t encoded = 0;
+  for (const auto& json : lines) {
+    encoded += encoder->Encode(json).ok() ? 1 : 0;
+  }
+  secs = elapsed_secs(start);
+  printf("simdjson encoder  lines:%zu/%zu cost:%.3fs throughput:%.2fMB/s %.0flines/s\n", encoded, lines.size(), secs,
+         input_bytes / secs / 1e6, lines.size() / secs);
+
+  size_t mismatch = 0;
+  for (const auto& json : lines) {
+    auto encoded_result = encoder->Encode(json);
+    if (!encoded_result.ok() || !parser.ParseJson(json.c_str())) {
+      continue;
+    }
+    std::string_view expected(reinterpret_cast<const char*>(parser.builder_.GetBufferPointer()),
+                              parser.builder_.GetSize());
+    if (encoded_result.value() != expected) {
+      mismatch++;
+    }
+  }
+  printf("byte mismatches:%zu\n", mismatch);
+  return mismatch == 0 ? 0 : -1;
+}
+
+int main(int argc, char** argv) {
+  std::string_view cmd = argc > 1 ? argv[1] : "";
+  if (cmd == "json") {
+    return bench_json(argc, argv);
+  }
+  printf("Usage: %s <json> ...\n", argv[0]);
+  return -1;
+}
@@ -0,0 +1,676 @@
+/*
+** BSD 3-Clause License
+**
+** Copyright (c) 2023, qiyingwang <qiyingwang@tencent.com>, the respective contributors, as shown by the AUTHORS file.
+** All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions are met:
+** * Redistributions of source code must retain the above copyright notice, this
+** list of conditions and the following disclaimer.
+**
+** * Redistributions in binary form must reproduce the above copyright notice,
+** this list of conditions and the following disclaimer in the documentation
+** and/or other materials provided with the distribution.
+**
+** * Neither the name of the copyright holder nor the names of its
+** contributors may be used to endorse or promote products derived from
+** this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+** AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+** IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+** DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+** FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+** DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+** SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+** CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+** OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+#include "rdict/embedding_kv.h"
+#include "rdict/kv.h"
+#include "rdict/list.h"
+#include "rdict/mmap_file.h"
+#include "rdict/rdict_c.h"
+#include "rdict/trie.h"
+
+static double elapsed_secs(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// bench_rdict load <rdict file> [max_threads]
+static int bench_load(int argc, char** argv) {
+  if (argc < 3) {
+    printf("Usage: %s load <rdict file> [max_threads]\n", argv[0]);
+    return -1;
+  }
+  std::string path = argv[2];
+  uint32_t max_threads = argc > 3 ? static_cast<uint32_t>(atoi(argv[3])) : 16;
+
+  rdict::MmapFile::Options opts;
+  opts.path = path;
+  opts.readonly = true;
+  auto start = std::chrono::steady_clock::now();
+  auto mmap_result = rdict::MmapFile::Open(opts);
+  if (!mmap_result.ok()) {
+    printf("open %s failed:%s\n", path.c_str(), mmap_result.status().ToString().c_str());
+    return -1;
+  }
+  auto mmap_file = std::move(mmap_result.value());
+  size_t file_size = mmap_file->GetWriteOffset();
+  uint64_t checksum = 0;
+  for (size_t i = 0; i < file_size; i += 4096) {
+    checksum += mmap_file->GetRawData()[i];
+  }
+  double secs = elapsed_secs(start);
+  printf("mmap+touch        size:%zu cost:%.3fs throughput:%.2fGB/s checksum:%lu\n", file_size, secs,
+         file_size / secs / 1e9, checksum);
+  mmap_file.reset();
+
+  opts.load_mode = rdict::MmapFile::LOAD_ANONYMOUS;
+  for (uint32_t threads = 1; threads <= max_threads; threads *= 2) {
+    opts.load_threads = threads;
+    start = std::chrono::steady_clock::now();
+    auto result = rdict::MmapFile::Open(opts);
+    if (!result.ok()) {
+      printf("load %s failed:%s\n", path.c_str(), result.status().ToString().c_str());
+      return -1;
+    }
+    secs = elapsed_secs(start);
+    printf("anonymous threads:%-3u size:%zu cost:%.3fs throughput:%.2fGB/s\n", threads, file_size, secs,
+           file_size / secs / 1e9);
+  }
+  return 0;
+}
+
+// bench_rdict put <output dir> [count] [value_size]
+static int bench_put(int argc, char** argv) {
+  if (argc < 3) {
+    printf("Usage: %s put <output dir> [count] [value_size]\n", argv[0]);
+    return -1;
+  }
+  std::string dir = argv[2];
+  size_t count = argc > 3 ? strtoull(argv[3], nullptr, 10) : 10000000;
+  size_t value_size = argc > 4 ? strtoull(argv[4], nullptr, 10) : 64;
+  std::string value(value_size, 'v');
+
+  rdict::ReadonlyKV<uint64_t, std::string_view>::Options kv_opts;
+  kv_opts.path = dir + "/bench_put_kv.rdict";
+  kv_opts.readonly = false;
+  kv_opts.truncate = true;
+  kv_opts.bucket_count = static_cast<size_t>(count / kv_opts.max_load_factor) + 1;
+  auto kv_result = rdict::ReadonlyKV<uint64_t, std::string_view>::New(kv_opts);
+  if (!kv_result.ok()) {
+    printf("create kv failed:%s\n", kv_result.status().ToString().c_str());
+    return -1;
+  }
+  auto kv = std::move(kv_result.value());
+  auto start = std::chrono::steady_clock::now();
+  for (uint64_t i = 0; i < count; i++) {
+    kv->Put(i, value);
+  }
+  double secs = elapsed_secs(start);
+  printf("kv put   count:%zu value_size:%zu cost:%.3fs %.2fM records/s\n", count, value_size, secs,
+         count / secs / 1e6);
+
+  // same records deferred to one radix partitioned index build, without a reserved bucket count
+  kv_opts.path = dir + "/bench_bulk_kv.rdict";
+  kv_opts.bucket_count = 0;
+  kv_opts.bulk_build_threads = std::max(std::thread::hardware_concurrency(), 1U);
+  kv = std::move(rdict::ReadonlyKV<uint64_t, std::string_view>::New(kv_opts).value());
+  start = std::chrono::steady_clock::now();
+  for (uint64_t i = 0; i < count; i++) {
+    kv->BulkAdd(i, value);
+  }
+  double append_secs = elapsed_secs(start);
+  kv->BulkFinish();
+  secs = elapsed_secs(start);
+  printf("kv bulk  count:%zu value_size:%zu cost:%.3fs(index %.3fs, %u threads) %.2fM records/s\n", count, value_size,
+         secs, secs - append_secs, kv_opts.bulk_build_threads, count / secs / 1e6);
+
+  rdict::ReadonlyList::Options list_opts;
+  list_opts.path = dir + "/bench_put_list.rdict";
+  list_opts.readonly = false;
+  list_opts.truncate = true;
+  auto list_result = rdict::ReadonlyList::New(list_opts);
+  if (!list_result.ok()) {
+    printf("create list failed:%s\n", list_result.status().ToString().c_str());
+    return -1;
+  }
+  auto list = std::move(list_result.value());
+  start = std::chrono::steady_clock::now();
+  for (uint64_t i = 0; i < count; i++) {
+    list->Add(value);
+  }
+  secs = elapsed_secs(start);
+  printf("list add count:%zu value_size:%zu cost:%.3fs %.2fM records/s\n", count, value_size, secs,
+         count / secs / 1e6);
+  return 0;
+}
+
+// bench_rdict ffi <output dir> [count] [batch]
+static int bench_ffi(int argc, char** argv) {
+  if (argc < 3) {
+    printf("Usage: %s ffi <output dir> [count] [batch]\n", argv[0]);
+    return -1;
+  }
+  std::string path = std::string(argv[2]) + "/bench_ffi_kv.rdict";
+  size_t count = argc > 3 ? strtoull(argv[3], nullptr, 10) : 1000000;
+  size_t batch = argc > 4 ? strtoull(argv[4], nullptr, 10) : 64;
+  using Dict = rdict::ReadonlyKV<uint64_t, std::string_view>;
+  Dict::Options opts;
+  opts.path = path;
+  opts.truncate = true;
+  opts.bucket_count = static_cast<size_t>(count / opts.max_load_factor) + 1;
+  {
+    auto result = Dict::New(opts);
+    if (!result.ok()) {
+      printf("create kv failed:%s\n", result.status().ToString().c_str());
+      return -1;
+    }
+    auto dict = std::move(result.value());
+    std::string value(64, 'v');
+    for (uint64_t i = 0; i < count; i++) {
+      dict->Put(i, value);
+    }
+    dict->Commit();
+  }
+  // half of the lookups miss
+  std::vector<int64_t> keys(count);
+  for (size_t i = 0; i < count; i++) {
+    keys[i] = static_cast<int64_t>((i * 2654435761ULL) % (count * 2));
+  }
+
+  opts.readonly = true;
+  auto dict = std::move(Dict::New(opts).value());
+  rdict_kv* kv = nullptr;
+  if (rdict_kv_open(path.c_str(), RDICT_KEY_UINT64, RDICT_LOAD_MMAP, &kv) != RDICT_OK) {
+    printf("open %s failed:%s\n", path.c_str(), rdict_last_error());
+    return -1;
+  }
+  std::vector<const void*> vals(batch);
+  std::vector<size_t> val_lens(batch);
+  // the first round faults in the pages of both mappings, the second round is reported
+  for (int round = 0; round < 2; round++) {
+    size_t found = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int64_t key : keys) {
+      found += dict->Get(static_cast<uint64_t>(key)).ok();
+    }
+    double get_secs = elapsed_secs(start);
+
+    start = std::chrono::steady_clock::now();
+    for (int64_t key : keys) {
+      std::string_view value;
+      found += dict->Find(static_cast<uint64_t>(key), &value);
+    }
+    double find_secs = elapsed_secs(start);
+
+    start = std::chrono::steady_clock::now();
+    for (int64_t key : keys) {
+      const void* val = nullptr;
+      size_t val_len = 0;
+      found += rdict_kv_get_int(kv, key, &val, &val_len) == RDICT_OK;
+    }
+    double c_get_secs = elapsed_secs(start);
+
+    start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < count; i += batch) {
+      size_t n = std::min(batch, count - i);
+      found += rdict_kv_multi_get_int(kv, &keys[i], n, vals.data(), val_lens.data());
+    }
+    double c_multi_get_secs = elapsed_secs(start);
+    if (round == 0) {
+      continue;
+    }
+    printf("found:%zu\n", found / 4);
+    printf("c++ Get          %.1fns/key\n", get_secs * 1e9 / count);
+    printf("c++ Find         %.1fns/key\n", find_secs * 1e9 / count);
+    printf("c get_int        %.1fns/key\n", c_get_secs * 1e9 / count);
+    printf("c multi_get_int  %.1fns/key batch:%zu\n", c_multi_get_secs * 1e9 / count, batch);
+  }
+  rdict_kv_close(kv);
+  return 0;
+}
+
+// bench_rdict probe <output dir> [count]
+static int bench_probe(int argc, char** argv) {
+  if (argc < 3) {
+    printf("Usage: %s probe <output dir> [count]\n", argv[0]);
+    return -1;
+  }
+  std::string dir = argv[2];
+  size_t count = argc > 3 ? strtoull(argv[3], nullptr, 10) : 4000000;
+  using Dict = rdict::ReadonlyKV<std::string_view, std::string_view>;
+  std::vector<std::string> keys(count);
+  for (size_t i = 0; i < count; i++) {
+    keys[i] = "key" + std::to_string(i * 2654435761ULL % (count * 4));
+  }
+  const char* names[] = {"robin_hood", "cuckoo", "inline"};
+  for (auto index_type : {rdict::detail::INDEX_ROBIN_HOOD, rdict::detail::INDEX_CUCKOO, rdict::detail::INDEX_INLINE}) {
+    Dict::Options opts;
+    opts.path = dir + "/bench_probe_" + names[index_type] + ".rdict";
+    opts.truncate = true;
+    opts.index_type = index_type;
+    {
+      auto result = Dict::New(opts);
+      if (!result.ok()) {
+        printf("create kv failed:%s\n", result.status().ToString().c_str());
+        return -1;
+      }
+      auto dict = std::move(result.value());
+      for (const auto& key : keys) {
+        dict->Put(key, "v");
+      }
+      auto status = dict->Commit();
+      if (!status.ok()) {
+        printf("commit kv failed:%s\n", status.ToString().c_str());
+        return -1;
+      }
+    }
+    opts.readonly = true;
+    opts.truncate = false;
+    auto dict = std::move(Dict::New(opts).value());
+    // half of the lookups miss, a miss walks the whole probe sequence
+    std::vector<uint64_t> latencies;
+    latencies.reserve(count * 2);
+    for (int round = 0; round < 2; round++) {
+      latencies.clear();
+      for (size_t i = 0; i < count; i++) {
+        std::string miss = keys[i] + "x";
+        for (const std::string* key : {&keys[i], &miss}) {
+          auto start = std::chrono::steady_clock::now();
+          std::string_view value;
+          dict->Find(*key, &value);
+          latencies.emplace_back(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                     std::chrono::steady_clock::now() - start)
+                                     .count());
+        }
+      }
+    }
+    std::sort(latencies.begin(), latencies.end());
+    auto percentile = [&](double p) { return latencies[static_cast<size_t>(p * (latencies.size() - 1))]; };
+    printf("%-10s count:%zu p50:%luns p99:%luns p99.9:%luns p99.99:%luns max:%luns\n", names[index_type], count,
+           percentile(0.5), percentile(0.99), percentile(0.999), percentile(0.9999), latencies.back());
+  }
+  return 0;
+}
+
+#if defined(__cpp_impl_coroutine)
+// bench_rdict async <output dir> [count] [group]
+static int bench_async(int argc, char** argv) {
+  if (argc < 3) {
+    printf("Usage: %s async <output dir> [count] [group]\n", argv[0]);
+    return -1;
+  }
+  std::string path = std::string(argv[2]) + "/bench_async_kv.rdict";
+  size_t count = argc > 3 ? strtoull(argv[3], nullptr, 10) : 10000000;
+  size_t group = argc > 4 ? strtoull(argv[4], nullptr, 10) : 32;
+  using Dict = rdict::ReadonlyKV<uint64_t, std::string_view>;
+  Dict::Options opts;
+  opts.path = path;
+  opts.truncate = true;
+  opts.bucket_count = static_cast<size_t>(count / opts.max_load_factor) + 1;
+  {
+    auto dict = std::move(Dict::New(opts).value());
+    std::string value(64, 'v');
+    for (uint64_t i = 0; i < count; i++) {
+      dict->Put(i, value);
+    }
+    dict->Commit();
+  }
+  opts.readonly = true;
+  opts.truncate = false;
+  opts.load_mode = rdict::MmapFile::LOAD_ANONYMOUS;
+  auto dict = std::move(Dict::New(opts).value());
+  std::vector<uint64_t> keys(count);
+  for (size_t i = 0; i < count; i++) {
+    keys[i] = (i * 2654435761ULL) % count;
+  }
+
+  size_t found = 0;
+  auto start = std::chrono::steady_clock::now();
+  for (uint64_t key : keys) {
+    std::string_view value;
+    found += dict->Find(key, &value);
+  }
+  double secs = elapsed_secs(start);
+  printf("Find              found:%zu %.1fns/key\n", found, secs * 1e9 / count);
+
+  // the resumable lookup interleaved by hand, the lower bound of the coroutine version
+  found = 0;
+  std::vector<Dict::Lookup> lookups;
+  lookups.reserve(group);
+  start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < count; i += group) {
+    size_t n = std::min(group, count - i);
+    lookups.clear();
+    for (size_t j = 0; j < n; j++) {
+      lookups.emplace_back(Dict::hashed_key_type(keys[i + j]));
+      dict->StartLookup(&lookups.back());
+    }
+    for (size_t done = 0; done < n;) {
+      for (auto& lookup : lookups) {
+        if (lookup.data != nullptr && dict->StepLookup(&lookup)) {
+          found += lookup.found;
+          lookup.data = nullptr;
+          done++;
+        }
+      }
+    }
+  }
+  secs = elapsed_secs(start);
+  printf("StepLookup        found:%zu %.1fns/key group:%zu\n", found, secs * 1e9 / count, group);
+
+  found = 0;
+  std::vector<rdict::Task<absl::StatusOr<std::string_view>>> tasks;
+  tasks.reserve(group);
+  rdict::Interleaver scheduler;
+  start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < count; i += group) {
+    size_t n = std::min(group, count - i);
+    tasks.clear();
+    for (size_t j = 0; j < n; j++) {
+      tasks.emplace_back(dict->AsyncGet(keys[i + j]));
+      scheduler.Spawn(tasks.back());
+    }
+    scheduler.Run();
+    for (auto& task : tasks) {
+      found += task.Result().ok();
+    }
+  }
+  secs = elapsed_secs(start);
+  printf("AsyncGet          found:%zu %.1fns/key group:%zu\n", found, secs * 1e9 / count, group);
+  return 0;
+}
+#endif
+
+// builds 'keys' into a dict hashed by HashFn, returns the mean Find latency in ns
+template <typename HashFn>
+static double bench_get_with_hash(const std::string& path, const std::vector<std::string>& keys) {
+  using Dict = rdict::ReadonlyKV<std::string_view, std::string_view, HashFn>;
+  typename Dict::Options opts;
+  opts.path = path;
+  opts.truncate = true;
+  {
+    auto dict = std::move(Dict::New(opts).value());
+    for (const auto& key : keys) {
+      dict->Put(key, "v");
+    }
+    auto status = dict->Commit();
+    if (!status.ok()) {
+      printf("commit kv failed:%s\n", status.ToString().c_str());
+      return -1;
+    }
+  }
+  opts.readonly = true;
+  opts.truncate = false;
+  auto dict = std::move(Dict::New(opts).value());
+  double secs = 0;
+  size_t found = 0;
+  for (int round = 0; round < 2; round++) {
+    auto start = std::chrono::steady_clock::now();
+    for (const auto& key : keys) {
+      std::string_view value;
+      found += dict->Find(key, &value);
+    }
+    secs = elapsed_secs(start);
+  }
+  if (found != 2 * keys.size()) {
+    printf("missing keys with hash %s\n", path.c_str());
+  }
+  return secs * 1e9 / keys.size();
+}
+
+// bench_rdict hash <output dir> [count]
+static int bench_hash(int argc, char** argv) {
+  if (argc < 3) {
+    printf("Usage: %s hash <output dir> [count]\n", argv[0]);
+    return -1;
+  }
+  std::string dir = argv[2];
+  size_t count = argc > 3 ? strtoull(argv[3], nullptr, 10) : 1000000;
+  printf("crc32c hardware:%d stripe hardware:%d\n", rdict::crc32c::HardwareAccelerated(),
+         rdict::stripe::HardwareAccelerated());
+  printf("%-6s %-8s %10s %10s %12s\n", "keylen", "hash", "ns/hash", "GB/s", "Get ns/key");
+  for (size_t key_len : {8, 16, 32, 64, 128, 256, 1024}) {
+    // bounded to 256MB of keys
+    size_t n = std::min(count, (size_t{256} << 20) / key_len);
+    std::vector<std::string> keys(n);
+    for (size_t i = 0; i < n; i++) {
+      std::string id = std::to_string(i * 2654435761ULL % (n * 4));
+      keys[i] = std::string(key_len - std::min(key_len, id.size()), 'k') + id.substr(0, key_len);
+    }
+    struct HashCase {
+      const char* name;
+      uint64_t (*hash)(std::string_view);
+      double (*get)(const std::string&, const std::vector<std::string>&);
+    };
+    HashCase cases[] = {
+        {"wyhash", [](std::string_view k) { return rdict::hash<std::string_view>{}(k); },
+         bench_get_with_hash<rdict::hash<std::string_view>>},
+        {"crc32c", [](std::string_view k) { return rdict::crc32c_hash<std::string_view>{}(k); },
+         bench_get_with_hash<rdict::crc32c_hash<std::string_view>>},
+        {"stripe", [](std::string_view k) { return rdict::stripe_hash<std::string_view>{}(k); },
+         bench_get_with_hash<rdict::stripe_hash<std::string_view>>},
+    };
+    for (const auto& hash_case : cases) {
+      // hash throughput over a L1 resident subset of the keys
+      size_t hot = std::min(n, std::max<size_t>(1, (size_t{16} << 10) / key_len));
+      size_t rounds = std::max<size_t>(1, (size_t{1} << 30) / (hot * key_len));
+      uint64_t sum = 0;
+      auto start = std::chrono::steady_clock::now();
+      for (size_t round = 0; round < rounds; round++) {
+        for (size_t i = 0; i < hot; i++) {
+          sum += hash_case.hash(keys[i]);
+        }
+      }
+      double secs = elapsed_secs(start);
+      double get_ns = hash_case.get(dir + "/bench_hash_" + hash_case.name + ".rdict", keys);
+      printf("%-6zu %-8s %10.2f %10.2f %12.1f%s\n", key_len, hash_case.name, secs * 1e9 / (rounds * hot),
+             rounds * hot * key_len / secs / 1e9, get_ns, sum == 0 ? " " : "");
+    }
+  }
+  return 0;
+}
+
+// bench_rdict embedding <output dir> [count] [dim]
+static int bench_embedding(int argc, char** argv) {
+  if (argc < 3) {
+    printf("Usage: %s embedding <output dir> [count] [dim]\n", argv[0]);
+    return -1;
+  }
+  std::string dir = argv[2];
+  size_t count = argc > 3 ? strtoull(argv[3], nullptr, 10) : 1000000;
+  uint32_t dim = argc > 4 ? static_cast<uint32_t>(atoi(argv[4])) : 128;
+  size_t batch = 512, lookups = 2000000;
+  std::vector<float> row(dim);
+  std::vector<uint64_t> keys(lookups);
+  for (size_t i = 0; i < lookups; i++) {
+    keys[i] = (i * 2654435761ULL) % count;
+  }
+  std::vector<float> matrix(batch * dim);
+  printf("simd:%d\n", rdict::embedding::HardwareAccelerated());
+  printf("%-16s %10s %12s\n", "format", "row bytes", "ns/row");
+  {
+    // baseline of string values, as stored by FbsKv
+    rdict::ReadonlyKV<uint64_t, std::string_view>::Options opts;
+    opts.path = dir + "/bench_embedding_str.rdict";
+    opts.truncate = true;
+    auto dict = std::move(rdict::ReadonlyKV<uint64_t, std::string_view>::New(opts).value());
+    for (size_t i = 0; i < count; i++) {
+      row[0] = i;
+      dict->Put(i, std::string_view(reinterpret_cast<const char*>(row.data()), dim * sizeof(float)));
+    }
+    dict->Commit();
+    opts.truncate = false;
+    opts.readonly = true;
+    dict = std::move(rdict::ReadonlyKV<uint64_t, std::string_view>::New(opts).value());
+    std::chrono::steady_clock::time_point start;
+    // the first round faults the pages in
+    for (int round = 0; round < 2; round++) {
+      start = std::chrono::steady_clock::now();
+      for (size_t i = 0; i < lookups; i++) {
+        std::string_view val;
+        if (dict->Find(keys[i], &val)) {
+          memcpy(&matrix[(i % batch) * dim], val.data(), val.size());
+        }
+      }
+    }
+    printf("%-16s %10zu %12.1f\n", "string value", dim * sizeof(float), elapsed_secs(start) * 1e9 / lookups);
+  }
+  const char* names[] = {"fp32 gather", "fp16 gather", "int8 gather"};
+  for (auto quantization : {rdict::EMBEDDING_FP32, rdict::EMBEDDING_FP16, rdict::EMBEDDING_INT8}) {
+    rdict::ReadonlyEmbeddingKV<uint64_t>::Options opts;
+    opts.path = dir + "/bench_embedding.rdict";
+    opts.truncate = true;
+    opts.dim = dim;
+    opts.quantization = quantization;
+    auto dict = std::move(rdict::ReadonlyEmbeddingKV<uint64_t>::New(opts).value());
+    for (size_t i = 0; i < count; i++) {
+      row[0] = i;
+      dict->Put(i, row.data());
+    }
+    dict->Commit();
+    dict = std::move(rdict::ReadonlyEmbeddingKV<uint64_t>::Load(opts.path).value());
+    std::chrono::steady_clock::time_point start;
+    for (int round = 0; round < 2; round++) {
+      start = std::chrono::steady_clock::now();
+      for (size_t i = 0; i < lookups; i += batch) {
+        dict->Gather(&keys[i], std::min(batch, lookups - i), matrix.data());
+      }
+    }
+    printf("%-16s %10zu %12.1f\n", names[quantization], dict->RowBytes(), elapsed_secs(start) * 1e9 / lookups);
+  }
+  std::vector<float> query(dim, 0.5F), scores(batch);
+  size_t rounds = 20000;
+  auto start = std::chrono::steady_clock::now();
+  for (size_t round = 0; round < rounds; round++) {
+    rdict::embedding::Score(query.data(), matrix.data(), batch, dim, scores.data());
+  }
+  printf("%-16s %10s %12.1f\n", "score", "", elapsed_secs(start) * 1e9 / (rounds * batch));
+  start = std::chrono::steady_clock::now();
+  for (size_t round = 0; round < rounds; round++) {
+    for (size_t i = 0; i < batch; i++) {
+      scores[i] = rdict::embedding::PortableDot(query.data(), &matrix[i * dim], dim);
+    }
+  }
+  printf("%-16s %10s %12.1f\n", "score portable", "", elapsed_secs(start) * 1e9 / (rounds * batch));
+  return 0;
+}
+
+// bench_rdict trie <output dir> [count]
+static int bench_trie(int argc, char** argv) {
+  if (argc < 3) {
+    printf("Usage: %s trie <output dir> [count]\n", argv[0]);
+    return -1;
+  }
+  std::string dir = argv[2];
+  size_t count = argc > 3 ? strtoull(argv[3], nullptr, 10) : 5000000;
+  // url like keys sharing long prefixes
+  std::vector<std::string> keys(count);
+  for (size_t i = 0; i < count; i++) {
+    uint64_t h = i * 2654435761ULL;
+    keys[i] = "https://www" + std::to_string(h % 97) + ".example.com/item/" + std::to_string(h % 1000) + "/" +
+              std::to_string(i);
+  }
+  std::vector<size_t> lookups(count);
+  for (size_t i = 0; i < count; i++) {
+    lookups[i] = (i * 40503ULL) % count;
+  }
+  std::string kv_path = dir + "/bench_trie_kv.rdict";
+  std::string trie_path = dir + "/bench_trie.rdict";
+  {
+    rdict::ReadonlyKV<std::string_view, std::string_view>::Options opts;
+    opts.path = kv_path;
+    opts.truncate = true;
+    auto dict = std::move(rdict::ReadonlyKV<std::string_view, std::string_view>::New(opts).value());
+    dict->Reserve(count);
+    for (size_t i = 0; i < count; i++) {
+      dict->Put(keys[i], "v");
+    }
+    dict->Commit();
+    rdict::ReadonlyTrie::Options trie_opts;
+    trie_opts.path = trie_path;
+    trie_opts.truncate = true;
+    auto trie = std::move(rdict::ReadonlyTrie::New(trie_opts).value());
+    for (size_t i = 0; i < count; i++) {
+      trie->Put(keys[i], "v");
+    }
+    trie->Commit();
+  }
+  printf("%-6s %12s %12s\n", "dict", "file MB", "Get ns/key");
+  {
+    rdict::ReadonlyKV<std::string_view, std::string_view>::Options opts;
+    opts.path = kv_path;
+    opts.readonly = true;
+    auto dict = std::move(rdict::ReadonlyKV<std::string_view, std::string_view>::New(opts).value());
+    size_t file_size = std::filesystem::file_size(kv_path);
+    std::string_view value;
+    size_t hits = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i : lookups) {
+      hits += dict->Find(keys[i], &value);
+    }
+    printf("%-6s %12.1f %12.1f%s\n", "hash", file_size / 1048576.0, elapsed_secs(start) * 1e9 / count,
+           hits == count ? "" : " missing");
+  }
+  {
+    rdict::ReadonlyTrie::Options opts;
+    opts.path = trie_path;
+    opts.readonly = true;
+    auto trie = std::move(rdict::ReadonlyTrie::New(opts).value());
+    size_t file_size = std::filesystem::file_size(trie_path);
+    std::string_view value;
+    size_t hits = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i : lookups) {
+      hits += trie->Find(keys[i], &value);
+    }
+    printf("%-6s %12.1f %12.1f%s\n", "trie", file_size / 1048576.0, elapsed_secs(start) * 1e9 / count,
+           hits == count ? "" : " missing");
+  }
+  return 0;
+}
+
+int main(int argc, char** argv) {
+  std::string_view cmd = argc > 1 ? argv[1] : "";
+  if (cmd == "load") {
+    return bench_load(argc, argv);
+  }
+  if (cmd == "put") {
+    return bench_put(argc, argv);
+  }
+  if (cmd == "ffi") {
+    return bench_ffi(argc, argv);
+  }
+  if (cmd == "probe") {
+    return bench_probe(argc, argv);
+  }
+  if (cmd == "hash") {
+    return bench_hash(argc, argv);
+  }
+  if (cmd == "embedding") {
+    return bench_embedding(argc, argv);
+  }
+  if (cmd == "trie") {
+    return bench_trie(argc, argv);
+  }
+#if defined(__cpp_impl_coroutine)
+  if (cmd == "async") {
+    return bench_async(argc, argv);
+  }
+#endif
+  printf("Usage: %s <load|put|ffi|probe|hash|embedding|trie|async> ...\n", argv[0]);
+  return -1;
+}
@@ -0,0 +1,148 @@
+/*
+** BSD 3-Clause License
+**
+** Copyright (c) 2023, qiyingwang <qiyingwang@tencent.com>, the respective contributors, as shown by the AUTHORS file.
+** All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions are met:
+** * Redistributions of source code must retain the above copyright notice, this
+** list of conditions and the following disclaimer.
+**
+** * Redistributions in binary form must reproduce the above copyright notice,
+** this list of conditions and the following disclaimer in the documentation
+** and/or other materials provided with the distribution.
+**
+** * Neither the name of the copyright holder nor the names of its
+** contributors may be used to endorse or promote products derived from
+** this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+** AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+** IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+** DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+** FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+** DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+** SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+** CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+** OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#include <gtest/gtest.h>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+#include "flatbuffers/idl.h"
+#include "flatbuffers/reflection.h"
+#include "rdict/fbs_builder.h"
+#include "rdict/kv.h"
+
+static const char* kSchema = R"(
+namespace test.rdict;
+table Entry {
+  id:long (key);
+  name:string;
+  d:double;
+}
+root_type Entry;
+)";
+
+struct BuilderContext {
+  std::string schema_path = "./test_fbs_builder.fbs";
+  flatbuffers::Parser parser;
+  flatbuffers::Parser schema_parser;
+  const reflection::Schema* reflection_schema = nullptr;
+
+  bool Init() {
+    std::ofstream(schema_path) << kSchema;
+    if (!parser.Parse(kSchema) || !schema_parser.Parse(kSchema)) {
+      return false;
+    }
+    schema_parser.Serialize();
+    reflection_schema = reflection::GetSchema(schema_parser.builder_.GetBufferPointer());
+    return true;
+  }
+  // checks the stored root table in place, 8 bytes scalars must be naturally aligned
+  void Check(rdict::ReadonlyKV<int64_t, std::string_view>* kv, int64_t id, const std::string& name, double d) {
+    auto result = kv->Get(id);
+    ASSERT_TRUE(result.ok()) << id << " " << result.status();
+    std::string_view value = result.value();
+    const uint8_t* data = reinterpret_cast<const uint8_t*>(value.data());
+    ASSERT_TRUE(flatbuffers::Verify(*reflection_schema, *reflection_schema->root_table(), data, value.size()));
+    auto& root = *flatbuffers::GetAnyRoot(data);
+    auto fields = reflection_schema->root_table()->fields();
+    auto id_field = fields->LookupByKey("id");
+    auto name_field = fields->LookupByKey("name");
+    auto d_field = fields->LookupByKey("d");
+    ASSERT_EQ(flatbuffers::GetFieldI<int64_t>(root, *id_field), id);
+    ASSERT_EQ(flatbuffers::GetFieldS(root, *name_field)->str(), name);
+    ASSERT_EQ(flatbuffers::GetFieldF<double>(root, *d_field), d);
+    const uint8_t* id_addr = root.GetAddressOf(id_field->offset());
+    ASSERT_NE(id_addr, nullptr);
+    ASSERT_EQ(reinterpret_cast<uintptr_t>(id_addr) % sizeof(int64_t), 0);
+  }
+};
+
+TEST(FbsDictBuilder, add_flatbuffer) {
+  BuilderContext ctx;
+  ASSERT_TRUE(ctx.Init());
+  std::string output_path = "./test_fbs_builder_kv";
+  auto builder = std::move(rdict::FbsDictBuilder::New(ctx.schema_path, output_path).value());
+  // plain buffer at an unaligned address
+  ASSERT_TRUE(ctx.parser.ParseJson(R"({"id": 1, "name": "a", "d": 0.5})"));
+  std::string unaligned = " " + std::string(reinterpret_cast<const char*>(ctx.parser.builder_.GetBufferPointer()),
+                                            ctx.parser.builder_.GetSize());
+  ASSERT_TRUE(builder->AddFlatbuffer(std::string_view(unaligned).substr(1)).ok());
+  // size prefixed buffers as read from a '-F fbs' stream
+  for (int64_t id = 2; id < 100; id++) {
+    flatbuffers::FlatBufferBuilder fbb;
+    std::string name(id, 'x');
+    auto name_offset = fbb.CreateString(name);
+    auto start = fbb.StartTable();
+    fbb.AddElement<int64_t>(ctx.reflection_schema->root_table()->fields()->LookupByKey("id")->offset(), id, 0);
+    fbb.AddOffset(ctx.reflection_schema->root_table()->fields()->LookupByKey("name")->offset(), name_offset);
+    fbb.AddElement<double>(ctx.reflection_schema->root_table()->fields()->LookupByKey("d")->offset(), id * 0.25, 0);
+    fbb.FinishSizePrefixed(flatbuffers::Offset<flatbuffers::Table>(fbb.EndTable(start)));
+    std::string record(reinterpret_cast<const char*>(fbb.GetBufferPointer()), fbb.GetSize());
+    ASSERT_TRUE(builder->AddSizePrefixedFlatbuffer(record).ok()) << id;
+  }
+  ASSERT_FALSE(builder->AddSizePrefixedFlatbuffer(std::string(8, '\0')).ok());
+  ASSERT_FALSE(builder->AddFlatbuffer("abcdefgh").ok());
+  ASSERT_TRUE(builder->Flush().ok());
+  ASSERT_EQ(builder->GetReport().records, 99u);
+  builder.reset();
+
+  rdict::ReadonlyKV<int64_t, std::string_view>::Options opts;
+  opts.path = output_path;
+  opts.readonly = true;
+  auto kv = std::move(rdict::ReadonlyKV<int64_t, std::string_view>::New(opts).value());
+  ctx.Check(kv.get(), 1, "a", 0.5);
+  for (int64_t id = 2; id < 100; id++) {
+    ctx.Check(kv.get(), id, std::string(id, 'x'), id * 0.25);
+  }
+}
+
+TEST(FbsDictBuilder, add_row) {
+  BuilderContext ctx;
+  ASSERT_TRUE(ctx.Init());
+  std::string output_path = "./test_fbs_builder_row_kv";
+  auto builder = std::move(rdict::FbsDictBuilder::New(ctx.schema_path, output_path).value());
+  // the first row is the header
+  ASSERT_TRUE(builder->AddRow("name,id,d\r", ',').ok());
+  ASSERT_TRUE(builder->AddRow("\"a,\"\"b\",1,0.5", ',').ok());
+  ASSERT_TRUE(builder->AddRow("c,2,", ',').ok());
+  ASSERT_FALSE(builder->AddRow("d,x,1", ',').ok());
+  ASSERT_TRUE(builder->Flush().ok());
+  ASSERT_EQ(builder->GetReport().records, 2u);
+  builder.reset();
+
+  rdict::ReadonlyKV<int64_t, std::string_view>::Options opts;
+  opts.path = output_path;
+  opts.readonly = true;
+  auto kv = std::move(rdict::ReadonlyKV<int64_t, std::string_view>::New(opts).value());
+  ctx.Check(kv.get(), 1, "a,\"b", 0.5);
+  ctx.Check(kv.get(), 2, "c", 0);
+  ASSERT_FALSE(kv->Get(3).ok());
+}
@@ -0,0 +1,171 @@
+/*
+** BSD 3-Clause License
+**
+** Copyright (c) 2023, qiyingwang <qiyingwang@tencent.com>, the respective contributors, as shown by the AUTHORS file.
+** All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions are met:
+** * Redistributions of source code must retain the above copyright notice, this
+** list of conditions and the following disclaimer.
+**
+** * Redistributions in binary form must reproduce the above copyright notice,
+** this list of conditions and the following disclaimer in the documentation
+** and/or other materials provided with the distribution.
+**
+** * Neither the name of the copyright holder nor the names of its
+** contributors may be used to endorse or promote products derived from
+** this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+** AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+** IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+** DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+** FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+** DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+** SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+** CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+** OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#include <gtest/gtest.h>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include "rdict/fbs_encoder.h"
+
+static const char* kSchema = R"(
+namespace test.rdict;
+enum Kind:ubyte { A = 0, B, C }
+table Item {
+  name:string;
+  weight:float;
+  tags:[string];
+}
+table Entry {
+  id:long (key);
+  name:string;
+  flag:bool;
+  b:byte = 1;
+  s:short = 150;
+  u:uint;
+  d:double = 0.5;
+  f:float;
+  kind:Kind = B;
+  scores:[int];
+  names:[string];
+  item:Item;
+  items:[Item];
+}
+root_type Entry;
+)";
+
+struct EncoderContext {
+  flatbuffers::Parser parser;
+  flatbuffers::Parser schema_parser;
+  const reflection::Schema* reflection_schema = nullptr;
+  std::unique_ptr<rdict::FbsJsonEncoder> encoder;
+
+  absl::Status Init(const char* schema) {
+    if (!parser.Parse(schema) || !schema_parser.Parse(schema)) {
+      return absl::InvalidArgumentError("invalid schema");
+    }
+    schema_parser.Serialize();
+    reflection_schema = reflection::GetSchema(schema_parser.builder_.GetBufferPointer());
+    auto result = rdict::FbsJsonEncoder::New(parser, reflection_schema);
+    if (!result.ok()) {
+      return result.status();
+    }
+    encoder = std::move(result.value());
+    return absl::OkStatus();
+  }
+  std::string ParseJson(const std::string& json) {
+    if (!parser.ParseJson(json.c_str())) {
+      return "";
+    }
+    return std::string(reinterpret_cast<const char*>(parser.builder_.GetBufferPointer()), parser.builder_.GetSize());
+  }
+};
+
+TEST(FbsJsonEncoder, identical_to_parser) {
+  EncoderContext ctx;
+  ASSERT_TRUE(ctx.Init(kSchema).ok());
+  std::vector<std::string> jsons = {
+      R"({})",
+      R"({"id": 1})",
+      R"({"id": -100, "name": "hello", "flag": true, "b": 1, "s": 150, "u": 4294967295})",
+      R"({"u": 7, "name": "café\n", "id": 9223372036854775807, "s": -32768, "b": -128})",
+      R"({"d": 0.1, "f": 0.1, "kind": "C", "id": 3})",
+      R"({"f": 1, "d": 1e300, "kind": 1, "flag": false})",
+      R"({"kind": "B", "d": 0.5, "name": null})",
+      R"({"scores": [1, -2, 3, 2147483647], "names": ["a", "", "ccc"], "id": 5})",
+      R"({"item": {"weight": 2.5, "name": "x", "tags": ["t1", "t2"]}, "name": "outer"})",
+      R"({"items": [{"name": "a"}, {}, {"weight": -1.25, "tags": []}], "scores": [], "item": {}})",
+      R"(  {"name": "z", "items": [{"tags": ["q"]}], "names": ["n"], "id": 42, "f": 3.4028234e38}  )",
+  };
+  for (const auto& json : jsons) {
+    auto result = ctx.encoder->Encode(json);
+    ASSERT_TRUE(result.ok()) << json << " " << result.status();
+    std::string expected = ctx.ParseJson(json);
+    ASSERT_FALSE(expected.empty()) << json;
+    ASSERT_EQ(std::string(result.value()), expected) << json;
+  }
+}
+
+TEST(FbsJsonEncoder, fallback) {
+  EncoderContext ctx;
+  ASSERT_TRUE(ctx.Init(kSchema).ok());
+  // input the encoder does not reproduce is reported instead of encoded differently
+  std::vector<std::string> jsons = {
+      R"({"id": "12"})",
+      R"({"unknown": 1})",
+      R"({"b": 200})",
+      R"({"u": -1})",
+      R"({"flag": 1})",
+      R"({"kind": "D"})",
+      R"({"id": 1, "id": 2})",
+      R"({"s": 1.5})",
+      R"({"name": 1})",
+      R"({"id": 1} {"id": 2})",
+      R"([1, 2])",
+      R"({"scores": [1, null]})",
+  };
+  for (const auto& json : jsons) {
+    ASSERT_FALSE(ctx.encoder->Encode(json).ok()) << json;
+  }
+}
+
+TEST(FbsRowEncoder, identical_to_equivalent_json) {
+  EncoderContext ctx;
+  ASSERT_TRUE(ctx.Init(kSchema).ok());
+  auto result = rdict::FbsRowEncoder::New(ctx.parser, ctx.reflection_schema, {"id", "name", "", "kind", "f", "flag"});
+  ASSERT_TRUE(result.ok()) << result.status();
+  auto encoder = std::move(result.value());
+  std::vector<std::pair<std::vector<std::string_view>, std::string>> rows = {
+      {{"5", "hello", "ignored", "C", "0.1", "true"},
+       R"({"id": 5, "name": "hello", "kind": "C", "f": 0.1, "flag": true})"},
+      {{"-7", "", "", "2", "", "0"}, R"({"id": -7, "kind": 2, "flag": false})"},
+      {{"1", "x"}, R"({"id": 1, "name": "x"})"},
+  };
+  for (const auto& [row, json] : rows) {
+    auto encoded = encoder->Encode(row);
+    ASSERT_TRUE(encoded.ok()) << json << " " << encoded.status();
+    ASSERT_EQ(std::string(encoded.value()), ctx.ParseJson(json)) << json;
+  }
+  ASSERT_FALSE(encoder->Encode({"abc"}).ok());
+  ASSERT_FALSE(encoder->Encode({"1", "x", "", "D"}).ok());
+  ASSERT_FALSE(rdict::FbsRowEncoder::New(ctx.parser, ctx.reflection_schema, {"unknown"}).ok());
+  ASSERT_FALSE(rdict::FbsRowEncoder::New(ctx.parser, ctx.reflection_schema, {"scores"}).ok());
+}
+
+TEST(FbsJsonEncoder, unsupported_schema) {
+  EncoderContext ctx;
+  auto status = ctx.Init(R"(
+table Weapon { name:string; }
+union Equipment { Weapon }
+table Monster { name:string; equipped:Equipment; }
+root_type Monster;
+)");
+  ASSERT_TRUE(absl::IsUnimplemented(status));
+}
@@ -0,0 +1,131 @@
+/*
+** BSD 3-Clause License
+**
+** Copyright (c) 2023, qiyingwang <qiyingwang@tencent.com>, the respective contributors, as shown by the AUTHORS file.
+** All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions are met:
+** * Redistributions of source code must retain the above copyright notice, this
+** list of conditions and the following disclaimer.
+**
+** * Redistributions in binary form must reproduce the above copyright notice,
+** this list of conditions and the following disclaimer in the documentation
+** and/or other materials provided with the distribution.
+**
+** * Neither the name of the copyright holder nor the names of its
+** contributors may be used to endorse or promote products derived from
+** this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+** AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+** IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+** DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+** FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+** DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+** SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+** CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+** OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#include <gtest/gtest.h>
+#include <string>
+#include "rdict/bundle.h"
+#include "rdict/kv.h"
+#include "rdict/list.h"
+#include "rdict/set.h"
+#include "rdict/trie.h"
+
+static void build_dicts(size_t count, const std::string& tag) {
+  rdict::ReadonlyKV<std::string_view, std::string_view>::Options kv_opts;
+  kv_opts.path = "./test_bundle_kv";
+  kv_opts.truncate = true;
+  auto kv = std::move(rdict::ReadonlyKV<std::string_view, std::string_view>::New(kv_opts).value());
+  rdict::ReadonlyKV<uint64_t, uint64_t>::Options flat_opts;
+  flat_opts.path = "./test_bundle_flat";
+  flat_opts.truncate = true;
+  auto flat = std::move(rdict::ReadonlyKV<uint64_t, uint64_t>::New(flat_opts).value());
+  rdict::ReadonlyList::Options list_opts;
+  list_opts.path = "./test_bundle_list";
+  list_opts.truncate = true;
+  auto list = std::move(rdict::ReadonlyList::New(list_opts).value());
+  rdict::ReadonlySet<std::string_view>::Options set_opts;
+  set_opts.path = "./test_bundle_set";
+  set_opts.truncate = true;
+  auto set = std::move(rdict::ReadonlySet<std::string_view>::New(set_opts).value());
+  rdict::ReadonlyTrie::Options trie_opts;
+  trie_opts.path = "./test_bundle_trie";
+  trie_opts.truncate = true;
+  auto trie = std::move(rdict::ReadonlyTrie::New(trie_opts).value());
+  for (size_t i = 0; i < count; i++) {
+    std::string key = "key_" + std::to_string(i);
+    std::string val = tag + std::to_string(i);
+    ASSERT_TRUE(kv->Put(key, val).ok());
+    ASSERT_TRUE(flat->Put(i, i + count).ok());
+    ASSERT_TRUE(list->Add(val).ok());
+    ASSERT_TRUE(set->Insert(key).ok());
+    ASSERT_TRUE(trie->Put(key, val).ok());
+  }
+  ASSERT_TRUE(kv->Commit().ok());
+  ASSERT_TRUE(flat->Commit().ok());
+  ASSERT_TRUE(list->Commit().ok());
+  ASSERT_TRUE(set->Commit().ok());
+  ASSERT_TRUE(trie->Commit().ok());
+
+  rdict::DictBundleBuilder::Options opts;
+  opts.path = "./test_bundle";
+  auto builder = std::move(rdict::DictBundleBuilder::New(opts).value());
+  ASSERT_TRUE(builder->Add("kv", kv_opts.path).ok());
+  ASSERT_TRUE(builder->Add("flat", flat_opts.path).ok());
+  ASSERT_TRUE(builder->Add("list", list_opts.path).ok());
+  ASSERT_TRUE(builder->Add("set", set_opts.path).ok());
+  ASSERT_TRUE(builder->Add("trie", trie_opts.path).ok());
+  ASSERT_FALSE(builder->Add("kv", kv_opts.path).ok());
+  ASSERT_FALSE(builder->Add("none", "./test_bundle_none").ok());
+  ASSERT_TRUE(builder->Commit().ok());
+}
+
+TEST(Rdict, dict_bundle) {
+  size_t test_count = 10000;
+  build_dicts(test_count, "val_");
+  rdict::DictBundle::Options opts;
+  opts.path = "./test_bundle";
+  opts.populate = true;
+  auto bundle = std::move(rdict::DictBundle::Load(opts).value());
+  ASSERT_EQ(bundle->Entries().size(), 5);
+  for (const auto& entry : bundle->Entries()) {
+    ASSERT_EQ(entry.offset % rdict::DictBundle::kPageSize, 0);
+  }
+  ASSERT_EQ(bundle->Find("list")->type, rdict::detail::DICT_LIST);
+  ASSERT_EQ(bundle->Find("set")->type, rdict::detail::DICT_SET);
+  ASSERT_EQ(bundle->Find("other"), nullptr);
+
+  auto kv = std::move(bundle->Open<rdict::ReadonlyKV<std::string_view, std::string_view>>("kv").value());
+  auto flat = std::move(bundle->Open<rdict::ReadonlyKV<uint64_t, uint64_t>>("flat").value());
+  auto list = std::move(bundle->Open<rdict::ReadonlyList>("list").value());
+  auto set = std::move(bundle->Open<rdict::ReadonlySet<std::string_view>>("set").value());
+  auto trie = std::move(bundle->Open<rdict::ReadonlyTrie>("trie").value());
+  ASSERT_FALSE(bundle->Open<rdict::ReadonlyList>("other").ok());
+  ASSERT_FALSE(bundle->Open<rdict::ReadonlySet<std::string_view>>("kv").ok());
+  // dicts keep the bundle mapped
+  bundle.reset();
+  for (size_t i = 0; i < test_count; i++) {
+    std::string key = "key_" + std::to_string(i);
+    std::string val = "val_" + std::to_string(i);
+    ASSERT_EQ(kv->Get(key).value(), val);
+    ASSERT_EQ(flat->Get(i).value(), i + test_count);
+    ASSERT_EQ(list->Get(i).value(), val);
+    ASSERT_TRUE(set->Contains(key));
+    ASSERT_EQ(trie->Get(key).value(), val);
+  }
+  ASSERT_FALSE(kv->Get("key_" + std::to_string(test_count)).ok());
+
+  // a rebuilt bundle is published as a whole, the dicts of the old one are still valid
+  build_dicts(test_count / 2, "new_");
+  auto bundle1 = std::move(rdict::DictBundle::Load("./test_bundle").value());
+  auto kv1 = std::move(bundle1->Open<rdict::ReadonlyKV<std::string_view, std::string_view>>("kv").value());
+  ASSERT_EQ(kv1->Size(), test_count / 2);
+  ASSERT_EQ(kv1->Get("key_1").value(), "new_1");
+  ASSERT_EQ(kv->Get("key_1").value(), "val_1");
+  ASSERT_FALSE(rdict::DictBundle::Load("./test_bundle_kv").ok());
+}
@@ -0,0 +1,145 @@
+/*
+** BSD 3-Clause License
+**
+** Copyright (c) 2023, qiyingwang <qiyingwang@tencent.com>, the respective contributors, as shown by the AUTHORS file.
+** All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions are met:
+** * Redistributions of source code must retain the above copyright notice, this
+** list of conditions and the following disclaimer.
+**
+** * Redistributions in binary form must reproduce the above copyright notice,
+** this list of conditions and the following disclaimer in the documentation
+** and/or other materials provided with the distribution.
+**
+** * Neither the name of the copyright holder nor the names of its
+** contributors may be used to endorse or promote products derived from
+** this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+** AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+** IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+** DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+** FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+** DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+** SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+** CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+** OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#include <gtest/gtest.h>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "rdict/kv.h"
+#include "rdict/list.h"
+#include "rdict/rdict_c.h"
+
+TEST(RdictC, kv_str) {
+  rdict::ReadonlyKV<std::string_view, std::string_view>::Options opts;
+  opts.path = "./test_c_str_kv";
+  opts.truncate = true;
+  opts.bucket_count = 1300;
+  {
+    auto dict = std::move(rdict::ReadonlyKV<std::string_view, std::string_view>::New(opts).value());
+    for (int i = 0; i < 1000; i++) {
+      ASSERT_TRUE(dict->Put("key" + std::to_string(i), "val" + std::to_string(i)).ok());
+    }
+    ASSERT_TRUE(dict->Commit().ok());
+  }
+
+  rdict_kv* kv = nullptr;
+  ASSERT_EQ(RDICT_OK, rdict_kv_open(opts.path.c_str(), RDICT_KEY_STRING, RDICT_LOAD_MMAP, &kv));
+  ASSERT_EQ(1000, rdict_kv_size(kv));
+  const void* val = nullptr;
+  size_t val_len = 0;
+  ASSERT_EQ(RDICT_OK, rdict_kv_get_str(kv, "key10", 5, &val, &val_len));
+  ASSERT_EQ("val10", std::string_view(reinterpret_cast<const char*>(val), val_len));
+  ASSERT_EQ(RDICT_NOT_FOUND, rdict_kv_get_str(kv, "nokey", 5, &val, &val_len));
+  ASSERT_EQ(RDICT_INVALID_ARGUMENT, rdict_kv_get_int(kv, 10, &val, &val_len));
+
+  std::vector<std::string> keys = {"key1", "nokey", "key999"};
+  std::vector<const char*> key_ptrs;
+  std::vector<size_t> key_lens;
+  for (const auto& key : keys) {
+    key_ptrs.emplace_back(key.data());
+    key_lens.emplace_back(key.size());
+  }
+  std::vector<const void*> vals(keys.size());
+  std::vector<size_t> val_lens(keys.size());
+  ASSERT_EQ(2, rdict_kv_multi_get_str(kv, key_ptrs.data(), key_lens.data(), keys.size(), vals.data(),
+                                      val_lens.data()));
+  ASSERT_EQ("val1", std::string_view(reinterpret_cast<const char*>(vals[0]), val_lens[0]));
+  ASSERT_EQ(nullptr, vals[1]);
+  ASSERT_EQ(0, val_lens[1]);
+  ASSERT_EQ("val999", std::string_view(reinterpret_cast<const char*>(vals[2]), val_lens[2]));
+  rdict_kv_close(kv);
+
+  rdict_list* list = nullptr;
+  ASSERT_EQ(RDICT_INVALID_ARGUMENT, rdict_list_open(opts.path.c_str(), RDICT_LOAD_MMAP, &list));
+  ASSERT_NE(std::string(rdict_last_error()), "");
+}
+
+TEST(RdictC, kv_int) {
+  rdict::ReadonlyKV<uint32_t, std::string_view>::Options opts;
+  opts.path = "./test_c_int_kv";
+  opts.truncate = true;
+  opts.bucket_count = 1300;
+  {
+    auto dict = std::move(rdict::ReadonlyKV<uint32_t, std::string_view>::New(opts).value());
+    for (uint32_t i = 0; i < 1000; i++) {
+      ASSERT_TRUE(dict->Put(i, "val" + std::to_string(i)).ok());
+    }
+    ASSERT_TRUE(dict->Commit().ok());
+  }
+
+  rdict_kv* kv = nullptr;
+  ASSERT_EQ(RDICT_OK, rdict_kv_open(opts.path.c_str(), RDICT_KEY_UINT32, RDICT_LOAD_ANONYMOUS, &kv));
+  const void* val = nullptr;
+  size_t val_len = 0;
+  ASSERT_EQ(RDICT_OK, rdict_kv_get_int(kv, 10, &val, &val_len));
+  ASSERT_EQ("val10", std::string_view(reinterpret_cast<const char*>(val), val_len));
+  ASSERT_EQ(RDICT_OUT_OF_RANGE, rdict_kv_get_int(kv, -1, &val, &val_len));
+  ASSERT_EQ(RDICT_NOT_FOUND, rdict_kv_get_int(kv, 1000, &val, &val_len));
+
+  std::vector<int64_t> keys = {5, -1, 1000, 999};
+  std::vector<const void*> vals(keys.size());
+  std::vector<size_t> val_lens(keys.size());
+  ASSERT_EQ(2, rdict_kv_multi_get_int(kv, keys.data(), keys.size(), vals.data(), val_lens.data()));
+  ASSERT_EQ("val5", std::string_view(reinterpret_cast<const char*>(vals[0]), val_lens[0]));
+  ASSERT_EQ(nullptr, vals[1]);
+  ASSERT_EQ(nullptr, vals[2]);
+  ASSERT_EQ("val999", std::string_view(reinterpret_cast<const char*>(vals[3]), val_lens[3]));
+  rdict_kv_close(kv);
+}
+
+TEST(RdictC, list) {
+  rdict::ReadonlyList::Options opts;
+  opts.path = "./test_c_list";
+  opts.truncate = true;
+  {
+    auto dict = std::move(rdict::ReadonlyList::New(opts).value());
+    for (int i = 0; i < 100; i++) {
+      ASSERT_TRUE(dict->Add("val" + std::to_string(i)).ok());
+    }
+    ASSERT_TRUE(dict->Commit().ok());
+  }
+  rdict_list* list = nullptr;
+  ASSERT_EQ(RDICT_OK, rdict_list_open(opts.path.c_str(), RDICT_LOAD_MMAP, &list));
+  ASSERT_EQ(100, rdict_list_size(list));
+  const void* val = nullptr;
+  size_t val_len = 0;
+  ASSERT_EQ(RDICT_OK, rdict_list_get(list, 42, &val, &val_len));
+  ASSERT_EQ("val42", std::string_view(reinterpret_cast<const char*>(val), val_len));
+  ASSERT_EQ(RDICT_OUT_OF_RANGE, rdict_list_get(list, 100, &val, &val_len));
+  rdict_list_close(list);
+
+  rdict_kv* kv = nullptr;
+  ASSERT_EQ(RDICT_INVALID_ARGUMENT, rdict_kv_open(opts.path.c_str(), RDICT_KEY_STRING, RDICT_LOAD_MMAP, &kv));
+  ASSERT_EQ(RDICT_NOT_FOUND, rdict_kv_open("./test_c_nonexist", RDICT_KEY_STRING, RDICT_LOAD_MMAP, &kv));
+  // unknown load modes are rejected before any cast
+  ASSERT_EQ(RDICT_INVALID_ARGUMENT, rdict_list_open(opts.path.c_str(), static_cast<rdict_load_mode>(7), &list));
+  ASSERT_EQ(RDICT_INVALID_ARGUMENT,
+            rdict_kv_open(opts.path.c_str(), RDICT_KEY_STRING, static_cast<rdict_load_mode>(-1), &kv));
+}
@@ -0,0 +1,119 @@
+/*
+** BSD 3-Clause License
+**
+** Copyright (c) 2023, qiyingwang <qiyingwang@tencent.com>, the respective contributors, as shown by the AUTHORS file.
+** All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions are met:
+** * Redistributions of source code must retain the above copyright notice, this
+** list of conditions and the following disclaimer.
+**
+** * Redistributions in binary form must reproduce the above copyright notice,
+** this list of conditions and the following disclaimer in the documentation
+** and/or other materials provided with the distribution.
+**
+** * Neither the name of the copyright holder nor the names of its
+** contributors may be used to endorse or promote products derived from
+** this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+** AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+** IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+** DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+** FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+** DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+** SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+** CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+** OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#include <gtest/gtest.h>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "rdict/coro.h"
+#include "rdict/kv.h"
+
+template <typename Dict>
+static void check_async_get(const Dict& dict, const std::vector<typename Dict::key_type>& keys,
+                            const std::vector<bool>& exists) {
+  rdict::Interleaver scheduler;
+  std::vector<rdict::Task<absl::StatusOr<typename Dict::value_type>>> tasks;
+  for (const auto& key : keys) {
+    tasks.emplace_back(dict.AsyncGet(key));
+    scheduler.Spawn(tasks.back());
+  }
+  scheduler.Run();
+  for (size_t i = 0; i < keys.size(); i++) {
+    ASSERT_TRUE(tasks[i].Done());
+    ASSERT_EQ(tasks[i].Result().ok(), exists[i]);
+    if (exists[i]) {
+      ASSERT_EQ(tasks[i].Result().value(), dict.Get(keys[i]).value());
+    }
+  }
+}
+
+class RdictCoro : public ::testing::TestWithParam<rdict::detail::IndexType> {};
+
+TEST_P(RdictCoro, async_get) {
+  using Dict = rdict::ReadonlyKV<std::string_view, std::string_view>;
+  Dict::Options opts;
+  opts.path = "./test_coro_rdict";
+  opts.truncate = true;
+  opts.index_type = GetParam();
+  {
+    auto dict = std::move(Dict::New(opts).value());
+    for (uint64_t i = 0; i < 10000; i++) {
+      ASSERT_TRUE(dict->Put("key" + std::to_string(i), "hello,world" + std::to_string(i)).ok());
+    }
+    ASSERT_TRUE(dict->Commit().ok());
+  }
+  opts.readonly = true;
+  opts.truncate = false;
+  auto dict = std::move(Dict::New(opts).value());
+  std::vector<std::string> key_strs;
+  std::vector<bool> exists;
+  for (uint64_t i = 0; i < 20000; i += 3) {
+    key_strs.emplace_back("key" + std::to_string(i));
+    exists.emplace_back(i < 10000);
+  }
+  std::vector<std::string_view> keys(key_strs.begin(), key_strs.end());
+  check_async_get(*dict, keys, exists);
+
+  // a handler coroutine awaiting several lookups, and the same without a scheduler
+  auto handler = [&]() -> rdict::Task<std::string> {
+    auto a = co_await dict->AsyncGet("key1");
+    auto b = co_await dict->AsyncGet("nokey");
+    co_return std::string(a.value()) + (b.ok() ? "" : ",missing");
+  };
+  rdict::Interleaver scheduler;
+  auto task = handler();
+  auto task1 = handler();
+  scheduler.Spawn(task);
+  scheduler.Spawn(task1);
+  scheduler.Run();
+  ASSERT_EQ(task.Result(), "hello,world1,missing");
+  ASSERT_EQ(task1.Result(), "hello,world1,missing");
+}
+
+INSTANTIATE_TEST_SUITE_P(IndexTypes, RdictCoro,
+                         ::testing::Values(rdict::detail::INDEX_ROBIN_HOOD, rdict::detail::INDEX_CUCKOO));
+
+TEST(RdictCoroFlat, async_get) {
+  using Dict = rdict::ReadonlyKV<uint64_t, uint64_t>;
+  Dict::Options opts;
+  opts.path = "./test_coro_flat_rdict";
+  opts.truncate = true;
+  auto dict = std::move(Dict::New(opts).value());
+  for (uint64_t i = 0; i < 10000; i++) {
+    ASSERT_TRUE(dict->Put(i, i + 100).ok());
+  }
+  std::vector<uint64_t> keys;
+  std::vector<bool> exists;
+  for (uint64_t i = 0; i < 20000; i += 7) {
+    keys.emplace_back(i);
+    exists.emplace_back(i < 10000);
+  }
+  check_async_get(*dict, keys, exists);
+}
@@ -0,0 +1,136 @@
+/*
+** BSD 3-Clause License
+**
+** Copyright (c) 2023, qiyingwang <qiyingwang@tencent.com>, the respective contributors, as shown by the AUTHORS file.
+** All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions are met:
+** * Redistributions of source code must retain the above copyright notice, this
+** list of conditions and the following disclaimer.
+**
+** * Redistributions in binary form must reproduce the above copyright notice,
+** this list of conditions and the following disclaimer in the documentation
+** and/or other materials provided with the distribution.
+**
+** * Neither the name of the copyright holder nor the names of its
+** contributors may be used to endorse or promote products derived from
+** this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+** AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+** IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+** DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+** FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+** DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+** SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+** CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+** OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#include <gtest/gtest.h>
+#include <string>
+#include "rdict/dict_manager.h"
+#include "rdict/kv.h"
+#include "rdict/list.h"
+
+TEST(Rdict, dict_manager) {
+  size_t test_count = 20000;
+  std::string value(1000, 'v');
+  rdict::ReadonlyKV<uint64_t, std::string_view>::Options kv_opts;
+  kv_opts.path = "./test_manager_kv";
+  kv_opts.truncate = true;
+  auto kv = std::move(rdict::ReadonlyKV<uint64_t, std::string_view>::New(kv_opts).value());
+  rdict::ReadonlyList::Options list_opts;
+  list_opts.path = "./test_manager_list";
+  list_opts.truncate = true;
+  auto list = std::move(rdict::ReadonlyList::New(list_opts).value());
+  for (size_t i = 0; i < test_count; i++) {
+    ASSERT_TRUE(kv->Put(i, value).ok());
+    ASSERT_TRUE(list->Add(value).ok());
+  }
+  ASSERT_TRUE(kv->Commit().ok());
+  ASSERT_TRUE(list->Commit().ok());
+
+  rdict::DictManager::Options opts;
+  opts.memory_budget_bytes = 1;
+  opts.lock_index_priority = 10;
+  opts.sample_pages = 256;
+  auto manager = std::move(rdict::DictManager::New(opts).value());
+  kv_opts.truncate = false;
+  auto writable = std::move(rdict::ReadonlyKV<uint64_t, std::string_view>::New(kv_opts).value());
+  ASSERT_FALSE(manager->Register("writable", *writable, 0).ok());
+
+  kv_opts.readonly = true;
+  kv = std::move(rdict::ReadonlyKV<uint64_t, std::string_view>::New(kv_opts).value());
+  list_opts.readonly = true;
+  list = std::move(rdict::ReadonlyList::New(list_opts).value());
+  ASSERT_TRUE(kv->DataRegion().file_backed);
+  ASSERT_TRUE(manager->Register("hot", *kv, 10).ok());
+  ASSERT_TRUE(manager->Register("cold", *list, 0).ok());
+  ASSERT_FALSE(manager->Register("cold", *list, 0).ok());
+  for (size_t i = 0; i < test_count; i++) {
+    ASSERT_EQ(kv->Get(i).value(), value);
+    ASSERT_EQ(list->Get(i).value(), value);
+  }
+
+  auto statuses = manager->GetStatus();
+  ASSERT_EQ(statuses.size(), 2);
+  ASSERT_EQ(statuses[0].name, "hot");
+  ASSERT_TRUE(statuses[0].index_locked);
+  ASSERT_EQ(statuses[0].resident_index_bytes, statuses[0].index_bytes);
+  ASSERT_EQ(statuses[1].name, "cold");
+  ASSERT_FALSE(statuses[1].index_locked);
+  ASSERT_GT(statuses[1].data_bytes, test_count * value.size());
+  ASSERT_GT(statuses[1].resident_data_bytes, 0);
+  ASSERT_LE(statuses[1].resident_data_bytes, statuses[1].data_bytes);
+
+  // the cold data goes first, locked indexes stay
+  ASSERT_TRUE(manager->Enforce().ok());
+  statuses = manager->GetStatus();
+  ASSERT_GT(statuses[1].evicted_bytes, 0);
+  ASSERT_TRUE(statuses[0].index_locked);
+  ASSERT_EQ(statuses[0].resident_index_bytes, statuses[0].index_bytes);
+  for (size_t i = 0; i < test_count; i += 100) {
+    ASSERT_EQ(kv->Get(i).value(), value);
+    ASSERT_EQ(list->Get(i).value(), value);
+  }
+
+  ASSERT_TRUE(manager->Unregister("cold").ok());
+  ASSERT_FALSE(manager->Unregister("cold").ok());
+  ASSERT_EQ(manager->GetStatus().size(), 1);
+  ASSERT_EQ(manager->ResidentBytes(rdict::MemoryRegion{}), 0);
+}
+
+TEST(Rdict, dict_manager_anonymous) {
+  size_t test_count = 20000;
+  std::string value(1000, 'v');
+  rdict::ReadonlyKV<uint64_t, std::string_view>::Options kv_opts;
+  kv_opts.path = "./test_manager_anonymous_kv";
+  kv_opts.truncate = true;
+  {
+    auto kv = std::move(rdict::ReadonlyKV<uint64_t, std::string_view>::New(kv_opts).value());
+    for (size_t i = 0; i < test_count; i++) {
+      ASSERT_TRUE(kv->Put(i, value + std::to_string(i)).ok());
+    }
+    ASSERT_TRUE(kv->Commit().ok());
+  }
+  kv_opts.truncate = false;
+  kv_opts.readonly = true;
+  kv_opts.load_mode = rdict::MmapFile::LOAD_ANONYMOUS;
+  auto kv = std::move(rdict::ReadonlyKV<uint64_t, std::string_view>::New(kv_opts).value());
+  ASSERT_FALSE(kv->IndexRegion().file_backed);
+  ASSERT_FALSE(kv->DataRegion().file_backed);
+
+  rdict::DictManager::Options opts;
+  opts.memory_budget_bytes = 1;
+  auto manager = std::move(rdict::DictManager::New(opts).value());
+  ASSERT_TRUE(manager->Register("anonymous", *kv, 0).ok());
+  // the anonymous copy is over the budget but never advised out, its pages would read back as zeros
+  ASSERT_TRUE(manager->Enforce().ok());
+  ASSERT_EQ(manager->GetStatus()[0].evicted_bytes, 0);
+  for (size_t i = 0; i < test_count; i++) {
+    ASSERT_EQ(kv->Get(i).value(), value + std::to_string(i));
+  }
+  ASSERT_TRUE(manager->Unregister("anonymous").ok());
+}
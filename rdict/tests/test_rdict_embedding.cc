@@ -0,0 +1,168 @@
+/*
+** BSD 3-Clause License
+**
+** Copyright (c) 2023, qiyingwang <qiyingwang@tencent.com>, the respective contributors, as shown by the AUTHORS file.
+** All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions are met:
+** * Redistributions of source code must retain the above copyright notice, this
+** list of conditions and the following disclaimer.
+**
+** * Redistributions in binary form must reproduce the above copyright notice,
+** this list of conditions and the following disclaimer in the documentation
+** and/or other materials provided with the distribution.
+**
+** * Neither the name of the copyright holder nor the names of its
+** contributors may be used to endorse or promote products derived from
+** this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+** AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+** IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+** DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+** FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+** DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+** SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+** CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+** OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <random>
+#include "rdict/embedding_kv.h"
+
+static std::vector<float> random_row(std::mt19937& rng, size_t dim) {
+  std::normal_distribution<float> dist(0, 1);
+  std::vector<float> row(dim);
+  for (auto& v : row) v = dist(rng);
+  return row;
+}
+
+TEST(Rdict, embedding_kernels) {
+  std::mt19937 rng(3);
+  for (size_t dim : {1, 7, 8, 31, 64, 100, 256}) {
+    auto a = random_row(rng, dim), b = random_row(rng, dim);
+    ASSERT_NEAR(rdict::embedding::Dot(a.data(), b.data(), dim), rdict::embedding::PortableDot(a.data(), b.data(), dim),
+                1e-4 * dim);
+    std::vector<int8_t> q(dim);
+    std::vector<float> out(dim), portable(dim);
+    float scale = rdict::embedding::QuantizeInt8(a.data(), dim, q.data());
+    rdict::embedding::DequantizeInt8(q.data(), scale, dim, out.data());
+    rdict::embedding::PortableDequantizeInt8(q.data(), scale, dim, portable.data());
+    ASSERT_EQ(out, portable);
+    for (size_t i = 0; i < dim; i++) {
+      ASSERT_NEAR(out[i], a[i], scale / 2 + 1e-6);
+    }
+  }
+  std::vector<uint16_t> halves(65536);
+  for (size_t i = 0; i < halves.size(); i++) halves[i] = i;
+  std::vector<float> out(halves.size()), portable(halves.size());
+  rdict::embedding::HalfToFloat(halves.data(), halves.size(), out.data());
+  rdict::embedding::PortableHalfToFloat(halves.data(), halves.size(), portable.data());
+  ASSERT_EQ(memcmp(out.data(), portable.data(), out.size() * sizeof(float)), 0);
+  std::vector<uint16_t> back(halves.size());
+  rdict::embedding::FloatToHalf(out.data(), out.size(), back.data());
+  for (size_t i = 0; i < halves.size(); i++) {
+    if (!std::isnan(out[i])) {
+      ASSERT_EQ(back[i], halves[i]);
+    }
+  }
+  float rounding[] = {1.0F + 1.0F / 4096, 65519.0F, 65520.0F, 1e-8F, 3e-5F};
+  uint16_t expected[] = {0x3C00, 0x7BFF, 0x7C00, 0x0000, 0x01F7};
+  uint16_t rounded[5];
+  rdict::embedding::FloatToHalf(rounding, 5, rounded);
+  for (size_t i = 0; i < 5; i++) {
+    ASSERT_EQ(rounded[i], expected[i]) << i;
+  }
+}
+
+TEST(Rdict, embedding_top_k) {
+  std::mt19937 rng(5);
+  size_t dim = 48, n = 1000;
+  auto query = random_row(rng, dim);
+  std::vector<float> rows;
+  for (size_t i = 0; i < n; i++) {
+    auto row = random_row(rng, dim);
+    rows.insert(rows.end(), row.begin(), row.end());
+  }
+  std::vector<float> scores(n);
+  rdict::embedding::Score(query.data(), rows.data(), n, dim, scores.data());
+  std::vector<uint32_t> order(n);
+  for (uint32_t i = 0; i < n; i++) order[i] = i;
+  std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) { return scores[a] > scores[b]; });
+  std::vector<rdict::embedding::ScoredRow> top;
+  rdict::embedding::TopK(query.data(), rows.data(), n, dim, 10, &top);
+  ASSERT_EQ(top.size(), 10);
+  for (size_t i = 0; i < top.size(); i++) {
+    ASSERT_EQ(top[i].row, order[i]);
+    ASSERT_EQ(top[i].score, scores[order[i]]);
+  }
+  rdict::embedding::TopK(query.data(), rows.data(), 3, dim, 10, &top);
+  ASSERT_EQ(top.size(), 3);
+}
+
+TEST(Rdict, embedding_kv) {
+  std::mt19937 rng(9);
+  size_t test_count = 5000;
+  uint32_t dim = 100;
+  std::vector<std::vector<float>> rows;
+  for (size_t i = 0; i < test_count; i++) {
+    rows.emplace_back(random_row(rng, dim));
+  }
+  for (auto quantization : {rdict::EMBEDDING_FP32, rdict::EMBEDDING_FP16, rdict::EMBEDDING_INT8}) {
+    rdict::ReadonlyEmbeddingKV<uint64_t>::Options opts;
+    opts.path = "./test_embedding_rdict";
+    opts.truncate = true;
+    opts.dim = dim;
+    opts.quantization = quantization;
+    auto dict = std::move(rdict::ReadonlyEmbeddingKV<uint64_t>::New(opts).value());
+    ASSERT_EQ(dict->RowBytes() % 64, 0);
+    for (size_t i = 0; i < test_count; i++) {
+      ASSERT_TRUE(dict->Put(i * 7, rows[i]).ok());
+    }
+    ASSERT_FALSE(dict->Put(1, std::vector<float>(dim - 1)).ok());
+    ASSERT_TRUE(dict->Commit().ok());
+    dict.reset();
+
+    auto dict1 = std::move(rdict::ReadonlyEmbeddingKV<uint64_t>::Load(opts.path).value());
+    ASSERT_EQ(dict1->Dim(), dim);
+    ASSERT_EQ(dict1->Quantization(), quantization);
+    float tolerance = quantization == rdict::EMBEDDING_FP32 ? 0 : (quantization == rdict::EMBEDDING_FP16 ? 4e-3 : 3e-2);
+    std::vector<float> out(dim);
+    for (size_t i = 0; i < test_count; i++) {
+      ASSERT_TRUE(dict1->Find(i * 7, out.data()));
+      for (size_t j = 0; j < dim; j++) {
+        ASSERT_NEAR(out[j], rows[i][j], tolerance * std::max(1.0F, std::fabs(rows[i][j])) + 1e-7);
+      }
+    }
+    ASSERT_FALSE(dict1->Find(1, out.data()));
+
+    std::vector<uint64_t> keys;
+    for (size_t i = 0; i < 1000; i++) keys.push_back(i * 5);
+    std::vector<float> matrix(keys.size() * dim, -1);
+    std::unique_ptr<bool[]> found(new bool[keys.size()]);
+    size_t hits = dict1->Gather(keys.data(), keys.size(), matrix.data(), found.get());
+    size_t expected_hits = 0;
+    for (size_t i = 0; i < keys.size(); i++) {
+      bool exists = keys[i] % 7 == 0;
+      expected_hits += exists;
+      ASSERT_EQ(found[i], exists);
+      if (exists) {
+        ASSERT_TRUE(dict1->Find(keys[i], out.data()));
+        ASSERT_TRUE(std::equal(out.begin(), out.end(), matrix.begin() + i * dim));
+      } else {
+        ASSERT_TRUE(
+            std::all_of(matrix.begin() + i * dim, matrix.begin() + (i + 1) * dim, [](float v) { return v == 0; }));
+      }
+    }
+    ASSERT_EQ(hits, expected_hits);
+  }
+  rdict::ReadonlyEmbeddingKV<uint64_t>::Options opts;
+  opts.path = "./test_embedding_rdict";
+  opts.dim = dim + 1;
+  ASSERT_FALSE(rdict::ReadonlyEmbeddingKV<uint64_t>::Load(opts).ok());
+}
@@ -0,0 +1,101 @@
+/*
+** BSD 3-Clause License
+**
+** Copyright (c) 2023, qiyingwang <qiyingwang@tencent.com>, the respective contributors, as shown by the AUTHORS file.
+** All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions are met:
+** * Redistributions of source code must retain the above copyright notice, this
+** list of conditions and the following disclaimer.
+**
+** * Redistributions in binary form must reproduce the above copyright notice,
+** this list of conditions and the following disclaimer in the documentation
+** and/or other materials provided with the distribution.
+**
+** * Neither the name of the copyright holder nor the names of its
+** contributors may be used to endorse or promote products derived from
+** this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+** AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+** IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+** DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+** FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+** DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+** SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+** CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+** OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <string>
+#include "rdict/hash_key_kv.h"
+
+TEST(Rdict, hash_key_kv) {
+  size_t test_count = 100000;
+  rdict::HashKeyKV<std::string_view>::Options opts;
+  opts.path = "./test_hash_key_rdict";
+  opts.truncate = true;
+  auto dict = std::move(rdict::HashKeyKV<std::string_view>::New(opts).value());
+  rdict::ReadonlyKV<std::string_view, std::string_view>::Options plain_opts;
+  plain_opts.path = "./test_plain_key_rdict";
+  plain_opts.truncate = true;
+  auto plain = std::move(rdict::ReadonlyKV<std::string_view, std::string_view>::New(plain_opts).value());
+  for (size_t i = 0; i < test_count; i++) {
+    std::string key = "hash_key_test_key_" + std::to_string(i);
+    std::string val = "val_" + std::to_string(i);
+    ASSERT_TRUE(dict->Put(key, val).ok());
+    ASSERT_TRUE(plain->Put(key, val).ok());
+  }
+  // puts of a same key are not collisions
+  ASSERT_TRUE(dict->Put("hash_key_test_key_0", "val_new").ok());
+  ASSERT_TRUE(dict->Commit().ok());
+  ASSERT_EQ(dict->Collisions(), 0);
+  ASSERT_TRUE(plain->Commit().ok());
+  dict.reset();
+  plain.reset();
+  ASSERT_LT(std::filesystem::file_size(opts.path), std::filesystem::file_size(plain_opts.path));
+
+  auto dict1 = std::move(rdict::HashKeyKV<std::string_view>::Load(opts.path).value());
+  ASSERT_EQ(dict1->Get("hash_key_test_key_0").value(), "val_new");
+  for (size_t i = 1; i < test_count; i++) {
+    std::string key = "hash_key_test_key_" + std::to_string(i);
+    std::string_view val;
+    ASSERT_TRUE(dict1->Find(key, &val));
+    ASSERT_EQ(val, "val_" + std::to_string(i));
+  }
+  ASSERT_FALSE(dict1->Exists("hash_key_test_key_" + std::to_string(test_count)));
+  ASSERT_FALSE(dict1->Get("none").ok());
+  // also a plain dict of uint64 keys
+  rdict::ReadonlyKV<uint64_t, std::string_view>::Options hash_opts;
+  hash_opts.path = opts.path;
+  hash_opts.readonly = true;
+  auto by_hash = std::move(rdict::ReadonlyKV<uint64_t, std::string_view>::New(hash_opts).value());
+  ASSERT_EQ(by_hash->Get(rdict::HashKeyKV<std::string_view>::HashKey("hash_key_test_key_7")).value(), "val_7");
+  // the key hash sizes are checked at load
+  ASSERT_FALSE((rdict::HashKeyKV<std::string_view, rdict::Hash128>::Load(opts.path).ok()));
+  ASSERT_FALSE(rdict::HashKeyKV<std::string_view>::Load(plain_opts.path).ok());
+}
+
+TEST(Rdict, hash_key_kv_128) {
+  size_t test_count = 50000;
+  using Dict = rdict::HashKeyKV<uint64_t, rdict::Hash128>;
+  Dict::Options opts;
+  opts.path = "./test_hash_key_rdict";
+  opts.truncate = true;
+  auto dict = std::move(Dict::New(opts).value());
+  for (size_t i = 0; i < test_count; i++) {
+    ASSERT_TRUE(dict->Put("key_" + std::to_string(i), i * 3).ok());
+  }
+  ASSERT_TRUE(dict->Commit().ok());
+  dict.reset();
+
+  auto dict1 = std::move(Dict::Load(opts.path).value());
+  for (size_t i = 0; i < test_count; i++) {
+    ASSERT_EQ(dict1->Get("key_" + std::to_string(i)).value(), i * 3);
+  }
+  ASSERT_FALSE(dict1->Exists("key_" + std::to_string(test_count)));
+  ASSERT_FALSE(rdict::HashKeyKV<uint64_t>::Load(opts.path).ok());
+}
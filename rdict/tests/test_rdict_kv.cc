@@ -28,9 +28,16 @@
 ** OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
 ** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 */
+#include <unistd.h>
 #include <gtest/gtest.h>
+#include <array>
+#include <cmath>
 #include <string>
 #include <string_view>
+#include <utility>
+#include <vector>
+#include "absl/strings/cord.h"
+#include "rdict/hyperloglog.h"
 #include "rdict/kv.h"
 
 // TEST(Rdict, simple_ints) {
@@ -119,4 +126,756 @@ TEST(Rdict, simple_strs) {
   //   val = other_dict->Get(i + 1000000);
   //   ASSERT_EQ(val.value(), data);
   // }
-}
\ No newline at end of file
+}
+TEST(Rdict, anonymous_load) {
+  uint64_t test_count = 100000;
+  rdict::ReadonlyKV<uint64_t, std::string_view>::Options opts;
+  opts.readonly = false;
+  opts.path = "./test_anonymous_rdict";
+  opts.truncate = true;
+  auto result = rdict::ReadonlyKV<uint64_t, std::string_view>::New(opts);
+  auto dict = std::move(result.value());
+  for (uint64_t i = 1; i < test_count; i++) {
+    std::string data = "hello,world" + std::to_string(i);
+    ASSERT_TRUE(dict->Put(i, data).ok());
+  }
+  ASSERT_TRUE(dict->Commit().ok());
+  dict.reset();
+
+  opts.readonly = true;
+  opts.truncate = false;
+  opts.load_mode = rdict::MmapFile::LOAD_ANONYMOUS;
+  opts.load_threads = 3;
+  auto result1 = rdict::ReadonlyKV<uint64_t, std::string_view>::New(opts);
+  ASSERT_TRUE(result1.ok());
+  auto dict1 = std::move(result1.value());
+  ASSERT_EQ(dict1->Size(), test_count - 1);
+  for (uint64_t i = 1; i < test_count; i++) {
+    std::string data = "hello,world" + std::to_string(i);
+    auto val = dict1->Get(i);
+    ASSERT_EQ(val.value(), data);
+  }
+}
+
+TEST(Rdict, numa_replicate) {
+  uint64_t test_count = 100000;
+  rdict::ReadonlyKV<std::string_view, std::string_view>::Options opts;
+  opts.readonly = false;
+  opts.path = "./test_numa_rdict";
+  opts.truncate = true;
+  auto result = rdict::ReadonlyKV<std::string_view, std::string_view>::New(opts);
+  auto dict = std::move(result.value());
+  for (uint64_t i = 1; i < test_count; i++) {
+    std::string key = "key" + std::to_string(i);
+    std::string data = "hello,world" + std::to_string(i);
+    ASSERT_TRUE(dict->Put(key, data).ok());
+  }
+  ASSERT_TRUE(dict->Commit().ok());
+  dict.reset();
+
+  opts.readonly = true;
+  opts.truncate = false;
+  opts.numa_replicate_index = true;
+  opts.numa_replicate_data = true;
+  auto result1 = rdict::ReadonlyKV<std::string_view, std::string_view>::New(opts);
+  ASSERT_TRUE(result1.ok());
+  auto dict1 = std::move(result1.value());
+  for (uint64_t i = 1; i < test_count; i++) {
+    std::string key = "key" + std::to_string(i);
+    std::string data = "hello,world" + std::to_string(i);
+    ASSERT_TRUE(dict1->Exists(key));
+    ASSERT_EQ(dict1->Get(key).value(), data);
+  }
+  ASSERT_FALSE(dict1->Exists("key0"));
+}
+
+TEST(Rdict, reorder_data) {
+  uint64_t test_count = 10000;
+  rdict::ReadonlyKV<std::string_view, std::string_view>::Options opts;
+  opts.readonly = false;
+  opts.path = "./test_reorder_rdict";
+  opts.truncate = true;
+  auto result = rdict::ReadonlyKV<std::string_view, std::string_view>::New(opts);
+  auto dict = std::move(result.value());
+  for (uint64_t i = 0; i < test_count; i++) {
+    ASSERT_TRUE(dict->Put("key" + std::to_string(i), "hello,world" + std::to_string(i)).ok());
+  }
+  // the last key is the hottest one
+  std::vector<std::pair<uint64_t, uint64_t>> layout;
+  auto status = dict->ReorderData(
+      [test_count](const std::string_view& key) -> uint64_t {
+        return key == "key" + std::to_string(test_count - 1) ? 100 : 0;
+      },
+      &layout);
+  ASSERT_TRUE(status.ok());
+  ASSERT_EQ(layout.size(), test_count);
+  ASSERT_EQ(layout[0].first, 100);
+  ASSERT_TRUE(dict->Commit().ok());
+  dict.reset();
+
+  opts.readonly = true;
+  opts.truncate = false;
+  auto result1 = rdict::ReadonlyKV<std::string_view, std::string_view>::New(opts);
+  ASSERT_TRUE(result1.ok());
+  auto dict1 = std::move(result1.value());
+  ASSERT_EQ(dict1->Size(), test_count);
+  for (uint64_t i = 0; i < test_count; i++) {
+    ASSERT_EQ(dict1->Get("key" + std::to_string(i)).value(), "hello,world" + std::to_string(i));
+  }
+}
+
+TEST(Rdict, atomic_publish) {
+  uint64_t test_count = 10000;
+  std::string path = "./test_atomic_rdict";
+  unlink(path.c_str());
+  rdict::ReadonlyKV<std::string_view, std::string_view>::Options opts;
+  opts.readonly = false;
+  opts.path = path;
+  opts.truncate = true;
+  opts.atomic_publish = true;
+  auto result = rdict::ReadonlyKV<std::string_view, std::string_view>::New(opts);
+  ASSERT_TRUE(result.ok());
+  auto dict = std::move(result.value());
+  for (uint64_t i = 0; i < test_count; i++) {
+    ASSERT_TRUE(dict->Put("key" + std::to_string(i), "hello,world" + std::to_string(i)).ok());
+  }
+  ASSERT_TRUE(dict->ReorderData([](const std::string_view& key) -> uint64_t { return key.size(); }).ok());
+  // nothing is visible at the final path before Commit
+  ASSERT_NE(access(path.c_str(), F_OK), 0);
+  ASSERT_TRUE(dict->Commit().ok());
+  dict.reset();
+  ASSERT_EQ(access(path.c_str(), F_OK), 0);
+  ASSERT_NE(access((path + ".tmp").c_str(), F_OK), 0);
+  ASSERT_NE(access((path + ".reorder").c_str(), F_OK), 0);
+
+  // append to the published dict through a copy, discarded without Commit
+  opts.truncate = false;
+  result = rdict::ReadonlyKV<std::string_view, std::string_view>::New(opts);
+  ASSERT_TRUE(result.ok());
+  ASSERT_TRUE(result.value()->Put("extra", "value").ok());
+  result.value().reset();
+  ASSERT_NE(access((path + ".tmp").c_str(), F_OK), 0);
+
+  opts.readonly = true;
+  auto result1 = rdict::ReadonlyKV<std::string_view, std::string_view>::New(opts);
+  ASSERT_TRUE(result1.ok());
+  auto dict1 = std::move(result1.value());
+  ASSERT_EQ(dict1->Size(), test_count);
+  ASSERT_FALSE(dict1->Exists("extra"));
+  for (uint64_t i = 0; i < test_count; i++) {
+    ASSERT_EQ(dict1->Get("key" + std::to_string(i)).value(), "hello,world" + std::to_string(i));
+  }
+}
+
+TEST(Rdict, hashed_and_heterogeneous_keys) {
+  using Dict = rdict::ReadonlyKV<std::string_view, std::string_view>;
+  Dict::Options opts;
+  opts.path = "./test_hashed_key_rdict";
+  opts.truncate = true;
+  auto dict = std::move(Dict::New(opts).value());
+  opts.path = "./test_hashed_key_rdict1";
+  auto dict1 = std::move(Dict::New(opts).value());
+  for (uint64_t i = 0; i < 1000; i++) {
+    ASSERT_TRUE(dict->Put("key" + std::to_string(i), "a" + std::to_string(i)).ok());
+    ASSERT_TRUE(dict1->Put("key" + std::to_string(i), "b" + std::to_string(i)).ok());
+  }
+
+  std::string key = "key10";
+  Dict::hashed_key_type hashed_key(key);
+  ASSERT_EQ(dict->Get(hashed_key).value(), "a10");
+  ASSERT_EQ(dict1->Get(hashed_key).value(), "b10");
+  ASSERT_TRUE(dict1->Exists(hashed_key));
+  std::string_view value;
+  ASSERT_TRUE(dict1->Find(hashed_key, &value));
+  ASSERT_EQ(value, "b10");
+  ASSERT_FALSE(dict->Exists(Dict::hashed_key_type("nokey")));
+
+  ASSERT_EQ(dict->Get("key11").value(), "a11");
+  const char* c_key = "key12";
+  ASSERT_EQ(dict->Get(c_key).value(), "a12");
+  ASSERT_EQ(dict->Get(std::string("key13")).value(), "a13");
+  ASSERT_TRUE(dict->Exists(absl::string_view("key14")));
+  ASSERT_EQ(dict->Get(absl::Cord("key15")).value(), "a15");
+  absl::Cord fragmented;
+  fragmented.Append(absl::MakeCordFromExternal("ke", [] {}));
+  fragmented.Append(absl::MakeCordFromExternal("y16", [] {}));
+  ASSERT_FALSE(fragmented.TryFlat().has_value());
+  ASSERT_TRUE(dict->Find(fragmented, &value));
+  ASSERT_EQ(value, "a16");
+  ASSERT_FALSE(dict->Exists(absl::Cord("nokey")));
+}
+
+TEST(Rdict, cuckoo_index) {
+  using Dict = rdict::ReadonlyKV<std::string_view, std::string_view>;
+  uint64_t test_count = 100000;
+  Dict::Options opts;
+  opts.path = "./test_cuckoo_rdict";
+  opts.truncate = true;
+  opts.index_type = rdict::detail::INDEX_CUCKOO;
+  auto dict = std::move(Dict::New(opts).value());
+  for (uint64_t i = 0; i < test_count; i++) {
+    ASSERT_TRUE(dict->Put("key" + std::to_string(i), "hello,world" + std::to_string(i)).ok());
+  }
+  ASSERT_TRUE(dict->Put("key0", "updated").ok());
+  ASSERT_TRUE(dict->Commit().ok());
+  dict.reset();
+
+  opts.readonly = true;
+  opts.truncate = false;
+  opts.numa_replicate_index = true;
+  opts.access_profile_sample_rate = 1;
+  auto dict1 = std::move(Dict::New(opts).value());
+  ASSERT_EQ(dict1->Size(), test_count);
+  ASSERT_EQ(dict1->Get("key0").value(), "updated");
+  for (uint64_t i = 1; i < test_count; i++) {
+    ASSERT_EQ(dict1->Get("key" + std::to_string(i)).value(), "hello,world" + std::to_string(i));
+  }
+  for (uint64_t i = test_count; i < 2 * test_count; i++) {
+    ASSERT_FALSE(dict1->Exists("key" + std::to_string(i)));
+  }
+  dict1.reset();
+
+  // reopened writable with the robin hood index rebuilt, committed back as robin hood
+  opts.readonly = false;
+  opts.numa_replicate_index = false;
+  opts.access_profile_sample_rate = 0;
+  opts.index_type = rdict::detail::INDEX_ROBIN_HOOD;
+  auto dict2 = std::move(Dict::New(opts).value());
+  ASSERT_EQ(dict2->Size(), test_count);
+  ASSERT_TRUE(dict2->Put("extra", "value").ok());
+  ASSERT_EQ(dict2->Get("key10").value(), "hello,world10");
+  ASSERT_TRUE(dict2->Commit().ok());
+  dict2.reset();
+
+  opts.readonly = true;
+  auto dict3 = std::move(Dict::New(opts).value());
+  ASSERT_EQ(dict3->Size(), test_count + 1);
+  ASSERT_EQ(dict3->Get("extra").value(), "value");
+  ASSERT_EQ(dict3->Get("key0").value(), "updated");
+  ASSERT_EQ(dict3->Get("key99999").value(), "hello,world99999");
+
+  using FlatDict = rdict::ReadonlyKV<uint64_t, uint64_t>;
+  FlatDict::Options flat_opts;
+  flat_opts.path = "./test_cuckoo_flat_rdict";
+  flat_opts.truncate = true;
+  flat_opts.index_type = rdict::detail::INDEX_CUCKOO;
+  ASSERT_FALSE(FlatDict::New(flat_opts).ok());
+}
+
+TEST(Rdict, front_index) {
+  using Dict = rdict::ReadonlyKV<std::string_view, std::string_view>;
+  uint64_t test_count = 100000;
+  uint64_t hot_count = 1000;
+  auto hotness = [&](std::string_view key) -> uint64_t {
+    uint64_t i = std::stoull(std::string(key.substr(3)));
+    return i < hot_count ? hot_count - i : 0;
+  };
+  for (auto index_type : {rdict::detail::INDEX_ROBIN_HOOD, rdict::detail::INDEX_CUCKOO}) {
+    Dict::Options opts;
+    opts.path = "./test_front_rdict";
+    opts.truncate = true;
+    opts.index_type = index_type;
+    auto dict = std::move(Dict::New(opts).value());
+    for (uint64_t i = 0; i < test_count; i++) {
+      ASSERT_TRUE(dict->Put("key" + std::to_string(i), "hello,world" + std::to_string(i)).ok());
+    }
+    ASSERT_TRUE(dict->ReorderData(hotness).ok());
+    ASSERT_TRUE(dict->SetFrontIndex(hotness, hot_count / 2).ok());
+    ASSERT_TRUE(dict->Commit().ok());
+    dict.reset();
+
+    opts.readonly = true;
+    opts.truncate = false;
+    auto dict1 = std::move(Dict::New(opts).value());
+    ASSERT_EQ(dict1->Size(), test_count);
+    for (uint64_t i = 0; i < test_count; i++) {
+      ASSERT_EQ(dict1->Get("key" + std::to_string(i)).value(), "hello,world" + std::to_string(i));
+    }
+    for (uint64_t i = test_count; i < 2 * test_count; i++) {
+      ASSERT_FALSE(dict1->Exists("key" + std::to_string(i)));
+    }
+    dict1.reset();
+
+    // interleaved lookups probe the front index and sample the access profile like Get
+    opts.access_profile_sample_rate = 1;
+    size_t hot_pages[2] = {0, 0};
+    for (int step = 0; step < 2; step++) {
+      auto dict4 = std::move(Dict::New(opts).value());
+      for (uint64_t i = 0; i < 2 * hot_count; i += 7) {
+        std::string key = "key" + std::to_string(i);
+        if (step) {
+          Dict::Lookup lookup{Dict::hashed_key_type(key)};
+          dict4->StartLookup(&lookup);
+          while (!dict4->StepLookup(&lookup)) {
+          }
+          ASSERT_TRUE(lookup.found);
+          ASSERT_EQ(lookup.value, "hello,world" + std::to_string(i));
+        } else {
+          ASSERT_EQ(dict4->Get(key).value(), "hello,world" + std::to_string(i));
+        }
+      }
+      ASSERT_TRUE(dict4->SaveAccessProfile("./test_front_rdict.profile").ok());
+      hot_pages[step] = rdict::AccessProfile::Load("./test_front_rdict.profile").value()->HotPages();
+    }
+    ASSERT_GT(hot_pages[0], 0u);
+    ASSERT_EQ(hot_pages[0], hot_pages[1]);
+    opts.access_profile_sample_rate = 0;
+
+    // dropped by a writable reopen without SetFrontIndex
+    opts.readonly = false;
+    auto dict2 = std::move(Dict::New(opts).value());
+    ASSERT_TRUE(dict2->Put("extra", "value").ok());
+    ASSERT_TRUE(dict2->Commit().ok());
+    dict2.reset();
+    opts.readonly = true;
+    auto dict3 = std::move(Dict::New(opts).value());
+    ASSERT_EQ(dict3->Size(), test_count + 1);
+    ASSERT_EQ(dict3->Get("key1").value(), "hello,world1");
+    ASSERT_EQ(dict3->Get("extra").value(), "value");
+  }
+
+  using FlatDict = rdict::ReadonlyKV<uint64_t, uint64_t>;
+  FlatDict::Options flat_opts;
+  flat_opts.path = "./test_front_flat_rdict";
+  flat_opts.truncate = true;
+  auto flat_dict = std::move(FlatDict::New(flat_opts).value());
+  ASSERT_FALSE(flat_dict->SetFrontIndex([](uint64_t) -> uint64_t { return 1; }, 10).ok());
+}
+
+template <typename Dict>
+static absl::StatusOr<std::unique_ptr<Dict>> open_readonly(const std::string& path) {
+  typename Dict::Options opts;
+  opts.path = path;
+  opts.readonly = true;
+  return Dict::New(opts);
+}
+
+TEST(Rdict, hash_functions) {
+  // the dispatched implementations must return the portable values whatever the cpu
+  std::string bytes;
+  for (size_t len = 0; len <= 2100; len++) {
+    std::string_view key(bytes.data(), len);
+    ASSERT_EQ(rdict::crc32c::Hash(key.data(), key.size()), rdict::crc32c::PortableHash(key.data(), key.size()));
+    ASSERT_EQ(rdict::stripe::Hash(key.data(), key.size()), rdict::stripe::PortableHash(key.data(), key.size()));
+    uint64_t x = len * 0x9E3779B97F4A7C15ULL;
+    ASSERT_EQ(rdict::crc32c::Hash(x), rdict::crc32c::PortableHash(x));
+    bytes.push_back(static_cast<char>(len * 131 + 7));
+  }
+  ASSERT_NE(rdict::crc32c::Hash("ab", 2), rdict::crc32c::Hash("ab\0", 3));
+  ASSERT_NE(rdict::stripe::Hash(bytes.data(), 100), rdict::stripe::Hash(bytes.data() + 1, 100));
+
+  using CrcDict = rdict::ReadonlyKV<std::string_view, std::string_view, rdict::crc32c_hash<std::string_view>>;
+  using StripeDict = rdict::ReadonlyKV<std::string_view, std::string_view, rdict::stripe_hash<std::string_view>>;
+  using Dict = rdict::ReadonlyKV<std::string_view, std::string_view>;
+  uint64_t test_count = 10000;
+  std::string prefix(100, 'k');
+  CrcDict::Options opts;
+  opts.path = "./test_hash_rdict";
+  opts.truncate = true;
+  {
+    auto dict = std::move(CrcDict::New(opts).value());
+    for (uint64_t i = 0; i < test_count; i++) {
+      ASSERT_TRUE(dict->Put("key" + std::to_string(i), "hello,world" + std::to_string(i)).ok());
+    }
+    ASSERT_TRUE(dict->Commit().ok());
+  }
+  opts.readonly = true;
+  opts.truncate = false;
+  {
+    auto dict = std::move(CrcDict::New(opts).value());
+    for (uint64_t i = 0; i < test_count; i++) {
+      ASSERT_EQ(dict->Get("key" + std::to_string(i)).value(), "hello,world" + std::to_string(i));
+    }
+    ASSERT_FALSE(dict->Exists("key" + std::to_string(test_count)));
+  }
+  // the hash recorded in the header must match
+  ASSERT_FALSE(open_readonly<Dict>(opts.path).ok());
+  ASSERT_FALSE(open_readonly<StripeDict>(opts.path).ok());
+
+  StripeDict::Options stripe_opts;
+  stripe_opts.path = "./test_hash_stripe_rdict";
+  stripe_opts.truncate = true;
+  stripe_opts.index_type = rdict::detail::INDEX_CUCKOO;
+  {
+    auto dict = std::move(StripeDict::New(stripe_opts).value());
+    for (uint64_t i = 0; i < test_count; i++) {
+      ASSERT_TRUE(dict->Put(prefix + std::to_string(i), std::to_string(i)).ok());
+    }
+    ASSERT_TRUE(dict->Commit().ok());
+  }
+  {
+    auto dict = std::move(open_readonly<StripeDict>(stripe_opts.path).value());
+    for (uint64_t i = 0; i < test_count; i++) {
+      ASSERT_EQ(dict->Get(prefix + std::to_string(i)).value(), std::to_string(i));
+    }
+  }
+  ASSERT_FALSE(open_readonly<CrcDict>(stripe_opts.path).ok());
+
+  using CrcIntDict = rdict::ReadonlyKV<uint64_t, uint64_t, rdict::crc32c_hash<uint64_t>>;
+  CrcIntDict::Options int_opts;
+  int_opts.path = "./test_hash_int_rdict";
+  int_opts.truncate = true;
+  {
+    auto dict = std::move(CrcIntDict::New(int_opts).value());
+    for (uint64_t i = 0; i < test_count; i++) {
+      ASSERT_TRUE(dict->Put(i * 1000, i).ok());
+    }
+    ASSERT_TRUE(dict->Commit().ok());
+  }
+  auto int_dict = std::move(open_readonly<CrcIntDict>(int_opts.path).value());
+  for (uint64_t i = 0; i < test_count; i++) {
+    ASSERT_EQ(int_dict->Get(i * 1000).value(), i);
+  }
+  ASSERT_FALSE(int_dict->Exists(1));
+}
+
+TEST(Rdict, inline_index) {
+  using Dict = rdict::ReadonlyKV<std::string_view, std::string_view>;
+  uint64_t test_count = 100000;
+  auto value_of = [](uint64_t i) {
+    // every 10th value is too large to be inlined
+    return i % 10 == 0 ? std::string(32, 'v') + std::to_string(i) : std::to_string(i);
+  };
+  Dict::Options opts;
+  opts.path = "./test_inline_rdict";
+  opts.truncate = true;
+  opts.index_type = rdict::detail::INDEX_INLINE;
+  {
+    auto dict = std::move(Dict::New(opts).value());
+    for (uint64_t i = 0; i < test_count; i++) {
+      ASSERT_TRUE(dict->Put("key" + std::to_string(i), value_of(i)).ok());
+    }
+    ASSERT_TRUE(dict->Put("", "empty").ok());
+    ASSERT_TRUE(dict->Commit().ok());
+  }
+  opts.readonly = true;
+  opts.truncate = false;
+  opts.numa_replicate_index = true;
+  opts.access_profile_sample_rate = 1;
+  {
+    auto dict = std::move(Dict::New(opts).value());
+    ASSERT_EQ(dict->Size(), test_count + 1);
+    for (uint64_t i = 0; i < test_count; i++) {
+      ASSERT_EQ(dict->Get("key" + std::to_string(i)).value(), value_of(i));
+    }
+    ASSERT_EQ(dict->Get("").value(), "empty");
+    for (uint64_t i = test_count; i < 2 * test_count; i++) {
+      ASSERT_FALSE(dict->Exists("key" + std::to_string(i)));
+    }
+    Dict::Lookup lookup(Dict::hashed_key_type("key7"));
+    dict->StartLookup(&lookup);
+    while (!dict->StepLookup(&lookup)) {
+    }
+    ASSERT_TRUE(lookup.found);
+    ASSERT_EQ(lookup.value, "7");
+  }
+
+  // reopened writable with the robin hood index narrowed back
+  opts.readonly = false;
+  opts.numa_replicate_index = false;
+  opts.access_profile_sample_rate = 0;
+  opts.index_type = rdict::detail::INDEX_ROBIN_HOOD;
+  {
+    auto dict = std::move(Dict::New(opts).value());
+    ASSERT_EQ(dict->Size(), test_count + 1);
+    ASSERT_TRUE(dict->Put("key1", "updated").ok());
+    ASSERT_TRUE(dict->Commit().ok());
+  }
+  opts.readonly = true;
+  auto dict = std::move(Dict::New(opts).value());
+  ASSERT_EQ(dict->Size(), test_count + 1);
+  ASSERT_EQ(dict->Get("key1").value(), "updated");
+  ASSERT_EQ(dict->Get("key10").value(), value_of(10));
+
+  using IntDict = rdict::ReadonlyKV<uint64_t, std::string_view>;
+  IntDict::Options int_opts;
+  int_opts.path = "./test_inline_int_rdict";
+  int_opts.truncate = true;
+  int_opts.index_type = rdict::detail::INDEX_INLINE;
+  {
+    auto int_dict = std::move(IntDict::New(int_opts).value());
+    for (uint64_t i = 0; i < test_count; i++) {
+      ASSERT_TRUE(int_dict->Put(i, value_of(i)).ok());
+    }
+    ASSERT_TRUE(int_dict->Commit().ok());
+  }
+  int_opts.readonly = true;
+  int_opts.truncate = false;
+  auto int_dict = std::move(IntDict::New(int_opts).value());
+  for (uint64_t i = 0; i < test_count; i++) {
+    ASSERT_EQ(int_dict->Get(i).value(), value_of(i));
+  }
+  ASSERT_FALSE(int_dict->Exists(test_count));
+
+  using FlatDict = rdict::ReadonlyKV<uint64_t, uint64_t>;
+  FlatDict::Options flat_opts;
+  flat_opts.path = "./test_inline_flat_rdict";
+  flat_opts.truncate = true;
+  flat_opts.index_type = rdict::detail::INDEX_INLINE;
+  ASSERT_FALSE(FlatDict::New(flat_opts).ok());
+}
+
+struct TestFeature {
+  uint32_t id;
+  float weights[4];
+  uint64_t ts;
+};
+
+TEST(Rdict, flat_pod_values) {
+  using Dict = rdict::ReadonlyKV<uint64_t, TestFeature>;
+  using ArrayDict = rdict::ReadonlyKV<uint32_t, std::array<float, 8>>;
+  static_assert(rdict::detail::is_flat_kv_v<uint64_t, TestFeature>);
+  static_assert(rdict::detail::is_flat_kv_v<uint32_t, std::array<float, 8>>);
+  static_assert(!rdict::detail::is_flat_kv_v<uint64_t, std::array<float, 16>>);
+  uint64_t test_count = 100000;
+  Dict::Options opts;
+  opts.path = "./test_flat_pod_rdict";
+  opts.truncate = true;
+  ArrayDict::Options array_opts;
+  array_opts.path = "./test_flat_array_rdict";
+  array_opts.truncate = true;
+  {
+    auto dict = std::move(Dict::New(opts).value());
+    auto array_dict = std::move(ArrayDict::New(array_opts).value());
+    for (uint64_t i = 0; i < test_count; i++) {
+      TestFeature feature{static_cast<uint32_t>(i), {1.0F * i, 2.0F * i, 3.0F * i, 4.0F * i}, i * 7};
+      ASSERT_TRUE(dict->Put(i, feature).ok());
+      std::array<float, 8> weights;
+      weights.fill(0.5F * i);
+      ASSERT_TRUE(array_dict->Put(static_cast<uint32_t>(i), weights).ok());
+    }
+    ASSERT_TRUE(dict->Commit().ok());
+    ASSERT_TRUE(array_dict->Commit().ok());
+  }
+  opts.readonly = true;
+  opts.truncate = false;
+  array_opts.readonly = true;
+  array_opts.truncate = false;
+  auto dict = std::move(Dict::New(opts).value());
+  auto array_dict = std::move(ArrayDict::New(array_opts).value());
+  ASSERT_EQ(dict->Size(), test_count);
+  for (uint64_t i = 0; i < test_count; i++) {
+    auto feature = dict->Get(i).value();
+    ASSERT_EQ(feature.id, i);
+    ASSERT_EQ(feature.weights[3], 4.0F * i);
+    ASSERT_EQ(feature.ts, i * 7);
+    ASSERT_EQ(array_dict->Get(static_cast<uint32_t>(i)).value()[7], 0.5F * i);
+  }
+  ASSERT_FALSE(dict->Exists(test_count));
+
+  // same key type with a value of another size fails on load
+  rdict::ReadonlyKV<uint64_t, std::array<float, 4>>::Options other_opts;
+  other_opts.path = opts.path;
+  other_opts.readonly = true;
+  ASSERT_FALSE((rdict::ReadonlyKV<uint64_t, std::array<float, 4>>::New(other_opts).ok()));
+  rdict::ReadonlyKV<uint64_t, std::string_view>::Options non_flat_opts;
+  non_flat_opts.path = opts.path;
+  non_flat_opts.readonly = true;
+  ASSERT_FALSE((rdict::ReadonlyKV<uint64_t, std::string_view>::New(non_flat_opts).ok()));
+
+  // builtin primitive flat dicts
+  rdict::ReadonlyKV<uint64_t, uint32_t>::Options u64_opts;
+  u64_opts.path = "./test_flat_u64_rdict";
+  u64_opts.truncate = true;
+  {
+    auto u64_dict = std::move(rdict::ReadonlyKV<uint64_t, uint32_t>::New(u64_opts).value());
+    for (uint64_t i = 0; i < test_count; i++) {
+      ASSERT_TRUE(u64_dict->Put(i, static_cast<uint32_t>(i + 1)).ok());
+    }
+    ASSERT_TRUE(u64_dict->Commit().ok());
+  }
+  u64_opts.readonly = true;
+  u64_opts.truncate = false;
+  auto u64_dict = std::move(rdict::ReadonlyKV<uint64_t, uint32_t>::New(u64_opts).value());
+  for (uint64_t i = 0; i < test_count; i++) {
+    ASSERT_EQ(u64_dict->Get(i).value(), i + 1);
+  }
+}
+
+// an int64_t stored as data section records, as int64_t pairs were before the flat layout
+struct LegacyInt64 {
+  int64_t v = 0;
+  LegacyInt64() = default;
+  LegacyInt64(int64_t x) : v(x) {}
+  LegacyInt64(const LegacyInt64& other) : v(other.v) {}
+  LegacyInt64& operator=(const LegacyInt64& other) = default;
+  bool operator==(const LegacyInt64& other) const { return v == other.v; }
+};
+struct LegacyInt64Hash {
+  using is_avalanching = void;
+  static constexpr rdict::detail::HashType hash_id = rdict::detail::HASH_WYHASH;
+  uint64_t operator()(const LegacyInt64& k) const noexcept { return rdict::hash<int64_t>{}(k.v); }
+};
+namespace rdict::detail {
+template <>
+struct Serializer<LegacyInt64> : Serializer<int64_t> {
+  static size_t PackSize(const LegacyInt64& v, bool align) { return Serializer<int64_t>::PackSize(v.v, align); }
+  static void PackTo(const LegacyInt64& v, uint8_t* dst, bool align) { Serializer<int64_t>::PackTo(v.v, dst, align); }
+  static size_t Unpack(const uint8_t* data, LegacyInt64& v, bool align) {
+    return Serializer<int64_t>::Unpack(data, v.v, align);
+  }
+};
+}  // namespace rdict::detail
+
+TEST(Rdict, flat_legacy_records) {
+  using LegacyDict = rdict::ReadonlyKV<LegacyInt64, LegacyInt64, LegacyInt64Hash>;
+  using Dict = rdict::ReadonlyKV<int64_t, int64_t>;
+  static_assert(!rdict::detail::is_flat_kv_v<LegacyInt64, LegacyInt64>);
+  int64_t test_count = 100000;
+  LegacyDict::Options legacy_opts;
+  legacy_opts.path = "./test_flat_legacy_rdict";
+  legacy_opts.truncate = true;
+  {
+    auto legacy_dict = std::move(LegacyDict::New(legacy_opts).value());
+    for (int64_t i = 0; i < test_count; i++) {
+      ASSERT_TRUE(legacy_dict->Put(-i, i * 3).ok());
+    }
+    ASSERT_TRUE(legacy_dict->Commit().ok());
+  }
+
+  // readonly dicts read the records in place
+  Dict::Options opts;
+  opts.path = legacy_opts.path;
+  opts.readonly = true;
+  opts.access_profile_sample_rate = 1;
+  {
+    auto dict = std::move(Dict::New(opts).value());
+    ASSERT_EQ(dict->Size(), test_count);
+    for (int64_t i = 0; i < test_count; i++) {
+      ASSERT_EQ(dict->Get(-i).value(), i * 3);
+    }
+    ASSERT_FALSE(dict->Exists(1));
+    Dict::Lookup lookup(Dict::hashed_key_type(-7));
+    dict->StartLookup(&lookup);
+    while (!dict->StepLookup(&lookup)) {
+    }
+    ASSERT_TRUE(lookup.found);
+    ASSERT_EQ(lookup.value, 21);
+  }
+
+  // writable dicts convert them into flat buckets
+  opts.readonly = false;
+  opts.access_profile_sample_rate = 0;
+  {
+    auto dict = std::move(Dict::New(opts).value());
+    ASSERT_EQ(dict->Size(), test_count);
+    ASSERT_TRUE(dict->Put(1, 1).ok());
+    ASSERT_TRUE(dict->Put(-1, 4).ok());
+    ASSERT_TRUE(dict->Commit().ok());
+  }
+  opts.readonly = true;
+  auto dict = std::move(Dict::New(opts).value());
+  ASSERT_EQ(dict->Size(), test_count + 1);
+  ASSERT_EQ(dict->DataRegion().size, 0);
+  ASSERT_EQ(dict->Get(1).value(), 1);
+  ASSERT_EQ(dict->Get(-1).value(), 4);
+  for (int64_t i = 2; i < test_count; i++) {
+    ASSERT_EQ(dict->Get(-i).value(), i * 3);
+  }
+}
+
+TEST(Rdict, bulk_build) {
+  using Dict = rdict::ReadonlyKV<std::string_view, std::string_view>;
+  uint64_t test_count = 200000;
+  Dict::Options opts;
+  opts.path = "./test_bulk_rdict";
+  opts.truncate = true;
+  opts.bulk_build_threads = 3;
+  {
+    auto dict = std::move(Dict::New(opts).value());
+    // put records are overridden by bulk records of the same key
+    for (uint64_t i = 0; i < 1000; i++) {
+      ASSERT_TRUE(dict->Put("key" + std::to_string(i), "put").ok());
+    }
+    ASSERT_TRUE(dict->Put("put_only", "put").ok());
+    std::vector<std::pair<std::string, std::string>> records;
+    for (uint64_t i = 0; i < test_count; i++) {
+      records.emplace_back("key" + std::to_string(i), "old");
+    }
+    for (uint64_t i = 0; i < test_count; i++) {
+      records.emplace_back("key" + std::to_string(i), "val" + std::to_string(i));
+    }
+    ASSERT_TRUE(dict->BulkBuild(records).ok());
+    ASSERT_EQ(dict->Size(), test_count + 1);
+    for (uint64_t i = 0; i < test_count; i++) {
+      ASSERT_EQ(dict->Get("key" + std::to_string(i)).value(), "val" + std::to_string(i));
+    }
+    ASSERT_EQ(dict->Get("put_only").value(), "put");
+    ASSERT_FALSE(dict->Exists("key" + std::to_string(test_count)));
+    // the bulk built index takes further puts, pending bulk records are finished by Commit
+    ASSERT_TRUE(dict->Put("key1", "updated").ok());
+    ASSERT_TRUE(dict->BulkAdd("pending", "bulk").ok());
+    ASSERT_TRUE(dict->Commit().ok());
+  }
+  opts.readonly = true;
+  opts.truncate = false;
+  {
+    auto dict = std::move(Dict::New(opts).value());
+    ASSERT_EQ(dict->Size(), test_count + 2);
+    ASSERT_EQ(dict->Get("key1").value(), "updated");
+    ASSERT_EQ(dict->Get("key2").value(), "val2");
+    ASSERT_EQ(dict->Get("pending").value(), "bulk");
+    ASSERT_FALSE(dict->BulkAdd("key", "val").ok());
+  }
+
+  // flat dicts of every size, small tables wrap records around the last bucket
+  using FlatDict = rdict::ReadonlyKV<uint64_t, uint64_t>;
+  for (uint64_t count : {1, 3, 50, 1000, 100000}) {
+    FlatDict::Options flat_opts;
+    flat_opts.path = "./test_bulk_flat_rdict";
+    flat_opts.truncate = true;
+    auto dict = std::move(FlatDict::New(flat_opts).value());
+    std::vector<std::pair<uint64_t, uint64_t>> records;
+    for (uint64_t i = 0; i < count; i++) {
+      records.emplace_back(i * 7, i);
+    }
+    ASSERT_TRUE(dict->BulkBuild(records).ok());
+    ASSERT_EQ(dict->Size(), count);
+    for (uint64_t i = 0; i < count; i++) {
+      ASSERT_EQ(dict->Get(i * 7).value(), i);
+      ASSERT_FALSE(dict->Exists(i * 7 + 1));
+    }
+  }
+}
+
+TEST(Rdict, key_estimate_and_reserve) {
+  using Dict = rdict::ReadonlyKV<uint64_t, std::string_view>;
+  for (uint64_t count : {100, 10000, 1000000}) {
+    rdict::HyperLogLog hll;
+    for (uint64_t i = 0; i < count; i++) {
+      // every key twice
+      hll.Add(Dict::hashed_key_type::Mix(i));
+      hll.Add(Dict::hashed_key_type::Mix(i));
+    }
+    double error = std::abs(static_cast<double>(hll.Estimate()) - count) / count;
+    ASSERT_LT(error, 0.03);
+  }
+  rdict::HyperLogLog left, right, other(10);
+  for (uint64_t i = 0; i < 20000; i++) {
+    (i < 10000 ? left : right).Add(Dict::hashed_key_type::Mix(i));
+  }
+  ASSERT_TRUE(left.Merge(right).ok());
+  ASSERT_LT(std::abs(static_cast<double>(left.Estimate()) - 20000) / 20000, 0.03);
+  ASSERT_TRUE(absl::IsInvalidArgument(left.Merge(other)));
+
+  uint64_t test_count = 200000;
+  Dict::Options opts;
+  opts.path = "./test_reserve_rdict";
+  opts.truncate = true;
+  {
+    auto dict = std::move(Dict::New(opts).value());
+    for (uint64_t i = 0; i < test_count; i++) {
+      ASSERT_TRUE(dict->Put(i, "v").ok());
+    }
+    ASSERT_GT(dict->GetBuildStats().rehashes, 10);
+  }
+  {
+    auto dict = std::move(Dict::New(opts).value());
+    ASSERT_TRUE(dict->Reserve(test_count).ok());
+    for (uint64_t i = 0; i < test_count; i++) {
+      ASSERT_TRUE(dict->Put(i, "v").ok());
+    }
+    ASSERT_EQ(dict->GetBuildStats().rehashes, 0);
+    ASSERT_EQ(dict->Get(test_count - 1).value(), "v");
+  }
+}
@@ -56,4 +56,56 @@ TEST(Rdict, simple_strs) {
     ASSERT_EQ(val.value(), add_content);
   }
   ASSERT_EQ(dict1->Size(), test_count - 1);
-}
\ No newline at end of file
+}
+TEST(Rdict, access_profile_warmup) {
+  uint64_t test_count = 100000;
+  rdict::ReadonlyList::Options opts;
+  opts.readonly = false;
+  opts.truncate = true;
+  opts.path = "./test_profile_list_rdict";
+  auto result = rdict::ReadonlyList::New(opts);
+  auto dict = std::move(result.value());
+  for (uint64_t i = 0; i < test_count; i++) {
+    ASSERT_TRUE(dict->Add("hello,world" + std::to_string(i)).ok());
+  }
+  ASSERT_TRUE(dict->Commit().ok());
+  dict.reset();
+
+  opts.readonly = true;
+  opts.truncate = false;
+  opts.access_profile_sample_rate = 1;
+  opts.warmup_profile_path = "./test_profile_list_rdict.profile";
+  auto result1 = rdict::ReadonlyList::New(opts);
+  ASSERT_TRUE(result1.ok());
+  auto dict1 = std::move(result1.value());
+  for (uint64_t i = 0; i < 100; i++) {
+    ASSERT_EQ(dict1->Get(i).value(), "hello,world" + std::to_string(i));
+  }
+  ASSERT_TRUE(dict1->SaveAccessProfile(opts.warmup_profile_path).ok());
+  dict1.reset();
+
+  auto profile = rdict::AccessProfile::Load(opts.warmup_profile_path);
+  ASSERT_TRUE(profile.ok());
+  // first 100 entries live in the first data page and the first index page
+  ASSERT_EQ(profile.value()->HotPages(), 2);
+
+  auto result2 = rdict::ReadonlyList::New(opts);
+  ASSERT_TRUE(result2.ok());
+  ASSERT_EQ(result2.value()->Get(test_count - 1).value(), "hello,world" + std::to_string(test_count - 1));
+}
+
+TEST(Rdict, access_profile_sample_rate) {
+  auto profile1 = rdict::AccessProfile::New(4096, 4);
+  auto profile2 = rdict::AccessProfile::New(4096, 4);
+  auto every = rdict::AccessProfile::New(4096, 1);
+  size_t sampled1 = 0, sampled2 = 0;
+  // interleaved lookups of two dicts are both sampled at their rate
+  for (size_t i = 0; i < 100000; i++) {
+    sampled1 += profile1->Sample();
+    sampled2 += profile2->Sample();
+    sampled2 += profile2->Sample();
+    ASSERT_TRUE(every->Sample());
+  }
+  ASSERT_NEAR(sampled1, 25000, 1000);
+  ASSERT_NEAR(sampled2, 50000, 2000);
+}
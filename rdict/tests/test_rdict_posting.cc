@@ -0,0 +1,154 @@
+/*
+** BSD 3-Clause License
+**
+** Copyright (c) 2023, qiyingwang <qiyingwang@tencent.com>, the respective contributors, as shown by the AUTHORS file.
+** All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions are met:
+** * Redistributions of source code must retain the above copyright notice, this
+** list of conditions and the following disclaimer.
+**
+** * Redistributions in binary form must reproduce the above copyright notice,
+** this list of conditions and the following disclaimer in the documentation
+** and/or other materials provided with the distribution.
+**
+** * Neither the name of the copyright holder nor the names of its
+** contributors may be used to endorse or promote products derived from
+** this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+** AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+** IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+** DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+** FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+** DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+** SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+** CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+** OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <random>
+#include <set>
+#include <string_view>
+#include "rdict/posting_list.h"
+
+static std::vector<uint32_t> random_docs(std::mt19937& rng, size_t n, uint32_t max_gap) {
+  std::vector<uint32_t> docs;
+  uint32_t doc = rng() % max_gap;
+  for (size_t i = 0; i < n; i++) {
+    docs.push_back(doc);
+    doc += 1 + rng() % max_gap;
+  }
+  return docs;
+}
+
+TEST(Rdict, posting_list_roundtrip) {
+  std::mt19937 rng(7);
+  for (size_t n : {0, 1, 3, 127, 128, 129, 1000, 100000}) {
+    for (uint32_t max_gap : {1U, 200U, 70000U, 30000000U}) {
+      if (n > 129 && max_gap > 70000) continue;
+      auto docs = random_docs(rng, n, max_gap);
+      std::string encoded;
+      ASSERT_TRUE(rdict::PostingList::Encode(docs.data(), docs.size(), &encoded).ok());
+      auto list = rdict::PostingList::Parse(encoded);
+      ASSERT_TRUE(list.ok());
+      ASSERT_EQ(list->Size(), n);
+      ASSERT_EQ(list->Decode(), docs);
+      uint32_t block[rdict::PostingList::kBlockSize];
+      uint32_t portable[rdict::PostingList::kBlockSize];
+      for (size_t b = 0; b < list->Blocks(); b++) {
+        size_t count = list->DecodeBlock(b, block);
+        ASSERT_EQ(count, list->DecodeBlockPortable(b, portable));
+        ASSERT_TRUE(std::equal(block, block + count, portable));
+      }
+    }
+  }
+  std::vector<uint32_t> unsorted = {1, 5, 5, 7};
+  std::string encoded;
+  ASSERT_FALSE(rdict::PostingList::Encode(unsorted.data(), unsorted.size(), &encoded).ok());
+  ASSERT_FALSE(rdict::PostingList::Parse("abc").ok());
+}
+
+TEST(Rdict, posting_list_next_geq) {
+  std::mt19937 rng(11);
+  auto docs = random_docs(rng, 5000, 300);
+  std::string encoded;
+  ASSERT_TRUE(rdict::PostingList::Encode(docs.data(), docs.size(), &encoded).ok());
+  auto list = rdict::PostingList::Parse(encoded).value();
+  rdict::PostingCursor cursor(list);
+  uint32_t target = 0;
+  while (true) {
+    target += rng() % 2000;
+    auto expected = std::lower_bound(docs.begin(), docs.end(), target);
+    bool valid = cursor.NextGEQ(target);
+    ASSERT_EQ(valid, expected != docs.end());
+    if (!valid) break;
+    ASSERT_EQ(cursor.Doc(), *expected);
+  }
+  // never moves backwards
+  rdict::PostingCursor cursor1(list);
+  ASSERT_TRUE(cursor1.NextGEQ(docs[2000]));
+  ASSERT_TRUE(cursor1.NextGEQ(docs[10]));
+  ASSERT_EQ(cursor1.Doc(), docs[2000]);
+}
+
+TEST(Rdict, posting_list_intersect_union) {
+  std::mt19937 rng(13);
+  std::vector<std::vector<uint32_t>> lists = {random_docs(rng, 20000, 4), random_docs(rng, 3000, 30),
+                                              random_docs(rng, 8000, 10)};
+  std::vector<std::string> encoded(lists.size());
+  std::vector<rdict::PostingCursor> cursors;
+  for (size_t i = 0; i < lists.size(); i++) {
+    ASSERT_TRUE(rdict::PostingList::Encode(lists[i].data(), lists[i].size(), &encoded[i]).ok());
+    cursors.emplace_back(rdict::PostingList::Parse(encoded[i]).value());
+  }
+  std::vector<uint32_t> expected_and = lists[0], tmp;
+  std::set<uint32_t> expected_or(lists[0].begin(), lists[0].end());
+  for (size_t i = 1; i < lists.size(); i++) {
+    tmp.clear();
+    std::set_intersection(expected_and.begin(), expected_and.end(), lists[i].begin(), lists[i].end(),
+                          std::back_inserter(tmp));
+    expected_and.swap(tmp);
+    expected_or.insert(lists[i].begin(), lists[i].end());
+  }
+  std::vector<uint32_t> docs;
+  rdict::IntersectPostings(&cursors, &docs);
+  ASSERT_FALSE(expected_and.empty());
+  ASSERT_EQ(docs, expected_and);
+
+  cursors.clear();
+  for (auto& e : encoded) {
+    cursors.emplace_back(rdict::PostingList::Parse(e).value());
+  }
+  docs.clear();
+  rdict::UnionPostings(&cursors, &docs);
+  ASSERT_EQ(docs, std::vector<uint32_t>(expected_or.begin(), expected_or.end()));
+}
+
+TEST(Rdict, posting_dict) {
+  std::mt19937 rng(17);
+  size_t test_count = 2000;
+  std::vector<std::vector<uint32_t>> postings;
+  rdict::PostingDict<std::string_view>::Options opts;
+  opts.path = "./test_posting_rdict";
+  auto dict = std::move(rdict::PostingDict<std::string_view>::New(opts).value());
+  for (size_t i = 0; i < test_count; i++) {
+    postings.emplace_back(random_docs(rng, rng() % 500, 1000));
+    ASSERT_TRUE(dict->Put("term" + std::to_string(i), postings.back()).ok());
+  }
+  std::vector<uint32_t> unsorted = {3, 2};
+  ASSERT_FALSE(dict->Put("bad", unsorted).ok());
+  ASSERT_TRUE(dict->Commit().ok());
+  dict.reset();
+
+  auto dict1 = std::move(rdict::PostingDict<std::string_view>::Load(opts.path).value());
+  for (size_t i = 0; i < test_count; i++) {
+    auto list = dict1->Get("term" + std::to_string(i));
+    ASSERT_TRUE(list.ok());
+    ASSERT_EQ(list->Decode(), postings[i]);
+  }
+  ASSERT_FALSE(dict1->Get("bad").ok());
+}
@@ -0,0 +1,125 @@
+/*
+** BSD 3-Clause License
+**
+** Copyright (c) 2023, qiyingwang <qiyingwang@tencent.com>, the respective contributors, as shown by the AUTHORS file.
+** All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions are met:
+** * Redistributions of source code must retain the above copyright notice, this
+** list of conditions and the following disclaimer.
+**
+** * Redistributions in binary form must reproduce the above copyright notice,
+** this list of conditions and the following disclaimer in the documentation
+** and/or other materials provided with the distribution.
+**
+** * Neither the name of the copyright holder nor the names of its
+** contributors may be used to endorse or promote products derived from
+** this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+** AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+** IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+** DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+** FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+** DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+** SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+** CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+** OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <set>
+#include <string>
+#include <vector>
+#include "rdict/set.h"
+
+TEST(Rdict, set_string) {
+  size_t test_count = 100000;
+  rdict::ReadonlySet<std::string_view>::Options opts;
+  opts.path = "./test_set_rdict";
+  opts.truncate = true;
+  auto set = std::move(rdict::ReadonlySet<std::string_view>::New(opts).value());
+  rdict::ReadonlyKV<std::string_view, uint32_t>::Options kv_opts;
+  kv_opts.path = "./test_set_kv_rdict";
+  kv_opts.truncate = true;
+  auto kv = std::move(rdict::ReadonlyKV<std::string_view, uint32_t>::New(kv_opts).value());
+  for (size_t i = 0; i < test_count; i++) {
+    std::string key = "set_key_" + std::to_string(i);
+    ASSERT_TRUE(set->Insert(key).ok());
+    ASSERT_TRUE(kv->Put(key, 1).ok());
+  }
+  ASSERT_TRUE(set->Insert("set_key_0").ok());
+  ASSERT_EQ(set->Size(), test_count);
+  ASSERT_TRUE(set->Commit().ok());
+  ASSERT_TRUE(kv->Commit().ok());
+  set.reset();
+  kv.reset();
+  ASSERT_LT(std::filesystem::file_size(opts.path), std::filesystem::file_size(kv_opts.path));
+
+  auto set1 = std::move(rdict::ReadonlySet<std::string_view>::Load(opts.path).value());
+  std::vector<std::string> keys;
+  for (size_t i = 0; i < test_count * 2; i++) {
+    keys.emplace_back("set_key_" + std::to_string(i));
+    ASSERT_EQ(set1->Contains(keys.back()), i < test_count);
+  }
+  std::vector<std::string_view> views(keys.begin(), keys.end());
+  std::unique_ptr<bool[]> found(new bool[views.size()]);
+  ASSERT_EQ(set1->ContainsMany(views.data(), views.size(), found.get()), test_count);
+  for (size_t i = 0; i < views.size(); i++) {
+    ASSERT_EQ(found[i], i < test_count);
+  }
+  size_t visited = 0;
+  set1->ForEach([&](std::string_view key) {
+    ASSERT_EQ(key.substr(0, 8), "set_key_");
+    visited++;
+  });
+  ASSERT_EQ(visited, test_count);
+  // sets and kv dicts do not load each other
+  ASSERT_FALSE(rdict::ReadonlySet<std::string_view>::Load(kv_opts.path).ok());
+  rdict::ReadonlyKV<std::string_view, uint32_t>::Options load_opts;
+  load_opts.path = opts.path;
+  load_opts.readonly = true;
+  ASSERT_FALSE((rdict::ReadonlyKV<std::string_view, uint32_t>::New(load_opts).ok()));
+}
+
+TEST(Rdict, set_algebra) {
+  using Set = rdict::ReadonlySet<uint64_t>;
+  std::vector<std::unique_ptr<Set>> sets;
+  std::vector<std::set<uint64_t>> expected(3);
+  for (size_t i = 0; i < 3; i++) {
+    Set::Options opts;
+    opts.path = "./test_set_rdict_" + std::to_string(i);
+    opts.truncate = true;
+    auto set = std::move(Set::New(opts).value());
+    // multiples of 2, 3 and 5
+    for (uint64_t key = 0; key < 30000; key += i + 2 + (i == 2)) {
+      ASSERT_TRUE(set->Insert(key).ok());
+      expected[i].insert(key);
+    }
+    ASSERT_TRUE(set->Commit().ok());
+    sets.emplace_back(std::move(Set::Load(opts.path).value()));
+  }
+  std::vector<const Set*> inputs{sets[0].get(), sets[1].get(), sets[2].get()};
+  Set::Options opts;
+  opts.path = "./test_set_rdict_union";
+  opts.truncate = true;
+  ASSERT_TRUE(Set::Union(inputs, opts).ok());
+  opts.path = "./test_set_rdict_intersect";
+  ASSERT_TRUE(Set::Intersect(inputs, opts).ok());
+
+  auto united = std::move(Set::Load("./test_set_rdict_union").value());
+  auto intersected = std::move(Set::Load("./test_set_rdict_intersect").value());
+  size_t union_size = 0, intersect_size = 0;
+  for (uint64_t key = 0; key < 30000; key++) {
+    size_t in = expected[0].count(key) + expected[1].count(key) + expected[2].count(key);
+    ASSERT_EQ(united->Contains(key), in > 0);
+    ASSERT_EQ(intersected->Contains(key), in == 3);
+    union_size += in > 0;
+    intersect_size += in == 3;
+  }
+  ASSERT_EQ(united->Size(), union_size);
+  ASSERT_EQ(intersected->Size(), intersect_size);
+  ASSERT_EQ(intersect_size, 1000);
+}
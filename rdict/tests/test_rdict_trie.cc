@@ -0,0 +1,158 @@
+/*
+** BSD 3-Clause License
+**
+** Copyright (c) 2023, qiyingwang <qiyingwang@tencent.com>, the respective contributors, as shown by the AUTHORS file.
+** All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions are met:
+** * Redistributions of source code must retain the above copyright notice, this
+** list of conditions and the following disclaimer.
+**
+** * Redistributions in binary form must reproduce the above copyright notice,
+** this list of conditions and the following disclaimer in the documentation
+** and/or other materials provided with the distribution.
+**
+** * Neither the name of the copyright holder nor the names of its
+** contributors may be used to endorse or promote products derived from
+** this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+** AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+** IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+** DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+** FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+** DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+** SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+** CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+** OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#include <gtest/gtest.h>
+#include <map>
+#include <random>
+#include <string>
+#include <string_view>
+#include "rdict/trie.h"
+
+static std::string random_url(std::mt19937& rng) {
+  static const char* hosts[] = {"www.example.com", "news.example.com", "example.org", "a.b.example.org", "x.io"};
+  std::string url = "https://";
+  url += hosts[rng() % 5];
+  size_t segments = rng() % 4;
+  for (size_t i = 0; i < segments; i++) {
+    url += "/p" + std::to_string(rng() % 50);
+  }
+  return url;
+}
+
+TEST(Rdict, trie_dict) {
+  std::mt19937 rng(21);
+  std::map<std::string, std::string> expected;
+  rdict::ReadonlyTrie::Options opts;
+  opts.path = "./test_trie_rdict";
+  opts.truncate = true;
+  auto dict = std::move(rdict::ReadonlyTrie::New(opts).value());
+  for (size_t i = 0; i < 50000; i++) {
+    std::string key = random_url(rng);
+    std::string value = "v" + std::to_string(i);
+    expected[key] = value;
+    ASSERT_TRUE(dict->Put(key, value).ok());
+  }
+  // empty key, binary labels and a key prefixing others
+  for (std::string key : {std::string(), std::string("\x00\xff", 2), std::string("https://x.io/p1/")}) {
+    expected[key] = "special" + key;
+    ASSERT_TRUE(dict->Put(key, "special" + key).ok());
+  }
+  ASSERT_TRUE(dict->Commit().ok());
+  ASSERT_EQ(dict->Size(), expected.size());
+  ASSERT_FALSE(dict->Put("k", "v").ok());
+  dict.reset();
+
+  opts.truncate = false;
+  ASSERT_FALSE(rdict::ReadonlyTrie::New(opts).ok());
+  opts.readonly = true;
+  auto dict1 = std::move(rdict::ReadonlyTrie::New(opts).value());
+  ASSERT_EQ(dict1->Size(), expected.size());
+  for (const auto& [key, value] : expected) {
+    auto result = dict1->Get(key);
+    ASSERT_TRUE(result.ok()) << key;
+    ASSERT_EQ(result.value(), value);
+  }
+  ASSERT_FALSE(dict1->Get("https://www.example.co").ok());
+  ASSERT_FALSE(dict1->Get("https://www.example.com/p1/p2/p3/p4/p5").ok());
+
+  for (std::string prefix : {"", "https://news.", "https://x.io/p1", "https://x.io/p1/", "nothing"}) {
+    std::vector<std::pair<std::string, std::string>> found, wanted;
+    dict1->PrefixSearch(prefix, [&](std::string_view key, std::string_view value) {
+      found.emplace_back(key, value);
+      return true;
+    });
+    for (auto it = expected.lower_bound(prefix); it != expected.end(); ++it) {
+      if (it->first.compare(0, prefix.size(), prefix) != 0) break;
+      wanted.emplace_back(it->first, it->second);
+    }
+    ASSERT_EQ(found, wanted) << prefix;
+  }
+  size_t visited = 0;
+  dict1->PrefixSearch("https://", [&](std::string_view, std::string_view) { return ++visited < 10; });
+  ASSERT_EQ(visited, 10);
+
+  for (size_t i = 0; i < 5000; i++) {
+    std::string query = random_url(rng) + "/q" + std::to_string(i);
+    query.resize(rng() % (query.size() + 1));
+    size_t want_len = 0;
+    for (size_t len = 0; len <= query.size(); len++) {
+      if (expected.count(query.substr(0, len)) > 0) {
+        want_len = len;
+      }
+    }
+    size_t match_len = 0;
+    std::string_view value;
+    ASSERT_TRUE(dict1->LongestPrefixMatch(query, &match_len, &value));
+    ASSERT_EQ(match_len, want_len) << query;
+    ASSERT_EQ(value, expected[query.substr(0, want_len)]);
+  }
+}
+
+TEST(Rdict, trie_dict_tails) {
+  std::mt19937 rng(23);
+  std::map<std::string, std::string> expected;
+  rdict::ReadonlyTrie::Options opts;
+  opts.path = "./test_trie_tails_rdict";
+  opts.truncate = true;
+  auto dict = std::move(rdict::ReadonlyTrie::New(opts).value());
+  // long unique suffixes under short shared prefixes
+  for (size_t i = 0; i < 20000; i++) {
+    std::string key(rng() % 24, 'a');
+    for (auto& c : key) c = 'a' + rng() % 3;
+    expected[key] = std::to_string(i);
+    ASSERT_TRUE(dict->Put(key, std::to_string(i)).ok());
+  }
+  ASSERT_TRUE(dict->Commit().ok());
+  for (const auto& [key, value] : expected) {
+    std::string_view found;
+    ASSERT_TRUE(dict->Find(key, &found)) << key;
+    ASSERT_EQ(found, value);
+    ASSERT_FALSE(dict->Find(key + "c", &found) && expected.count(key + "c") == 0) << key;
+    size_t match_len = 0;
+    ASSERT_TRUE(dict->LongestPrefixMatch(key + "cccccccc", &match_len, &found));
+    ASSERT_GE(match_len, key.size());
+    ASSERT_EQ(found, expected[std::string(key + "cccccccc").substr(0, match_len)]);
+  }
+  size_t checked = 0;
+  for (const auto& [key, value] : expected) {
+    if (key.size() < 6 || ++checked % 20 != 0) continue;
+    std::string prefix = key.substr(0, key.size() / 2 + 1);
+    size_t count = 0;
+    dict->PrefixSearch(prefix, [&](std::string_view k, std::string_view v) {
+      count++;
+      return k.substr(0, prefix.size()) == prefix && expected[std::string(k)] == v;
+    });
+    size_t wanted = 0;
+    for (auto it = expected.lower_bound(prefix); it != expected.end() && it->first.rfind(prefix, 0) == 0; ++it) {
+      wanted++;
+    }
+    ASSERT_EQ(count, wanted) << prefix;
+  }
+}
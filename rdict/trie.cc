@@ -0,0 +1,574 @@
+/*
+** BSD 3-Clause License
+**
+** Copyright (c) 2023, qiyingwang <qiyingwang@tencent.com>, the respective contributors, as shown by the AUTHORS file.
+** All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions are met:
+** * Redistributions of source code must retain the above copyright notice, this
+** list of conditions and the following disclaimer.
+**
+** * Redistributions in binary form must reproduce the above copyright notice,
+** this list of conditions and the following disclaimer in the documentation
+** and/or other materials provided with the distribution.
+**
+** * Neither the name of the copyright holder nor the names of its
+** contributors may be used to endorse or promote products derived from
+** this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+** AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+** IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+** DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+** FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+** DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+** SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+** CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+** OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#include "rdict/trie.h"
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <numeric>
+#include <utility>
+
+#include "folly/Likely.h"
+
+namespace rdict {
+namespace {
+constexpr size_t kBlockBits = 512;
+constexpr size_t kBlockWords = kBlockBits / 64;
+constexpr size_t kZeroSampleRate = 64;
+
+constexpr auto kSelectInByte = [] {
+  std::array<std::array<uint8_t, 8>, 256> table{};
+  for (size_t byte = 0; byte < 256; byte++) {
+    for (size_t bit = 0, rank = 0; bit < 8; bit++) {
+      if ((byte >> bit) & 1) {
+        table[byte][rank++] = bit;
+      }
+    }
+  }
+  return table;
+}();
+
+// position of the 'rank'-th set bit of 'word'
+inline size_t SelectInWord(uint64_t word, size_t rank) {
+  size_t pos = 0;
+  for (size_t width : {32, 16, 8}) {
+    size_t count = __builtin_popcountll(word & ((uint64_t{1} << width) - 1));
+    if (rank >= count) {
+      rank -= count;
+      word >>= width;
+      pos += width;
+    }
+  }
+  return pos + kSelectInByte[word & 0xFF][rank];
+}
+
+size_t BitsWords(size_t size) { return (size + 63) / 64; }
+size_t BitsBlocks(size_t size) { return (size + kBlockBits - 1) / kBlockBits; }
+size_t ZeroSamples(size_t zeros) { return (zeros + kZeroSampleRate - 1) / kZeroSampleRate; }
+size_t Align8(size_t n) { return (n + 7) & ~size_t{7}; }
+
+void AppendBytes(const void* data, size_t len, std::vector<uint8_t>* index) {
+  const uint8_t* p = reinterpret_cast<const uint8_t*>(data);
+  index->insert(index->end(), p, p + len);
+  index->resize(Align8(index->size()));
+}
+
+// words, ranks of every block plus the total, and the zero samples if 'zeros' > 0
+void AppendBits(const std::vector<uint64_t>& words, size_t size, size_t zeros, std::vector<uint8_t>* index) {
+  std::vector<uint64_t> ranks(BitsBlocks(size) + 1);
+  std::vector<uint64_t> samples;
+  uint64_t ones = 0, seen_zeros = 0;
+  for (size_t i = 0; i < words.size(); i++) {
+    if (i % kBlockWords == 0) {
+      ranks[i / kBlockWords] = ones;
+    }
+    ones += __builtin_popcountll(words[i]);
+    if (zeros > 0) {
+      size_t bits = std::min<size_t>(64, size - i * 64);
+      uint64_t word_zeros = ~words[i] & (bits == 64 ? ~uint64_t{0} : (uint64_t{1} << bits) - 1);
+      size_t count = __builtin_popcountll(word_zeros);
+      for (size_t next = samples.size() * kZeroSampleRate; next < seen_zeros + count; next += kZeroSampleRate) {
+        samples.push_back(i * 64 + SelectInWord(word_zeros, next - seen_zeros));
+      }
+      seen_zeros += count;
+    }
+  }
+  ranks.back() = ones;
+  AppendBytes(words.data(), words.size() * sizeof(uint64_t), index);
+  AppendBytes(ranks.data(), ranks.size() * sizeof(uint64_t), index);
+  AppendBytes(samples.data(), samples.size() * sizeof(uint64_t), index);
+}
+
+size_t BitsBytes(size_t size, size_t zeros) {
+  return (BitsWords(size) + BitsBlocks(size) + 1 + ZeroSamples(zeros)) * sizeof(uint64_t);
+}
+
+const uint8_t* MapBits(const uint8_t* p, size_t size, size_t zeros, ReadonlyTrie::Bits* bits) {
+  bits->size = size;
+  bits->words = reinterpret_cast<const uint64_t*>(p);
+  bits->ranks = bits->words + BitsWords(size);
+  bits->zero_samples = bits->ranks + BitsBlocks(size) + 1;
+  return p + BitsBytes(size, zeros);
+}
+
+inline size_t Rank1Of(const ReadonlyTrie::Bits& bits, size_t pos) {
+  size_t block = pos / kBlockBits;
+  size_t rank = bits.ranks[block];
+  for (size_t i = block * kBlockWords; i < pos / 64; i++) {
+    rank += __builtin_popcountll(bits.words[i]);
+  }
+  if (pos % 64 != 0) {
+    rank += __builtin_popcountll(bits.words[pos / 64] << (64 - pos % 64));
+  }
+  return rank;
+}
+
+inline size_t Select0Of(const ReadonlyTrie::Bits& bits, size_t rank) {
+  size_t pos = bits.zero_samples[rank / kZeroSampleRate];
+  rank %= kZeroSampleRate;
+  size_t i = pos / 64;
+  uint64_t zeros = ~bits.words[i] & (~uint64_t{0} << (pos % 64));
+  for (;;) {
+    size_t count = __builtin_popcountll(zeros);
+    if (rank < count) {
+      return i * 64 + SelectInWord(zeros, rank);
+    }
+    rank -= count;
+    zeros = ~bits.words[++i];
+  }
+}
+
+#if defined(__x86_64__)
+// the same inlined with the popcnt instruction instead of a libgcc call
+__attribute__((target("popcnt"))) size_t Rank1Popcnt(const ReadonlyTrie::Bits& bits, size_t pos) {
+  return Rank1Of(bits, pos);
+}
+__attribute__((target("popcnt"))) size_t Select0Popcnt(const ReadonlyTrie::Bits& bits, size_t rank) {
+  return Select0Of(bits, rank);
+}
+const bool kHasPopcnt = (__builtin_cpu_init(), __builtin_cpu_supports("popcnt"));
+#endif
+
+inline bool StartsWith(std::string_view s, std::string_view prefix) {
+  return s.size() >= prefix.size() && s.compare(0, prefix.size(), prefix) == 0;
+}
+}  // namespace
+
+size_t ReadonlyTrie::Bits::Rank1(size_t pos) const {
+#if defined(__x86_64__)
+  if (FOLLY_LIKELY(kHasPopcnt)) {
+    return Rank1Popcnt(*this, pos);
+  }
+#endif
+  return Rank1Of(*this, pos);
+}
+
+size_t ReadonlyTrie::Bits::Select0(size_t rank) const {
+#if defined(__x86_64__)
+  if (FOLLY_LIKELY(kHasPopcnt)) {
+    return Select0Popcnt(*this, rank);
+  }
+#endif
+  return Select0Of(*this, rank);
+}
+
+absl::StatusOr<std::unique_ptr<ReadonlyTrie>> ReadonlyTrie::New(const Options& opt) {
+  std::unique_ptr<ReadonlyTrie> p(new ReadonlyTrie);
+  auto status = p->Init(opt);
+  if (!status.ok()) {
+    return status;
+  }
+  return p;
+}
+
+absl::Status ReadonlyTrie::Init(const Options& opt) {
+  opt_ = opt;
+  MmapFile::Options data_opts;
+  data_opts.path = opt.path;
+  data_opts.readonly = opt.readonly;
+  data_opts.reserved_space_bytes = opt.reserved_space_bytes;
+  data_opts.truncate = opt.truncate;
+  data_opts.atomic_publish = opt.atomic_publish;
+  data_opts.load_mode = opt.load_mode;
+  data_opts.load_threads = opt.load_threads;
+  data_opts.view = opt.view;
+  auto data_file_result = MmapFile::Open(data_opts);
+  if (!data_file_result.ok()) {
+    return data_file_result.status();
+  }
+  data_mmap_file_ = std::move(data_file_result.value());
+  rdict_header_buffer_.resize(detail::kRdictMetaHeaderSize);
+  header_ = reinterpret_cast<detail::RdictMetaHeader*>(&rdict_header_buffer_[0]);
+  if (data_mmap_file_->GetWriteOffset() == 0) {
+    if (opt.readonly) {
+      return absl::InvalidArgumentError("invalid rdict file with too small length");
+    }
+    *header_ = detail::RdictMetaHeader{};
+    header_->type = detail::DictType::DICT_TRIE;
+    data_mmap_file_->ResetWriteOffset(detail::kRdictMetaHeaderSize);
+    return absl::OkStatus();
+  }
+  if (!opt.readonly) {
+    return absl::FailedPreconditionError("trie dict can not be extended, truncate to rebuild it");
+  }
+  return LoadIndex();
+}
+
+absl::Status ReadonlyTrie::LoadIndex() {
+  const uint8_t* data = data_mmap_file_->GetRawData();
+  if (data_mmap_file_->GetWriteOffset() < detail::kRdictMetaHeaderSize) {
+    return absl::InvalidArgumentError("invalid rdict file with too small length");
+  }
+  memcpy(&rdict_header_buffer_[0], data, detail::kRdictMetaHeaderSize);
+  if (header_->type != detail::DictType::DICT_TRIE) {
+    return absl::InvalidArgumentError("not a trie dict");
+  }
+  const uint8_t* index = data + detail::kRdictMetaHeaderSize + header_->data_size + header_->data_pad_size;
+  if (index + header_->index_size > data + data_mmap_file_->GetWriteOffset() ||
+      header_->index_size < k_meta_reserved_space) {
+    return absl::InvalidArgumentError("invalid trie index size");
+  }
+  const IndexMeta* meta = reinterpret_cast<const IndexMeta*>(index);
+  if (meta->nodes == 0) {
+    return absl::InvalidArgumentError("invalid trie index");
+  }
+  size_t edges = meta->nodes - 1;
+  size_t offset_bytes = meta->narrow_offsets ? sizeof(uint32_t) : sizeof(uint64_t);
+  size_t tail_end_bytes = meta->narrow_tails ? sizeof(uint32_t) : sizeof(uint64_t);
+  size_t expected = k_meta_reserved_space + Align8(edges) + BitsBytes(edges + meta->nodes, meta->nodes) +
+                    2 * BitsBytes(meta->nodes, 0) + Align8(meta->size * offset_bytes) +
+                    Align8(meta->tails * tail_end_bytes) + meta->tail_bytes;
+  if (expected > header_->index_size) {
+    return absl::InvalidArgumentError("invalid trie index size");
+  }
+  const uint8_t* p = index + k_meta_reserved_space;
+  labels_ = p;
+  p += Align8(edges);
+  p = MapBits(p, edges + meta->nodes, meta->nodes, &louds_);
+  p = MapBits(p, meta->nodes, 0, &values_);
+  p = MapBits(p, meta->nodes, 0, &tails_);
+  offsets_ = p;
+  p += Align8(meta->size * offset_bytes);
+  tail_ends_ = p;
+  p += Align8(meta->tails * tail_end_bytes);
+  tail_data_ = reinterpret_cast<const char*>(p);
+  meta_ = meta;
+  return absl::OkStatus();
+}
+
+absl::Status ReadonlyTrie::Put(std::string_view key, std::string_view value) {
+  if (opt_.readonly || Ready()) {
+    return absl::PermissionDeniedError("Unable to put into readonly or committed trie dict");
+  }
+  uint32_t len = value.size();
+  size_t record_len = (sizeof(uint32_t) + value.size() + 7) & ~size_t{7};
+  auto result = data_mmap_file_->Reserve(record_len);
+  if (!result.ok()) {
+    return result.status();
+  }
+  uint8_t* dst = result.value();
+  memcpy(dst, &len, sizeof(uint32_t));
+  memcpy(dst + sizeof(uint32_t), value.data(), value.size());
+  memset(dst + sizeof(uint32_t) + value.size(), 0, record_len - sizeof(uint32_t) - value.size());
+  value_offsets_.push_back(data_mmap_file_->Commit(record_len));
+  key_buffer_.append(key);
+  key_offsets_.push_back(key_buffer_.size());
+  return absl::OkStatus();
+}
+
+size_t ReadonlyTrie::Size() const { return Ready() ? meta_->size : key_offsets_.size(); }
+
+absl::Status ReadonlyTrie::Commit() {
+  if (opt_.readonly || Ready()) {
+    return absl::PermissionDeniedError("Unable to commit readonly or committed trie dict");
+  }
+  auto key_of = [this](size_t i) {
+    size_t begin = i == 0 ? 0 : key_offsets_[i - 1];
+    return std::string_view(key_buffer_.data() + begin, key_offsets_[i] - begin);
+  };
+  std::vector<size_t> order(key_offsets_.size());
+  std::iota(order.begin(), order.end(), 0);
+  std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) { return key_of(a) < key_of(b); });
+  // the last put of a key wins
+  size_t unique = 0;
+  for (size_t i = 0; i < order.size(); i++) {
+    if (i + 1 < order.size() && key_of(order[i]) == key_of(order[i + 1])) {
+      continue;
+    }
+    order[unique++] = order[i];
+  }
+  order.resize(unique);
+
+  // level order build, every node is a range of 'order' sharing 'depth' bytes
+  std::vector<uint8_t> labels;
+  std::vector<uint64_t> louds, values, tails;
+  size_t louds_size = 0, nodes = 0, tail_bits = 0, tail_nodes = 0;
+  std::vector<uint64_t> offsets, tail_ends;
+  std::string tail_data;
+  auto push_bit = [](std::vector<uint64_t>* bits, size_t* size, bool bit) {
+    if (*size % 64 == 0) {
+      bits->push_back(0);
+    }
+    bits->back() |= uint64_t{bit} << (*size % 64);
+    (*size)++;
+  };
+  std::vector<std::pair<size_t, size_t>> level = {{0, order.size()}}, next_level;
+  for (size_t depth = 0; !level.empty(); depth++) {
+    next_level.clear();
+    for (auto [begin, end] : level) {
+      std::string_view first = begin < end ? key_of(order[begin]) : std::string_view();
+      bool terminal = begin < end && first.size() == depth;
+      bool tail = end - begin == 1 && first.size() > depth + k_min_tail_len;
+      push_bit(&values, &nodes, terminal || tail);
+      push_bit(&tails, &tail_bits, tail);
+      if (terminal || tail) {
+        offsets.push_back(value_offsets_[order[begin]]);
+        begin++;
+      }
+      if (tail) {
+        tail_data.append(first.substr(depth));
+        tail_ends.push_back(tail_data.size());
+        tail_nodes++;
+      }
+      while (begin < end) {
+        uint8_t c = key_of(order[begin])[depth];
+        size_t child_end = std::partition_point(order.begin() + begin, order.begin() + end,
+                                                [&](size_t i) { return uint8_t(key_of(i)[depth]) == c; }) -
+                           order.begin();
+        labels.push_back(c);
+        push_bit(&louds, &louds_size, true);
+        next_level.emplace_back(begin, child_end);
+        begin = child_end;
+      }
+      push_bit(&louds, &louds_size, false);
+    }
+    level.swap(next_level);
+  }
+  key_buffer_.clear();
+  key_buffer_.shrink_to_fit();
+  key_offsets_ = std::vector<uint64_t>();
+
+  std::vector<uint8_t> index(k_meta_reserved_space);
+  IndexMeta meta;
+  meta.size = offsets.size();
+  meta.nodes = nodes;
+  meta.tails = tail_nodes;
+  meta.tail_bytes = tail_data.size();
+  uint64_t data_end = data_mmap_file_->GetWriteOffset();
+  meta.narrow_offsets = data_end / 8 <= UINT32_MAX;
+  meta.narrow_tails = tail_data.size() <= UINT32_MAX;
+  memcpy(index.data(), &meta, sizeof(meta));
+  AppendBytes(labels.data(), labels.size(), &index);
+  AppendBits(louds, louds_size, nodes, &index);
+  AppendBits(values, nodes, 0, &index);
+  AppendBits(tails, nodes, 0, &index);
+  if (meta.narrow_offsets) {
+    std::vector<uint32_t> narrow(offsets.size());
+    for (size_t i = 0; i < offsets.size(); i++) {
+      narrow[i] = offsets[i] / 8;
+    }
+    AppendBytes(narrow.data(), narrow.size() * sizeof(uint32_t), &index);
+  } else {
+    AppendBytes(offsets.data(), offsets.size() * sizeof(uint64_t), &index);
+  }
+  if (meta.narrow_tails) {
+    std::vector<uint32_t> narrow(tail_ends.begin(), tail_ends.end());
+    AppendBytes(narrow.data(), narrow.size() * sizeof(uint32_t), &index);
+  } else {
+    AppendBytes(tail_ends.data(), tail_ends.size() * sizeof(uint64_t), &index);
+  }
+  AppendBytes(tail_data.data(), tail_data.size(), &index);
+
+  uint64_t data_len = data_end - detail::kRdictMetaHeaderSize;
+  header_->data_size = data_len;
+  header_->data_pad_size = 0;
+  header_->index_size = index.size();
+  memcpy(data_mmap_file_->GetRawData(), header_, detail::kRdictMetaHeaderSize);
+  auto result = data_mmap_file_->Add(index.data(), index.size());
+  if (!result.ok()) {
+    return result.status();
+  }
+  result = data_mmap_file_->ShrinkToFit();
+  if (!result.ok()) {
+    return result.status();
+  }
+  value_offsets_ = std::vector<uint64_t>();
+  return LoadIndex();
+}
+
+std::pair<size_t, size_t> ReadonlyTrie::Edges(size_t node) const {
+  size_t pos = node == 0 ? 0 : louds_.Select0(node - 1) + 1;
+  size_t degree = 0;
+  for (size_t i = pos;; i += 64 - i % 64) {
+    uint64_t word = louds_.words[i / 64] >> (i % 64);
+    size_t ones = ~word == 0 ? 64 : __builtin_ctzll(~word);
+    degree += ones;
+    if (ones < 64 - i % 64) {
+      break;
+    }
+  }
+  return {pos - node, degree};
+}
+
+size_t ReadonlyTrie::Child(size_t node, uint8_t c) const {
+  auto [first, degree] = Edges(node);
+  const uint8_t* begin = labels_ + first;
+  const uint8_t* it = std::lower_bound(begin, begin + degree, c);
+  if (it == begin + degree || *it != c) {
+    return 0;
+  }
+  // the child of edge e is node e + 1, the root has no edge
+  return it - labels_ + 1;
+}
+
+size_t ReadonlyTrie::Walk(std::string_view key, size_t* node) const {
+  size_t current = 0, i = 0;
+  for (; i < key.size(); i++) {
+    size_t child = Child(current, static_cast<uint8_t>(key[i]));
+    if (child == 0) {
+      break;
+    }
+    current = child;
+  }
+  *node = current;
+  return i;
+}
+
+std::string_view ReadonlyTrie::GetTail(size_t node) const {
+  size_t idx = tails_.Rank1(node);
+  uint64_t begin = 0, end = 0;
+  if (meta_->narrow_tails) {
+    const uint32_t* ends = reinterpret_cast<const uint32_t*>(tail_ends_);
+    begin = idx == 0 ? 0 : ends[idx - 1];
+    end = ends[idx];
+  } else {
+    const uint64_t* ends = reinterpret_cast<const uint64_t*>(tail_ends_);
+    begin = idx == 0 ? 0 : ends[idx - 1];
+    end = ends[idx];
+  }
+  return std::string_view(tail_data_ + begin, end - begin);
+}
+
+std::string_view ReadonlyTrie::GetValue(size_t node) const {
+  size_t idx = values_.Rank1(node);
+  uint64_t offset;
+  if (meta_->narrow_offsets) {
+    offset = uint64_t{reinterpret_cast<const uint32_t*>(offsets_)[idx]} * 8;
+  } else {
+    offset = reinterpret_cast<const uint64_t*>(offsets_)[idx];
+  }
+  const uint8_t* record = data_mmap_file_->GetRawData() + offset;
+  uint32_t len;
+  memcpy(&len, record, sizeof(len));
+  return std::string_view(reinterpret_cast<const char*>(record + sizeof(uint32_t)), len);
+}
+
+bool ReadonlyTrie::Find(std::string_view key, std::string_view* value) const {
+  if (!Ready()) {
+    return false;
+  }
+  size_t node = 0;
+  size_t consumed = Walk(key, &node);
+  if (!values_.Get(node)) {
+    return false;
+  }
+  if (tails_.Get(node) ? GetTail(node) != key.substr(consumed) : consumed != key.size()) {
+    return false;
+  }
+  *value = GetValue(node);
+  return true;
+}
+
+absl::StatusOr<std::string_view> ReadonlyTrie::Get(std::string_view key) const {
+  if (!Ready()) {
+    return absl::FailedPreconditionError("trie dict is not committed");
+  }
+  std::string_view value;
+  if (!Find(key, &value)) {
+    return absl::NotFoundError("not found entry");
+  }
+  return value;
+}
+
+bool ReadonlyTrie::Enumerate(size_t node, std::string* key,
+                             const std::function<bool(std::string_view, std::string_view)>& fn) const {
+  if (values_.Get(node)) {
+    if (tails_.Get(node)) {
+      size_t len = key->size();
+      key->append(GetTail(node));
+      bool more = fn(*key, GetValue(node));
+      key->resize(len);
+      return more;
+    }
+    if (!fn(*key, GetValue(node))) {
+      return false;
+    }
+  }
+  auto [first, degree] = Edges(node);
+  for (size_t edge = first; edge < first + degree; edge++) {
+    key->push_back(static_cast<char>(labels_[edge]));
+    if (!Enumerate(edge + 1, key, fn)) {
+      return false;
+    }
+    key->pop_back();
+  }
+  return true;
+}
+
+void ReadonlyTrie::PrefixSearch(std::string_view prefix,
+                                const std::function<bool(std::string_view, std::string_view)>& fn) const {
+  if (!Ready()) {
+    return;
+  }
+  size_t node = 0;
+  size_t consumed = Walk(prefix, &node);
+  if (consumed == prefix.size()) {
+    std::string key(prefix);
+    Enumerate(node, &key, fn);
+  } else if (tails_.Get(node) && StartsWith(GetTail(node), prefix.substr(consumed))) {
+    // the only key under 'node'
+    std::string key(prefix.substr(0, consumed));
+    key.append(GetTail(node));
+    fn(key, GetValue(node));
+  }
+}
+
+bool ReadonlyTrie::LongestPrefixMatch(std::string_view query, size_t* match_len, std::string_view* value) const {
+  if (!Ready()) {
+    return false;
+  }
+  bool found = false;
+  size_t node = 0, best = 0;
+  for (size_t i = 0;; i++) {
+    if (values_.Get(node)) {
+      if (!tails_.Get(node)) {
+        found = true;
+        best = node;
+        *match_len = i;
+      } else if (StartsWith(query.substr(i), GetTail(node))) {
+        found = true;
+        best = node;
+        *match_len = i + GetTail(node).size();
+      }
+    }
+    if (i == query.size()) {
+      break;
+    }
+    node = Child(node, static_cast<uint8_t>(query[i]));
+    if (node == 0) {
+      break;
+    }
+  }
+  if (found) {
+    *value = GetValue(best);
+  }
+  return found;
+}
+}  // namespace rdict
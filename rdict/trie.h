@@ -0,0 +1,140 @@
+/*
+** BSD 3-Clause License
+**
+** Copyright (c) 2023, qiyingwang <qiyingwang@tencent.com>, the respective contributors, as shown by the AUTHORS file.
+** All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions are met:
+** * Redistributions of source code must retain the above copyright notice, this
+** list of conditions and the following disclaimer.
+**
+** * Redistributions in binary form must reproduce the above copyright notice,
+** this list of conditions and the following disclaimer in the documentation
+** and/or other materials provided with the distribution.
+**
+** * Neither the name of the copyright holder nor the names of its
+** contributors may be used to endorse or promote products derived from
+** this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+** AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+** IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+** DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+** FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+** DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+** SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+** CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+** OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "rdict/common.h"
+#include "rdict/mmap_file.h"
+
+namespace rdict {
+/**
+ * String keyed dict with a LOUDS trie index: keys share their prefixes in a level order trie of 1 byte labels plus
+ * about 3 bits per node, the unique suffix of a key is cut into a tail string instead of a chain of nodes and values
+ * are stored without keys. Besides exact lookups it enumerates keys by prefix and finds the longest key prefixing a
+ * query, e.g. for URL and domain rules.
+ * The trie is built from all keys at once, keys are kept in memory until Commit and an existing file is readonly.
+ */
+class ReadonlyTrie {
+ public:
+  struct Options {
+    std::string path;
+    size_t reserved_space_bytes = 100 * 1024 * 1024 * 1024LL;
+    bool readonly = false;
+    bool truncate = false;
+    // writable only, build into a temporary file renamed to 'path' by Commit, see MmapFile::Options
+    bool atomic_publish = false;
+    MmapFile::LoadMode load_mode = MmapFile::LOAD_MMAP;
+    uint32_t load_threads = 4;
+    // readonly only, load from a range of an already loaded file instead of 'path', see DictBundle::Open
+    MmapFile::View view;
+  };
+  // a bit sequence with rank/select directories, laid out in the index
+  struct Bits {
+    const uint64_t* words = nullptr;
+    // ones before every 512 bits block
+    const uint64_t* ranks = nullptr;
+    // position of every 64th zero, select only
+    const uint64_t* zero_samples = nullptr;
+    size_t size = 0;
+    size_t Rank1(size_t pos) const;
+    size_t Select0(size_t rank) const;
+    bool Get(size_t pos) const { return (words[pos / 64] >> (pos % 64)) & 1; }
+  };
+
+  static absl::StatusOr<std::unique_ptr<ReadonlyTrie>> New(const Options& opt);
+  // writable only, a duplicated key keeps the last value
+  absl::Status Put(std::string_view key, std::string_view value);
+  absl::Status Commit();
+  size_t Size() const;
+  absl::StatusOr<std::string_view> Get(std::string_view key) const;
+  bool Find(std::string_view key, std::string_view* value) const;
+  // calls 'fn'(key, value) for the keys starting with 'prefix' in lexicographic order until it returns false
+  void PrefixSearch(std::string_view prefix,
+                    const std::function<bool(std::string_view, std::string_view)>& fn) const;
+  // finds the longest key which is a prefix of 'query', 'match_len' receives its length
+  bool LongestPrefixMatch(std::string_view query, size_t* match_len, std::string_view* value) const;
+
+ protected:
+  static constexpr uint32_t k_meta_reserved_space = 64;
+  // tails are cut from single key subtrees with longer suffixes than this
+  static constexpr size_t k_min_tail_len = 4;
+  struct IndexMeta {
+    uint64_t size = 0;
+    uint64_t nodes = 0;
+    uint64_t tails = 0;
+    uint64_t tail_bytes = 0;
+    // value offsets in 8 bytes units as uint32 if true, else uint64 bytes
+    uint8_t narrow_offsets = 0;
+    // tail end offsets as uint32 if true, else uint64
+    uint8_t narrow_tails = 0;
+  };
+  ReadonlyTrie() {}
+  absl::Status Init(const Options& opt);
+  absl::Status LoadIndex();
+  bool Ready() const { return nullptr != meta_; }
+  // first edge and number of edges of 'node'
+  std::pair<size_t, size_t> Edges(size_t node) const;
+  // the child of 'node' labeled 'c', 0 if none
+  size_t Child(size_t node, uint8_t c) const;
+  // walks down 'key' and returns the number of bytes consumed, 'node' receives the last node reached
+  size_t Walk(std::string_view key, size_t* node) const;
+  std::string_view GetTail(size_t node) const;
+  std::string_view GetValue(size_t node) const;
+  bool Enumerate(size_t node, std::string* key,
+                 const std::function<bool(std::string_view, std::string_view)>& fn) const;
+
+  Options opt_;
+  std::unique_ptr<MmapFile> data_mmap_file_;
+  std::vector<uint8_t> rdict_header_buffer_;
+  detail::RdictMetaHeader* header_ = nullptr;
+  // building keys, 'key_offsets_'[i] is the end of the i-th key in 'key_buffer_'
+  std::string key_buffer_;
+  std::vector<uint64_t> key_offsets_;
+  std::vector<uint64_t> value_offsets_;
+  // readonly index
+  const IndexMeta* meta_ = nullptr;
+  const uint8_t* labels_ = nullptr;
+  // a 1 per edge then a 0 for every node in level order, the child of edge e is node e + 1
+  Bits louds_;
+  // nodes with a value, the key ending at the node or extended by its tail
+  Bits values_;
+  Bits tails_;
+  const uint8_t* offsets_ = nullptr;
+  const uint8_t* tail_ends_ = nullptr;
+  const char* tail_data_ = nullptr;
+};
+}  // namespace rdict